@@ -1,5 +1,110 @@
+#define ADD_EXPORTS
 #include "add.h"
 
-__declspec(dllexport) int __stdcall add(int x) {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define ADD_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define ADD_TARGET_SSE2
+        #define ADD_TARGET_AVX2
+    #else
+        #include <cpuid.h>
+        #define ADD_TARGET_SSE2 __attribute__((target("sse2")))
+        #define ADD_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+typedef void (*AddKernel)(const int32_t *in, int32_t *out, size_t n);
+
+ADD_API int TMS_STDCALL add(int x) {
     return x+1;
-}
\ No newline at end of file
+}
+
+static void add_batch_scalar(const int32_t *in, int32_t *out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = in[i] + 1;
+}
+
+#ifdef ADD_X86
+ADD_TARGET_SSE2
+static void add_batch_sse2(const int32_t *in, int32_t *out, size_t n) {
+    const __m128i one = _mm_set1_epi32(1);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_add_epi32(v, one));
+    }
+    add_batch_scalar(in + i, out + i, n - i);
+}
+
+ADD_TARGET_AVX2
+static void add_batch_avx2(const int32_t *in, int32_t *out, size_t n) {
+    const __m256i one = _mm256_set1_epi32(1);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_add_epi32(v, one));
+    }
+    add_batch_sse2(in + i, out + i, n - i);
+}
+
+static void cpuid(unsigned leaf, unsigned sub, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)sub);
+    for (int i = 0; i < 4; i++)
+        regs[i] = (unsigned)r[i];
+#else
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    __get_cpuid_count(leaf, sub, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+}
+
+// AVX2 needs the CPU flag and the OS saving YMM state (OSXSAVE + XCR0).
+static bool has_avx2() {
+    unsigned regs[4];
+
+    cpuid(0, 0, regs);
+    if (regs[0] < 7)
+        return false;
+    cpuid(1, 0, regs);
+    if (!(regs[2] & (1u << 27)) || !(regs[2] & (1u << 28)))
+        return false;
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+    if ((xcr0 & 6) != 6)
+        return false;
+    cpuid(7, 0, regs);
+    return (regs[1] & (1u << 5)) != 0;
+}
+
+static bool has_sse2() {
+    unsigned regs[4];
+
+    cpuid(1, 0, regs);
+    return (regs[3] & (1u << 26)) != 0;
+}
+#endif
+
+static AddKernel select_kernel() {
+#ifdef ADD_X86
+    if (has_avx2())
+        return add_batch_avx2;
+    if (has_sse2())
+        return add_batch_sse2;
+#endif
+    return add_batch_scalar;
+}
+
+ADD_API void TMS_STDCALL add_batch(const int32_t *in, int32_t *out, size_t n) {
+    static const AddKernel kernel = select_kernel();
+    kernel(in, out, n);
+}
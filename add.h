@@ -1,12 +1,29 @@
 #ifndef __MYDLL_H__
 #define __MYDLL_H__
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tmsstep.h"
+
+/* add.cpp defines ADD_EXPORTS; clients that link add.lib get the import */
+#ifdef ADD_EXPORTS
+    #define ADD_API TMS_STEP_EXPORT
+#else
+    #define ADD_API TMS_STEP_IMPORT
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
-    __declspec(dllexport) int __stdcall add(int x);
+    ADD_API int TMS_STDCALL add(int x);
+
+    /* Batch form of add: out[i] = add(in[i]) for i < n.  Uses AVX2 or SSE2
+       when the CPU has them, plain C otherwise.  in and out may alias. */
+    ADD_API void TMS_STDCALL add_batch(const int32_t *in, int32_t *out,
+                                       size_t n);
 #ifdef __cplusplus
 }
 #endif
 
-#endif // __MYDLL_H__
\ No newline at end of file
+#endif // __MYDLL_H__
@@ -0,0 +1,303 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    arena.cpp                                                        */
+/*                                                                           */
+/* PURPOSE: Arena allocator implementation.                                  */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+
+#include "arena.h"
+#include "strpool.h"
+
+using tms::StringPool;
+
+/*---------------------------------------------------------------------------*/
+/* Defines                                                                   */
+/*---------------------------------------------------------------------------*/
+static const size_t kAlign = 16;
+static const size_t kDefaultBlockSize = 64 * 1024;
+static const size_t kNumFreeLists = 16;   /* 16, 32, ... 256 bytes */
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+
+/* A block's header; its memory follows, kHeaderSize bytes in */
+struct ArenaBlock
+{
+    ArenaBlock *next;
+    size_t      size;                   /* bytes after the header */
+};
+
+static const size_t kHeaderSize =
+    (sizeof(ArenaBlock) + kAlign - 1) & ~(kAlign - 1);
+
+/* An object given back with ARN_Recycle */
+struct FreeObject
+{
+    FreeObject *next;
+};
+
+struct ArenaRec_Tag
+{
+    size_t      blockSize;
+    ArenaBlock *blocks;                 /* in use, the current one first */
+    ArenaBlock *spare;                  /* kept by ARN_Reset */
+    char       *cursor;                 /* into the current block */
+    char       *limit;
+    size_t      used;
+    size_t      held;
+    FreeObject *freeLists[kNumFreeLists];
+};
+
+/* Pointers to the interned paths' characters, compared by content */
+struct PathHash
+{
+    size_t operator() (const char *path) const
+        {
+        return StringPool::Hash (path, strlen (path));
+        }
+};
+
+struct PathEqual
+{
+    bool operator() (const char *a, const char *b) const
+        {
+        return strcmp (a, b) == 0;
+        }
+};
+
+/*---------------------------------------------------------------------------*/
+/* Create an arena.  No memory is taken until the first allocation.          */
+/*---------------------------------------------------------------------------*/
+Arena ARN_New (size_t blockSize)
+{
+    Arena arena = (Arena)calloc (1, sizeof(*arena));
+
+    if (!arena)
+        return 0;
+    if (!blockSize)
+        blockSize = kDefaultBlockSize;
+    arena->blockSize = (blockSize + kAlign - 1) & ~(kAlign - 1);
+    return arena;
+}
+
+static void FreeBlocks (ArenaBlock *block)
+{
+    while (block)
+        {
+        ArenaBlock *next = block->next;
+
+        free (block);
+        block = next;
+        }
+}
+
+void ARN_Dispose (Arena arena)
+{
+    if (!arena)
+        return;
+    FreeBlocks (arena->blocks);
+    FreeBlocks (arena->spare);
+    free (arena);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Take a block of size bytes (after the header) from the heap.              */
+/*---------------------------------------------------------------------------*/
+static ArenaBlock *NewBlock (Arena arena, size_t size)
+{
+    ArenaBlock *block = (ArenaBlock *)malloc (kHeaderSize + size);
+
+    if (!block)
+        return 0;
+    block->next = 0;
+    block->size = size;
+    arena->held += kHeaderSize + size;
+    return block;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Bump the cursor, moving on to a spare or new block when the current one   */
+/* is full.  A request bigger than a block gets its own, placed behind the   */
+/* current block so that block's remainder is still used.                    */
+/*---------------------------------------------------------------------------*/
+void *ARN_Alloc (Arena arena, size_t numBytes)
+{
+    ArenaBlock *block;
+    size_t      size;
+    char       *object;
+
+    if (!arena)
+        return 0;
+    size = numBytes ? (numBytes + kAlign - 1) & ~(kAlign - 1) : kAlign;
+    if (size < numBytes)
+        return 0;
+    if (size <= kNumFreeLists * kAlign && arena->freeLists[size / kAlign - 1])
+        {
+        FreeObject *recycled = arena->freeLists[size / kAlign - 1];
+
+        arena->freeLists[size / kAlign - 1] = recycled->next;
+        arena->used += size;
+        return recycled;
+        }
+    if ((size_t)(arena->limit - arena->cursor) >= size)
+        {
+        object = arena->cursor;
+        arena->cursor += size;
+        arena->used += size;
+        return object;
+        }
+
+    if (size > arena->blockSize)
+        {
+        if (size > (size_t)-1 - kHeaderSize
+            || !(block = NewBlock (arena, size)))
+            return 0;
+        if (arena->blocks)
+            {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+            }
+        else
+            arena->blocks = block;
+        arena->used += size;
+        return (char *)block + kHeaderSize;
+        }
+
+    if ((block = arena->spare) != 0)
+        arena->spare = block->next;
+    else if (!(block = NewBlock (arena, arena->blockSize)))
+        return 0;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    object = (char *)block + kHeaderSize;
+    arena->cursor = object + size;
+    arena->limit = object + block->size;
+    arena->used += size;
+    return object;
+}
+
+void *ARN_Calloc (Arena arena, size_t numBytes)
+{
+    void *object = ARN_Alloc (arena, numBytes);
+
+    if (object)
+        memset (object, 0, numBytes);
+    return object;
+}
+
+char *ARN_StrDup (Arena arena, const char *str)
+{
+    size_t len;
+    char  *copy;
+
+    if (!str)
+        return 0;
+    len = strlen (str);
+    if ((copy = (char *)ARN_Alloc (arena, len + 1)) != 0)
+        memcpy (copy, str, len + 1);
+    return copy;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Put a small object on the free list of its size.                          */
+/*---------------------------------------------------------------------------*/
+void ARN_Recycle (Arena arena, void *object, size_t numBytes)
+{
+    FreeObject *recycled = (FreeObject *)object;
+    size_t      size;
+
+    if (!arena || !object)
+        return;
+    size = numBytes ? (numBytes + kAlign - 1) & ~(kAlign - 1) : kAlign;
+    if (size > kNumFreeLists * kAlign)
+        return;
+    recycled->next = arena->freeLists[size / kAlign - 1];
+    arena->freeLists[size / kAlign - 1] = recycled;
+    arena->used -= size;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Keep the blocks of the usual size as spares and free the others.          */
+/*---------------------------------------------------------------------------*/
+void ARN_Reset (Arena arena)
+{
+    ArenaBlock *block;
+    size_t      i;
+
+    if (!arena)
+        return;
+    while ((block = arena->blocks) != 0)
+        {
+        arena->blocks = block->next;
+        if (block->size == arena->blockSize)
+            {
+            block->next = arena->spare;
+            arena->spare = block;
+            }
+        else
+            {
+            arena->held -= kHeaderSize + block->size;
+            free (block);
+            }
+        }
+    for (i = 0; i < kNumFreeLists; i++)
+        arena->freeLists[i] = 0;
+    arena->cursor = 0;
+    arena->limit = 0;
+    arena->used = 0;
+}
+
+size_t ARN_BytesUsed (Arena arena)
+{
+    return arena ? arena->used : 0;
+}
+
+size_t ARN_BytesHeld (Arena arena)
+{
+    return arena ? arena->held : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Look path up in the process's table, copying it into the path arena the   */
+/* first time.  Neither is ever freed, so the pointers stay good.            */
+/*---------------------------------------------------------------------------*/
+const char *ARN_InternPath (const char *path)
+{
+    static std::mutex lock;
+    static Arena      paths;
+    static std::unordered_set<const char *, PathHash, PathEqual> *table;
+    std::lock_guard<std::mutex> guard (lock);
+    char *copy;
+
+    if (!path)
+        return 0;
+    try
+        {
+        if (!table)
+            table = new std::unordered_set<const char *, PathHash,
+                                           PathEqual> ();
+        if (!paths && !(paths = ARN_New (4096)))
+            return 0;
+
+        std::unordered_set<const char *, PathHash, PathEqual>::iterator it
+            = table->find (path);
+        if (it != table->end ())
+            return *it;
+        if (!(copy = ARN_StrDup (paths, path)))
+            return 0;
+        table->insert (copy);
+        return copy;
+        }
+    catch (const std::bad_alloc &)
+        {
+        return 0;
+        }
+}
@@ -0,0 +1,69 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    arena.h                                                          */
+/*                                                                           */
+/* PURPOSE: Arena allocation for short-lived and per-document data.  An      */
+/*          arena hands out memory from large blocks by bumping a pointer,   */
+/*          and gives all of it back at once with ARN_Reset, which keeps     */
+/*          the blocks for the next run instead of returning them to the     */
+/*          heap.  Small objects that die one at a time can be recycled      */
+/*          into the arena and are handed out again before new memory is.    */
+/*          Paths are interned for the life of the process, so menu items    */
+/*          and the like can point at them without copying or freeing.       */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+#include "tmsapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct ArenaRec_Tag *Arena;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+
+/* An arena taking blockSize bytes from the heap at a time (0 for 64 KB) */
+TMS_API Arena       ARN_New        (size_t blockSize);
+TMS_API void        ARN_Dispose    (Arena arena);
+
+/* numBytes aligned for any type, valid until the next ARN_Reset; 0 if  */
+/* out of memory.  Requests larger than a block get a block of their    */
+/* own.                                                                 */
+TMS_API void       *ARN_Alloc      (Arena arena, size_t numBytes);
+TMS_API void       *ARN_Calloc     (Arena arena, size_t numBytes);
+TMS_API char       *ARN_StrDup     (Arena arena, const char *str);
+
+/* Give back an object of numBytes from ARN_Alloc, for the next         */
+/* ARN_Alloc of the same size to reuse.  Objects over 256 bytes are     */
+/* only given back by ARN_Reset.                                        */
+TMS_API void        ARN_Recycle    (Arena arena, void *object,
+                                    size_t numBytes);
+
+/* Free everything allocated, keeping the blocks (bar those of larger   */
+/* requests) for the allocations that follow                            */
+TMS_API void        ARN_Reset      (Arena arena);
+
+/* Bytes handed out since the last reset, and bytes held from the heap */
+TMS_API size_t      ARN_BytesUsed  (Arena arena);
+TMS_API size_t      ARN_BytesHeld  (Arena arena);
+
+/* The one copy of path, the same pointer every time for the same path, */
+/* that lives as long as the process.  Thread safe.  0 if out of        */
+/* memory.                                                              */
+TMS_API const char *ARN_InternPath (const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ARENA_H__ */
@@ -0,0 +1,402 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    asyncstep.cpp                                                    */
+/*                                                                           */
+/* PURPOSE: Asynchronous steps and the I/O thread they wait on.  See         */
+/*          asyncstep.h.                                                     */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <limits.h>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+  #include <errno.h>
+  #include <sys/epoll.h>
+  #include <sys/eventfd.h>
+  #include <unistd.h>
+#endif
+
+#include "asyncstep.h"
+
+namespace tms {
+
+/*---------------------------------------------------------------------------*/
+/* Pool callback: carry on with a step whose wait is over.                   */
+/*---------------------------------------------------------------------------*/
+static void ResumeStep (void *context, int, int)
+{
+    StepTask::Handle::from_address (context).resume ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Hold the group for the step's lifetime and run it to its first wait.      */
+/*---------------------------------------------------------------------------*/
+void StepTask::Start (WorkPool &pool, TaskGroup &group, StepDoneFunc done,
+                      void *context, int index)
+{
+    Handle handle = m_handle;
+
+    m_handle = Handle ();
+    handle.promise ().pool = &pool;
+    handle.promise ().group = &group;
+    handle.promise ().done = done;
+    handle.promise ().context = context;
+    handle.promise ().index = index;
+    pool.Hold (group);
+    handle.resume ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* The step has finished: report it, free it, and let its group go.          */
+/*---------------------------------------------------------------------------*/
+void StepTask::FinalAwaiter::await_suspend (Handle handle) noexcept
+{
+    promise_type &promise = handle.promise ();
+    WorkPool     *pool = promise.pool;
+    TaskGroup    *group = promise.group;
+
+    promise.done (promise.context, promise.index, promise.value,
+                  promise.completed);
+    handle.destroy ();
+    pool->Release (*group);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Run a step to the end, resuming it on this thread if no worker does.      */
+/*---------------------------------------------------------------------------*/
+struct StepResult
+{
+    int32_t value;
+};
+
+static void StoreResult (void *context, int, int32_t value, int completed)
+{
+    ((StepResult *)context)->value = completed ? value : INT32_MIN;
+}
+
+int32_t RunStepTask (StepTask task)
+{
+    WorkPool  &pool = WorkPool::Instance ();
+    TaskGroup  group;
+    StepResult result = { INT32_MIN };
+
+    task.Start (pool, group, StoreResult, &result, 0);
+    pool.Wait (group);
+    return result.value;
+}
+
+#if defined(__linux__)
+
+/*---------------------------------------------------------------------------*/
+/* Post to and empty the I/O thread's eventfd.                               */
+/*---------------------------------------------------------------------------*/
+static void WakeUp (int fd)
+{
+    uint64_t one = 1;
+    ssize_t  written = write (fd, &one, sizeof(one));
+
+    (void)written;
+}
+
+static void Drain (int fd)
+{
+    uint64_t count;
+    ssize_t  numRead = read (fd, &count, sizeof(count));
+
+    (void)numRead;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The I/O thread: one epoll set for every waiting descriptor and a heap of  */
+/* deadlines.  Waits are known by id, so a wait that has finished one way    */
+/* (ready, timed out) is simply not found when the other comes round.        */
+/*---------------------------------------------------------------------------*/
+class IoReactor
+{
+public:
+    IoReactor ();
+
+    static IoReactor &Instance ();
+
+    /* End the I/O thread.  Waits still pending end as timed out, and */
+    /* later ones carry straight on, so every step can still finish.   */
+    void Stop ();
+
+    /* Watch fd (or only the clock for fd -1); false if it cannot be */
+    bool Add (IoWait *wait, int fd, int events, int timeoutMs);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Waiting
+    {
+        IoWait *wait;
+        int     fd;
+    };
+
+    struct Deadline
+    {
+        Clock::time_point when;
+        uint64_t          id;
+
+        bool operator> (const Deadline &other) const
+            {
+            return when > other.when;
+            }
+    };
+
+    void Run ();
+    void Finish (uint64_t id, bool ready);
+
+    static IoReactor *Create ();
+    static void       StopHook (void *context);
+
+    int                   m_epoll;
+    int                   m_wake;       /* eventfd: a new deadline */
+    std::mutex            m_lock;
+    std::unordered_map<uint64_t, Waiting> m_waiting;
+    std::priority_queue<Deadline, std::vector<Deadline>,
+                        std::greater<Deadline> > m_deadlines;
+    uint64_t              m_nextId;
+    bool                  m_stop;
+    std::thread           m_thread;
+};
+
+IoReactor::IoReactor ()
+    : m_epoll (epoll_create1 (EPOLL_CLOEXEC)),
+      m_wake (eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK)), m_nextId (1),
+      m_stop (false)
+{
+    struct epoll_event event = {};
+
+    if (m_epoll < 0 || m_wake < 0)
+        return;
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    epoll_ctl (m_epoll, EPOLL_CTL_ADD, m_wake, &event);
+    m_thread = std::thread (&IoReactor::Run, this);
+}
+
+void IoReactor::Stop ()
+{
+    {
+    std::lock_guard<std::mutex> guard (m_lock);
+    if (m_stop)
+        return;
+    m_stop = true;
+    }
+    if (m_thread.joinable ())
+        {
+        WakeUp (m_wake);
+        m_thread.join ();
+        }
+    while (!m_waiting.empty ())
+        Finish (m_waiting.begin ()->first, false);
+}
+
+void IoReactor::StopHook (void *context)
+{
+    ((IoReactor *)context)->Stop ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Started the first time a step waits.  Not a static object: the I/O thread */
+/* queues resumed steps on the shared pool, so the pool's destructor stops   */
+/* it, before taking the workers down, rather than the order statics happen  */
+/* to be destroyed in.  If the hook cannot be registered, steps do not wait  */
+/* on the thread at all.                                                     */
+/*---------------------------------------------------------------------------*/
+IoReactor *IoReactor::Create ()
+{
+    IoReactor *reactor = new IoReactor;
+
+    try
+        {
+        WorkPool::Instance ().AtStop (StopHook, reactor);
+        }
+    catch (const std::bad_alloc &)
+        {
+        reactor->Stop ();
+        }
+    return reactor;
+}
+
+IoReactor &IoReactor::Instance ()
+{
+    static IoReactor *reactor = Create ();
+    return *reactor;
+}
+
+bool IoReactor::Add (IoWait *wait, int fd, int events, int timeoutMs)
+{
+    std::lock_guard<std::mutex> guard (m_lock);
+    uint64_t                    id = 0;
+    Waiting                     waiting = { wait, fd };
+
+    if (!m_thread.joinable () || m_stop)
+        return false;
+    try
+        {
+        id = m_nextId++;
+        m_waiting.insert (std::make_pair (id, waiting));
+        if (fd >= 0)
+            {
+            struct epoll_event event = {};
+
+            event.events = (uint32_t)EPOLLONESHOT
+                           | ((events & IoWait::kRead) ? (uint32_t)EPOLLIN
+                                                       : 0u)
+                           | ((events & IoWait::kWrite) ? (uint32_t)EPOLLOUT
+                                                        : 0u);
+            event.data.u64 = id;
+            if (epoll_ctl (m_epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+                {
+                m_waiting.erase (id);
+                return false;
+                }
+            }
+        if (timeoutMs >= 0)
+            {
+            Deadline deadline = { Clock::now ()
+                                  + std::chrono::milliseconds (timeoutMs),
+                                  id };
+
+            m_deadlines.push (deadline);
+            WakeUp (m_wake);
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        m_waiting.erase (id);
+        if (fd >= 0)
+            epoll_ctl (m_epoll, EPOLL_CTL_DEL, fd, 0);
+        return false;
+        }
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* End a wait, if it has not ended already, and resume its step.  Called on  */
+/* the I/O thread.                                                           */
+/*---------------------------------------------------------------------------*/
+void IoReactor::Finish (uint64_t id, bool ready)
+{
+    IoWait *wait;
+
+    {
+    std::lock_guard<std::mutex> guard (m_lock);
+    std::unordered_map<uint64_t, Waiting>::iterator it = m_waiting.find (id);
+
+    if (it == m_waiting.end ())
+        return;
+    wait = it->second.wait;
+    if (it->second.fd >= 0)
+        epoll_ctl (m_epoll, EPOLL_CTL_DEL, it->second.fd, 0);
+    m_waiting.erase (it);
+    }
+    wait->Finish (ready);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Wait for descriptors until the nearest deadline, then end the waits that  */
+/* are ready and those whose deadline has passed.                            */
+/*---------------------------------------------------------------------------*/
+void IoReactor::Run ()
+{
+    struct epoll_event events[64];
+    int                timeoutMs;
+    int                numEvents;
+    int                i;
+
+    for (;;)
+        {
+        {
+        std::lock_guard<std::mutex> guard (m_lock);
+
+        if (m_stop)
+            return;
+        timeoutMs = -1;
+        if (!m_deadlines.empty ())
+            {
+            Clock::duration left = m_deadlines.top ().when - Clock::now ();
+
+            /* Round up so the deadline has passed on waking */
+            timeoutMs = left.count () <= 0 ? 0
+                : (int)std::chrono::ceil<std::chrono::milliseconds> (
+                      left).count ();
+            }
+        }
+        numEvents = epoll_wait (m_epoll, events, 64, timeoutMs);
+        if (numEvents < 0 && errno != EINTR)
+            return;
+        for (i = 0; i < numEvents; i++)
+            if (events[i].data.u64)
+                Finish (events[i].data.u64, true);
+            else
+                Drain (m_wake);
+        for (;;)
+            {
+            uint64_t id;
+
+            {
+            std::lock_guard<std::mutex> guard (m_lock);
+
+            if (m_deadlines.empty ()
+                || m_deadlines.top ().when > Clock::now ())
+                break;
+            id = m_deadlines.top ().id;
+            m_deadlines.pop ();
+            }
+            Finish (id, false);
+            }
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Hand the wait to the I/O thread, or carry straight on if it cannot take   */
+/* it (the descriptor already has a wait, or is a regular file).             */
+/*---------------------------------------------------------------------------*/
+bool IoWait::await_suspend (StepTask::Handle handle)
+{
+    m_handle = handle;
+    if (IoReactor::Instance ().Add (this, m_fd, m_events, m_timeoutMs))
+        return true;
+    m_ready = m_fd >= 0;
+    return false;
+}
+
+#else
+
+/*---------------------------------------------------------------------------*/
+/* No I/O thread: a descriptor is taken to be ready and a sleep blocks.      */
+/*---------------------------------------------------------------------------*/
+bool IoWait::await_suspend (StepTask::Handle handle)
+{
+    (void)handle;
+    if (m_fd < 0)
+        std::this_thread::sleep_for (std::chrono::milliseconds (m_timeoutMs));
+    m_ready = m_fd >= 0;
+    return false;
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* The wait is over: queue the rest of the step on its pool.                 */
+/*---------------------------------------------------------------------------*/
+void IoWait::Finish (bool ready)
+{
+    StepTask::promise_type &promise = m_handle.promise ();
+
+    m_ready = ready;
+    promise.pool->Submit (*promise.group, ResumeStep, m_handle.address ());
+}
+
+} /* namespace tms */
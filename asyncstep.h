@@ -0,0 +1,158 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    asyncstep.h                                                      */
+/*                                                                           */
+/* PURPOSE: Asynchronous steps.  A step that spends its time waiting on an   */
+/*          instrument is written as a C++20 coroutine returning StepTask    */
+/*          and co_awaits the wait (Readable, Writable, SleepFor) instead of */
+/*          blocking in it.  While it waits the worker that started it goes  */
+/*          on to other steps; one I/O thread watches every waiting step's   */
+/*          descriptor or timer, and when it is ready the step carries on    */
+/*          on a pool worker.  Thousands of steps can be in flight on a few  */
+/*          threads.  Async steps are built in (builtin.h).  The waits use   */
+/*          epoll, so on platforms other than Linux they return at once and  */
+/*          the I/O that follows blocks as before.  C++ only.                */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __ASYNCSTEP_H__
+#define __ASYNCSTEP_H__
+
+#include <coroutine>
+#include <stdint.h>
+
+#include "workpool.h"
+
+namespace tms {
+
+/* Called once a step started with StepTask::Start has finished: value is */
+/* what it returned, completed 0 if it threw instead                      */
+typedef void (*StepDoneFunc) (void *context, int index, int32_t value,
+                              int completed);
+
+/*---------------------------------------------------------------------------*/
+/* The coroutine an async step is.  It does not run until Started; from      */
+/* then on it owns itself, holds its task group open until it finishes,      */
+/* and frees itself after calling done.                                      */
+/*---------------------------------------------------------------------------*/
+class StepTask
+{
+public:
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    struct FinalAwaiter
+    {
+        bool await_ready () const noexcept { return false; }
+        void await_suspend (Handle handle) noexcept;
+        void await_resume () const noexcept {}
+    };
+
+    struct promise_type
+    {
+        WorkPool     *pool;
+        TaskGroup    *group;
+        StepDoneFunc  done;
+        void         *context;
+        int           index;
+        int32_t       value;
+        int           completed;
+
+        promise_type ()
+            : pool (0), group (0), done (0), context (0), index (0),
+              value (0), completed (0) {}
+
+        StepTask get_return_object ()
+            {
+            return StepTask (Handle::from_promise (*this));
+            }
+        std::suspend_always initial_suspend () const noexcept { return {}; }
+        FinalAwaiter final_suspend () const noexcept { return {}; }
+        void return_value (int32_t result)
+            {
+            value = result;
+            completed = 1;
+            }
+        void unhandled_exception () { completed = 0; }
+    };
+
+    StepTask () {}
+    StepTask (StepTask &&other) : m_handle (other.m_handle)
+        {
+        other.m_handle = Handle ();
+        }
+    ~StepTask ()
+        {
+        if (m_handle)
+            m_handle.destroy ();
+        }
+
+    /* Run the step until its first wait (or to the end) on this thread.  */
+    /* It is resumed on pool, counts as a task of group, and calls        */
+    /* done (context, index, ...) when it finishes.                       */
+    void Start (WorkPool &pool, TaskGroup &group, StepDoneFunc done,
+                void *context, int index);
+
+private:
+    explicit StepTask (Handle handle) : m_handle (handle) {}
+    StepTask (const StepTask &);
+    StepTask &operator= (const StepTask &);
+
+    Handle m_handle;
+};
+
+/* Start task on the shared pool and wait for it, for callers that need the */
+/* value now (batch and sweep loops).  INT32_MIN if the step threw.         */
+int32_t RunStepTask (StepTask task);
+
+/*---------------------------------------------------------------------------*/
+/* What a step can wait for.  co_await gives true when the descriptor is     */
+/* ready, false when timeoutMs (-1 for none) ran out first.  A descriptor    */
+/* can have one wait at a time.                                              */
+/*---------------------------------------------------------------------------*/
+class IoWait
+{
+public:
+    enum { kRead = 1, kWrite = 2 };
+
+    IoWait (int fd, int events, int timeoutMs)
+        : m_fd (fd), m_events (events), m_timeoutMs (timeoutMs),
+          m_ready (false) {}
+
+    bool await_ready () const { return false; }
+    bool await_suspend (StepTask::Handle handle);
+    bool await_resume () const { return m_ready; }
+
+    /* Called on the I/O thread: record the outcome and resume the step */
+    void Finish (bool ready);
+
+private:
+    int              m_fd;
+    int              m_events;
+    int              m_timeoutMs;
+    bool             m_ready;
+    StepTask::Handle m_handle;
+};
+
+inline IoWait Readable (int fd, int timeoutMs = -1)
+{
+    return IoWait (fd, IoWait::kRead, timeoutMs);
+}
+
+inline IoWait Writable (int fd, int timeoutMs = -1)
+{
+    return IoWait (fd, IoWait::kWrite, timeoutMs);
+}
+
+/* Resume after milliseconds; co_await gives false */
+inline IoWait SleepFor (int milliseconds)
+{
+    return IoWait (-1, 0, milliseconds < 0 ? 0 : milliseconds);
+}
+
+} /* namespace tms */
+
+/* An async step: socket is -1 outside a socket set */
+typedef tms::StepTask (*SeqAsyncFunc) (int socket, int x);
+
+#endif /* __ASYNCSTEP_H__ */
@@ -0,0 +1,59 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    builtin.cpp                                                      */
+/*                                                                           */
+/* PURPOSE: The built-in step table.  See builtin.h.                         */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "builtin.h"
+
+namespace tms {
+
+/*---------------------------------------------------------------------------*/
+/* In-tree step modules.  Keep each in step with the module it stands in for */
+/* (add.cpp): a sequence naming the module gets these, not the module.       */
+/*---------------------------------------------------------------------------*/
+static inline int Add (int x)
+{
+    return x + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Steps of the engine's own.  wait pauses for x milliseconds -- letting an  */
+/* instrument settle, say -- without holding a thread, and returns x.        */
+/*---------------------------------------------------------------------------*/
+static StepTask Wait (int socket, int x)
+{
+    (void)socket;
+    co_await SleepFor (x);
+    co_return x;
+}
+
+static const BuiltinStepEntry kBuiltinSteps[] =
+{
+    TMS_BUILTIN_STEP ("add", "add", Add),
+    TMS_BUILTIN_ASYNC_STEP ("tms", "wait", Wait),
+};
+
+/*---------------------------------------------------------------------------*/
+/* Look a step up by module and symbol.  The table is a handful of rows and  */
+/* binding looks each (module, symbol) pair up once, so a scan will do.      */
+/*---------------------------------------------------------------------------*/
+const BuiltinStepEntry *FindBuiltinStep (const char *module,
+                                         const char *symbol)
+{
+    size_t i;
+
+    if (!module || !symbol)
+        return 0;
+    for (i = 0; i < sizeof(kBuiltinSteps) / sizeof(kBuiltinSteps[0]); i++)
+        if (strcmp (kBuiltinSteps[i].module, module) == 0
+            && strcmp (kBuiltinSteps[i].symbol, symbol) == 0)
+            return &kBuiltinSteps[i];
+    return 0;
+}
+
+} /* namespace tms */
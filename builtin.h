@@ -0,0 +1,260 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    builtin.h                                                        */
+/*                                                                           */
+/* PURPOSE: Built-in steps: test steps compiled into the engine instead of   */
+/*          loaded from a module.  A step is registered as a plain C++       */
+/*          function of one argument (or of a socket and one argument) of    */
+/*          any arithmetic type, and the templates below generate its entry  */
+/*          points at compile time: converting the argument, converting the  */
+/*          result to a value that can be judged against the step's limits,  */
+/*          and a batch form whose loop has the function inlined in it.      */
+/*          A step that waits on an instrument can be a coroutine instead    */
+/*          (asyncstep.h), which the executor runs without tying up a        */
+/*          thread while it waits.                                           */
+/*          PLG_BindSequence binds steps naming a built-in module to them    */
+/*          instead of opening the module; other modules are loaded as       */
+/*          before.  C++ only.                                               */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __BUILTIN_H__
+#define __BUILTIN_H__
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include "asyncstep.h"
+#include "sequence.h"
+
+namespace tms {
+
+/*---------------------------------------------------------------------------*/
+/* Marshalling.  The argument is converted from int32_t as C would.  The     */
+/* result saturates to int32_t (floating point rounds to nearest, NaN gives  */
+/* INT32_MIN) so a value out of range still fails its limits instead of      */
+/* wrapping into them; bool gives 0 or 1.                                    */
+/*---------------------------------------------------------------------------*/
+template <typename T>
+inline T FromStepValue (int32_t x)
+{
+    return static_cast<T> (x);
+}
+
+template <typename T>
+inline int32_t ToStepValue (T value)
+{
+    static_assert (std::is_arithmetic<T>::value,
+                   "a built-in step must return an arithmetic type or void");
+
+    if constexpr (std::is_same<T, bool>::value)
+        return value ? 1 : 0;
+    else if constexpr (std::is_floating_point<T>::value)
+        {
+        if (!(value == value) || value <= (T)INT32_MIN)
+            return INT32_MIN;
+        if (value >= (T)INT32_MAX)
+            return INT32_MAX;
+        return (int32_t)(value < 0 ? value - (T)0.5 : value + (T)0.5);
+        }
+    else if constexpr (std::is_signed<T>::value)
+        {
+        if constexpr (sizeof(T) > sizeof(int32_t))
+            {
+            if (value < (T)INT32_MIN)
+                return INT32_MIN;
+            if (value > (T)INT32_MAX)
+                return INT32_MAX;
+            }
+        return (int32_t)value;
+        }
+    else
+        {
+        if constexpr (sizeof(T) >= sizeof(int32_t))
+            {
+            if (value > (T)INT32_MAX)
+                return INT32_MAX;
+            }
+        return (int32_t)value;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Signatures a built-in step may have.  Call invokes F with socket (for     */
+/* the two-argument form) and x converted to its parameter type.             */
+/*---------------------------------------------------------------------------*/
+template <typename F>
+struct StepSignature;
+
+template <typename R, typename A>
+struct StepSignature<R (*) (A)>
+{
+    typedef R Result;
+    static const bool kSocket = false;
+
+    template <R (*F) (A)>
+    static R Call (int socket, int32_t x)
+        {
+        (void)socket;
+        return F (FromStepValue<A> (x));
+        }
+};
+
+template <typename R, typename S, typename A>
+struct StepSignature<R (*) (S, A)>
+{
+    typedef R Result;
+    static const bool kSocket = true;
+
+    template <R (*F) (S, A)>
+    static R Call (int socket, int32_t x)
+        {
+        return F (static_cast<S> (socket), FromStepValue<A> (x));
+        }
+};
+
+#if defined(_WIN32) && (defined(_M_IX86) || defined(__i386__))
+/* On 32-bit Windows __stdcall is part of the type; elsewhere it is the */
+/* default convention and these would repeat the ones above             */
+template <typename R, typename A>
+struct StepSignature<R (__stdcall *) (A)>
+{
+    typedef R Result;
+    static const bool kSocket = false;
+
+    template <R (__stdcall *F) (A)>
+    static R Call (int socket, int32_t x)
+        {
+        (void)socket;
+        return F (FromStepValue<A> (x));
+        }
+};
+
+template <typename R, typename S, typename A>
+struct StepSignature<R (__stdcall *) (S, A)>
+{
+    typedef R Result;
+    static const bool kSocket = true;
+
+    template <R (__stdcall *F) (S, A)>
+    static R Call (int socket, int32_t x)
+        {
+        return F (static_cast<S> (socket), FromStepValue<A> (x));
+        }
+};
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* The entry points generated for Function, with the signatures the          */
+/* sequence's step table holds.  A socket step is called with socket -1      */
+/* outside a socket set.  Batch's loop calls Function directly, so the       */
+/* compiler can inline and vectorize it.                                     */
+/*---------------------------------------------------------------------------*/
+template <auto Function>
+struct BuiltinStep
+{
+    typedef StepSignature<decltype (Function)> Signature;
+    typedef typename Signature::Result         Result;
+
+    static int32_t Value (int socket, int32_t x)
+        {
+        if constexpr (std::is_void<Result>::value)
+            {
+            Signature::template Call<Function> (socket, x);
+            return 0;
+            }
+        else
+            return ToStepValue (Signature::template Call<Function> (socket,
+                                                                     x));
+        }
+
+    static int TMS_STDCALL Scalar (int x)
+        {
+        return Value (-1, x);
+        }
+
+    static int TMS_STDCALL Socket (int socket, int x)
+        {
+        return Value (socket, x);
+        }
+
+    static void TMS_STDCALL Batch (const int32_t *in, int32_t *out,
+                                   size_t n)
+        {
+        size_t i;
+
+        for (i = 0; i < n; i++)
+            out[i] = Value (-1, in[i]);
+        }
+};
+
+/*---------------------------------------------------------------------------*/
+/* One row of the built-in step table (builtin.cpp)                          */
+/*---------------------------------------------------------------------------*/
+struct BuiltinStepEntry
+{
+    const char    *module;
+    const char    *symbol;
+    SeqStepFunc    func;
+    SeqBatchFunc   batch;
+    SeqSocketFunc  socketFunc;              /* 0 for one-argument steps */
+    SeqAsyncFunc   asyncFunc;               /* 0 but for async steps */
+};
+
+template <auto Function>
+inline BuiltinStepEntry MakeBuiltinStep (const char *module,
+                                         const char *symbol)
+{
+    typedef BuiltinStep<Function> Step;
+    BuiltinStepEntry entry = { module, symbol, Step::Scalar, Step::Batch,
+                               Step::Signature::kSocket ? Step::Socket : 0,
+                               0 };
+
+    return entry;
+}
+
+#define TMS_BUILTIN_STEP(module, symbol, function) \
+    tms::MakeBuiltinStep<&function> (module, symbol)
+
+/*---------------------------------------------------------------------------*/
+/* An async step, StepTask f (int socket, int x).  The executor starts it    */
+/* and moves on; its plain entry points, for loops that need the value at    */
+/* once (sweeps), run it to the end.                                         */
+/*---------------------------------------------------------------------------*/
+template <SeqAsyncFunc Function>
+struct BuiltinAsyncStep
+{
+    static int TMS_STDCALL Scalar (int x)
+        {
+        return RunStepTask (Function (-1, x));
+        }
+
+    static int TMS_STDCALL Socket (int socket, int x)
+        {
+        return RunStepTask (Function (socket, x));
+        }
+};
+
+template <SeqAsyncFunc Function>
+inline BuiltinStepEntry MakeBuiltinAsyncStep (const char *module,
+                                              const char *symbol)
+{
+    typedef BuiltinAsyncStep<Function> Step;
+    BuiltinStepEntry entry = { module, symbol, Step::Scalar, 0,
+                               Step::Socket, Function };
+
+    return entry;
+}
+
+#define TMS_BUILTIN_ASYNC_STEP(module, symbol, function) \
+    tms::MakeBuiltinAsyncStep<&function> (module, symbol)
+
+/* The built-in step for symbol of module, or 0 if there is none */
+const BuiltinStepEntry *FindBuiltinStep (const char *module,
+                                         const char *symbol);
+
+} /* namespace tms */
+
+#endif /* __BUILTIN_H__ */
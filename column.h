@@ -0,0 +1,107 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    column.h                                                         */
+/*                                                                           */
+/* PURPOSE: One column of a step table.  A column either owns its elements  */
+/*          or borrows read-only memory -- a section of a mapped sequence    */
+/*          file -- without copying it.  Reads never copy; the first change  */
+/*          to a borrowed column copies it into storage of its own.  Only   */
+/*          const element access is offered, so a read through a non-const  */
+/*          table cannot trigger the copy by accident.  C++ only.            */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __COLUMN_H__
+#define __COLUMN_H__
+
+#include <stddef.h>
+#include <vector>
+
+namespace tms {
+
+template <typename T>
+class Column
+{
+public:
+    Column () : m_data (0), m_size (0), m_borrowed (false) {}
+    Column (const Column &other) : m_data (0), m_size (0), m_borrowed (false)
+        {
+        *this = other;
+        }
+
+    Column &operator= (const Column &other)
+        {
+        if (this != &other)
+            {
+            m_owned.assign (other.m_data, other.m_data + other.m_size);
+            m_borrowed = false;
+            Sync ();
+            }
+        return *this;
+        }
+
+    size_t   size () const { return m_size; }
+    bool     empty () const { return m_size == 0; }
+    const T *data () const { return m_data; }
+    const T &operator[] (size_t i) const { return m_data[i]; }
+    bool     Borrowed () const { return m_borrowed; }
+
+    /* Use count elements at view in place.  They must stay valid until */
+    /* the column is changed or destroyed.                              */
+    void Borrow (const T *view, size_t count)
+        {
+        std::vector<T> ().swap (m_owned);
+        m_data = view;
+        m_size = count;
+        m_borrowed = true;
+        }
+
+    /* Changes.  A borrowed column is copied first. */
+    T   *MutableData ()          { Own (); return m_owned.data (); }
+    T   &At (size_t i)           { Own (); return m_owned[i]; }
+    void resize (size_t n)       { Own (); m_owned.resize (n); Sync (); }
+    void reserve (size_t n)      { Own (); m_owned.reserve (n); Sync (); }
+    void clear ()
+        {
+        m_owned.clear ();
+        m_borrowed = false;
+        Sync ();
+        }
+    void push_back (const T &value)
+        {
+        Own ();
+        m_owned.push_back (value);
+        Sync ();
+        }
+    void append (const T *first, const T *last)
+        {
+        Own ();
+        m_owned.insert (m_owned.end (), first, last);
+        Sync ();
+        }
+
+private:
+    void Own ()
+        {
+        if (m_borrowed)
+            {
+            m_owned.assign (m_data, m_data + m_size);
+            m_borrowed = false;
+            Sync ();
+            }
+        }
+    void Sync ()
+        {
+        m_data = m_owned.data ();
+        m_size = m_owned.size ();
+        }
+
+    std::vector<T> m_owned;
+    const T       *m_data;      /* m_owned's elements, or the borrowed view */
+    size_t         m_size;
+    bool           m_borrowed;
+};
+
+} /* namespace tms */
+
+#endif /* __COLUMN_H__ */
@@ -0,0 +1,1570 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    docctl.c                                                         */
+/*                                                                           */
+/* PURPOSE: Document controller.  See docctl.h.                              */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/* Include files                                                             */
+/*---------------------------------------------------------------------------*/
+#include <ctype.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "docctl.h"
+#include "undo.h"
+#include "findidx.h"
+#include "arena.h"
+
+/*---------------------------------------------------------------------------*/
+/* Defines                                                                   */
+/*---------------------------------------------------------------------------*/
+
+/* Memory each document's Undo history may hold before old edits go */
+#define UNDO_BUDGET_BYTES   ((size_t)16 * 1024 * 1024)
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct DocControllerRec_Tag
+{
+    const UiBackend *ui;
+    int              parentPanel;
+    DocRegistry      docs;
+    Execution        exec;
+    SocketSet        sockets;           /* 0 until DCT_SetNumSockets */
+    StepHost         host;              /* Step mode's; 0 for in process */
+    char            *hostPath;          /* 0 for in process */
+    PluginLoader     plugins;
+    SessionLog       session;
+    int              topLeftValue;
+    Arena            docArena;          /* DocStates, recycled on close */
+    Arena            scratch;           /* reset by each call using it */
+
+    /* The menus as the backend last showed them, and the changes not yet */
+    /* made to them (see UpdateMenus)                                     */
+    int              updateDepth;       /* DCT_BeginUpdate nesting */
+    int              dimmed[UI_NUM_COMMANDS];   /* -1 before first set */
+    DocHandle       *windowItems;       /* item 1 first; 0 to delete */
+    int              numWindowItems;
+    int              maxWindowItems;
+    const char     **recentFiles;       /* to add, oldest first */
+    int              numRecentFiles;
+    int              recentCapacity;
+    int              maxRecentFiles;    /* 0 for no limit */
+    Arena            recentArena;       /* the paths in recentFiles */
+
+    /* Tabbed view (see UpdateView) */
+    int              tabbed;
+    int              contentPanel;      /* every document's, or 0 */
+    DocHandle        contentDoc;        /* the one it shows */
+    int              contentStale;      /* its steps changed since */
+    int              contentRows;       /* step rows it has filled */
+    DocHandle       *tabs;              /* open documents, oldest first */
+    int              numTabs;
+    int              tabCapacity;
+    int              tabsClosed;        /* tabs holds closed documents */
+    int              firstTab;          /* first tab in view */
+    DocHandle        tabTop;            /* top document brought into view */
+    DocHandle       *tabSlots;          /* tab in view shows; -1 unknown */
+    int              numTabSlots;
+    int              selectedSlot;      /* -1 for none */
+    int              shownNumTabs;      /* as setTabView last had them */
+    int              shownFirstTab;
+};
+
+/* What the registry keeps for each document */
+typedef struct
+{
+    Sequence    seq;
+    UndoHistory history;                /* 0 until the first edit */
+    FindIndex   index;                  /* 0 until the first Find */
+    int         firstStep;              /* first step in view */
+    int         numRows;                /* step rows its panel has filled */
+} DocState;
+
+/*---------------------------------------------------------------------------*/
+/* Internal function prototypes                                              */
+/*---------------------------------------------------------------------------*/
+static void     AddRecentFile     (DocController ctl, const char *path);
+static void     DimCommands       (DocController ctl);
+static void     DeleteWindowItem  (DocController ctl, DocHandle doc);
+static void     UpdateWindowItems (DocController ctl);
+static void     UpdateRecentFiles (DocController ctl);
+static void     UpdateMenus       (DocController ctl);
+static void     ShowSteps         (DocController ctl, DocHandle doc,
+                                   int panel, int *numFilled);
+static void     StepsChanged      (DocController ctl, DocHandle doc);
+static int      ReserveTab        (DocController ctl);
+static void     ForgetTab         (DocController ctl, DocHandle doc);
+static void     UpdateTabs        (DocController ctl, DocHandle top);
+static void     UpdateView        (DocController ctl);
+static int      GetContentPanel   (DocController ctl);
+static void     DiscardContentPanel (DocController ctl);
+static Sequence GetDocumentSequence (DocController ctl, DocHandle doc);
+static int      SetDocumentSequence (DocController ctl, DocHandle doc,
+                                     Sequence seq);
+static UndoHistory GetDocumentHistory (DocController ctl, DocHandle doc,
+                                       int create);
+static FindIndex GetDocumentIndex (DocController ctl, DocHandle doc);
+static int      RecordEdit        (DocController ctl, DocHandle doc,
+                                   const char *label, int firstStep,
+                                   int numSteps);
+static int      StepHistory       (DocController ctl, int redo);
+static int      ReadSequence      (DocController ctl, const char *path,
+                                   Sequence *seq);
+static int      LoadDocumentSequence (DocController ctl, DocHandle doc);
+static int      WriteSequence     (Sequence seq, const char *path,
+                                   int overwrite);
+static int      Materialize       (DocController ctl, DocHandle doc);
+static int      OpenDocument      (DocController ctl, const char *path,
+                                   int show);
+static void     DiscardDocument   (DocController ctl, DocHandle doc);
+
+/*---------------------------------------------------------------------------*/
+/* Create a controller for the document panels of parentPanel.  The Window   */
+/* menu list holds maxWindowItems items.                                     */
+/*---------------------------------------------------------------------------*/
+DocController DCT_New (const UiBackend *ui, int parentPanel,
+                       int maxWindowItems)
+{
+    DocController ctl;
+    int           i;
+
+    if (!ui || !(ctl = calloc (1, sizeof(*ctl))))
+        return 0;
+    ctl->ui = ui;
+    ctl->parentPanel = parentPanel;
+    ctl->docs = DOC_New (maxWindowItems);
+    ctl->exec = EXE_New ();
+    ctl->plugins = PLG_New ();
+    ctl->docArena = ARN_New (4096);
+    ctl->scratch = ARN_New (0);
+    ctl->recentArena = ARN_New (4096);
+    ctl->maxWindowItems = maxWindowItems > 0 ? maxWindowItems : 0;
+    ctl->windowItems = calloc (ctl->maxWindowItems + 1, sizeof(DocHandle));
+    if (!ctl->docs || !ctl->exec || !ctl->plugins || !ctl->docArena
+        || !ctl->scratch || !ctl->recentArena || !ctl->windowItems)
+        {
+        DCT_Dispose (ctl);
+        return 0;
+        }
+    for (i = 0; i < UI_NUM_COMMANDS; i++)
+        ctl->dimmed[i] = -1;
+    UpdateMenus (ctl);
+    return ctl;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Close any documents still open and free the controller.                   */
+/*---------------------------------------------------------------------------*/
+void DCT_Dispose (DocController ctl)
+{
+    if (!ctl)
+        return;
+    if (ctl->docs)
+        {
+        DCT_CloseAll (ctl);
+        DOC_Dispose (ctl->docs);
+        }
+    if (ctl->contentPanel > 0)
+        DiscardContentPanel (ctl);
+    SKT_Dispose (ctl->sockets);
+    EXE_Dispose (ctl->exec);
+    HST_Dispose (ctl->host);
+    PLG_Dispose (ctl->plugins);
+    ARN_Dispose (ctl->docArena);
+    ARN_Dispose (ctl->scratch);
+    ARN_Dispose (ctl->recentArena);
+    free (ctl->windowItems);
+    free (ctl->recentFiles);
+    free (ctl->tabs);
+    free (ctl->hostPath);
+    free (ctl);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Record opened and closed documents and File menu MRU changes in session,  */
+/* which must outlive the controller.  0 stops recording.                    */
+/*---------------------------------------------------------------------------*/
+int DCT_SetSession (DocController ctl, SessionLog session)
+{
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    ctl->session = session;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Hold the menu changes made by the calls between DCT_BeginUpdate and       */
+/* DCT_EndUpdate, and make only their net result when the outermost          */
+/* DCT_EndUpdate returns.  Every other call is an update of its own.         */
+/*---------------------------------------------------------------------------*/
+int DCT_BeginUpdate (DocController ctl)
+{
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    ctl->updateDepth++;
+    return TMS_OK;
+}
+
+int DCT_EndUpdate (DocController ctl)
+{
+    if (!ctl || ctl->updateDepth <= 0)
+        return TMS_ERR_INVALID_ARG;
+    ctl->updateDepth--;
+    UpdateMenus (ctl);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Tell the controller how many files the backend's File menu list holds,    */
+/* so an update adds only the files that would stay on it.  0 (the default)  */
+/* for no limit.                                                             */
+/*---------------------------------------------------------------------------*/
+int DCT_SetMaxRecentFiles (DocController ctl, int maxRecentFiles)
+{
+    if (!ctl || maxRecentFiles < 0)
+        return TMS_ERR_INVALID_ARG;
+    ctl->maxRecentFiles = maxRecentFiles;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Bring the menus up to date with the documents, unless an update is open:  */
+/* add the File menu's new recent files, make the Window menu list match the */
+/* registry's mirror and dim the commands that cannot be used.  Each makes   */
+/* only the backend calls that change something, so closing 500 documents    */
+/* costs a handful of calls rather than several per document.  The tabbed    */
+/* view is brought up to date the same way.                                  */
+/*---------------------------------------------------------------------------*/
+static void UpdateMenus (DocController ctl)
+{
+    if (ctl->updateDepth > 0)
+        return;
+    UpdateRecentFiles (ctl);
+    UpdateWindowItems (ctl);
+    DimCommands (ctl);
+    UpdateView (ctl);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Add a path to the File menu's MRU list and to the session's copy of it.   */
+/* The menu's copy waits for the next update; if the path cannot be kept     */
+/* until then, the ones before it and it are added now.                      */
+/*---------------------------------------------------------------------------*/
+static void AddRecentFile (DocController ctl, const char *path)
+{
+    const char **grown;
+    const char  *copy;
+    int          capacity;
+
+    if (ctl->session)
+        SES_AddRecent (ctl->session, path);
+    if (ctl->numRecentFiles == ctl->recentCapacity)
+        {
+        capacity = ctl->recentCapacity ? ctl->recentCapacity * 2 : 16;
+        if ((grown = realloc (ctl->recentFiles,
+                              capacity * sizeof(*grown))) != 0)
+            {
+            ctl->recentFiles = grown;
+            ctl->recentCapacity = capacity;
+            }
+        }
+    if (ctl->numRecentFiles < ctl->recentCapacity
+        && (copy = ARN_StrDup (ctl->recentArena, path)) != 0)
+        {
+        ctl->recentFiles[ctl->numRecentFiles++] = copy;
+        return;
+        }
+    UpdateRecentFiles (ctl);
+    ctl->ui->addRecentFile (path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Add the files waiting for the File menu.  Each goes to the front of the   */
+/* list, pushing out the oldest and any earlier copy of itself, so only the  */
+/* newest copy of each path counts, and of those only as many as the list    */
+/* holds.  They are gathered, newest last, at the back of the queue.         */
+/*---------------------------------------------------------------------------*/
+static void UpdateRecentFiles (DocController ctl)
+{
+    const char **files = ctl->recentFiles;
+    int          numFiles = ctl->numRecentFiles;
+    int          numKept = 0;
+    int          i;
+    int          j;
+
+    if (!numFiles)
+        return;
+    if (!ctl->maxRecentFiles)
+        numKept = numFiles;
+    else
+        for (i = numFiles - 1; i >= 0 && numKept < ctl->maxRecentFiles; i--)
+            {
+            for (j = numFiles - numKept; j < numFiles; j++)
+                if (strcmp (files[j], files[i]) == 0)
+                    break;
+            if (j == numFiles)
+                files[numFiles - ++numKept] = files[i];
+            }
+    for (i = numFiles - numKept; i < numFiles; i++)
+        ctl->ui->addRecentFile (files[i]);
+    ctl->numRecentFiles = 0;
+    ARN_Reset (ctl->recentArena);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Dim the commands that need an open document when there is none, and Undo  */
+/* and Redo when the top document has nothing to undo or redo.  Only the     */
+/* commands whose state changed are set.                                     */
+/*---------------------------------------------------------------------------*/
+static void DimCommands (DocController ctl)
+{
+    int         dimmed = DOC_Count (ctl->docs) <= 0;
+    UndoHistory history = GetDocumentHistory (ctl, DOC_GetTop (ctl->docs), 0);
+    int         wanted[UI_NUM_COMMANDS];
+    int         i;
+
+    wanted[UI_CMD_SAVE] = dimmed;
+    wanted[UI_CMD_SAVEAS] = dimmed;
+    wanted[UI_CMD_CLOSE] = dimmed;
+    wanted[UI_CMD_CLOSEALL] = dimmed;
+    wanted[UI_CMD_HIDEALL] = dimmed;
+    wanted[UI_CMD_UNDO] = !UND_GetUndoLabel (history);
+    wanted[UI_CMD_REDO] = !UND_GetRedoLabel (history);
+    for (i = 0; i < UI_NUM_COMMANDS; i++)
+        if (ctl->dimmed[i] != wanted[i]
+            && ctl->ui->setCommandDimmed (i, wanted[i]) >= 0)
+            ctl->dimmed[i] = wanted[i];
+}
+
+/*---------------------------------------------------------------------------*/
+/* Delete a Window menu item (1-based) and its entry in the shadow list.     */
+/*---------------------------------------------------------------------------*/
+static void RemoveWindowItem (DocController ctl, int item)
+{
+    DocHandle *items = ctl->windowItems;
+
+    ctl->ui->deleteWindowItem (item);
+    memmove (items + item - 1, items + item,
+             (ctl->numWindowItems - item) * sizeof(*items));
+    ctl->numWindowItems--;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Make the Window menu list show the registry's mirror.  Items of documents */
+/* that left the mirror (closed, or renamed and so due a new item) go, last  */
+/* first so the others keep their positions -- but when the mirror fills the */
+/* list, those at the end are left for the items added later to push off.    */
+/* Then leading items go until the rest are the mirror's oldest, in order,   */
+/* and the newer documents are added to the front, oldest first.             */
+/*---------------------------------------------------------------------------*/
+static void UpdateWindowItems (DocController ctl)
+{
+    DocHandle *items = ctl->windowItems;
+    int        numMirrored = 0;
+    int        numLive;
+    int        first;
+    int        i;
+
+    for (i = 0; i < ctl->numWindowItems; i++)
+        if (items[i] && !DOC_GetMirrorIndex (ctl->docs, items[i]))
+            items[i] = 0;
+    for (numLive = ctl->numWindowItems; numLive > 0 && !items[numLive - 1];
+         numLive--)
+        ;
+    for (i = numLive; i > 0; i--)
+        if (!items[i - 1])
+            {
+            RemoveWindowItem (ctl, i);
+            numLive--;
+            }
+    while (DOC_GetMirrorItem (ctl->docs, numMirrored + 1))
+        numMirrored++;
+    for (;;)
+        {
+        first = numMirrored - numLive;
+        for (i = 0; i < numLive; i++)
+            if (items[i] != DOC_GetMirrorItem (ctl->docs, first + i + 1))
+                break;
+        if (i == numLive)
+            break;
+        RemoveWindowItem (ctl, 1);
+        numLive--;
+        }
+
+    /* The list fills up again only if the mirror is full */
+    if (numMirrored < ctl->maxWindowItems)
+        while (ctl->numWindowItems > numLive)
+            RemoveWindowItem (ctl, ctl->numWindowItems);
+    for (i = first; i > 0; i--)
+        {
+        DocHandle doc = DOC_GetMirrorItem (ctl->docs, i);
+
+        ctl->ui->addWindowItem (DOC_GetPath (ctl->docs, doc),
+                                (void *)(size_t)doc);
+        if (ctl->numWindowItems == ctl->maxWindowItems)
+            ctl->numWindowItems--;
+        memmove (items + 1, items, ctl->numWindowItems++ * sizeof(*items));
+        items[0] = doc;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Have the next update remove a document's Window menu item, if it has one: */
+/* a closed document's, or a renamed one's, which is added again.            */
+/*---------------------------------------------------------------------------*/
+static void DeleteWindowItem (DocController ctl, DocHandle doc)
+{
+    int i;
+
+    for (i = 0; i < ctl->numWindowItems; i++)
+        if (ctl->windowItems[i] == doc)
+            ctl->windowItems[i] = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Fill a panel's step list with the steps of doc in view, from the first    */
+/* one the user scrolled to.  Only the rows the panel shows are set, so a    */
+/* long sequence costs no more to show than a short one; of the rows past    */
+/* the last step, only the *numFilled that held steps before are cleared.    */
+/*---------------------------------------------------------------------------*/
+static void ShowSteps (DocController ctl, DocHandle doc, int panel,
+                       int *numFilled)
+{
+    DocState *state = (DocState *)DOC_GetData (ctl->docs, doc);
+    Sequence  seq = state ? state->seq : 0;
+    UiStepRow row;
+    int       numSteps = seq ? SEQ_NumSteps (seq) : 0;
+    int       first = state ? state->firstStep : 0;
+    int       numRows;
+    int       filled;
+    int       i;
+
+    if ((numRows = ctl->ui->setStepView (panel, numSteps, first)) < 0)
+        return;
+
+    /* Steps were taken away below the view, so scroll up to keep it full */
+    if (first > 0 && first > numSteps - numRows)
+        {
+        first = numSteps > numRows ? numSteps - numRows : 0;
+        state->firstStep = first;
+        if ((numRows = ctl->ui->setStepView (panel, numSteps, first)) < 0)
+            return;
+        }
+    for (i = 0; i < numRows && first + i < numSteps; i++)
+        {
+        row.step = first + i;
+        row.name = SEQ_GetStepName (seq, row.step);
+        row.module = 0;
+        row.symbol = 0;
+        SEQ_GetStepSymbol (seq, row.step, &row.module, &row.symbol);
+        row.param = SEQ_GetStepParam (seq, row.step);
+        ctl->ui->setStepRow (panel, i, &row);
+        }
+    for (filled = i; i < numRows && i < *numFilled; i++)
+        ctl->ui->setStepRow (panel, i, 0);
+    *numFilled = filled;
+}
+
+/*---------------------------------------------------------------------------*/
+/* A document's steps changed or were scrolled.  Its own panel's list is     */
+/* filled in again now; the tabbed view's waits for the next update.         */
+/*---------------------------------------------------------------------------*/
+static void StepsChanged (DocController ctl, DocHandle doc)
+{
+    DocState *state = (DocState *)DOC_GetData (ctl->docs, doc);
+    int       panel;
+
+    if (ctl->tabbed)
+        {
+        if (doc == ctl->contentDoc)
+            ctl->contentStale = 1;
+        }
+    else if (state && (panel = DOC_GetPanel (ctl->docs, doc)) > 0)
+        ShowSteps (ctl, doc, panel, &state->numRows);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Tabs.  Every open document has one, in the order they were opened, in     */
+/* either mode so switching to tabs costs nothing.  Closed documents are     */
+/* left in the list until the next update, which drops them all at once.     */
+/*---------------------------------------------------------------------------*/
+static int ReserveTab (DocController ctl)
+{
+    DocHandle *grown;
+    int        capacity;
+
+    if (ctl->numTabs < ctl->tabCapacity)
+        return TMS_OK;
+    capacity = ctl->tabCapacity ? ctl->tabCapacity * 2 : 16;
+    if (!(grown = realloc (ctl->tabs, capacity * sizeof(*grown))))
+        return TMS_ERR_NO_MEMORY;
+    ctl->tabs = grown;
+    ctl->tabCapacity = capacity;
+    return TMS_OK;
+}
+
+/* Have the next update set a renamed document's tab again */
+static void ForgetTab (DocController ctl, DocHandle doc)
+{
+    int i;
+
+    for (i = 0; i < ctl->numTabSlots; i++)
+        if (ctl->tabSlots[i] == doc)
+            ctl->tabSlots[i] = -1;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Show the tabs in view, setting only those that changed.  When another     */
+/* document comes to the top its tab is scrolled into view; otherwise the    */
+/* strip stays where the user scrolled it.                                   */
+/*---------------------------------------------------------------------------*/
+static void UpdateTabs (DocController ctl, DocHandle top)
+{
+    int       panel = ctl->contentPanel;
+    int       numSlots = ctl->numTabSlots;
+    int       selected = -1;
+    int       maxFirst;
+    int       tab;
+    int       i;
+    DocHandle doc;
+
+    if (top != ctl->tabTop)
+        {
+        for (tab = 0; tab < ctl->numTabs && ctl->tabs[tab] != top; tab++)
+            ;
+        if (tab < ctl->firstTab)
+            ctl->firstTab = tab;
+        else if (tab < ctl->numTabs && tab >= ctl->firstTab + numSlots)
+            ctl->firstTab = tab - numSlots + 1;
+        ctl->tabTop = top;
+        }
+    maxFirst = ctl->numTabs > numSlots ? ctl->numTabs - numSlots : 0;
+    if (ctl->firstTab > maxFirst)
+        ctl->firstTab = maxFirst;
+    if ((ctl->numTabs != ctl->shownNumTabs
+         || ctl->firstTab != ctl->shownFirstTab)
+        && ctl->ui->setTabView (panel, ctl->numTabs, ctl->firstTab) >= 0)
+        {
+        ctl->shownNumTabs = ctl->numTabs;
+        ctl->shownFirstTab = ctl->firstTab;
+        }
+    for (i = 0; i < numSlots; i++)
+        if (ctl->firstTab + i < ctl->numTabs
+            && ctl->tabs[ctl->firstTab + i] == top)
+            selected = i;
+    for (i = 0; i < numSlots; i++)
+        {
+        tab = ctl->firstTab + i;
+        doc = tab < ctl->numTabs ? ctl->tabs[tab] : 0;
+        if (doc == ctl->tabSlots[i]
+            && (i == selected) == (i == ctl->selectedSlot))
+            continue;
+        ctl->tabSlots[i] = ctl->ui->setTab (panel, i,
+                                            DOC_GetPath (ctl->docs, doc),
+                                            i == selected) >= 0 ? doc : -1;
+        }
+    ctl->selectedSlot = selected;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Drop closed documents' tabs and, when tabbed, make the content panel show */
+/* the top document -- its path, its steps and the tabs around its own --    */
+/* or discard the panel once no document is left.                            */
+/*---------------------------------------------------------------------------*/
+static void UpdateView (DocController ctl)
+{
+    DocHandle top = DOC_GetTop (ctl->docs);
+    int       panel;
+    int       i;
+    int       j;
+
+    if (ctl->tabsClosed)
+        {
+        for (i = j = 0; i < ctl->numTabs; i++)
+            if (DOC_GetPath (ctl->docs, ctl->tabs[i]))
+                ctl->tabs[j++] = ctl->tabs[i];
+        ctl->numTabs = j;
+        ctl->tabsClosed = 0;
+        }
+    if (!ctl->tabbed)
+        return;
+    if (!top)
+        {
+        if (ctl->contentPanel > 0)
+            DiscardContentPanel (ctl);
+        return;
+        }
+    if ((panel = GetContentPanel (ctl)) < 0)
+        return;
+    if (top != ctl->contentDoc)
+        {
+        ctl->ui->setDocumentPath (panel, DOC_GetPath (ctl->docs, top));
+        ctl->contentDoc = top;
+        ctl->contentStale = 1;
+        }
+    if (ctl->contentStale)
+        {
+        ShowSteps (ctl, top, panel, &ctl->contentRows);
+        ctl->contentStale = 0;
+        }
+    UpdateTabs (ctl, top);
+}
+
+/*---------------------------------------------------------------------------*/
+/* The one panel tabbed documents are shown in, loaded and displayed the     */
+/* first time one is shown.  Its tab strip starts out empty.                 */
+/*---------------------------------------------------------------------------*/
+static int GetContentPanel (DocController ctl)
+{
+    DocHandle *slots;
+    int        panel;
+    int        numSlots;
+    int        i;
+
+    if (ctl->contentPanel > 0)
+        return ctl->contentPanel;
+    if ((panel = ctl->ui->loadDocumentPanel (ctl->parentPanel)) < 0)
+        return TMS_ERR_IO;
+    if ((numSlots = ctl->ui->setTabView (panel, 0, 0)) < 0
+        || !(slots = malloc ((numSlots + 1) * sizeof(*slots))))
+        {
+        ctl->ui->discardPanel (panel);
+        return numSlots < 0 ? TMS_ERR_IO : TMS_ERR_NO_MEMORY;
+        }
+    for (i = 0; i < numSlots; i++)
+        slots[i] = 0;
+    ctl->contentPanel = panel;
+    ctl->contentDoc = 0;
+    ctl->contentRows = 0;
+    ctl->tabSlots = slots;
+    ctl->numTabSlots = numSlots;
+    ctl->selectedSlot = -1;
+    ctl->shownNumTabs = 0;
+    ctl->shownFirstTab = 0;
+    ctl->tabTop = 0;
+    ctl->ui->setPanelPosition (panel, 0, 0);
+    ctl->ui->displayPanel (panel);
+    return panel;
+}
+
+static void DiscardContentPanel (DocController ctl)
+{
+    ctl->ui->discardPanel (ctl->contentPanel);
+    free (ctl->tabSlots);
+    ctl->contentPanel = 0;
+    ctl->contentDoc = 0;
+    ctl->tabSlots = 0;
+    ctl->numTabSlots = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Each document owns a compiled Sequence and its Undo history, kept with it */
+/* in the registry.                                                          */
+/*---------------------------------------------------------------------------*/
+static Sequence GetDocumentSequence (DocController ctl, DocHandle doc)
+{
+    DocState *state = (DocState *)DOC_GetData (ctl->docs, doc);
+
+    return state ? state->seq : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Replace a document's sequence, disposing of the old one, its history and  */
+/* its Find index.                                                           */
+/*---------------------------------------------------------------------------*/
+static int SetDocumentSequence (DocController ctl, DocHandle doc,
+                                Sequence seq)
+{
+    DocState *state = (DocState *)DOC_GetData (ctl->docs, doc);
+    Sequence  oldSeq = state ? state->seq : 0;
+
+    if (!state && seq)
+        {
+        if (!(state = ARN_Calloc (ctl->docArena, sizeof(*state))))
+            return TMS_ERR_NO_MEMORY;
+        DOC_SetData (ctl->docs, doc, state);
+        }
+    if (oldSeq && oldSeq == EXE_GetSequence (ctl->exec))
+        {
+        EXE_Wait (ctl->exec);
+        EXE_Load (ctl->exec, 0);
+        }
+    if (oldSeq && oldSeq == SKT_GetSequence (ctl->sockets))
+        {
+        SKT_Wait (ctl->sockets);
+        SKT_Load (ctl->sockets, 0);
+        }
+    if (state && oldSeq != seq)
+        {
+        UND_Dispose (state->history);
+        FND_Dispose (state->index);
+        state->history = 0;
+        state->index = 0;
+        state->seq = seq;
+        }
+    if (state && !seq)
+        {
+        DOC_SetData (ctl->docs, doc, 0);
+        ARN_Recycle (ctl->docArena, state, sizeof(*state));
+        }
+    if (oldSeq && oldSeq != seq)
+        SEQ_Dispose (oldSeq);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* A document's Undo history, or 0.  With create set, a document that has    */
+/* none yet gets one starting from its sequence as it is now -- so call it   */
+/* before the edit.                                                          */
+/*---------------------------------------------------------------------------*/
+static UndoHistory GetDocumentHistory (DocController ctl, DocHandle doc,
+                                       int create)
+{
+    DocState *state = (DocState *)DOC_GetData (ctl->docs, doc);
+
+    if (!state)
+        return 0;
+    if (!state->history && create)
+        state->history = UND_New (state->seq, UNDO_BUDGET_BYTES);
+    return state->history;
+}
+
+/*---------------------------------------------------------------------------*/
+/* A document's Find index, built the first time it is asked for; 0 if the   */
+/* document has no sequence or there is no memory for the index.             */
+/*---------------------------------------------------------------------------*/
+static FindIndex GetDocumentIndex (DocController ctl, DocHandle doc)
+{
+    DocState *state = (DocState *)DOC_GetData (ctl->docs, doc);
+
+    if (!state)
+        return 0;
+    if (!state->index)
+        state->index = FND_New (state->seq);
+    return state->index;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Record an edit to a document for Undo, bring its Find index up to date    */
+/* and update the Edit menu.  Without a history (out of memory) the edit     */
+/* stands but cannot be undone.                                              */
+/*---------------------------------------------------------------------------*/
+static int RecordEdit (DocController ctl, DocHandle doc, const char *label,
+                       int firstStep, int numSteps)
+{
+    DocState *state = (DocState *)DOC_GetData (ctl->docs, doc);
+    int       status = TMS_OK;
+
+    if (state->history)
+        status = UND_Record (state->history, label, firstStep, numSteps);
+    if (state->index)
+        FND_Update (state->index, firstStep, numSteps);
+    StepsChanged (ctl, doc);
+    UpdateMenus (ctl);
+    return status;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Read a document's sequence from its file, binary or text, and bind it to  */
+/* the step modules.  A new file, or one that is not a sequence, starts      */
+/* with an empty sequence; a damaged sequence file is an error.              */
+/*---------------------------------------------------------------------------*/
+static int ReadSequence (DocController ctl, const char *path, Sequence *seq)
+{
+    switch (SEQ_FileFormat (path))
+        {
+        case SEQ_FORMAT_BINARY:
+            *seq = SEQ_Load (path);
+            break;
+        case SEQ_FORMAT_TEXT:
+            *seq = SEQ_ImportText (path);
+            break;
+        default:
+            if (!(*seq = SEQ_New ()))
+                return TMS_ERR_NO_MEMORY;
+            return TMS_OK;
+        }
+    if (!*seq)
+        return TMS_ERR_IO;
+    PLG_BindSequence (ctl->plugins, *seq);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Read a document's sequence, unless it already has it.  Returns 1 if it    */
+/* was read now.                                                             */
+/*---------------------------------------------------------------------------*/
+static int LoadDocumentSequence (DocController ctl, DocHandle doc)
+{
+    Sequence seq;
+    int      status;
+
+    if (GetDocumentSequence (ctl, doc))
+        return 0;
+    if ((status = ReadSequence (ctl, DOC_GetPath (ctl->docs, doc), &seq)) < 0)
+        return status;
+    if ((status = SetDocumentSequence (ctl, doc, seq)) < 0)
+        {
+        SEQ_Dispose (seq);
+        return status;
+        }
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write a sequence to path, in the format the file already has or, for a    */
+/* new file, as text if the name ends in ".txt".  An existing file that is   */
+/* not a sequence is only replaced if overwrite is set.                      */
+/*---------------------------------------------------------------------------*/
+static int WriteSequence (Sequence seq, const char *path, int overwrite)
+{
+    int         format = SEQ_FileFormat (path);
+    const char *ext = strrchr (path, '.');
+
+    if (format == TMS_ERR_NOT_FOUND || (format == 0 && overwrite))
+        {
+        format = SEQ_FORMAT_BINARY;
+        if (ext && strlen (ext) == 4 && tolower ((unsigned char)ext[1]) == 't'
+            && tolower ((unsigned char)ext[2]) == 'x'
+            && tolower ((unsigned char)ext[3]) == 't')
+            format = SEQ_FORMAT_TEXT;
+        }
+    else if (format == 0)
+        return TMS_ERR_EXISTS;
+    else if (format < 0)
+        return format;
+    if (format == SEQ_FORMAT_TEXT)
+        return SEQ_ExportText (seq, path);
+    return SEQ_Save (seq, path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Give a document its panel, cascaded from the previous one, and display    */
+/* it.  Documents opened in the background get theirs the first time they    */
+/* are shown, so opening many of them creates no panels.  The sequence is    */
+/* read from the document's file along with the panel.  Tabbed, documents    */
+/* share the content panel instead, which the next update points at the top  */
+/* one.  Returns the panel.                                                  */
+/*---------------------------------------------------------------------------*/
+static int Materialize (DocController ctl, DocHandle doc)
+{
+    DocState *state;
+    int       panel;
+    int       loaded;
+    int       status;
+
+    if ((panel = DOC_GetPanel (ctl->docs, doc)) > 0)
+        return panel;
+    if (!DOC_GetPath (ctl->docs, doc))
+        return TMS_ERR_NOT_FOUND;
+    if (ctl->tabbed)
+        {
+        if ((status = LoadDocumentSequence (ctl, doc)) < 0)
+            return status;
+        return GetContentPanel (ctl);
+        }
+    if ((panel = ctl->ui->loadDocumentPanel (ctl->parentPanel)) < 0)
+        return TMS_ERR_IO;
+    if ((status = loaded = LoadDocumentSequence (ctl, doc)) >= 0
+        && (status = DOC_SetPanel (ctl->docs, doc, panel)) < 0 && loaded)
+        SetDocumentSequence (ctl, doc, 0);
+    if (status < 0)
+        {
+        ctl->ui->discardPanel (panel);
+        return status;
+        }
+
+    /* Set top and left for the panel */
+    ctl->ui->setPanelPosition (panel, ctl->topLeftValue * 25 + 50,
+                               ctl->topLeftValue * 25 + 25);
+    ctl->topLeftValue = (ctl->topLeftValue + 1) % 5;
+    ctl->ui->setDocumentPath (panel, DOC_GetPath (ctl->docs, doc));
+    if ((state = (DocState *)DOC_GetData (ctl->docs, doc)) != 0)
+        {
+        state->numRows = 0;
+        ShowSteps (ctl, doc, panel, &state->numRows);
+        }
+    ctl->ui->displayPanel (panel);
+    return panel;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Close a document: its path goes to the File menu's MRU list, its Window   */
+/* menu item, tab and panel go away, and its sequence is freed.              */
+/*---------------------------------------------------------------------------*/
+static void DiscardDocument (DocController ctl, DocHandle doc)
+{
+    int panel = DOC_GetPanel (ctl->docs, doc);
+
+    AddRecentFile (ctl, DOC_GetPath (ctl->docs, doc));
+    if (ctl->session)
+        SES_Closed (ctl->session, DOC_GetPath (ctl->docs, doc));
+    DeleteWindowItem (ctl, doc);
+    ctl->tabsClosed = 1;
+    SetDocumentSequence (ctl, doc, 0);
+    DOC_Close (ctl->docs, doc);
+    if (panel > 0)
+        ctl->ui->discardPanel (panel);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Register a document and add its Window menu item and tab.  A shown        */
+/* document gets its panel now and goes on top; a background one goes just   */
+/* below the top document and has no panel until it is shown -- unless it    */
+/* is the only document, since the top document always has a panel.          */
+/*---------------------------------------------------------------------------*/
+static int OpenDocument (DocController ctl, const char *path, int show)
+{
+    DocHandle doc;
+    DocHandle top;
+    int       panel = 0;
+
+    if (!ctl || !path || !path[0])
+        return TMS_ERR_INVALID_ARG;
+    if (DOC_FindPath (ctl->docs, path))
+        return TMS_ERR_EXISTS;
+    if (ReserveTab (ctl) < 0)
+        return TMS_ERR_NO_MEMORY;
+    top = DOC_GetTop (ctl->docs);
+    if ((doc = DOC_Open (ctl->docs, path, 0)) < 0)
+        return doc;
+    if (show || !top)
+        {
+        if ((panel = Materialize (ctl, doc)) < 0)
+            {
+            DOC_Close (ctl->docs, doc);
+            return panel;
+            }
+        }
+    else
+        DOC_Activate (ctl->docs, top);
+    ctl->tabs[ctl->numTabs++] = doc;
+    if (ctl->session)
+        SES_Opened (ctl->session, path);
+    UpdateMenus (ctl);
+    return show ? panel : doc;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open a document and show it.  Returns its panel.                          */
+/*---------------------------------------------------------------------------*/
+int DCT_Open (DocController ctl, const char *path)
+{
+    return OpenDocument (ctl, path, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open a document behind the top one without creating its panel (session    */
+/* restore).  Returns its handle.                                            */
+/*---------------------------------------------------------------------------*/
+int DCT_OpenInBackground (DocController ctl, const char *path)
+{
+    return OpenDocument (ctl, path, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Save the top document's sequence to its file, which also adds it to the   */
+/* File menu's MRU list.  Returns TMS_ERR_EXISTS rather than replace a file  */
+/* that is not a sequence.                                                   */
+/*---------------------------------------------------------------------------*/
+int DCT_Save (DocController ctl)
+{
+    DocHandle doc;
+    int       panel;
+    int       status;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    if (!(doc = DOC_GetTop (ctl->docs)))
+        return TMS_ERR_NOT_FOUND;
+    if ((panel = Materialize (ctl, doc)) < 0)
+        return panel;
+    if ((status = WriteSequence (GetDocumentSequence (ctl, doc),
+                                 DOC_GetPath (ctl->docs, doc), 0)) < 0)
+        return status;
+    AddRecentFile (ctl, DOC_GetPath (ctl->docs, doc));
+    UpdateMenus (ctl);
+    return panel;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Save the top document's sequence under a new path, replacing whatever     */
+/* file the user chose.  The old path goes to the File menu's MRU list and   */
+/* the Window menu item and tab are replaced.                                */
+/*---------------------------------------------------------------------------*/
+int DCT_SaveAs (DocController ctl, const char *newPath)
+{
+    DocHandle doc;
+    DocHandle other;
+    int       panel;
+    int       status;
+
+    if (!ctl || !newPath || !newPath[0])
+        return TMS_ERR_INVALID_ARG;
+    if (!(doc = DOC_GetTop (ctl->docs)))
+        return TMS_ERR_NOT_FOUND;
+    if ((other = DOC_FindPath (ctl->docs, newPath)) != 0 && other != doc)
+        return TMS_ERR_EXISTS;
+    if ((panel = Materialize (ctl, doc)) < 0)
+        return panel;
+    if ((status = WriteSequence (GetDocumentSequence (ctl, doc), newPath,
+                                 1)) < 0)
+        return status;
+    AddRecentFile (ctl, DOC_GetPath (ctl->docs, doc));
+    if (ctl->session)
+        SES_Closed (ctl->session, DOC_GetPath (ctl->docs, doc));
+    DeleteWindowItem (ctl, doc);
+    ForgetTab (ctl, doc);
+    DOC_Rename (ctl->docs, doc, newPath);
+    if (ctl->session)
+        SES_Opened (ctl->session, newPath);
+    ctl->ui->setDocumentPath (panel, newPath);
+    UpdateMenus (ctl);
+    return panel;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Close the top document.                                                   */
+/*---------------------------------------------------------------------------*/
+int DCT_Close (DocController ctl)
+{
+    DocHandle doc;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    if (!(doc = DOC_GetTop (ctl->docs)))
+        return TMS_ERR_NOT_FOUND;
+    DiscardDocument (ctl, doc);
+
+    /* The document below comes to the front, so it needs its panel now */
+    if ((doc = DOC_GetTop (ctl->docs)) != 0)
+        Materialize (ctl, doc);
+    UpdateMenus (ctl);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Close every document, top first.  Returns the number closed.              */
+/*---------------------------------------------------------------------------*/
+int DCT_CloseAll (DocController ctl)
+{
+    DocHandle doc;
+    int       numClosed = 0;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    while ((doc = DOC_GetTop (ctl->docs)) != 0)
+        {
+        DiscardDocument (ctl, doc);
+        numClosed++;
+        }
+    UpdateMenus (ctl);
+    return numClosed;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Record that a document panel came to the front.  The tabbed view's panel  */
+/* coming to the front changes nothing: its tabs choose the document.        */
+/*---------------------------------------------------------------------------*/
+int DCT_Activate (DocController ctl, int panel)
+{
+    int status;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    if (ctl->tabbed && panel > 0 && panel == ctl->contentPanel)
+        return TMS_OK;
+    status = DOC_Activate (ctl->docs, DOC_FindPanel (ctl->docs, panel));
+    UpdateMenus (ctl);
+    return status;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Bring a document to the front (Window menu item chosen).                  */
+/*---------------------------------------------------------------------------*/
+int DCT_ShowDocument (DocController ctl, DocHandle doc)
+{
+    int panel;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    if ((panel = Materialize (ctl, doc)) < 0)
+        return panel;
+    DOC_Activate (ctl->docs, doc);
+    UpdateMenus (ctl);
+    return ctl->ui->displayPanel (panel);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Switch between a panel for each shown document and tabs on one panel      */
+/* (View > Tab).  Going to tabs discards every document's panel; going back  */
+/* gives the top document a panel again, and the others get theirs when      */
+/* they are next shown.                                                      */
+/*---------------------------------------------------------------------------*/
+int DCT_SetTabbed (DocController ctl, int tabbed)
+{
+    DocHandle doc;
+    int       panel;
+    int       i;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    if ((tabbed = tabbed != 0) == ctl->tabbed)
+        return TMS_OK;
+    if (tabbed)
+        {
+        for (i = 0; (doc = DOC_GetByIndex (ctl->docs, i)) != 0; i++)
+            if ((panel = DOC_GetPanel (ctl->docs, doc)) > 0)
+                {
+                DOC_SetPanel (ctl->docs, doc, 0);
+                ctl->ui->discardPanel (panel);
+                }
+        }
+    else if (ctl->contentPanel > 0)
+        DiscardContentPanel (ctl);
+    ctl->tabbed = tabbed;
+    ctl->topLeftValue = 0;
+    if ((doc = DOC_GetTop (ctl->docs)) != 0)
+        Materialize (ctl, doc);
+    UpdateMenus (ctl);
+    return TMS_OK;
+}
+
+int DCT_IsTabbed (DocController ctl)
+{
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    return ctl->tabbed;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The user scrolled a panel's step list so firstStep is the first in view.  */
+/*---------------------------------------------------------------------------*/
+int DCT_ScrollSteps (DocController ctl, int panel, int firstStep)
+{
+    DocHandle doc;
+    DocState *state;
+
+    if (!ctl || panel <= 0 || firstStep < 0)
+        return TMS_ERR_INVALID_ARG;
+    if (ctl->tabbed)
+        doc = panel == ctl->contentPanel ? ctl->contentDoc : 0;
+    else
+        doc = DOC_FindPanel (ctl->docs, panel);
+    if (!(state = (DocState *)DOC_GetData (ctl->docs, doc)))
+        return TMS_ERR_NOT_FOUND;
+    state->firstStep = firstStep;
+    StepsChanged (ctl, doc);
+    UpdateMenus (ctl);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The user scrolled the tab strip so firstTab is the first tab in view.     */
+/*---------------------------------------------------------------------------*/
+int DCT_ScrollTabs (DocController ctl, int firstTab)
+{
+    if (!ctl || firstTab < 0)
+        return TMS_ERR_INVALID_ARG;
+    if (!ctl->tabbed)
+        return TMS_ERR_NOT_FOUND;
+    ctl->firstTab = firstTab;
+    UpdateMenus (ctl);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Bring the document of a tab, numbered from 0 along the whole strip, to    */
+/* the front.                                                                */
+/*---------------------------------------------------------------------------*/
+int DCT_ShowTab (DocController ctl, int tab)
+{
+    if (!ctl || tab < 0)
+        return TMS_ERR_INVALID_ARG;
+    if (tab >= ctl->numTabs || !DOC_GetPath (ctl->docs, ctl->tabs[tab]))
+        return TMS_ERR_NOT_FOUND;
+    return DCT_ShowDocument (ctl, ctl->tabs[tab]);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Append count steps calling symbol in module to the top document.  Each    */
+/* is a numeric limit test expecting its input plus one, and all are         */
+/* independent.  The symbol is resolved once for all of them.  Returns the   */
+/* number of steps left unresolved.  The steps added are one Undo.           */
+/*---------------------------------------------------------------------------*/
+int DCT_AddSteps (DocController ctl, int count, const char *module,
+                  const char *symbol)
+{
+    Sequence seq;
+    int      first;
+    int      i;
+    int      step;
+    int      status = 0;
+
+    if (!ctl || count <= 0 || !module || !symbol)
+        return TMS_ERR_INVALID_ARG;
+    if (!(seq = DCT_GetTopSequence (ctl)))
+        return TMS_ERR_NOT_FOUND;
+    GetDocumentHistory (ctl, DOC_GetTop (ctl->docs), 1);
+    first = SEQ_NumSteps (seq);
+    SEQ_Reserve (seq, first + count);
+    for (i = 0; (i < count) && (status >= 0); i++)
+        {
+        step = SEQ_AddStep (seq, symbol, SEQ_KIND_NUMERIC_LIMIT, 0, first + i,
+                            first + i + 1, first + i + 1, 0);
+        if ((status = step) >= 0)
+            status = SEQ_SetStepSymbol (seq, step, module, symbol);
+        }
+    if (status >= 0)
+        status = PLG_BindSequence (ctl->plugins, seq);
+
+    /* Whatever was added stays, so record it even after an error */
+    RecordEdit (ctl, DOC_GetTop (ctl->docs), "Add Steps", first,
+                SEQ_NumSteps (seq) - first);
+    return status;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Merge the sequence of the most recently opened other document into the    */
+/* top one.  Documents on the Window menu are tried newest first, then any   */
+/* other open document.  The other steps are appended in place, so the       */
+/* merge is one Undo and a loaded sequence stays loaded.                     */
+/*---------------------------------------------------------------------------*/
+int DCT_Combinate (DocController ctl)
+{
+    Sequence  seq;
+    Sequence  other = 0;
+    DocHandle doc;
+    DocHandle topDoc;
+    int       first;
+    int       i;
+    int       status;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    topDoc = DOC_GetTop (ctl->docs);
+    if (!(seq = GetDocumentSequence (ctl, topDoc)))
+        return TMS_ERR_NOT_FOUND;
+    for (i = 1; !other && (doc = DOC_GetMirrorItem (ctl->docs, i)); i++)
+        if (doc != topDoc)
+            other = GetDocumentSequence (ctl, doc);
+    for (i = 0; !other && (doc = DOC_GetByIndex (ctl->docs, i)); i++)
+        if (doc != topDoc)
+            other = GetDocumentSequence (ctl, doc);
+    if (!other)
+        return TMS_ERR_NOT_FOUND;
+    GetDocumentHistory (ctl, topDoc, 1);
+    first = SEQ_NumSteps (seq);
+    if ((status = SEQ_Append (seq, other)) < 0)
+        return status;
+    return RecordEdit (ctl, topDoc, "Combinate", first,
+                       SEQ_NumSteps (seq) - first);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Undo or redo one edit of the top document.  Steps come back bound to the  */
+/* functions they had, so nothing is resolved again.                         */
+/*---------------------------------------------------------------------------*/
+static int StepHistory (DocController ctl, int redo)
+{
+    DocState *state;
+    int       first;
+    int       count;
+    int       status;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    state = (DocState *)DOC_GetData (ctl->docs, DOC_GetTop (ctl->docs));
+    if (!state || !state->history)
+        return TMS_ERR_NOT_FOUND;
+    status = redo ? UND_Redo (state->history) : UND_Undo (state->history);
+    if (status >= 0 && state->index
+        && UND_GetChangedSteps (state->history, &first, &count) >= 0)
+        FND_Update (state->index, first, count);
+    if (status >= 0)
+        StepsChanged (ctl, DOC_GetTop (ctl->docs));
+    UpdateMenus (ctl);
+    return status;
+}
+
+int DCT_Undo (DocController ctl)
+{
+    return StepHistory (ctl, 0);
+}
+
+int DCT_Redo (DocController ctl)
+{
+    return StepHistory (ctl, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Find the steps of every open document whose fields (FND_FIELD_*) contain  */
+/* text.  Documents opened in the background have their sequences read, but  */
+/* get no panel.  Fills up to maxMatches, grouped by document with each      */
+/* document's steps in order, and returns the number of steps that match.    */
+/*---------------------------------------------------------------------------*/
+int DCT_Find (DocController ctl, const char *text, int fields,
+              DctMatch *matches, int maxMatches)
+{
+    FndMatch *found = 0;
+    FindIndex index;
+    DocHandle doc;
+    int       numMatches = 0;
+    int       numFound;
+    int       i;
+    int       j;
+
+    if (!ctl || !text || !text[0] || maxMatches < 0
+        || (maxMatches && !matches))
+        return TMS_ERR_INVALID_ARG;
+    ARN_Reset (ctl->scratch);
+    if (maxMatches && !(found = ARN_Alloc (ctl->scratch,
+                                           maxMatches * sizeof(*found))))
+        return TMS_ERR_NO_MEMORY;
+    for (i = 0; (doc = DOC_GetByIndex (ctl->docs, i)) != 0; i++)
+        {
+        if (LoadDocumentSequence (ctl, doc) < 0
+            || !(index = GetDocumentIndex (ctl, doc)))
+            continue;
+        numFound = FND_Find (index, text, fields, found,
+                             maxMatches > numMatches ? maxMatches - numMatches
+                                                     : 0);
+        if (numFound < 0)
+            continue;
+        for (j = 0; j < numFound && numMatches + j < maxMatches; j++)
+            {
+            matches[numMatches + j].doc = doc;
+            matches[numMatches + j].step = found[j].step;
+            matches[numMatches + j].fields = found[j].fields;
+            }
+        numMatches += numFound;
+        }
+    return numMatches;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Replace text by replacement in the name, module and symbol fields         */
+/* selected of every step of every open document -- retargeting all the      */
+/* steps of one module at another, say.  Each document's changes are one     */
+/* edit of its own, undone with Edit > Undo there.  Steps whose module or    */
+/* symbol changed are bound again.  Returns the number of steps changed.     */
+/*---------------------------------------------------------------------------*/
+int DCT_Replace (DocController ctl, const char *text, int fields,
+                 const char *replacement)
+{
+    FindIndex index;
+    DocHandle doc;
+    int       numChanged = 0;
+    int       first;
+    int       count;
+    int       status;
+    int       i;
+
+    if (!ctl || !text || !text[0] || !replacement)
+        return TMS_ERR_INVALID_ARG;
+    for (i = 0; (doc = DOC_GetByIndex (ctl->docs, i)) != 0; i++)
+        {
+        if ((status = LoadDocumentSequence (ctl, doc)) < 0)
+            continue;
+        if (!(index = GetDocumentIndex (ctl, doc)))
+            return TMS_ERR_NO_MEMORY;
+        GetDocumentHistory (ctl, doc, 1);
+        if ((status = FND_Replace (index, text, fields, replacement, &first,
+                                   &count)) < 0)
+            return status;
+        if (status == 0)
+            continue;
+        numChanged += status;
+        if (fields & (FND_FIELD_MODULE | FND_FIELD_SYMBOL))
+            PLG_BindSequence (ctl->plugins, GetDocumentSequence (ctl, doc));
+        RecordEdit (ctl, doc, "Replace", first, count);
+        }
+    return numChanged;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Make the top document's sequence the one the Run menu executes, on the    */
+/* test sockets as well.  Switching documents rewinds Step mode.             */
+/*---------------------------------------------------------------------------*/
+int DCT_LoadTopSequence (DocController ctl)
+{
+    Sequence seq;
+    int      status;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    if (!(seq = DCT_GetTopSequence (ctl)) || SEQ_NumSteps (seq) <= 0)
+        return TMS_ERR_NOT_FOUND;
+    if (seq != EXE_GetSequence (ctl->exec)
+        && (status = EXE_Load (ctl->exec, seq)) < 0)
+        return status;
+    if (ctl->sockets && seq != SKT_GetSequence (ctl->sockets))
+        return SKT_Load (ctl->sockets, seq);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Test numSockets units at a time on Run > All (see sockets.h), or go back  */
+/* to the single execution with 0.  The new sockets have no result logs.     */
+/*---------------------------------------------------------------------------*/
+int DCT_SetNumSockets (DocController ctl, int numSockets)
+{
+    SocketSet sockets = 0;
+    int       status;
+
+    if (!ctl || numSockets < 0)
+        return TMS_ERR_INVALID_ARG;
+    if (ctl->sockets && SKT_IsRunning (ctl->sockets))
+        return TMS_ERR_BUSY;
+    if (numSockets > 0)
+        {
+        if (!(sockets = SKT_New (numSockets)))
+            return TMS_ERR_NO_MEMORY;
+        if (ctl->hostPath
+            && (status = SKT_OpenStepHosts (sockets, ctl->hostPath)) < 0)
+            {
+            SKT_Dispose (sockets);
+            return status;
+            }
+        SKT_Load (sockets, EXE_GetSequence (ctl->exec));
+        }
+    SKT_Dispose (ctl->sockets);
+    ctl->sockets = sockets;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Isolate the steps in step hosts (see stephost.h), or stop.  If any host   */
+/* cannot be started, steps go back to running in process.                   */
+/*---------------------------------------------------------------------------*/
+int DCT_SetStepHost (DocController ctl, const char *hostPath)
+{
+    StepHost host = 0;
+    char    *path = 0;
+    int      status = TMS_OK;
+
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    if (EXE_IsRunning (ctl->exec) > 0
+        || (ctl->sockets && SKT_IsRunning (ctl->sockets) > 0))
+        return TMS_ERR_BUSY;
+    if (hostPath)
+        {
+        if (!(path = malloc (strlen (hostPath) + 1)))
+            return TMS_ERR_NO_MEMORY;
+        strcpy (path, hostPath);
+        if (!(host = HST_New (hostPath)))
+            status = TMS_ERR_IO;
+        }
+    if (status == TMS_OK && ctl->sockets)
+        status = SKT_OpenStepHosts (ctl->sockets, hostPath);
+    if (status < 0)
+        {
+        HST_Dispose (host);
+        free (path);
+        host = 0;
+        path = 0;
+        if (ctl->sockets)
+            SKT_OpenStepHosts (ctl->sockets, 0);
+        }
+    EXE_SetStepHost (ctl->exec, host);
+    HST_Dispose (ctl->host);
+    free (ctl->hostPath);
+    ctl->host = host;
+    ctl->hostPath = path;
+    return status;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Panel of the top document, or -1 if none is open.                         */
+/*---------------------------------------------------------------------------*/
+int DCT_GetTopPanel (DocController ctl)
+{
+    DocHandle top;
+    int       panel;
+
+    if (!ctl || !(top = DOC_GetTop (ctl->docs)))
+        return -1;
+    if (ctl->tabbed)
+        return ctl->contentPanel > 0 ? ctl->contentPanel : -1;
+    return (panel = DOC_GetPanel (ctl->docs, top)) > 0 ? panel : -1;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Path of the top document, or 0.                                           */
+/*---------------------------------------------------------------------------*/
+const char *DCT_GetTopPath (DocController ctl)
+{
+    if (!ctl)
+        return 0;
+    return DOC_GetPath (ctl->docs, DOC_GetTop (ctl->docs));
+}
+
+/*---------------------------------------------------------------------------*/
+/* Sequence of the top document, or 0.                                       */
+/*---------------------------------------------------------------------------*/
+Sequence DCT_GetTopSequence (DocController ctl)
+{
+    if (!ctl)
+        return 0;
+    return GetDocumentSequence (ctl, DOC_GetTop (ctl->docs));
+}
+
+/*---------------------------------------------------------------------------*/
+/* Name of the edit Edit > Undo (or Redo, with redo set) would act on, for   */
+/* the menu or a status line; 0 if there is none.                            */
+/*---------------------------------------------------------------------------*/
+const char *DCT_GetUndoLabel (DocController ctl, int redo)
+{
+    UndoHistory history;
+
+    if (!ctl)
+        return 0;
+    history = GetDocumentHistory (ctl, DOC_GetTop (ctl->docs), 0);
+    return redo ? UND_GetRedoLabel (history) : UND_GetUndoLabel (history);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Sequence of any open document, or 0 if it has not been read yet.          */
+/*---------------------------------------------------------------------------*/
+Sequence DCT_GetSequence (DocController ctl, DocHandle doc)
+{
+    if (!ctl)
+        return 0;
+    return GetDocumentSequence (ctl, doc);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Accessors.                                                                */
+/*---------------------------------------------------------------------------*/
+int DCT_NumDocuments (DocController ctl)
+{
+    if (!ctl)
+        return TMS_ERR_INVALID_ARG;
+    return DOC_Count (ctl->docs);
+}
+
+DocRegistry DCT_GetRegistry (DocController ctl)
+{
+    return ctl ? ctl->docs : 0;
+}
+
+Execution DCT_GetExecution (DocController ctl)
+{
+    return ctl ? ctl->exec : 0;
+}
+
+SocketSet DCT_GetSockets (DocController ctl)
+{
+    return ctl ? ctl->sockets : 0;
+}
+
+PluginLoader DCT_GetPlugins (DocController ctl)
+{
+    return ctl ? ctl->plugins : 0;
+}
@@ -0,0 +1,134 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    docctl.h                                                         */
+/*                                                                           */
+/* PURPOSE: Document controller.  Opens, saves and closes documents, keeps   */
+/*          the File and Window menu lists in step, and owns each            */
+/*          document's sequence.  It talks to the user interface only        */
+/*          through a UiBackend (uiport.h), so menudemo.c supplies the CVI   */
+/*          backend and headless builds supply the in-memory one.  Popups    */
+/*          stay with the caller; functions report what happened through     */
+/*          their return value.  Menu changes are made once per call, or per */
+/*          DCT_BeginUpdate/DCT_EndUpdate pair, and only where the menus     */
+/*          would change, so closing many documents redraws them once.       */
+/*          Document panels list their steps a screenful at a time; tabbed,  */
+/*          one panel shows whichever document is on top.                    */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __DOCCTL_H__
+#define __DOCCTL_H__
+
+#include "tmsapi.h"
+#include "uiport.h"
+#include "docreg.h"
+#include "sequence.h"
+#include "executor.h"
+#include "sockets.h"
+#include "plugin.h"
+#include "session.h"
+#include "findidx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct DocControllerRec_Tag *DocController;
+
+/* One step found by DCT_Find */
+typedef struct
+{
+    DocHandle doc;
+    int       step;
+    int       fields;                   /* FND_FIELD_* that matched */
+} DctMatch;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API DocController DCT_New             (const UiBackend *ui, int parentPanel,
+                                           int maxWindowItems);
+TMS_API void          DCT_Dispose         (DocController ctl);
+TMS_API int           DCT_SetSession      (DocController ctl,
+                                           SessionLog session);
+TMS_API int           DCT_SetMaxRecentFiles (DocController ctl,
+                                             int maxRecentFiles);
+
+/* Make the menu changes of the calls in between as one, when the */
+/* outermost EndUpdate returns (each call is one by itself)       */
+TMS_API int           DCT_BeginUpdate     (DocController ctl);
+TMS_API int           DCT_EndUpdate       (DocController ctl);
+
+/* File and Window menu commands.  Open returns the new panel or */
+/* TMS_ERR_EXISTS; the others act on the top document and return */
+/* TMS_ERR_NOT_FOUND when there is none.  A document's sequence   */
+/* is read from its file (see SEQ_Load) and Save writes it back.  */
+TMS_API int           DCT_Open            (DocController ctl, const char *path);
+TMS_API int           DCT_OpenInBackground (DocController ctl,
+                                            const char *path);
+TMS_API int           DCT_Save            (DocController ctl);
+TMS_API int           DCT_SaveAs          (DocController ctl,
+                                           const char *newPath);
+TMS_API int           DCT_Close           (DocController ctl);
+TMS_API int           DCT_CloseAll        (DocController ctl);
+TMS_API int           DCT_Activate        (DocController ctl, int panel);
+TMS_API int           DCT_ShowDocument    (DocController ctl, DocHandle doc);
+
+/* View menu.  Tabbed, the documents share one panel showing the top one, */
+/* with a tab for each; otherwise each shown document has its own.  The   */
+/* others pass on the user scrolling a panel's step list or the tab       */
+/* strip, or choosing a tab (numbered from 0 along the whole strip).      */
+TMS_API int           DCT_SetTabbed       (DocController ctl, int tabbed);
+TMS_API int           DCT_IsTabbed        (DocController ctl);
+TMS_API int           DCT_ScrollSteps     (DocController ctl, int panel,
+                                           int firstStep);
+TMS_API int           DCT_ScrollTabs      (DocController ctl, int firstTab);
+TMS_API int           DCT_ShowTab         (DocController ctl, int tab);
+
+/* Sequence and Run menu commands on the top document */
+TMS_API int           DCT_AddSteps        (DocController ctl, int count,
+                                           const char *module,
+                                           const char *symbol);
+TMS_API int           DCT_Combinate       (DocController ctl);
+TMS_API int           DCT_LoadTopSequence (DocController ctl);
+TMS_API int           DCT_SetNumSockets   (DocController ctl, int numSockets);
+
+/* Call steps in separate processes running hostPath (tmshost): one for */
+/* each socket and one for Step mode.  0 calls them in process again.   */
+TMS_API int           DCT_SetStepHost     (DocController ctl,
+                                           const char *hostPath);
+
+/* Edit menu.  Sequence menu edits can be undone, newest first, until */
+/* the document is closed; TMS_ERR_NOT_FOUND when there is nothing    */
+/* to undo or redo.                                                   */
+TMS_API int           DCT_Undo            (DocController ctl);
+TMS_API int           DCT_Redo            (DocController ctl);
+TMS_API const char   *DCT_GetUndoLabel    (DocController ctl, int redo);
+
+/* Edit > Find and Replace, across every open document (findidx.h) */
+TMS_API int           DCT_Find            (DocController ctl, const char *text,
+                                           int fields, DctMatch *matches,
+                                           int maxMatches);
+TMS_API int           DCT_Replace         (DocController ctl, const char *text,
+                                           int fields,
+                                           const char *replacement);
+
+/* Queries */
+TMS_API int           DCT_GetTopPanel     (DocController ctl);
+TMS_API const char   *DCT_GetTopPath      (DocController ctl);
+TMS_API Sequence      DCT_GetTopSequence  (DocController ctl);
+TMS_API Sequence      DCT_GetSequence     (DocController ctl, DocHandle doc);
+TMS_API int           DCT_NumDocuments    (DocController ctl);
+TMS_API DocRegistry   DCT_GetRegistry     (DocController ctl);
+TMS_API Execution     DCT_GetExecution    (DocController ctl);
+TMS_API SocketSet     DCT_GetSockets      (DocController ctl);
+TMS_API PluginLoader  DCT_GetPlugins      (DocController ctl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DOCCTL_H__ */
@@ -0,0 +1,486 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    docreg.cpp                                                       */
+/*                                                                           */
+/* PURPOSE: Registry of open documents.  See docreg.h.                       */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "docreg.h"
+
+/*---------------------------------------------------------------------------*/
+/* Handles pack a slab index (low bits) and a generation (high bits), so a   */
+/* handle to a closed document never aliases the slot's next occupant.       */
+/*---------------------------------------------------------------------------*/
+#define INDEX_BITS   20
+#define INDEX_MASK   ((1u << INDEX_BITS) - 1)
+#define GEN_MASK     0x3FFu
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct DocEntry
+{
+    std::string path;
+    int         panel;         /* 0 until the document is first shown */
+    void       *data;
+    unsigned    generation;
+    int         denseIndex;    /* position in dense, -1 when free */
+    int         above;         /* z-order neighbours (slab indices), -1 */
+    int         below;         /* at either end                         */
+};
+
+struct DocRegistryRec_Tag
+{
+    std::vector<DocEntry>  slab;
+    std::vector<unsigned>  freeSlots;
+    std::vector<DocHandle> dense;      /* open documents, unordered */
+    std::vector<DocHandle> mirror;     /* Window menu, newest first */
+    int                    maxMirror;
+    int                    top;        /* slab index of top document, -1 */
+    std::unordered_map<std::string, DocHandle> byPath;
+    std::unordered_map<int, DocHandle>         byPanel;
+};
+
+/*---------------------------------------------------------------------------*/
+/* Handle <-> slab entry.                                                    */
+/*---------------------------------------------------------------------------*/
+static DocHandle MakeHandle (unsigned index, unsigned generation)
+{
+    return (DocHandle)(((generation & GEN_MASK) << INDEX_BITS) | (index + 1));
+}
+
+static DocHandle HandleAt (DocRegistry reg, int index)
+{
+    if (index < 0)
+        return 0;
+    return MakeHandle ((unsigned)index, reg->slab[index].generation);
+}
+
+static DocEntry *Lookup (DocRegistry reg, DocHandle doc)
+{
+    unsigned  index;
+    DocEntry *entry;
+
+    if (!reg || doc <= 0)
+        return 0;
+    index = ((unsigned)doc & INDEX_MASK) - 1;
+    if (index >= reg->slab.size ())
+        return 0;
+    entry = &reg->slab[index];
+    if (entry->denseIndex < 0
+        || (entry->generation & GEN_MASK) != ((unsigned)doc >> INDEX_BITS))
+        return 0;
+    return entry;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Mirror bookkeeping.  The Window menu list holds at most maxMirror items,  */
+/* newest first, and drops its last item when a new one is added to a full   */
+/* list; these helpers apply exactly the same rules.                         */
+/*---------------------------------------------------------------------------*/
+static int MirrorRemove (DocRegistry reg, DocHandle doc)
+{
+    size_t i;
+
+    for (i = 0; i < reg->mirror.size (); i++)
+        if (reg->mirror[i] == doc)
+            {
+            reg->mirror.erase (reg->mirror.begin () + i);
+            return (int)i + 1;
+            }
+    return 0;
+}
+
+static void MirrorPushFront (DocRegistry reg, DocHandle doc)
+{
+    if (reg->maxMirror <= 0)
+        return;
+    reg->mirror.insert (reg->mirror.begin (), doc);
+    if ((int)reg->mirror.size () > reg->maxMirror)
+        reg->mirror.pop_back ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Z-order bookkeeping.  Entries form an intrusive doubly-linked list from   */
+/* the top document down, so raising, closing and finding the top document   */
+/* are all O(1).                                                             */
+/*---------------------------------------------------------------------------*/
+static void ZUnlink (DocRegistry reg, int index)
+{
+    DocEntry &entry = reg->slab[index];
+
+    if (entry.above >= 0)
+        reg->slab[entry.above].below = entry.below;
+    else
+        reg->top = entry.below;
+    if (entry.below >= 0)
+        reg->slab[entry.below].above = entry.above;
+    entry.above = entry.below = -1;
+}
+
+static void ZPushTop (DocRegistry reg, int index)
+{
+    DocEntry &entry = reg->slab[index];
+
+    entry.above = -1;
+    entry.below = reg->top;
+    if (reg->top >= 0)
+        reg->slab[reg->top].above = index;
+    reg->top = index;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Create a registry whose menu mirror holds up to maxMirrorItems entries.   */
+/*---------------------------------------------------------------------------*/
+DocRegistry DOC_New (int maxMirrorItems)
+{
+    DocRegistry reg = new (std::nothrow) DocRegistryRec_Tag;
+
+    if (reg)
+        {
+        reg->maxMirror = maxMirrorItems;
+        reg->top = -1;
+        }
+    return reg;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Discard a registry.                                                       */
+/*---------------------------------------------------------------------------*/
+void DOC_Dispose (DocRegistry reg)
+{
+    delete reg;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Register an open document, on top of the z-order and at the front of      */
+/* the menu mirror.  Returns TMS_ERR_EXISTS if the path is already open.     */
+/* Everything that can run out of memory is done before the registry         */
+/* changes: the lists are reserved and a new slot made (and put on the free  */
+/* list) first, and the path entry is taken back out if the panel entry      */
+/* cannot be added.                                                          */
+/*---------------------------------------------------------------------------*/
+DocHandle DOC_Open (DocRegistry reg, const char *path, int panel)
+{
+    unsigned  index;
+    DocEntry *entry;
+    DocHandle doc;
+
+    if (!reg || !path || !path[0])
+        return TMS_ERR_INVALID_ARG;
+    try
+        {
+        std::string key (path);
+
+        if (reg->byPath.count (key))
+            return TMS_ERR_EXISTS;
+        if (!reg->freeSlots.empty ())
+            index = reg->freeSlots.back ();
+        else
+            {
+            if (reg->slab.size () >= INDEX_MASK)
+                return TMS_ERR_NO_MEMORY;
+            index = (unsigned)reg->slab.size ();
+            reg->freeSlots.reserve (reg->slab.size () + 1);
+            reg->slab.push_back (DocEntry ());
+            reg->slab[index].generation = 0;
+            reg->slab[index].denseIndex = -1;
+            reg->slab[index].above = -1;
+            reg->slab[index].below = -1;
+            reg->freeSlots.push_back (index);
+            }
+        reg->dense.reserve (reg->dense.size () + 1);
+        reg->mirror.reserve (reg->mirror.size () + 1);
+        entry = &reg->slab[index];
+        doc = MakeHandle (index, entry->generation);
+        reg->byPath[key] = doc;
+        try
+            {
+            if (panel > 0)
+                reg->byPanel[panel] = doc;
+            }
+        catch (const std::bad_alloc &)
+            {
+            reg->byPath.erase (key);
+            throw;
+            }
+
+        /* Nothing below allocates */
+        reg->freeSlots.pop_back ();
+        reg->dense.push_back (doc);
+        entry->path.swap (key);
+        entry->panel = panel > 0 ? panel : 0;
+        entry->data = 0;
+        entry->denseIndex = (int)reg->dense.size () - 1;
+        MirrorPushFront (reg, doc);
+        ZPushTop (reg, (int)index);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return doc;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Unregister a document.  Call DOC_GetMirrorIndex first to learn which      */
+/* menu item to delete.                                                      */
+/*---------------------------------------------------------------------------*/
+int DOC_Close (DocRegistry reg, DocHandle doc)
+{
+    DocEntry *entry = Lookup (reg, doc);
+    DocHandle moved;
+    unsigned  index;
+
+    if (!entry)
+        return TMS_ERR_NOT_FOUND;
+    index = ((unsigned)doc & INDEX_MASK) - 1;
+    MirrorRemove (reg, doc);
+    ZUnlink (reg, (int)index);
+    reg->byPath.erase (entry->path);
+    if (entry->panel)
+        reg->byPanel.erase (entry->panel);
+
+    /* Swap-remove from the dense list */
+    moved = reg->dense.back ();
+    reg->dense[entry->denseIndex] = moved;
+    Lookup (reg, moved)->denseIndex = entry->denseIndex;
+    reg->dense.pop_back ();
+
+    entry->denseIndex = -1;
+    entry->generation++;
+    std::string ().swap (entry->path);
+    reg->freeSlots.push_back (index);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Change a document's path (File > Save As).  The document moves to the     */
+/* front of the menu mirror, as its re-added menu item does.                 */
+/*---------------------------------------------------------------------------*/
+int DOC_Rename (DocRegistry reg, DocHandle doc, const char *newPath)
+{
+    DocEntry *entry = Lookup (reg, doc);
+
+    if (!entry || !newPath || !newPath[0])
+        return TMS_ERR_INVALID_ARG;
+    try
+        {
+        std::string key (newPath);
+
+        if (key == entry->path)
+            {
+            MirrorRemove (reg, doc);
+            MirrorPushFront (reg, doc);
+            return TMS_OK;
+            }
+        if (reg->byPath.count (key))
+            return TMS_ERR_EXISTS;
+        reg->byPath[key] = doc;
+        reg->byPath.erase (entry->path);
+        entry->path.swap (key);
+        MirrorRemove (reg, doc);
+        MirrorPushFront (reg, doc);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Give a document the panel it is shown in, for documents opened with no    */
+/* panel and materialized later, or take it away again with 0.               */
+/*---------------------------------------------------------------------------*/
+int DOC_SetPanel (DocRegistry reg, DocHandle doc, int panel)
+{
+    DocEntry *entry = Lookup (reg, doc);
+
+    if (!entry || panel < 0)
+        return TMS_ERR_INVALID_ARG;
+    if (panel)
+        {
+        try
+            {
+            if (reg->byPanel.count (panel))
+                return TMS_ERR_EXISTS;
+            reg->byPanel[panel] = doc;
+            }
+        catch (const std::bad_alloc &)
+            {
+            return TMS_ERR_NO_MEMORY;
+            }
+        }
+    if (entry->panel)
+        reg->byPanel.erase (entry->panel);
+    entry->panel = panel;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Caller data kept with a document (the controller keeps its sequence).     */
+/*---------------------------------------------------------------------------*/
+int DOC_SetData (DocRegistry reg, DocHandle doc, void *data)
+{
+    DocEntry *entry = Lookup (reg, doc);
+
+    if (!entry)
+        return TMS_ERR_NOT_FOUND;
+    entry->data = data;
+    return TMS_OK;
+}
+
+void *DOC_GetData (DocRegistry reg, DocHandle doc)
+{
+    DocEntry *entry = Lookup (reg, doc);
+
+    return entry ? entry->data : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Handle of the document open at path, or 0.                                */
+/*---------------------------------------------------------------------------*/
+DocHandle DOC_FindPath (DocRegistry reg, const char *path)
+{
+    if (!reg || !path)
+        return 0;
+    try
+        {
+        std::unordered_map<std::string, DocHandle>::const_iterator it
+            = reg->byPath.find (path);
+
+        return it == reg->byPath.end () ? 0 : it->second;
+        }
+    catch (const std::bad_alloc &)
+        {
+        return 0;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Handle of the document shown in panel, or 0.                              */
+/*---------------------------------------------------------------------------*/
+DocHandle DOC_FindPanel (DocRegistry reg, int panel)
+{
+    std::unordered_map<int, DocHandle>::const_iterator it;
+
+    if (!reg)
+        return 0;
+    it = reg->byPanel.find (panel);
+    return it == reg->byPanel.end () ? 0 : it->second;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Path of a document, or 0 for a stale handle.                              */
+/*---------------------------------------------------------------------------*/
+const char *DOC_GetPath (DocRegistry reg, DocHandle doc)
+{
+    DocEntry *entry = Lookup (reg, doc);
+
+    return entry ? entry->path.c_str () : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Panel of a document, or 0 for a stale handle or a document that has not   */
+/* been shown yet.                                                           */
+/*---------------------------------------------------------------------------*/
+int DOC_GetPanel (DocRegistry reg, DocHandle doc)
+{
+    DocEntry *entry = Lookup (reg, doc);
+
+    return entry ? entry->panel : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of open documents.                                                 */
+/*---------------------------------------------------------------------------*/
+int DOC_Count (DocRegistry reg)
+{
+    if (!reg)
+        return TMS_ERR_INVALID_ARG;
+    return (int)reg->dense.size ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* The index'th open document (0-based, in no particular order).  Closing a  */
+/* document moves the last one into its place, so close from the back when   */
+/* closing while iterating.                                                  */
+/*---------------------------------------------------------------------------*/
+DocHandle DOC_GetByIndex (DocRegistry reg, int index)
+{
+    if (!reg || index < 0 || index >= (int)reg->dense.size ())
+        return 0;
+    return reg->dense[index];
+}
+
+/*---------------------------------------------------------------------------*/
+/* 1-based position of a document in the menu mirror, or 0 if it is not      */
+/* shown there (the list is full of newer documents).                        */
+/*---------------------------------------------------------------------------*/
+int DOC_GetMirrorIndex (DocRegistry reg, DocHandle doc)
+{
+    size_t i;
+
+    if (!Lookup (reg, doc))
+        return 0;
+    for (i = 0; i < reg->mirror.size (); i++)
+        if (reg->mirror[i] == doc)
+            return (int)i + 1;
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Document shown at a 1-based menu mirror position, or 0.                   */
+/*---------------------------------------------------------------------------*/
+DocHandle DOC_GetMirrorItem (DocRegistry reg, int mirrorIndex)
+{
+    if (!reg || mirrorIndex < 1 || mirrorIndex > (int)reg->mirror.size ())
+        return 0;
+    return reg->mirror[mirrorIndex - 1];
+}
+
+/*---------------------------------------------------------------------------*/
+/* Record that a document's panel was raised (opened, focused or chosen from */
+/* the Window menu).                                                         */
+/*---------------------------------------------------------------------------*/
+int DOC_Activate (DocRegistry reg, DocHandle doc)
+{
+    int index;
+
+    if (!Lookup (reg, doc))
+        return TMS_ERR_NOT_FOUND;
+    index = (int)(((unsigned)doc & INDEX_MASK) - 1);
+    if (reg->top != index)
+        {
+        ZUnlink (reg, index);
+        ZPushTop (reg, index);
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Most recently raised document, or 0 if none is open.                      */
+/*---------------------------------------------------------------------------*/
+DocHandle DOC_GetTop (DocRegistry reg)
+{
+    if (!reg)
+        return 0;
+    return HandleAt (reg, reg->top);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Next document down the z-order from doc, or 0 at the bottom.              */
+/*---------------------------------------------------------------------------*/
+DocHandle DOC_GetBelow (DocRegistry reg, DocHandle doc)
+{
+    DocEntry *entry = Lookup (reg, doc);
+
+    return entry ? HandleAt (reg, entry->below) : 0;
+}
@@ -0,0 +1,63 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    docreg.h                                                         */
+/*                                                                           */
+/* PURPOSE: Registry of open documents.  Documents live in a slab and are    */
+/*          addressed by stable handles; a path-keyed and a panel-keyed hash */
+/*          map make open, close and "is it already open?" O(1).  The CVI    */
+/*          Window menu list only mirrors the most recent entries, and the   */
+/*          registry tracks which menu position each mirrored entry holds.   */
+/*          It also keeps the documents' z-order, so the top document is     */
+/*          known without walking the child panels.  A document may be       */
+/*          opened with no panel (0) and given one when it is first shown.   */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __DOCREG_H__
+#define __DOCREG_H__
+
+#include "tmsapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef int DocHandle;                      /* > 0; 0 means no document */
+
+typedef struct DocRegistryRec_Tag *DocRegistry;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API DocRegistry DOC_New             (int maxMirrorItems);
+TMS_API void        DOC_Dispose         (DocRegistry reg);
+TMS_API DocHandle   DOC_Open            (DocRegistry reg, const char *path,
+                                         int panel);
+TMS_API int         DOC_Close           (DocRegistry reg, DocHandle doc);
+TMS_API int         DOC_Rename          (DocRegistry reg, DocHandle doc,
+                                         const char *newPath);
+TMS_API int         DOC_SetPanel        (DocRegistry reg, DocHandle doc,
+                                         int panel);
+TMS_API int         DOC_SetData         (DocRegistry reg, DocHandle doc,
+                                         void *data);
+TMS_API void       *DOC_GetData         (DocRegistry reg, DocHandle doc);
+TMS_API DocHandle   DOC_FindPath        (DocRegistry reg, const char *path);
+TMS_API DocHandle   DOC_FindPanel       (DocRegistry reg, int panel);
+TMS_API const char *DOC_GetPath         (DocRegistry reg, DocHandle doc);
+TMS_API int         DOC_GetPanel        (DocRegistry reg, DocHandle doc);
+TMS_API int         DOC_Count           (DocRegistry reg);
+TMS_API DocHandle   DOC_GetByIndex      (DocRegistry reg, int index);
+TMS_API int         DOC_GetMirrorIndex  (DocRegistry reg, DocHandle doc);
+TMS_API DocHandle   DOC_GetMirrorItem   (DocRegistry reg, int mirrorIndex);
+TMS_API int         DOC_Activate        (DocRegistry reg, DocHandle doc);
+TMS_API DocHandle   DOC_GetTop          (DocRegistry reg);
+TMS_API DocHandle   DOC_GetBelow        (DocRegistry reg, DocHandle doc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DOCREG_H__ */
@@ -0,0 +1,1275 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    executor.cpp                                                     */
+/*                                                                           */
+/* PURPOSE: Sequence execution engine.  See executor.h.                      */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <limits.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "executor.h"
+#include "arena.h"
+#include "seqlock.h"
+#include "seqtable.h"
+#include "steptime.h"
+#include "workpool.h"
+
+using tms::SeqLock;
+using tms::StringPool;
+using tms::TaskGroup;
+using tms::TimingSlot;
+using tms::WorkPool;
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct ExecutionRec_Tag
+{
+    Sequence               seq;
+    int                    socket;        /* -1 outside a socket set */
+    ResultLog              log;
+    uint32_t               run;           /* numbers runs in the log */
+    std::vector<ExeResult> results;
+    std::vector<int32_t>   sweepValues;   /* parallel to the sequence's args */
+    std::vector<uint64_t>  stepTicks;     /* parallel to results */
+    StepHost               host;          /* 0 to call steps in process */
+    std::vector<int32_t>   hostSlots;     /* parallel to results, -1 if none */
+    Arena                  runArena;      /* the run's scratch, reset by */
+                                          /* ClearResults               */
+
+    /* One slot per pool worker, then one shared by other threads: Step */
+    /* mode's caller and threads that help out while they wait          */
+    std::vector<std::unique_ptr<TimingSlot> > timing;
+    std::mutex             callerLock;    /* guards the last slot */
+    int                    cursor;
+    std::atomic<int>       running;
+    std::atomic<int>       numPassed;
+    std::atomic<int>       numFailed;
+    WorkPool              *pool;          /* shared pool or ownPool */
+    std::unique_ptr<WorkPool> ownPool;
+    TaskGroup              runGroup;
+    TaskGroup             *stepGroup;     /* async steps started by RunSteps */
+                                          /* join it                        */
+    ExeDoneCallbackPtr     doneCallback;
+    void                  *doneCallbackData;
+
+    /* Parameter sweep (EXE_RunSweep), with a chunk's worth of buffers */
+    /* for each worker and one more shared like the last timing slot   */
+    ParamSweep             sweep;
+    int64_t                sweepNumPoints;
+    std::vector<int32_t>   sweepBuffers;
+    std::atomic<int64_t>   sweepRun;
+    std::atomic<int64_t>   sweepFailed;
+    std::atomic<int64_t>   sweepFirstFailed;
+
+    /* Progress for monitors (EXE_GetProgress), published at most once per */
+    /* interval.  Every step reads nextPublish, when the next one is due,   */
+    /* so it has a line of its own.                                         */
+    uint64_t               startTicks;
+    int                    sweeping;      /* the run is a sweep */
+    std::atomic<int>       group;         /* group being run, -1 */
+    alignas (64) std::atomic<uint64_t> nextPublish;
+    SeqLock<ExeProgress>   progress;
+
+    ExecutionRec_Tag ()
+        : seq (0), socket (-1), log (0), run (0), host (0), runArena (0),
+          cursor (0),
+          running (0),
+          numPassed (0), numFailed (0), pool (&WorkPool::Instance ()),
+          stepGroup (0), doneCallback (0), doneCallbackData (0), sweep (0),
+          sweepNumPoints (0), sweepRun (0), sweepFailed (0),
+          sweepFirstFailed (-1), startTicks (0), sweeping (0), group (-1),
+          nextPublish (0) {}
+};
+
+/* Points of a parameter sweep per task, and the most steps sent to the */
+/* step host in one round trip                                          */
+enum { kSweepChunk = 1024, kHostBatch = 256 };
+
+/* Time between progress snapshots while a run is in progress */
+static const double kPublishMicros = 1000.0;
+
+/*---------------------------------------------------------------------------*/
+/* Ticks in a publish interval and in a second, measured once.               */
+/*---------------------------------------------------------------------------*/
+static uint64_t PublishTicks ()
+{
+    static const uint64_t ticks
+        = (uint64_t)(kPublishMicros * 1000.0 / tms::NanosPerTick ()) + 1;
+
+    return ticks;
+}
+
+static double TicksPerSecond ()
+{
+    static const double ticks = 1e9 / tms::NanosPerTick ();
+
+    return ticks;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Take a snapshot of the counts for EXE_GetProgress.  Called by the thread  */
+/* driving the run when it starts, finishes, or moves on to another group,   */
+/* and by PublishIfDue in between.                                           */
+/*---------------------------------------------------------------------------*/
+static void PublishProgress (Execution exec, uint64_t now, int running)
+{
+    ExeProgress progress;
+
+    progress.running = running;
+    progress.numSteps = (int)exec->results.size ();
+    progress.numPassed = exec->numPassed.load (std::memory_order_relaxed);
+    progress.numFailed = exec->numFailed.load (std::memory_order_relaxed);
+    progress.numDone = progress.numPassed + progress.numFailed;
+    progress.group = exec->group.load (std::memory_order_relaxed);
+    progress.numPoints = 0;
+    progress.numFailedPoints = 0;
+    progress.totalPoints = 0;
+    if (exec->sweeping)
+        {
+        progress.numPoints = exec->sweepRun.load (std::memory_order_relaxed);
+        progress.numFailedPoints = exec->sweepFailed.load (
+                                       std::memory_order_relaxed);
+        progress.totalPoints = exec->sweepNumPoints;
+        }
+    progress.elapsedSeconds = now > exec->startTicks
+                              ? (now - exec->startTicks) / TicksPerSecond ()
+                              : 0.0;
+    exec->progress.Store (progress);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Publish the progress if the interval is up, given the time now, which     */
+/* the caller has read anyway.  Of the threads that find it due, the one     */
+/* that moves the deadline on publishes; the rest carry on at once.  The     */
+/* cost when not due is one read of a line that changes once an interval,    */
+/* whether or not anyone is watching.                                        */
+/*---------------------------------------------------------------------------*/
+static inline void PublishIfDue (Execution exec, uint64_t now)
+{
+    uint64_t due = exec->nextPublish.load (std::memory_order_relaxed);
+
+    if (now >= due
+        && exec->nextPublish.compare_exchange_strong (
+               due, now + PublishTicks (), std::memory_order_relaxed))
+        PublishProgress (exec, now, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Run a sweep step over its inputs, preferring the module's batch entry     */
+/* point (one call for the whole array) over one scalar call per input.      */
+/* Returns the number of values outside the limits, or -1 if there is        */
+/* nothing to call.                                                          */
+/*---------------------------------------------------------------------------*/
+static int RunSweep (Execution exec, int index)
+{
+    Sequence       seq = exec->seq;
+    size_t         count = (size_t)seq->argCount[index];
+    const int32_t *in = seq->args.data () + seq->argOffset[index];
+    int32_t       *out = exec->sweepValues.data () + seq->argOffset[index];
+    int32_t        low = seq->lowLimit[index];
+    int32_t        high = seq->highLimit[index];
+    SeqStepFunc    func = seq->func[index];
+    SeqSocketFunc  socketFunc = seq->socketFunc[index];
+    int            numOutside = 0;
+    size_t         i;
+
+    if (exec->host)
+        {
+        if (exec->hostSlots[index] < 0
+            || HST_CallBatch (exec->host, exec->hostSlots[index],
+                              exec->socket, in, out, count) < 0)
+            return -1;
+        }
+    else if (exec->socket >= 0 && socketFunc)
+        for (i = 0; i < count; i++)
+            out[i] = socketFunc (exec->socket, in[i]);
+    else if (seq->batch[index])
+        seq->batch[index] (in, out, count);
+    else if (func)
+        for (i = 0; i < count; i++)
+            out[i] = func (in[i]);
+    else
+        return -1;
+    for (i = 0; i < count; i++)
+        numOutside += (out[i] < low) | (out[i] > high);
+    return numOutside;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Judge the value a step returned against its limits and count and log      */
+/* the result.  callable is 0 if the step had no function to call.           */
+/*---------------------------------------------------------------------------*/
+static void JudgeStep (Execution exec, int index, int value, int callable)
+{
+    Sequence   seq = exec->seq;
+    ExeResult &result = exec->results[index];
+    int        passed;
+
+    result.value = value;
+    if (seq->kind[index] == SEQ_KIND_SWEEP)
+        passed = value == 0;
+    else
+        {
+        passed = callable;
+        if (seq->kind[index] == SEQ_KIND_NUMERIC_LIMIT)
+            passed = passed && value >= seq->lowLimit[index]
+                     && value <= seq->highLimit[index];
+        }
+    if (passed)
+        {
+        result.status = EXE_STATUS_PASSED;
+        exec->numPassed.fetch_add (1, std::memory_order_relaxed);
+        }
+    else
+        {
+        result.status = EXE_STATUS_FAILED;
+        exec->numFailed.fetch_add (1, std::memory_order_relaxed);
+        }
+    /* Worker numbers are only unique within the pool running the steps */
+    if (exec->log)
+        RLG_AddFrom (exec->log, exec->pool, exec->pool->CurrentWorker (),
+                     exec->run, index, result.value, result.status);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Invoke one step in process and judge it.                                  */
+/*---------------------------------------------------------------------------*/
+static void RunOneStep (Execution exec, int index)
+{
+    Sequence      seq = exec->seq;
+    SeqStepFunc   func = seq->func[index];
+    SeqSocketFunc socketFunc = exec->socket >= 0 ? seq->socketFunc[index] : 0;
+
+    if (seq->kind[index] == SEQ_KIND_SWEEP)
+        JudgeStep (exec, index, RunSweep (exec, index), 1);
+    else if (socketFunc)
+        JudgeStep (exec, index, socketFunc (exec->socket, seq->param[index]),
+                   1);
+    else
+        JudgeStep (exec, index, func ? func (seq->param[index]) : 0,
+                   func != 0);
+}
+
+/*---------------------------------------------------------------------------*/
+/* An async step (asyncstep.h) has finished, on whichever thread resumed it  */
+/* last.  Its time runs from its start, which stepTicks holds until now.     */
+/*---------------------------------------------------------------------------*/
+static void AsyncStepDone (void *context, int index, int32_t value,
+                           int completed)
+{
+    Execution exec = (Execution)context;
+    uint64_t  now = tms::ReadTicks ();
+
+    exec->stepTicks[index] = now - exec->stepTicks[index];
+    JudgeStep (exec, index, value, completed);
+    PublishIfDue (exec, now);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Start an async step, started at startTicks, as part of stepGroup.  It     */
+/* runs until its first wait here and is judged when it finishes.            */
+/*---------------------------------------------------------------------------*/
+static void StartAsyncStep (Execution exec, int index, uint64_t startTicks)
+{
+    Sequence seq = exec->seq;
+
+    exec->stepTicks[index] = startTicks;
+    try
+        {
+        seq->asyncFunc[index] (exec->socket, seq->param[index]).Start (
+            *exec->pool, *exec->stepGroup, AsyncStepDone, exec, index);
+        }
+    catch (const std::bad_alloc &)
+        {
+        AsyncStepDone (exec, index, 0, 0);
+        }
+}
+
+static bool IsAsyncStep (Sequence seq, int index)
+{
+    return seq->asyncFunc[index] && seq->kind[index] != SEQ_KIND_SWEEP;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Run a range of steps through the step host.  Consecutive steps go over in */
+/* one round trip, up to kHostBatch of them, and each is timed as its share  */
+/* of the trip; a sweep step makes trips of its own.  Async steps are built  */
+/* in, so they run in process.                                               */
+/*---------------------------------------------------------------------------*/
+static void RunHostedSteps (Execution exec, int begin, int end,
+                            TimingSlot &timing)
+{
+    Sequence seq = exec->seq;
+    HstCall  calls[kHostBatch];
+    uint64_t cpu = tms::ThreadCpuNanos ();
+    uint64_t start = tms::ReadTicks ();
+    uint64_t stepStart = start;
+    uint64_t now = start;
+    uint64_t share;
+    int      first;
+    int      last;
+    int      i;
+
+    for (first = begin; first < end; first = last)
+        {
+        if (IsAsyncStep (seq, first))
+            {
+            last = first + 1;
+            StartAsyncStep (exec, first, stepStart);
+            now = tms::ReadTicks ();
+            timing.RecordStep (first, stepStart, now - stepStart);
+            stepStart = now;
+            continue;
+            }
+        if (seq->kind[first] == SEQ_KIND_SWEEP)
+            {
+            last = first + 1;
+            JudgeStep (exec, first, RunSweep (exec, first), 1);
+            }
+        else
+            {
+            for (last = first; last < end && last - first < kHostBatch
+                               && seq->kind[last] != SEQ_KIND_SWEEP
+                               && !IsAsyncStep (seq, last); last++)
+                {
+                HstCall &call = calls[last - first];
+
+                call.slot = exec->hostSlots[last];
+                call.socket = exec->socket;
+                call.x = seq->param[last];
+                }
+            HST_Call (exec->host, calls, last - first);
+            for (i = first; i < last; i++)
+                JudgeStep (exec, i, calls[i - first].value,
+                           calls[i - first].status == HST_CALL_OK);
+            }
+        now = tms::ReadTicks ();
+        share = (now - stepStart) / (uint64_t)(last - first);
+        for (i = first; i < last; i++)
+            {
+            exec->stepTicks[i] = share;
+            timing.RecordStep (i, stepStart + (i - first) * share, share);
+            }
+        stepStart = now;
+        PublishIfDue (exec, now);
+        }
+    timing.RecordRange (begin, end, start, now - start,
+                        tms::ThreadCpuNanos () - cpu);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Run a range of steps on the calling thread, timing each one and the       */
+/* range as a whole in the slot given.  One step ends where the next one     */
+/* starts, so a step costs a single clock read; its time covers judging and  */
+/* logging the result as well as the call.  An async step is only started    */
+/* here; the slot times it up to its first wait, its result its whole run.   */
+/*---------------------------------------------------------------------------*/
+static void RunSteps (Execution exec, int begin, int end, TimingSlot &timing)
+{
+    uint64_t cpu = tms::ThreadCpuNanos ();
+    uint64_t start = tms::ReadTicks ();
+    uint64_t stepStart = start;
+    uint64_t now = start;
+    int      i;
+
+    if (exec->host)
+        {
+        RunHostedSteps (exec, begin, end, timing);
+        return;
+        }
+    for (i = begin; i < end; i++)
+        {
+        if (IsAsyncStep (exec->seq, i))
+            {
+            StartAsyncStep (exec, i, stepStart);
+            now = tms::ReadTicks ();
+            }
+        else
+            {
+            RunOneStep (exec, i);
+            now = tms::ReadTicks ();
+            exec->stepTicks[i] = now - stepStart;
+            }
+        timing.RecordStep (i, stepStart, now - stepStart);
+        stepStart = now;
+        PublishIfDue (exec, now);
+        }
+    timing.RecordRange (begin, end, start, now - start,
+                        tms::ThreadCpuNanos () - cpu);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Pool callback: run a range of steps from one group.                       */
+/*---------------------------------------------------------------------------*/
+static void RunStepRange (void *context, int begin, int end)
+{
+    Execution exec = (Execution)context;
+    int       worker = exec->pool->CurrentWorker ();
+
+    if (worker >= 0)
+        RunSteps (exec, begin, end, *exec->timing[worker]);
+    else
+        {
+        std::lock_guard<std::mutex> guard (exec->callerLock);
+
+        RunSteps (exec, begin, end, *exec->timing.back ());
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Pool callback: drive a whole Run > All, one group at a time.              */
+/*---------------------------------------------------------------------------*/
+static void RunAllGroups (void *context, int, int)
+{
+    Execution      exec = (Execution)context;
+    WorkPool      &pool = *exec->pool;
+    const int32_t *group = exec->seq->group.data ();
+    int            numSteps = (int)exec->seq->Size ();
+    int       first = 0;
+    int       last;
+    int       grain;
+
+    while (first < numSteps)
+        {
+        TaskGroup groupTasks;
+
+        for (last = first + 1; last < numSteps; last++)
+            if (group[last] != group[first])
+                break;
+        grain = (last - first) / (pool.NumThreads () * 8);
+        exec->stepGroup = &groupTasks;
+        exec->group.store (group[first], std::memory_order_relaxed);
+        PublishProgress (exec, tms::ReadTicks (), 1);
+        pool.ParallelFor (groupTasks, first, last, grain, RunStepRange, exec);
+        pool.Wait (groupTasks);
+        first = last;
+        }
+    exec->group.store (-1, std::memory_order_relaxed);
+    PublishProgress (exec, tms::ReadTicks (), 0);
+    exec->cursor = numSteps;
+    exec->seq->busy.fetch_sub (1);
+    exec->running.store (0, std::memory_order_release);
+    if (exec->doneCallback)
+        exec->doneCallback (exec, exec->doneCallbackData);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Run one chunk of a parameter sweep.  The chunk's points are generated     */
+/* into buffer, then each swept step runs over its column of values, so a    */
+/* step with a batch entry point takes the whole chunk in one call.  buffer  */
+/* holds kSweepChunk * (numParams + 2) values.                               */
+/*---------------------------------------------------------------------------*/
+static void RunSweepChunk (Execution exec, int chunk, int32_t *buffer)
+{
+    Sequence   seq = exec->seq;
+    ParamSweep sweep = exec->sweep;
+    int        numParams = SWP_NumParams (sweep);
+    int64_t    firstPoint = (int64_t)chunk * kSweepChunk;
+    int32_t   *values = buffer;
+    int32_t   *column = buffer + kSweepChunk * numParams;
+    int32_t   *out = column + kSweepChunk;
+    uint8_t    failed[kSweepChunk] = {0};
+    int        numPoints;
+    int        numFailed = 0;
+    int        firstFailed = -1;
+    int        param;
+    int        i;
+
+    numPoints = SWP_GetPoints (sweep, firstPoint, kSweepChunk, values);
+    for (param = 0; param < numParams; param++)
+        {
+        int           step = SWP_GetParamStep (sweep, param);
+        SeqStepFunc   func = seq->func[step];
+        SeqSocketFunc socketFunc = exec->socket >= 0 ? seq->socketFunc[step]
+                                                     : 0;
+        const int32_t *in = values;
+        int32_t       low = seq->lowLimit[step];
+        int32_t       high = seq->highLimit[step];
+
+        if (numParams > 1)
+            {
+            for (i = 0; i < numPoints; i++)
+                column[i] = values[i * numParams + param];
+            in = column;
+            }
+        if (exec->host)
+            {
+            if (exec->hostSlots[step] < 0
+                || HST_CallBatch (exec->host, exec->hostSlots[step],
+                                  exec->socket, in, out,
+                                  (size_t)numPoints) < 0)
+                {
+                for (i = 0; i < numPoints; i++)
+                    failed[i] = 1;
+                continue;
+                }
+            }
+        else if (socketFunc)
+            for (i = 0; i < numPoints; i++)
+                out[i] = socketFunc (exec->socket, in[i]);
+        else if (seq->batch[step])
+            seq->batch[step] (in, out, (size_t)numPoints);
+        else if (func)
+            for (i = 0; i < numPoints; i++)
+                out[i] = func (in[i]);
+        else
+            {
+            for (i = 0; i < numPoints; i++)
+                failed[i] = 1;
+            continue;
+            }
+        if (seq->kind[step] == SEQ_KIND_NUMERIC_LIMIT)
+            for (i = 0; i < numPoints; i++)
+                failed[i] |= (out[i] < low) | (out[i] > high);
+        }
+    for (i = numPoints - 1; i >= 0; i--)
+        if (failed[i])
+            {
+            numFailed++;
+            firstFailed = i;
+            }
+    if (numFailed)
+        exec->sweepFailed.fetch_add (numFailed, std::memory_order_relaxed);
+    exec->sweepRun.fetch_add (numPoints, std::memory_order_relaxed);
+    PublishIfDue (exec, tms::ReadTicks ());
+    if (!numFailed)
+        return;
+    {
+    int64_t point = firstPoint + firstFailed;
+    int64_t lowest = exec->sweepFirstFailed.load ();
+
+    while ((lowest < 0 || point < lowest)
+           && !exec->sweepFirstFailed.compare_exchange_weak (lowest, point))
+        ;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Pool callback: run a range of sweep chunks.                               */
+/*---------------------------------------------------------------------------*/
+static void RunSweepRange (void *context, int begin, int end)
+{
+    Execution exec = (Execution)context;
+    int       worker = exec->pool->CurrentWorker ();
+    size_t    stride = (size_t)kSweepChunk * (SWP_NumParams (exec->sweep) + 2);
+    int       i;
+
+    if (worker >= 0)
+        for (i = begin; i < end; i++)
+            RunSweepChunk (exec, i, &exec->sweepBuffers[worker * stride]);
+    else
+        {
+        std::lock_guard<std::mutex> guard (exec->callerLock);
+        int32_t *buffer = &exec->sweepBuffers[exec->pool->NumThreads ()
+                                              * stride];
+
+        for (i = begin; i < end; i++)
+            RunSweepChunk (exec, i, buffer);
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Pool callback: drive a whole parameter sweep.  The point indices are      */
+/* split into chunks and the chunks spread over the pool like the steps of   */
+/* a group.                                                                  */
+/*---------------------------------------------------------------------------*/
+static void RunSweepChunks (void *context, int, int)
+{
+    Execution exec = (Execution)context;
+    WorkPool &pool = *exec->pool;
+    TaskGroup chunkTasks;
+    int       numChunks;
+
+    numChunks = (int)((exec->sweepNumPoints + kSweepChunk - 1) / kSweepChunk);
+    PublishProgress (exec, tms::ReadTicks (), 1);
+    pool.ParallelFor (chunkTasks, 0, numChunks,
+                      numChunks / (pool.NumThreads () * 8), RunSweepRange,
+                      exec);
+    pool.Wait (chunkTasks);
+    PublishProgress (exec, tms::ReadTicks (), 0);
+    exec->seq->busy.fetch_sub (1);
+    exec->running.store (0, std::memory_order_release);
+    if (exec->doneCallback)
+        exec->doneCallback (exec, exec->doneCallbackData);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Find the step host's slot for every step, binding each module and symbol  */
+/* once, as PLG_BindSequence does in process.  The steps bound so far are    */
+/* kept in an open addressed table on the run arena.                         */
+/*---------------------------------------------------------------------------*/
+struct BoundSlot
+{
+    uint64_t key;                         /* module << 32 | symbol, + 1 */
+    int32_t  slot;
+};
+
+static void BindHostSlots (Execution exec)
+{
+    Sequence   seq = exec->seq;
+    size_t     numSteps = seq ? seq->Size () : 0;
+    size_t     mask;
+    BoundSlot *bound;
+    size_t     i;
+
+    exec->hostSlots.assign (numSteps, -1);
+    if (!exec->host || !numSteps)
+        return;
+    for (mask = 15; mask < 2 * numSteps; mask = mask * 2 + 1)
+        ;
+    if (!(bound = (BoundSlot *)ARN_Calloc (exec->runArena,
+                                           (mask + 1) * sizeof(*bound))))
+        throw std::bad_alloc ();
+    for (i = 0; i < numSteps; i++)
+        {
+        uint32_t module = seq->module[i];
+        uint64_t key;
+        size_t   probe;
+
+        if (module == StringPool::NotFound)
+            continue;
+        key = (((uint64_t)module << 32) | seq->symbol[i]) + 1;
+        for (probe = (size_t)(key * 0x9E3779B97F4A7C15ull) & mask;
+             bound[probe].key && bound[probe].key != key;
+             probe = (probe + 1) & mask)
+            ;
+        if (!bound[probe].key)
+            {
+            bound[probe].key = key;
+            bound[probe].slot = HST_Bind (exec->host,
+                                          seq->names.Get (module),
+                                          seq->names.Get (seq->symbol[i]));
+            }
+        exec->hostSlots[i] = bound[probe].slot < 0 ? -1 : bound[probe].slot;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Give every worker of the pool, and the other threads, a timing slot if    */
+/* they have none yet.  Every path that runs steps calls this first; it      */
+/* leaves no slots at all if it runs out of memory.                          */
+/*---------------------------------------------------------------------------*/
+static void MakeTimingSlots (Execution exec)
+{
+    std::vector<std::unique_ptr<TimingSlot> > timing;
+    size_t                                    i;
+
+    if (!exec->timing.empty ())
+        return;
+    timing.reserve ((size_t)exec->pool->NumThreads () + 1);
+    for (i = 0; i <= (size_t)exec->pool->NumThreads (); i++)
+        timing.emplace_back (new TimingSlot);
+    exec->timing.swap (timing);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Clear results, counters and timings before a new run.                     */
+/*---------------------------------------------------------------------------*/
+static void ClearResults (Execution exec)
+{
+    ExeResult blank = {0, EXE_STATUS_NOT_RUN};
+    size_t    i;
+
+    MakeTimingSlots (exec);
+    /* results last: EXE_RunStep takes its size to mean all three are set */
+    exec->sweepValues.assign (exec->seq ? exec->seq->args.size () : 0, 0);
+    exec->stepTicks.assign (exec->seq ? exec->seq->Size () : 0, 0);
+    exec->results.assign (exec->seq ? exec->seq->Size () : 0, blank);
+    ARN_Reset (exec->runArena);
+    BindHostSlots (exec);
+    for (i = 0; i < exec->timing.size (); i++)
+        exec->timing[i]->Clear ();
+    exec->numPassed.store (0);
+    exec->numFailed.store (0);
+    exec->cursor = 0;
+    exec->run++;
+    exec->sweeping = 0;
+    exec->startTicks = tms::ReadTicks ();
+    exec->nextPublish.store (exec->startTicks + PublishTicks ());
+    PublishProgress (exec, exec->startTicks, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Create an execution.                                                      */
+/*---------------------------------------------------------------------------*/
+Execution EXE_New (void)
+{
+    Execution exec = new (std::nothrow) ExecutionRec_Tag;
+
+    if (exec && !(exec->runArena = ARN_New (0)))
+        {
+        delete exec;
+        return 0;
+        }
+    return exec;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Discard an execution, waiting for any run in progress.                    */
+/*---------------------------------------------------------------------------*/
+void EXE_Dispose (Execution exec)
+{
+    if (!exec)
+        return;
+    EXE_Wait (exec);
+    ARN_Dispose (exec->runArena);
+    delete exec;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Point the execution at a sequence (0 to unload) and rewind it.            */
+/*---------------------------------------------------------------------------*/
+int EXE_Load (Execution exec, Sequence seq)
+{
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    try
+        {
+        exec->seq = seq;
+        ClearResults (exec);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The loaded sequence, or 0.                                                */
+/*---------------------------------------------------------------------------*/
+Sequence EXE_GetSequence (Execution exec)
+{
+    return exec ? exec->seq : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Make the execution run the unit in the given test socket: steps with a    */
+/* per-socket entry point are called with the socket number.  -1 (the        */
+/* default) calls the plain entry points.                                    */
+/*---------------------------------------------------------------------------*/
+int EXE_SetSocket (Execution exec, int socket)
+{
+    if (!exec || socket < -1)
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    exec->socket = socket;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Run this execution's steps on a pool of numThreads threads of its own,    */
+/* or on the shared pool with 0 (the default).  A private pool keeps a slow  */
+/* execution from holding up the others, and lets its scaling be measured.   */
+/*---------------------------------------------------------------------------*/
+int EXE_SetNumThreads (Execution exec, int numThreads)
+{
+    if (!exec || numThreads < 0)
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    exec->pool->Wait (exec->runGroup);
+    try
+        {
+        std::unique_ptr<WorkPool> ownPool;
+
+        if (numThreads > 0)
+            ownPool.reset (new WorkPool (numThreads));
+        exec->pool = ownPool ? ownPool.get () : &WorkPool::Instance ();
+        exec->ownPool.swap (ownPool);
+
+        /* The timing slots are per worker */
+        exec->timing.clear ();
+        ClearResults (exec);
+        }
+    catch (...)
+        {
+        exec->pool = &WorkPool::Instance ();
+        exec->ownPool.reset ();
+        exec->timing.clear ();
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Record every step result in log from now on (0 to stop).  The log must    */
+/* outlive the execution or be detached first.                               */
+/*---------------------------------------------------------------------------*/
+int EXE_SetResultLog (Execution exec, ResultLog log)
+{
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    exec->log = log;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Call steps through host (see stephost.h) instead of in process, or in     */
+/* process again with 0.                                                     */
+/*---------------------------------------------------------------------------*/
+int EXE_SetStepHost (Execution exec, StepHost host)
+{
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    try
+        {
+        exec->host = host;
+        BindHostSlots (exec);
+        }
+    catch (const std::bad_alloc &)
+        {
+        exec->host = 0;
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of loaded steps.                                                   */
+/*---------------------------------------------------------------------------*/
+int EXE_NumSteps (Execution exec)
+{
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    return exec->seq ? (int)exec->seq->Size () : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Rewind Step mode to the first step and clear results.                     */
+/*---------------------------------------------------------------------------*/
+int EXE_Reset (Execution exec)
+{
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    try
+        {
+        ClearResults (exec);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Step mode: run the next step on the calling thread.  Returns the index of */
+/* the step that ran, or TMS_ERR_NOT_FOUND once the sequence is finished.    */
+/*---------------------------------------------------------------------------*/
+int EXE_RunStep (Execution exec, ExeResult *result)
+{
+    int index;
+
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    if (!exec->seq || exec->cursor >= (int)exec->seq->Size ())
+        return TMS_ERR_NOT_FOUND;
+    try
+        {
+        MakeTimingSlots (exec);
+        if (exec->results.size () != exec->seq->Size ())
+            {
+            ExeResult blank = {0, EXE_STATUS_NOT_RUN};
+
+            exec->sweepValues.resize (exec->seq->args.size (), 0);
+            exec->stepTicks.resize (exec->seq->Size (), 0);
+            BindHostSlots (exec);
+            exec->results.resize (exec->seq->Size (), blank);
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    index = exec->cursor++;
+    {
+    std::lock_guard<std::mutex> guard (exec->callerLock);
+    TaskGroup                   stepTasks;
+
+    exec->stepGroup = &stepTasks;
+    RunSteps (exec, index, index + 1, *exec->timing.back ());
+    exec->pool->Wait (stepTasks);
+    }
+    exec->group.store (exec->seq->group[index], std::memory_order_relaxed);
+    PublishProgress (exec, tms::ReadTicks (), 0);
+    if (result)
+        *result = exec->results[index];
+    return index;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Start running every step on the pool and return immediately.              */
+/* doneCallback (optional) is called from a pool thread at the end.          */
+/*---------------------------------------------------------------------------*/
+int EXE_RunAll (Execution exec, ExeDoneCallbackPtr doneCallback,
+                void *callbackData)
+{
+    int idle = 0;
+
+    if (!exec || !exec->seq)
+        return TMS_ERR_INVALID_ARG;
+    if (!exec->running.compare_exchange_strong (idle, 1))
+        return TMS_ERR_BUSY;
+    try
+        {
+        ClearResults (exec);
+        }
+    catch (const std::bad_alloc &)
+        {
+        exec->running.store (0);
+        return TMS_ERR_NO_MEMORY;
+        }
+    exec->seq->busy.fetch_add (1);
+    exec->doneCallback = doneCallback;
+    exec->doneCallbackData = callbackData;
+    exec->pool->Submit (exec->runGroup, RunAllGroups, exec);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Start a parameter sweep on the pool and return immediately.               */
+/* doneCallback (optional) is called from a pool thread at the end.          */
+/*---------------------------------------------------------------------------*/
+int EXE_RunSweep (Execution exec, ParamSweep sweep,
+                  ExeDoneCallbackPtr doneCallback, void *callbackData)
+{
+    int64_t numPoints;
+    int     numParams;
+    int     status = TMS_OK;
+    int     idle = 0;
+    int     step;
+    int     i;
+
+    if (!exec || !exec->seq || (numParams = SWP_NumParams (sweep)) <= 0)
+        return TMS_ERR_INVALID_ARG;
+    if ((numPoints = SWP_NumPoints (sweep)) < 0)
+        return (int)numPoints;
+    if (numPoints / kSweepChunk >= INT_MAX)
+        return TMS_ERR_NO_MEMORY;
+    if (!exec->running.compare_exchange_strong (idle, 1))
+        return TMS_ERR_BUSY;
+    for (i = 0; i < numParams; i++)
+        {
+        step = SWP_GetParamStep (sweep, i);
+        if (step >= (int)exec->seq->Size ()
+            || exec->seq->kind[step] == SEQ_KIND_SWEEP)
+            status = TMS_ERR_INVALID_ARG;
+        }
+    try
+        {
+        if (status == TMS_OK)
+            {
+            exec->sweepBuffers.resize ((size_t)kSweepChunk * (numParams + 2)
+                                       * (exec->pool->NumThreads () + 1));
+            ARN_Reset (exec->runArena);
+            BindHostSlots (exec);
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        status = TMS_ERR_NO_MEMORY;
+        }
+    if (status < 0)
+        {
+        exec->running.store (0);
+        return status;
+        }
+    exec->sweep = sweep;
+    exec->sweepNumPoints = numPoints;
+    exec->sweepRun.store (0);
+    exec->sweepFailed.store (0);
+    exec->sweepFirstFailed.store (-1);
+    exec->group.store (-1);
+    exec->sweeping = 1;
+    exec->startTicks = tms::ReadTicks ();
+    exec->nextPublish.store (exec->startTicks + PublishTicks ());
+    exec->seq->busy.fetch_add (1);
+    exec->doneCallback = doneCallback;
+    exec->doneCallbackData = callbackData;
+    exec->pool->Submit (exec->runGroup, RunSweepChunks, exec);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Points run and failed by the last parameter sweep, so far if it is still  */
+/* running.                                                                  */
+/*---------------------------------------------------------------------------*/
+int EXE_GetSweepResult (Execution exec, ExeSweepResult *result)
+{
+    if (!exec || !result)
+        return TMS_ERR_INVALID_ARG;
+    result->numPoints = exec->sweepRun.load ();
+    result->numFailed = exec->sweepFailed.load ();
+    result->firstFailed = exec->sweepFirstFailed.load ();
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Non-zero while Run > All is in progress.                                  */
+/*---------------------------------------------------------------------------*/
+int EXE_IsRunning (Execution exec)
+{
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    return exec->running.load (std::memory_order_acquire);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Block until Run > All is finished.                                        */
+/*---------------------------------------------------------------------------*/
+int EXE_Wait (Execution exec)
+{
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    exec->pool->Wait (exec->runGroup);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Result of one step.                                                       */
+/*---------------------------------------------------------------------------*/
+int EXE_GetResult (Execution exec, int step, ExeResult *result)
+{
+    if (!exec || !result || step < 0 || step >= (int)exec->results.size ())
+        return TMS_ERR_INVALID_ARG;
+    *result = exec->results[step];
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Pass/fail totals for the current run.                                     */
+/*---------------------------------------------------------------------------*/
+int EXE_GetCounts (Execution exec, int *numPassed, int *numFailed)
+{
+    if (!exec)
+        return TMS_ERR_INVALID_ARG;
+    if (numPassed)
+        *numPassed = exec->numPassed.load ();
+    if (numFailed)
+        *numFailed = exec->numFailed.load ();
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The last progress snapshot published.                                     */
+/*---------------------------------------------------------------------------*/
+int EXE_GetProgress (Execution exec, ExeProgress *progress)
+{
+    if (!exec || !progress)
+        return TMS_ERR_INVALID_ARG;
+    *progress = exec->progress.Load ();
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Values produced by a sweep step in the last run.  Copies up to maxValues  */
+/* of them and returns the step's number of inputs.                          */
+/*---------------------------------------------------------------------------*/
+int EXE_GetSweepValues (Execution exec, int step, int32_t *values,
+                        int maxValues)
+{
+    Sequence seq;
+    int      count;
+
+    if (!exec || !(seq = exec->seq) || step < 0 || step >= (int)seq->Size ()
+        || maxValues < 0 || (maxValues && !values))
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    count = seq->argCount[step];
+    if (exec->sweepValues.size () >= seq->argOffset[step] + (size_t)count)
+        std::copy (exec->sweepValues.begin () + seq->argOffset[step],
+                   exec->sweepValues.begin () + seq->argOffset[step]
+                   + (count < maxValues ? count : maxValues), values);
+    return count;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Latency summary of the steps run since the last rewind, across all        */
+/* threads.                                                                  */
+/*---------------------------------------------------------------------------*/
+int EXE_GetTiming (Execution exec, ExeTiming *timing)
+{
+    tms::Histogram steps;
+    uint64_t       totalTicks = 0;
+    uint64_t       cpuNanos = 0;
+    double         micros;
+    size_t         i;
+
+    if (!exec || !timing)
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    for (i = 0; i < exec->timing.size (); i++)
+        {
+        steps.Add (exec->timing[i]->steps);
+        totalTicks += exec->timing[i]->totalTicks;
+        cpuNanos += exec->timing[i]->cpuNanos;
+        }
+    micros = tms::NanosPerTick () / 1000.0;
+    timing->numSteps = (int)steps.Count ();
+    timing->wallSeconds = totalTicks * micros / 1e6;
+    timing->cpuSeconds = cpuNanos / 1e9;
+    timing->minMicros = steps.Min () * micros;
+    timing->meanMicros = steps.Count () ? totalTicks * micros / steps.Count ()
+                                        : 0.0;
+    timing->p50Micros = steps.Quantile (0.50) * micros;
+    timing->p90Micros = steps.Quantile (0.90) * micros;
+    timing->p99Micros = steps.Quantile (0.99) * micros;
+    timing->p999Micros = steps.Quantile (0.999) * micros;
+    timing->maxMicros = steps.Max () * micros;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Time one step took in the last run, in microseconds (0 if it did not      */
+/* run).                                                                     */
+/*---------------------------------------------------------------------------*/
+int EXE_GetStepTime (Execution exec, int step, double *micros)
+{
+    if (!exec || !micros || step < 0
+        || step >= (int)exec->stepTicks.size ())
+        return TMS_ERR_INVALID_ARG;
+    if (exec->running.load ())
+        return TMS_ERR_BUSY;
+    *micros = exec->stepTicks[step] * tms::NanosPerTick () / 1000.0;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write text as a JSON string.                                              */
+/*---------------------------------------------------------------------------*/
+static void WriteJsonString (FILE *file, const char *text)
+{
+    const unsigned char *c;
+
+    putc ('"', file);
+    for (c = (const unsigned char *)(text ? text : ""); *c; c++)
+        if (*c == '"' || *c == '\\')
+            fprintf (file, "\\%c", *c);
+        else if (*c < 0x20)
+            fprintf (file, "\\u%04x", *c);
+        else
+            putc (*c, file);
+    putc ('"', file);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write the trace events of one execution as process pid: a metadata event  */
+/* naming each thread, then an event per range and per step.                 */
+/*---------------------------------------------------------------------------*/
+static void WriteTraceEvents (FILE *file, Execution exec, int pid,
+                              double micros)
+{
+    Sequence seq = exec->seq;
+    uint64_t epoch = tms::TickEpoch ();
+    int      numSlots = (int)exec->timing.size ();
+    int      slot;
+    size_t   i;
+
+    fprintf (file, ",\n{\"ph\":\"M\",\"pid\":%d,\"name\":\"process_name\","
+             "\"args\":{\"name\":", pid);
+    if (exec->socket >= 0)
+        fprintf (file, "\"Socket %d\"}}", exec->socket + 1);
+    else
+        fprintf (file, "\"Execution\"}}");
+    for (slot = 0; slot < numSlots; slot++)
+        {
+        const TimingSlot &timing = *exec->timing[slot];
+
+        fprintf (file, ",\n{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                 "\"name\":\"thread_name\",\"args\":{\"name\":", pid, slot);
+        if (slot < numSlots - 1)
+            fprintf (file, "\"Worker %d\"}}", slot + 1);
+        else
+            fprintf (file, "\"Caller\"}}");
+        for (i = 0; i < timing.rangeEvents.size (); i++)
+            {
+            const tms::RangeEvent &range = timing.rangeEvents[i];
+
+            fprintf (file, ",\n{\"ph\":\"X\",\"cat\":\"range\",\"pid\":%d,"
+                     "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                     "\"name\":\"Steps %d-%d\",\"args\":{\"cpu_us\":%.3f}}",
+                     pid, slot, (range.start - epoch) * micros,
+                     range.ticks * micros, range.begin + 1, range.end,
+                     range.cpuNanos / 1000.0);
+            }
+        for (i = 0; i < timing.stepEvents.size (); i++)
+            {
+            const tms::StepEvent &step = timing.stepEvents[i];
+
+            fprintf (file, ",\n{\"ph\":\"X\",\"cat\":\"step\",\"pid\":%d,"
+                     "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                     pid, slot, (step.start - epoch) * micros,
+                     step.ticks * micros);
+            WriteJsonString (file, seq && step.step < (int)seq->Size ()
+                             ? seq->names.Get (seq->name[step.step]) : 0);
+            fprintf (file, ",\"args\":{\"step\":%d}}", step.step + 1);
+            }
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Export the steps timed by one or more executions (the sockets of a set,   */
+/* say) as a Chrome trace, for chrome://tracing or Perfetto.  Each           */
+/* execution is a process and each worker a thread in it.                    */
+/*---------------------------------------------------------------------------*/
+int EXE_ExportTrace (const Execution *execs, int numExecs, const char *path)
+{
+    FILE  *file;
+    double micros;
+    int    failed;
+    int    i;
+
+    if (!execs || numExecs <= 0 || !path)
+        return TMS_ERR_INVALID_ARG;
+    for (i = 0; i < numExecs; i++)
+        {
+        if (!execs[i])
+            return TMS_ERR_INVALID_ARG;
+        if (execs[i]->running.load ())
+            return TMS_ERR_BUSY;
+        }
+    if (!(file = fopen (path, "w")))
+        return TMS_ERR_IO;
+    micros = tms::NanosPerTick () / 1000.0;
+    fprintf (file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+             "{\"ph\":\"M\",\"pid\":0,\"name\":\"process_name\","
+             "\"args\":{\"name\":\"TMS\"}}");
+    for (i = 0; i < numExecs; i++)
+        WriteTraceEvents (file, execs[i], i + 1, micros);
+    fprintf (file, "\n]}\n");
+    failed = ferror (file);
+    if (fclose (file) != 0 || failed)
+        return TMS_ERR_IO;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Size of the shared worker pool.                                           */
+/*---------------------------------------------------------------------------*/
+int EXE_NumThreads (void)
+{
+    return WorkPool::Instance ().NumThreads ();
+}
@@ -0,0 +1,145 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    executor.h                                                       */
+/*                                                                           */
+/* PURPOSE: Headless sequence execution engine behind Run > Step and         */
+/*          Run > All.  Steps that share a group number are independent and  */
+/*          run concurrently on a work-stealing pool sized to the cores;     */
+/*          groups run in order.  Step mode executes one step per call on    */
+/*          the calling thread.  The engine runs a Sequence in place, so the */
+/*          sequence must outlive the execution it is loaded into.           */
+/*          A parameter sweep (sweep.h) runs some of the steps once per      */
+/*          point, handing each worker a chunk of point indices at a time.   */
+/*          Steps can also be called in a separate process (stephost.h).     */
+/*          While it runs, an execution publishes its progress for monitors  */
+/*          to sample without slowing it down.                               */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __EXECUTOR_H__
+#define __EXECUTOR_H__
+
+#include "tmsapi.h"
+#include "sequence.h"
+#include "reslog.h"
+#include "stephost.h"
+#include "sweep.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+#define EXE_STATUS_NOT_RUN  0
+#define EXE_STATUS_PASSED   1
+#define EXE_STATUS_FAILED   2
+
+/* For sweep steps value is the number of points outside the limits */
+typedef struct ExeResultRec_Tag
+{
+    int value;
+    int status;
+} ExeResult;
+
+/* Step timings since the last rewind.  A step's wall time covers the call */
+/* and judging its result; cpuSeconds is the CPU time of the threads that  */
+/* ran the steps, so it falls well short of wallSeconds when steps wait on */
+/* instruments.                                                            */
+typedef struct ExeTimingRec_Tag
+{
+    int    numSteps;
+    double wallSeconds;
+    double cpuSeconds;
+    double minMicros;
+    double meanMicros;
+    double p50Micros;
+    double p90Micros;
+    double p99Micros;
+    double p999Micros;
+    double maxMicros;
+} ExeTiming;
+
+/* Outcome of a parameter sweep, or the counts so far while it runs.  A */
+/* point fails if any of its steps does.                                */
+typedef struct ExeSweepResultRec_Tag
+{
+    int64_t numPoints;                  /* points run */
+    int64_t numFailed;
+    int64_t firstFailed;                /* lowest failed point, or -1 */
+} ExeSweepResult;
+
+/* Progress of the run in progress, or of the last one.  The threads      */
+/* running the steps publish it at group boundaries and at most once a    */
+/* millisecond in between, so it is that old at most, unless every step   */
+/* running takes longer.  group is -1 outside Run > All.                  */
+typedef struct ExeProgressRec_Tag
+{
+    int     running;                    /* Run > All or a sweep */
+    int     numSteps;
+    int     numDone;                    /* steps judged */
+    int     numPassed;
+    int     numFailed;
+    int     group;
+    int64_t numPoints;                  /* of a sweep, run so far */
+    int64_t numFailedPoints;
+    int64_t totalPoints;                /* 0 outside a sweep */
+    double  elapsedSeconds;             /* since the run started */
+} ExeProgress;
+
+typedef struct ExecutionRec_Tag *Execution;
+
+/* Called on a pool thread when Run > All or a sweep finishes */
+typedef void (CVICALLBACK *ExeDoneCallbackPtr) (Execution exec,
+                                                void *callbackData);
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API Execution EXE_New         (void);
+TMS_API void      EXE_Dispose     (Execution exec);
+TMS_API int       EXE_Load        (Execution exec, Sequence seq);
+TMS_API Sequence  EXE_GetSequence (Execution exec);
+TMS_API int       EXE_SetSocket   (Execution exec, int socket);
+TMS_API int       EXE_SetNumThreads (Execution exec, int numThreads);
+TMS_API int       EXE_SetResultLog (Execution exec, ResultLog log);
+TMS_API int       EXE_SetStepHost (Execution exec, StepHost host);
+TMS_API int       EXE_NumSteps    (Execution exec);
+TMS_API int       EXE_Reset       (Execution exec);
+TMS_API int       EXE_RunStep     (Execution exec, ExeResult *result);
+TMS_API int       EXE_RunAll      (Execution exec,
+                                   ExeDoneCallbackPtr doneCallback,
+                                   void *callbackData);
+TMS_API int       EXE_IsRunning   (Execution exec);
+TMS_API int       EXE_Wait        (Execution exec);
+TMS_API int       EXE_GetResult   (Execution exec, int step,
+                                   ExeResult *result);
+TMS_API int       EXE_GetCounts   (Execution exec, int *numPassed,
+                                   int *numFailed);
+TMS_API int       EXE_GetSweepValues (Execution exec, int step, int32_t *values,
+                                      int maxValues);
+
+/* Any thread, at any rate: reading the progress never holds up the run */
+TMS_API int       EXE_GetProgress (Execution exec, ExeProgress *progress);
+
+/* Start running the steps of sweep once per point, with the point's    */
+/* values as their parameters, and return immediately.  Only the swept  */
+/* steps run, which must not be sweep steps; results are counted, not   */
+/* logged.  The sweep must not change until the run is over.            */
+TMS_API int       EXE_RunSweep    (Execution exec, ParamSweep sweep,
+                                   ExeDoneCallbackPtr doneCallback,
+                                   void *callbackData);
+TMS_API int       EXE_GetSweepResult (Execution exec, ExeSweepResult *result);
+
+TMS_API int       EXE_GetTiming   (Execution exec, ExeTiming *timing);
+TMS_API int       EXE_GetStepTime (Execution exec, int step, double *micros);
+TMS_API int       EXE_ExportTrace (const Execution *execs, int numExecs,
+                                   const char *path);
+TMS_API int       EXE_NumThreads  (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EXECUTOR_H__ */
@@ -0,0 +1,164 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    fileio.cpp                                                       */
+/*                                                                           */
+/* PURPOSE: File helpers.  See fileio.h.                                     */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#if defined(_WIN32)
+  #define NOMINMAX
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include "fileio.h"
+
+namespace tms {
+
+MappedFile::MappedFile () : m_data (0), m_size (0), m_file (0), m_mapping (0)
+{
+}
+
+MappedFile::~MappedFile ()
+{
+    Close ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Map a whole file.                                                         */
+/*---------------------------------------------------------------------------*/
+bool MappedFile::Open (const char *path)
+{
+    Close ();
+#if defined(_WIN32)
+    LARGE_INTEGER size;
+    HANDLE        file;
+
+    file = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, 0,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    m_file = file;
+    if (!GetFileSizeEx (file, &size))
+        {
+        Close ();
+        return false;
+        }
+    if (size.QuadPart == 0)
+        return true;
+    m_mapping = CreateFileMappingA (file, 0, PAGE_READONLY, 0, 0, 0);
+    if (m_mapping)
+        m_data = (const char *)MapViewOfFile ((HANDLE)m_mapping, FILE_MAP_READ,
+                                              0, 0, 0);
+    if (!m_data)
+        {
+        Close ();
+        return false;
+        }
+    m_size = (size_t)size.QuadPart;
+    return true;
+#else
+    struct stat info;
+    int         fd;
+    void       *data = MAP_FAILED;
+
+    if ((fd = open (path, O_RDONLY)) < 0)
+        return false;
+    if (fstat (fd, &info) != 0)
+        info.st_size = -1;
+    else if (info.st_size > 0)
+        data = mmap (0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (data != MAP_FAILED)
+        {
+        m_data = (const char *)data;
+        m_size = (size_t)info.st_size;
+        }
+    return m_data != 0 || info.st_size == 0;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/* Unmap.  Pointers into the data become invalid.                            */
+/*---------------------------------------------------------------------------*/
+void MappedFile::Close ()
+{
+#if defined(_WIN32)
+    if (m_data)
+        UnmapViewOfFile (m_data);
+    if (m_mapping)
+        CloseHandle ((HANDLE)m_mapping);
+    if (m_file)
+        CloseHandle ((HANDLE)m_file);
+#else
+    if (m_data)
+        munmap ((void *)m_data, m_size);
+#endif
+    m_data = 0;
+    m_size = 0;
+    m_file = 0;
+    m_mapping = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Push a stream's buffered data through to the disk.                        */
+/*---------------------------------------------------------------------------*/
+bool SyncFile (FILE *file)
+{
+    if (fflush (file) != 0)
+        return false;
+#if defined(_WIN32)
+    return _commit (_fileno (file)) == 0;
+#else
+    return fsync (fileno (file)) == 0;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/* Cut a stream's file to size bytes, dropping anything buffered.            */
+/*---------------------------------------------------------------------------*/
+bool TruncateFile (FILE *file, uint64_t size)
+{
+    if (fflush (file) != 0)
+        return false;
+#if defined(_WIN32)
+    return _chsize_s (_fileno (file), (__int64)size) == 0;
+#else
+    return ftruncate (fileno (file), (off_t)size) == 0;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/* Atomically replace to with from.  On POSIX the directory is synced too,   */
+/* so the rename itself survives a crash.                                    */
+/*---------------------------------------------------------------------------*/
+bool RenameOver (const std::string &from, const std::string &to)
+{
+#if defined(_WIN32)
+    return MoveFileExA (from.c_str (), to.c_str (),
+                        MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)
+           != 0;
+#else
+    size_t      slash = to.find_last_of ('/');
+    std::string dir = slash == std::string::npos ? std::string (".")
+                                                 : to.substr (0, slash + 1);
+    int         fd;
+
+    if (rename (from.c_str (), to.c_str ()) != 0)
+        return false;
+    if ((fd = open (dir.c_str (), O_RDONLY)) >= 0)
+        {
+        fsync (fd);
+        close (fd);
+        }
+    return true;
+#endif
+}
+
+} /* namespace tms */
@@ -0,0 +1,58 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    fileio.h                                                         */
+/*                                                                           */
+/* PURPOSE: File helpers shared by the engine modules that persist state:    */
+/*          read-only mapping of a whole file (mmap on POSIX, a file         */
+/*          mapping on Windows) for loaders that use its contents in place,  */
+/*          and crash-safe replacement of a file.  C++ only -- not part of   */
+/*          the exported C API.                                              */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __FILEIO_H__
+#define __FILEIO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+namespace tms {
+
+class MappedFile
+{
+public:
+    MappedFile ();
+    ~MappedFile ();
+
+    /* Map path.  False if it is missing or cannot be mapped; an empty */
+    /* file maps to no data.                                           */
+    bool        Open  (const char *path);
+    void        Close ();
+
+    const char *Data () const { return m_data; }
+    size_t      Size () const { return m_size; }
+
+private:
+    MappedFile (const MappedFile &);
+    MappedFile &operator= (const MappedFile &);
+
+    const char *m_data;
+    size_t      m_size;
+    void       *m_file;       /* Windows file and mapping handles */
+    void       *m_mapping;
+};
+
+/* Push a stream's buffered data through to the disk */
+bool SyncFile     (FILE *file);
+
+/* Cut a file open for writing to size bytes */
+bool TruncateFile (FILE *file, uint64_t size);
+
+/* Atomically replace to with from, making the rename itself durable */
+bool RenameOver   (const std::string &from, const std::string &to);
+
+} /* namespace tms */
+
+#endif /* __FILEIO_H__ */
@@ -0,0 +1,457 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    findidx.cpp                                                      */
+/*                                                                           */
+/* PURPOSE: Find and Replace index.  See findidx.h.                          */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "findidx.h"
+#include "seqtable.h"
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+
+/* Field numbers; FND_FIELD_* is 1 << field */
+enum { kName, kModule, kSymbol, kParam, kNumFields };
+
+static const uint32_t kNoTerm = 0xFFFFFFFFu;
+
+/* A distinct string (or parameter value) some step uses */
+struct FindTerm
+{
+    std::string folded;                 /* lower case, for matching */
+    uint32_t    stringId;               /* id in the pool, or NotFound */
+
+    /* Entries step * kNumFields + field, in no order.  An entry whose   */
+    /* step has since moved to another term is stale and skipped.       */
+    std::vector<uint32_t> postings;
+};
+
+struct FindIndexRec_Tag
+{
+    Sequence                                   seq;
+    std::vector<FindTerm>                      terms;
+    std::unordered_map<uint32_t, uint32_t>     termOfString;
+    std::unordered_map<int32_t, uint32_t>      termOfParam;
+    std::unordered_map<uint32_t, std::vector<uint32_t> > grams;
+
+    /* Term of each field of each step: the index's copy of the table */
+    std::vector<uint32_t>                      stepTerms;
+    size_t                                     numPostings;
+    size_t                                     numStale;
+
+    /* Scratch for queries: matched fields of each step */
+    std::vector<uint8_t>                       marks;
+
+    FindIndexRec_Tag () : seq (0), numPostings (0), numStale (0) {}
+};
+
+/*---------------------------------------------------------------------------*/
+/* Lower-case ASCII, which is all step and symbol names use.                 */
+/*---------------------------------------------------------------------------*/
+static std::string Fold (const char *text)
+{
+    std::string folded (text);
+    size_t      i;
+
+    for (i = 0; i < folded.size (); i++)
+        if (folded[i] >= 'A' && folded[i] <= 'Z')
+            folded[i] = (char)(folded[i] - 'A' + 'a');
+    return folded;
+}
+
+static uint32_t Trigram (const std::string &text, size_t i)
+{
+    return ((uint32_t)(unsigned char)text[i] << 16)
+           | ((uint32_t)(unsigned char)text[i + 1] << 8)
+           | (uint32_t)(unsigned char)text[i + 2];
+}
+
+/*---------------------------------------------------------------------------*/
+/* Add a term and list it under each of its trigrams.                        */
+/*---------------------------------------------------------------------------*/
+static uint32_t AddTerm (FindIndex index, const char *text, uint32_t stringId)
+{
+    uint32_t              term = (uint32_t)index->terms.size ();
+    std::vector<uint32_t> grams;
+    size_t                i;
+
+    index->terms.push_back (FindTerm ());
+    index->terms.back ().folded = Fold (text);
+    index->terms.back ().stringId = stringId;
+
+    const std::string &folded = index->terms.back ().folded;
+
+    for (i = 0; i + 3 <= folded.size (); i++)
+        grams.push_back (Trigram (folded, i));
+    std::sort (grams.begin (), grams.end ());
+    grams.erase (std::unique (grams.begin (), grams.end ()), grams.end ());
+    for (i = 0; i < grams.size (); i++)
+        index->grams[grams[i]].push_back (term);
+    return term;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Term of one field of step i, added if it is new.                          */
+/*---------------------------------------------------------------------------*/
+static uint32_t TermOf (FindIndex index, size_t i, int field)
+{
+    Sequence seq = index->seq;
+    uint32_t id;
+    char     text[16];
+
+    if (field == kParam)
+        {
+        int32_t param = seq->param[i];
+        std::unordered_map<int32_t, uint32_t>::iterator it
+            = index->termOfParam.find (param);
+
+        if (it != index->termOfParam.end ())
+            return it->second;
+        sprintf (text, "%d", (int)param);
+        return index->termOfParam[param]
+               = AddTerm (index, text, tms::StringPool::NotFound);
+        }
+    id = field == kName ? seq->name[i]
+                        : field == kModule ? seq->module[i] : seq->symbol[i];
+    if (id == tms::StringPool::NotFound)
+        return kNoTerm;
+
+    std::unordered_map<uint32_t, uint32_t>::iterator it
+        = index->termOfString.find (id);
+
+    if (it != index->termOfString.end ())
+        return it->second;
+    return index->termOfString[id] = AddTerm (index, seq->names.Get (id), id);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Re-read the fields of step i.                                             */
+/*---------------------------------------------------------------------------*/
+static void IndexStep (FindIndex index, size_t i)
+{
+    uint32_t entry;
+    uint32_t term;
+    int      field;
+
+    for (field = 0; field < kNumFields; field++)
+        {
+        entry = (uint32_t)(i * kNumFields + field);
+        term = TermOf (index, i, field);
+        if (term == index->stepTerms[entry])
+            continue;
+        if (index->stepTerms[entry] != kNoTerm)
+            index->numStale++;
+        index->stepTerms[entry] = term;
+        if (term != kNoTerm)
+            {
+            index->terms[term].postings.push_back (entry);
+            index->numPostings++;
+            }
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Rebuild the postings from the step table copy once most are stale.        */
+/*---------------------------------------------------------------------------*/
+static void Compact (FindIndex index)
+{
+    size_t entry;
+
+    for (entry = 0; entry < index->terms.size (); entry++)
+        index->terms[entry].postings.clear ();
+    index->numPostings = index->numStale = 0;
+    for (entry = 0; entry < index->stepTerms.size (); entry++)
+        if (index->stepTerms[entry] != kNoTerm)
+            {
+            index->terms[index->stepTerms[entry]].postings.push_back (
+                (uint32_t)entry);
+            index->numPostings++;
+            }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Forget everything after a failed update.  The next update then reads the  */
+/* whole table again, rather than trust an index left half updated.          */
+/*---------------------------------------------------------------------------*/
+static void Clear (FindIndex index)
+{
+    index->terms.clear ();
+    index->termOfString.clear ();
+    index->termOfParam.clear ();
+    index->grams.clear ();
+    index->stepTerms.clear ();
+    index->numPostings = index->numStale = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Mark the fields of every step matching text, and return the terms that    */
+/* matched.  Queries of three characters or more only check the terms        */
+/* listed under the rarest of their trigrams; shorter ones check them all.   */
+/*---------------------------------------------------------------------------*/
+static std::vector<uint32_t> Match (FindIndex index, const char *text,
+                                    int fields)
+{
+    std::string           query = Fold (text);
+    std::vector<uint32_t> matched;
+    const uint32_t       *candidates = 0;
+    size_t                numCandidates = index->terms.size ();
+    size_t                i;
+    size_t                j;
+
+    for (i = 0; i + 3 <= query.size (); i++)
+        {
+        std::unordered_map<uint32_t, std::vector<uint32_t> >::const_iterator
+            it = index->grams.find (Trigram (query, i));
+
+        if (it == index->grams.end ())
+            return matched;
+        if (!candidates || it->second.size () < numCandidates)
+            {
+            candidates = it->second.data ();
+            numCandidates = it->second.size ();
+            }
+        }
+    for (i = 0; i < numCandidates; i++)
+        {
+        uint32_t term = candidates ? candidates[i] : (uint32_t)i;
+
+        if (index->terms[term].folded.find (query) != std::string::npos)
+            matched.push_back (term);
+        }
+
+    index->marks.assign (index->stepTerms.size () / kNumFields, 0);
+    for (i = 0; i < matched.size (); i++)
+        {
+        const std::vector<uint32_t> &postings
+            = index->terms[matched[i]].postings;
+
+        for (j = 0; j < postings.size (); j++)
+            {
+            uint32_t entry = postings[j];
+            int      field = (int)(entry % kNumFields);
+
+            if ((fields & (1 << field))
+                && index->stepTerms[entry] == matched[i])
+                index->marks[entry / kNumFields] |= (uint8_t)(1 << field);
+            }
+        }
+    return matched;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Replace every occurrence of query in text, ignoring case.                 */
+/*---------------------------------------------------------------------------*/
+static std::string ReplaceAll (const char *text, const std::string &query,
+                               const char *replacement)
+{
+    std::string folded = Fold (text);
+    std::string result;
+    size_t      start = 0;
+    size_t      found;
+
+    while ((found = folded.find (query, start)) != std::string::npos)
+        {
+        result.append (text + start, found - start);
+        result.append (replacement);
+        start = found + query.size ();
+        }
+    result.append (text + start);
+    return result;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Index every step of seq.                                                  */
+/*---------------------------------------------------------------------------*/
+FindIndex FND_New (Sequence seq)
+{
+    FindIndex index;
+
+    if (!seq)
+        return 0;
+    if (!(index = new (std::nothrow) FindIndexRec_Tag))
+        return 0;
+    index->seq = seq;
+    if (FND_Update (index, 0, -1) < 0)
+        {
+        delete index;
+        return 0;
+        }
+    return index;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Discard an index.                                                         */
+/*---------------------------------------------------------------------------*/
+void FND_Dispose (FindIndex index)
+{
+    delete index;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Bring the index up to date after an edit.  Only the steps named, and      */
+/* those past the end of the shorter of the index and the table, are read.   */
+/*---------------------------------------------------------------------------*/
+int FND_Update (FindIndex index, int firstStep, int numSteps)
+{
+    size_t size;
+    size_t oldSize;
+    size_t end;
+    size_t i;
+
+    if (!index || firstStep < 0)
+        return TMS_ERR_INVALID_ARG;
+    size = index->seq->Size ();
+    oldSize = index->stepTerms.size () / kNumFields;
+    end = numSteps < 0 ? size : (size_t)firstStep + (size_t)numSteps;
+    if (end > oldSize)
+        end = oldSize;
+    if (end > size)
+        end = size;
+    try
+        {
+        for (i = size * kNumFields; i < index->stepTerms.size (); i++)
+            if (index->stepTerms[i] != kNoTerm)
+                index->numStale++;
+        index->stepTerms.resize (size * kNumFields, kNoTerm);
+        for (i = (size_t)firstStep; i < end; i++)
+            IndexStep (index, i);
+        for (i = oldSize; i < size; i++)
+            IndexStep (index, i);
+        if (index->numStale > 4096 && index->numStale * 2 > index->numPostings)
+            Compact (index);
+        }
+    catch (const std::bad_alloc &)
+        {
+        Clear (index);
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Find the steps matching text.                                             */
+/*---------------------------------------------------------------------------*/
+int FND_Find (FindIndex index, const char *text, int fields,
+              FndMatch *matches, int maxMatches)
+{
+    size_t i;
+    int    numMatches = 0;
+
+    if (!index || !text || !text[0] || maxMatches < 0
+        || (maxMatches && !matches))
+        return TMS_ERR_INVALID_ARG;
+    try
+        {
+        Match (index, text, fields);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    for (i = 0; i < index->marks.size (); i++)
+        if (index->marks[i])
+            {
+            if (numMatches < maxMatches)
+                {
+                matches[numMatches].step = (int)i;
+                matches[numMatches].fields = index->marks[i];
+                }
+            numMatches++;
+            }
+    return numMatches;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Replace text in every matching step.  Each matching string is rewritten   */
+/* and interned once, however many steps use it; the steps then just take    */
+/* the new string's id.                                                      */
+/*---------------------------------------------------------------------------*/
+int FND_Replace (FindIndex index, const char *text, int fields,
+                 const char *replacement, int *firstStep, int *numSteps)
+{
+    static const int kTextFields = FND_FIELD_NAME | FND_FIELD_MODULE
+                                   | FND_FIELD_SYMBOL;
+    Sequence  seq;
+    size_t    first = 0;
+    size_t    last = 0;
+    size_t    i;
+    int       numChanged = 0;
+    uint32_t *columns[kNumFields] = { 0, 0, 0, 0 };
+
+    if (!index || !text || !text[0] || !replacement || !firstStep
+        || !numSteps)
+        return TMS_ERR_INVALID_ARG;
+    *firstStep = *numSteps = 0;
+    seq = index->seq;
+    if (seq->busy.load ())
+        return TMS_ERR_BUSY;
+    fields &= kTextFields;
+    try
+        {
+        std::vector<uint32_t> matched = Match (index, text, fields);
+        std::vector<uint32_t> newIds (index->terms.size (), kNoTerm);
+        std::string           query = Fold (text);
+
+        for (i = 0; i < matched.size (); i++)
+            {
+            const FindTerm &term = index->terms[matched[i]];
+
+            if (term.stringId != tms::StringPool::NotFound)
+                newIds[matched[i]] = seq->names.Intern (
+                    ReplaceAll (seq->names.Get (term.stringId), query,
+                                replacement).c_str ());
+            }
+        if (fields & FND_FIELD_NAME)
+            columns[kName] = seq->name.MutableData ();
+        if (fields & FND_FIELD_MODULE)
+            columns[kModule] = seq->module.MutableData ();
+        if (fields & FND_FIELD_SYMBOL)
+            columns[kSymbol] = seq->symbol.MutableData ();
+
+        for (i = 0; i < index->marks.size (); i++)
+            {
+            bool changed = false;
+            int  field;
+
+            for (field = 0; field < kParam; field++)
+                {
+                uint32_t newId;
+
+                if (!(index->marks[i] & (1 << field)))
+                    continue;
+                newId = newIds[index->stepTerms[i * kNumFields + field]];
+                if (newId == kNoTerm || newId == columns[field][i])
+                    continue;
+                columns[field][i] = newId;
+                changed = true;
+                }
+            if (!changed)
+                continue;
+            if (!numChanged++)
+                first = i;
+            last = i;
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    if (numChanged)
+        {
+        *firstStep = (int)first;
+        *numSteps = (int)(last - first + 1);
+        FND_Update (index, *firstStep, *numSteps);
+        }
+    return numChanged;
+}
@@ -0,0 +1,78 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    findidx.h                                                        */
+/*                                                                           */
+/* PURPOSE: Find and Replace index of one sequence.  Step names, module and  */
+/*          symbol names and parameters are indexed by the distinct strings  */
+/*          they use: each string is broken into trigrams, and each string   */
+/*          lists the steps that use it.  A query looks up its trigrams,     */
+/*          checks the few strings they lead to and gathers their steps, so  */
+/*          it costs the number of matches, not the number of steps.  The    */
+/*          index is kept up to date edit by edit (FND_Update), not rebuilt. */
+/*          Matching is a case-insensitive substring match.  Not             */
+/*          thread-safe; use one index per thread.                           */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __FINDIDX_H__
+#define __FINDIDX_H__
+
+#include "tmsapi.h"
+#include "sequence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Fields to search, or-ed together.  Parameters match as decimal text.      */
+/*---------------------------------------------------------------------------*/
+#define FND_FIELD_NAME      1
+#define FND_FIELD_MODULE    2
+#define FND_FIELD_SYMBOL    4
+#define FND_FIELD_PARAM     8
+#define FND_FIELD_ALL       15
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct FindIndexRec_Tag *FindIndex;
+
+typedef struct
+{
+    int step;
+    int fields;                         /* FND_FIELD_* that matched */
+} FndMatch;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+
+/* Index seq, which must outlive the index */
+TMS_API FindIndex FND_New     (Sequence seq);
+TMS_API void      FND_Dispose (FindIndex index);
+
+/* Re-read steps [firstStep, firstStep + numSteps) after an edit, plus */
+/* any steps added or removed at the end; numSteps < 0 re-reads all    */
+TMS_API int       FND_Update  (FindIndex index, int firstStep, int numSteps);
+
+/* Steps whose fields contain text, in step order.  Fills up to        */
+/* maxMatches and returns the number of steps that match.              */
+TMS_API int       FND_Find    (FindIndex index, const char *text,
+                               int fields, FndMatch *matches,
+                               int maxMatches);
+
+/* Replace text by replacement in the name, module and symbol fields    */
+/* selected (not parameters) of every step that matches, as one edit.   */
+/* Returns the number of steps changed, which all lie in                */
+/* [*firstStep, *firstStep + *numSteps).  Steps whose module or symbol  */
+/* changed must be bound again (PLG_BindSequence).                      */
+TMS_API int       FND_Replace (FindIndex index, const char *text,
+                               int fields, const char *replacement,
+                               int *firstStep, int *numSteps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FINDIDX_H__ */
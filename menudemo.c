@@ -17,6 +17,9 @@
 #include <userint.h>
 #include "menudemo.h"
 #include "menuutil.h"
+#include "docctl.h"
+#include "arena.h"
+#include "uicvi.h"
 
 /*---------------------------------------------------------------------------*/
 /* Defines                                                                   */
@@ -26,15 +29,20 @@
 #else
   #define DEMO_REGISTRY_NAME "menudemo.ini"
 #endif
-
-/*---------------------------------------------------------------------------*/
-/* Types                                                                     */
-/*---------------------------------------------------------------------------*/
-typedef struct WindowMenuCallbackDataRec_Tag
-{
-    char fileName[MAX_PATHNAME_LEN];
-    int  panel;
-} WindowMenuCallbackData;
+#define DEMO_SESSION_FILE  "menudemo.session"
+#define DEMO_RESULT_FILE   "menudemo.results"
+#define DEMO_SOCKET_RESULT_FILE "menudemo.socket%d.results"
+#define DEMO_NUM_SOCKETS   8
+#define DEMO_TRACE_FILE    "menudemo.trace.json"
+#define DEMO_ADD_STEPS     "100"
+#define DEMO_STEP_MODULE   "add"
+#define DEMO_FIND_LINES    8
+#define DEMO_SWEEP_RANGES  "0:99:1 0:99:1 0:99:1"
+#define DEMO_STEP_HOST     "tmshost"
+#define DEMO_MONITOR_RATE  20           /* monitor refreshes per second */
+#define WINDOW_LIST_MAX    5
+#define FILE_LIST_MAX      5
+#define RESTORE_BATCH      16
 
 /*---------------------------------------------------------------------------*/
 /* Module-globals                                                            */
@@ -44,27 +52,32 @@ static int g_menubarHandle;
 static IniText g_iniTextHandle = 0;
 static menuList g_fileMenuListHandle = 0;
 static menuList g_winMenuListHandle = 0;
-static char g_msgBuffer[512];
-static int g_numChildPanels = 0;
-static int g_topLeftValue = 0;
+static char g_msgBuffer[1024];
+static DocController g_docctl = 0;
+static SessionLog g_session = 0;
+static ResultLog g_results = 0;
+static int g_timingPanel = 0;
+static int g_timingText = 0;
+static int g_monitorPanel = 0;
+static int g_monitorText = 0;
+static int g_sweepItem = 0;
+static int g_isolateItem = 0;
+static ParamSweep g_sweep = 0;
+static int g_reopen = 0;
 
 /*---------------------------------------------------------------------------*/
 /* Internal function prototypes                                              */
 /*---------------------------------------------------------------------------*/
-static int DimMenuItems                (void);
-static int GetTopChildWindow           (int panelHandle);
 static int SaveOptionsForUIR           (void);
 static int GetOptionsForUIR            (void);
 static int CreateWindowMenuList        (void); 
 static int RemoveWindowMenuList        (void); 
-static int AddFileNameToWindowMenuList (menuList menuListHandle,
-                                        char *fullPathAndFilename, int panel);
-static int AddFileNameToFileMenuList   (menuList menuListHandle,
-                                        char *fullPathAndFilename);
-static int RemoveFileNameFromMenuList  (menuList menuListHandle,
-                                        char *fullPathAndFilename);
-static int CheckForFileNameInMenuList  (menuList menuListHandle,
-                                        char *fullPathAndFilename);
+static int FillFileMenuList            (void);
+static int RestoreSession              (int numOpen);
+static void CVICALLBACK SessionLoadedCallback (SessionLog session,
+                                               void *callbackData);
+static void CVICALLBACK SessionLoaded  (void *callbackData);
+static void CVICALLBACK RestoreDocuments (void *callbackData);
 
 static void CVICALLBACK FILEMenuListCallbackFunc (menuList list, int menuIndex,
                                                   int event,
@@ -72,6 +85,59 @@ static void CVICALLBACK FILEMenuListCallbackFunc (menuList list, int menuIndex,
 static void CVICALLBACK WINDOWMenuListCallbackFunc (menuList list,
                                                     int menuIndex, int event,
                                                     void *callbackData);
+static int CVICALLBACK DocumentPanelCallback (int panel, int event,
+                                              void *callbackData,
+                                              int eventData1, int eventData2);
+static void CVICALLBACK DocumentViewCallback (int panel, int event,
+                                              int index);
+static int  OpenDocument               (char *fileName);
+static int  LoadTopSequence            (void);
+static void CVICALLBACK RunAllDoneCallback (SocketSet sockets,
+                                            void *callbackData);
+static void CVICALLBACK RunAllFinished (void *callbackData);
+static int CVICALLBACK TimingPanelCallback (int panel, int event,
+                                            void *callbackData,
+                                            int eventData1, int eventData2);
+static void UpdateTimingPanel          (void);
+static int CVICALLBACK MonitorPanelCallback (int panel, int event,
+                                             void *callbackData,
+                                             int eventData1, int eventData2);
+static int CVICALLBACK MonitorTick    (int panel, int control, int event,
+                                       void *callbackData, int eventData1,
+                                       int eventData2);
+static void UpdateMonitorPanel         (void);
+static void CVICALLBACK SweepDoneCallback (Execution exec,
+                                           void *callbackData);
+static void CVICALLBACK SweepFinished (void *callbackData);
+
+void CVICALLBACK RunStep (int menuBar, int menuItem, void *callbackData,
+                          int panel);
+void CVICALLBACK RunAll  (int menuBar, int menuItem, void *callbackData,
+                          int panel);
+void CVICALLBACK RunIsolateSteps   (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK EditUndo          (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK EditRedo          (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK EditFind          (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK EditReplace       (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK SequenceAdd       (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK SequenceCombinate (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK SequenceSweep     (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK ViewTab           (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK ViewTiming        (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK ViewExportTrace   (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
+void CVICALLBACK ViewMonitor       (int menuBar, int menuItem,
+                                    void *callbackData, int panel);
 
 /*---------------------------------------------------------------------------*/
 /* This is the application's entry-point.                                    */
@@ -83,13 +149,68 @@ int main (int argc, char *argv[])
     if ((g_panelHandle = LoadPanel (0, "menudemo.uir", PANEL)) < 0)
         return -1;
     g_menubarHandle = GetPanelMenuBar (g_panelHandle);
+    
+    /* The Edit, Sequence and Run menus are not wired in the UIR, so */
+    /* install their callbacks here                                   */
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_EDIT_UNDO,
+                         ATTR_CALLBACK_FUNCTION_POINTER, EditUndo);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_EDIT_REDO,
+                         ATTR_CALLBACK_FUNCTION_POINTER, EditRedo);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_EDIT_FIND,
+                         ATTR_CALLBACK_FUNCTION_POINTER, EditFind);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_EDIT_REPLACE,
+                         ATTR_CALLBACK_FUNCTION_POINTER, EditReplace);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_SEQUENCE_ADD,
+                         ATTR_CALLBACK_FUNCTION_POINTER, SequenceAdd);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_SEQUENCE_COMBINATE,
+                         ATTR_CALLBACK_FUNCTION_POINTER, SequenceCombinate);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_STEP,
+                         ATTR_CALLBACK_FUNCTION_POINTER, RunStep);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_ALL,
+                         ATTR_CALLBACK_FUNCTION_POINTER, RunAll);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_VIEW_TAB,
+                         ATTR_CALLBACK_FUNCTION_POINTER, ViewTab);
+    g_sweepItem = NewMenuItem (g_menubarHandle, MAINMENU_SEQUENCE,
+                               "Sweep...", -1, 0, SequenceSweep, 0);
+    g_isolateItem = NewMenuItem (g_menubarHandle, MAINMENU_RUN,
+                                 "Isolate Steps", -1, 0, RunIsolateSteps, 0);
+    NewMenuItem (g_menubarHandle, MAINMENU_VIEW, "Step Timing...", -1, 0,
+                 ViewTiming, 0);
+    NewMenuItem (g_menubarHandle, MAINMENU_VIEW, "Live Monitor...", -1, 0,
+                 ViewMonitor, 0);
+    NewMenuItem (g_menubarHandle, MAINMENU_VIEW, "Export Timing Trace...", -1,
+                 0, ViewExportTrace, 0);
     GetOptionsForUIR ();
-    DimMenuItems ();
     CreateWindowMenuList ();
+    
+    /* The document logic reaches the UI through the CVI backend */
+    UI_CviInit (g_menubarHandle, g_fileMenuListHandle, g_winMenuListHandle,
+                DocumentPanelCallback);
+    UI_CviSetViewCallback (DocumentViewCallback);
+    g_docctl = DCT_New (UI_CviBackend (), g_panelHandle, WINDOW_LIST_MAX);
+    DCT_SetSession (g_docctl, g_session);
+    DCT_SetMaxRecentFiles (g_docctl, FILE_LIST_MAX);
+    
+    /* Every step result goes to the result log, written in the background */
+    g_results = RLG_New (DEMO_RESULT_FILE);
+    EXE_SetResultLog (DCT_GetExecution (g_docctl), g_results);
+    
+    /* Run->All tests a fixture of units at once, each logged on its own */
+    DCT_SetNumSockets (g_docctl, DEMO_NUM_SOCKETS);
+    SKT_OpenResultLogs (DCT_GetSockets (g_docctl), DEMO_SOCKET_RESULT_FILE);
+    
+    /* Show the panel now; the MRU list and the documents of the last   */
+    /* session are filled in as the session store finishes loading them */
     DisplayPanel (g_panelHandle);
     RunUserInterface ();
     
-    /* Free resources and return */
+    /* Free resources and return.  Disposing of the session writes its */
+    /* final snapshot, so the controller has to go first; it also      */
+    /* waits for a run in progress, which may still be logging results */
+    DCT_Dispose (g_docctl);
+    SWP_Dispose (g_sweep);
+    SES_Dispose (g_session);
+    RLG_Dispose (g_results);
     RemoveWindowMenuList ();
     SaveOptionsForUIR ();
     DiscardPanel (g_panelHandle);
@@ -97,25 +218,6 @@ int main (int argc, char *argv[])
     return 0;
 }
 
-/*---------------------------------------------------------------------------*/
-/* Dim File and Window menu items depending on whether or not a file is      */
-/* open.                                                                  */ 
-/*---------------------------------------------------------------------------*/
-static int DimMenuItems(void) 
-{
-    SetMenuBarAttribute (g_menubarHandle, MAINMENU_FILE_SAVE, ATTR_DIMMED,
-                         !g_numChildPanels);
-    SetMenuBarAttribute (g_menubarHandle, MAINMENU_FILE_SAVEAS, ATTR_DIMMED,
-                         !g_numChildPanels);
-    SetMenuBarAttribute (g_menubarHandle, MAINMENU_FILE_CLOSE, ATTR_DIMMED,
-                         !g_numChildPanels);
-    SetMenuBarAttribute (g_menubarHandle, MAINMENU_WINDOW_CLOSEALL,
-                         ATTR_DIMMED, !g_numChildPanels);
-    SetMenuBarAttribute (g_menubarHandle, MAINMENU_WINDOW_HIDEALL,
-                         ATTR_DIMMED, !g_numChildPanels);
-    return 0;    
-}        
-
 /*---------------------------------------------------------------------------*/
 /* Create a menu list in the WINDOW menu.                                    */
 /*---------------------------------------------------------------------------*/
@@ -123,17 +225,20 @@ static int CreateWindowMenuList (void)
 {
     if (!g_winMenuListHandle)
         g_winMenuListHandle = MU_CreateMenuList (g_menubarHandle,
-                                                 MAINMENU_WINDOW, -1, 5,
+                                                 MAINMENU_WINDOW, -1,
+                                                 WINDOW_LIST_MAX,
                                                  WINDOWMenuListCallbackFunc);
         
     if (g_winMenuListHandle) 
         {
         
-        /* Update Attributes of the successfully createed list*/
+        /* Update Attributes of the successfully createed list.  The  */
+        /* document registry already rejects duplicate paths, and two */
+        /* paths may share a short name, so the list must keep both   */
         MU_SetMenuListAttribute (g_winMenuListHandle, 0,
                                  ATTR_MENULIST_APPEND_SHORTCUT, 1);
         MU_SetMenuListAttribute (g_winMenuListHandle, 0,
-                                 ATTR_MENULIST_ALLOW_DUPLICATE_ITEMS, 0);
+                                 ATTR_MENULIST_ALLOW_DUPLICATE_ITEMS, 1);
         }    
     else
         MessagePopup ("MenuDemo", "Unable to create WINDOW menu list.");
@@ -151,30 +256,34 @@ static int RemoveWindowMenuList(void)
 }
 
 /*---------------------------------------------------------------------------*/
-/* Get saved UIR options and update the UIR -- this means initializing the   */
-/* MRU File menu item list.                                                  */
+/* Get saved UIR options and update the UIR -- this means creating the MRU   */
+/* File menu item list.  The session store is the source of truth; it loads  */
+/* on its own thread, and FillFileMenuList fills the list in once it has.    */
 /*---------------------------------------------------------------------------*/
 static int GetOptionsForUIR (void)
 {
     int success = 1;
 
+    /* Open the session store: maps its image and replays its log.  If */
+    /* it cannot be opened, fill the menu from the registry straight    */
+    /* away                                                             */
+    if (!g_session
+        && !(g_session = SES_Open (DEMO_SESSION_FILE, FILE_LIST_MAX,
+                                   SessionLoadedCallback, 0)))
+        PostDeferredCall (SessionLoaded, 0);
+    
     /* Create an INI object */
     if (!g_iniTextHandle)
         g_iniTextHandle = Ini_New (0);
 
-    /* Get options and update UIR */
+    /* Create FILE menulist if it does not already exist */
     if (g_iniTextHandle)
         {
-        
-        /* Read previous MRU list data from system */      
-        MU_ReadRegistryInfo (g_iniTextHandle, DEMO_REGISTRY_NAME);
-
-        /* Create FILE menulist if it does not already exist */
         if (!g_fileMenuListHandle)
             g_fileMenuListHandle = MU_CreateMenuList (g_menubarHandle,
                                                       MAINMENU_FILE,
                                                       MAINMENU_FILE_ABOVE_EXIT_LINE,
-                                                      5,
+                                                      FILE_LIST_MAX,
                                                       FILEMenuListCallbackFunc);
             
         if (g_fileMenuListHandle)
@@ -186,17 +295,70 @@ static int GetOptionsForUIR (void)
             MU_SetMenuListAttribute (g_fileMenuListHandle, 0,
                                      ATTR_MENULIST_ALLOW_DUPLICATE_ITEMS,
                                      0);
-            
-            /* Update FILE menulist with files from INI object */
-            MU_GetFileListFromIniFile (g_fileMenuListHandle, g_iniTextHandle,
-                                       "FILE MenuList", "Filename", 1);
-            }    
+            }
         }
     else
         success = 0;
     return success;
 }   
 
+/*---------------------------------------------------------------------------*/
+/* Fill the MRU File menu item list from the loaded session store, or the    */
+/* first time from the system registry, which then seeds the store.          */
+/*---------------------------------------------------------------------------*/
+static int FillFileMenuList (void)
+{
+    int        item;
+    const char *fileName;
+
+    if (!g_iniTextHandle || !g_fileMenuListHandle)
+        return 0;
+    
+    /* Update FILE menulist with files from the session, oldest first.  */
+    /* Files opened while the store was loading are already on both    */
+    /* lists, so the menu is emptied and rebuilt in the session's order */
+    if (SES_HasSavedState (g_session) > 0)
+        {
+        while (MU_GetNumMenuListItems (g_fileMenuListHandle) > 0)
+            MU_DeleteMenuListItem (g_fileMenuListHandle, 1);
+        for (item = SES_NumRecent (g_session) - 1; item >= 0; item--)
+            {
+            fileName = SES_GetRecent (g_session, item);
+            MU_AddItemToMenuList (g_fileMenuListHandle, FRONT_OF_LIST,
+                                  MU_MakeShortFileName (NULL,
+                                                        (char *)fileName,
+                                                        32),
+                                  (void *)ARN_InternPath (fileName));
+            }
+        return 1;
+        }
+    
+    /* Read previous MRU list data from system, and update the FILE */
+    /* menulist from the INI object                                 */
+    MU_ReadRegistryInfo (g_iniTextHandle, DEMO_REGISTRY_NAME);
+    MU_GetFileListFromIniFile (g_fileMenuListHandle, g_iniTextHandle,
+                               "FILE MenuList", "Filename", 1);
+    
+    /* Seed the session with the registry's list, and swap the copies of */
+    /* the paths the INI object made for interned ones like those of the */
+    /* items added later                                                 */
+    for (item = MU_GetNumMenuListItems (g_fileMenuListHandle); item > 0;
+         item--)
+        {
+        fileName = 0;
+        MU_GetMenuListAttribute (g_fileMenuListHandle, item,
+                                 ATTR_MENULIST_ITEM_CALLBACK_DATA, &fileName);
+        if (!fileName)
+            continue;
+        SES_AddRecent (g_session, fileName);
+        MU_SetMenuListAttribute (g_fileMenuListHandle, item,
+                                 ATTR_MENULIST_ITEM_CALLBACK_DATA,
+                                 ARN_InternPath (fileName));
+        free ((char *)fileName);
+        }
+    return 1;
+}   
+
 /*---------------------------------------------------------------------------*/
 /* Save options from current state of UIR to the system.  Thius means storing*/
 /* the MRU list on the File menu.                                            */
@@ -230,203 +392,174 @@ static int SaveOptionsForUIR (void)
     return success;
 }   
 
-/*--------------------------------------------------------------------------*/
-/* Add a particular file name to the File menu's MRU list.                  */
-/*--------------------------------------------------------------------------*/
-static int AddFileNameToFileMenuList (menuList menuListHandle,
-                                      char *fullPathAndFilename)
+/*---------------------------------------------------------------------------*/
+/* Called on the session store's thread once it has loaded.  The menus can   */
+/* only be changed on the UI thread, so hand over to it, with the number of  */
+/* documents the last run left open.                                         */
+/*---------------------------------------------------------------------------*/
+static void CVICALLBACK SessionLoadedCallback (SessionLog session,
+                                               void *callbackData)
 {
-    int retVal = 0;
-    
-    if ((menuListHandle) && (fullPathAndFilename)
-        &&  (fullPathAndFilename[0] != '\0') )
-        retVal = MU_AddItemToMenuList (menuListHandle, FRONT_OF_LIST,
-                                       MU_MakeShortFileName (NULL,
-                                                             fullPathAndFilename,
-                                                             32),
-                                       StrDup (fullPathAndFilename));
-    return retVal;   
-}       
+    PostDeferredCall (SessionLoaded, (void *)(size_t)SES_NumOpen (session));
+}
 
-/*--------------------------------------------------------------------------*/
-/* Add a particular window entry to the Window menu's MRU list.             */
-/*--------------------------------------------------------------------------*/
-static int AddFileNameToWindowMenuList (menuList menuListHandle,
-                                        char *fullPathAndFilename,
-                                        int panel)
+static void CVICALLBACK SessionLoaded (void *callbackData)
 {
-    int                    retVal = 0;
-    WindowMenuCallbackData *callbackData;
-    
-    if ((menuListHandle) && (fullPathAndFilename)
-        &&  (fullPathAndFilename[0] != '\0')) 
-        { 
-        if ((callbackData = calloc (1, sizeof(WindowMenuCallbackData))))
-            {
-            strcpy (callbackData->fileName, fullPathAndFilename);
-            callbackData->panel = panel;
-            retVal = MU_AddItemToMenuList (menuListHandle, FRONT_OF_LIST,
-                                           MU_MakeShortFileName (NULL,
-                                                                 fullPathAndFilename,
-                                                                 32),
-                                           callbackData);
-            }    
-        }        
-    return retVal;   
-}       
+    FillFileMenuList ();
+    RestoreSession ((int)(size_t)callbackData);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Documents still open in the session were left open by a run that did not  */
+/* exit normally.  Offer to reopen them; otherwise forget them.              */
+/*---------------------------------------------------------------------------*/
+static int RestoreSession (int numOpen)
+{
+    if (numOpen <= 0)
+        return 0;
+    sprintf (g_msgBuffer, "%d file(s) were open when MenuDemo last stopped "
+                          "unexpectedly.\n\nReopen them?", numOpen);
+    g_reopen = ConfirmPopup ("MenuDemo", g_msgBuffer);
+    RestoreDocuments ((void *)(size_t)numOpen);
+    return g_reopen ? numOpen : 0;
+}
 
 /*---------------------------------------------------------------------------*/
-/* Remove a particular file from the File menu's MRU list.                   */
+/* Reopen (or forget) RESTORE_BATCH of the documents left open, updating the */
+/* menus once for them, then let the UI run before the next batch, so the    */
+/* Window menu fills in while the user works.  Reopening moves each path to  */
+/* the back of the session's list, so the front is always the next one; a    */
+/* path the user has opened meanwhile is just moved along.  Only the         */
+/* document that ends up on top gets a panel; the others get theirs when     */
+/* they are first shown.                                                     */
 /*---------------------------------------------------------------------------*/
-static int RemoveFileNameFromMenuList (menuList menuListHandle,
-                                       char *fullPathAndFilename)
+static void CVICALLBACK RestoreDocuments (void *callbackData)
 {
-    int  retVal = 0;
-    int  item = 0;
-    int  totalItems = 0;
-    char *fileName;
+    int         numLeft = (int)(size_t)callbackData;
+    const char *path = 0;
+    int         status;
+    int         i;
     
-    /* Find menu item and remove from list */
-    if ((menuListHandle) && (fullPathAndFilename)
-        &&  (fullPathAndFilename[0] != '\0')) 
-        { 
-        if ((totalItems = MU_GetNumMenuListItems (menuListHandle)))
-            {
-            for (item = 1; item <= totalItems; item++) 
-                {
-                fileName = 0;
-                MU_GetMenuListAttribute (menuListHandle, item,
-                                         ATTR_MENULIST_ITEM_CALLBACK_DATA,
-                                         &fileName);
-                if ((fileName) &&
-                    (strcmp (fileName, fullPathAndFilename) == 0))
-                    break;
-                }    
-            if (item <= totalItems)
-                MU_DeleteMenuListItem (menuListHandle, item);
-            }    
-        }        
-    return retVal;   
-}       
+    DCT_BeginUpdate (g_docctl);
+    for (i = 0; i < RESTORE_BATCH && numLeft > 0; i++, numLeft--)
+        {
+        if (!(path = SES_GetOpen (g_session, 0)))
+            break;
+        status = g_reopen ? DCT_OpenInBackground (g_docctl, path)
+                          : TMS_ERR_NOT_FOUND;
+        if (status == TMS_ERR_EXISTS)
+            SES_Opened (g_session, path);
+        else if (status < 0)
+            SES_Closed (g_session, path);
+        }
+    DCT_EndUpdate (g_docctl);
+    if (numLeft > 0 && path)
+        PostDeferredCall (RestoreDocuments, (void *)(size_t)numLeft);
+}
 
 /*---------------------------------------------------------------------------*/
-/* Check to see if the file is already in the Window Menu MRU list.          */
+/* Open a document, reporting a file that is already open or a panel that    */
+/* could not be loaded.  Returns the document's panel, or a negative value.  */
 /*---------------------------------------------------------------------------*/
-static int CheckForFileNameInMenuList (menuList menuListHandle,
-                                       char *fullPathAndFilename)
+static int OpenDocument (char *fileName)
 {
-    int  retVal = 0;
-    int  item = 0;
-    int  totalItems = 0;
-    char *fileName;
+    int childPanel = DCT_Open (g_docctl, fileName);
     
-    /* Find menu item in list*/
-    if ((menuListHandle) && (fullPathAndFilename)
-        &&  (fullPathAndFilename[0] != '\0')) 
-        { 
-        if ((totalItems = MU_GetNumMenuListItems (menuListHandle)))
-            {
-            for (item = 1; item <= totalItems; item++) 
-                {
-                fileName = 0;
-                MU_GetMenuListAttribute (menuListHandle, item,
-                                         ATTR_MENULIST_ITEM_CALLBACK_DATA,
-                                         &fileName);
-                if ((fileName) &&
-                    (strcmp (fileName, fullPathAndFilename) == 0))
-                    retVal = 1;
-                }
-            }
-        }        
-    return retVal;   
-}       
+    if (childPanel == TMS_ERR_EXISTS)
+        MessagePopup("File Open", "File is already open.  Use Window menu to see list of open files.");
+    else if (childPanel < 0)
+        {
+        sprintf (g_msgBuffer, "Failure in LoadPanel.");
+        MessagePopup ("MenuDemo", g_msgBuffer);
+        }
+    return childPanel;
+}
 
 /*---------------------------------------------------------------------------*/
 /* This menu callback function is called when a filename is chosen from the  */
 /* MRU list on the File menu.  callbackData will point to the long filename, */
-/* since we're just using the short one in the MRU list.                     */
+/* since we're just using the short one in the MRU list.  It is an interned  */
+/* path (ARN_InternPath), so there is nothing to free when the item goes.    */
 /*---------------------------------------------------------------------------*/
 static void CVICALLBACK FILEMenuListCallbackFunc (menuList list, int menuIndex,
                                                   int event,
                                                   void *callbackData)
 {
-    int  status;
-    int  childPanel;
     char *fileName = (char *)callbackData;
    
-    if (event == EVENT_DISCARD)
-        {
-        if (fileName)
-            free (fileName);
-        }
-    else if (fileName) 
-        {
-        if (!CheckForFileNameInMenuList(g_winMenuListHandle, fileName))
-            {
-            /* Create a child panel to represent the newly opened file */
-            if ((childPanel = LoadPanel (g_panelHandle, "menudemo.uir", FILEPANEL))
-                >= 0)
-                {
-            
-                /* Set top and left for child panel */
-                SetPanelAttribute (childPanel, ATTR_TOP,
-                                   g_topLeftValue * 25 + 50);
-                SetPanelAttribute (childPanel, ATTR_LEFT,
-                                   g_topLeftValue * 25 + 25);
-                g_topLeftValue = (g_topLeftValue + 1) % 5;
-            
-                /* Set Title of child panel */
-                SetPanelAttribute (childPanel, ATTR_TITLE,
-                                   MU_MakeShortFileName (NULL, fileName, 32));
-                SetCtrlVal (childPanel, FILEPANEL_FILENAME, fileName);
-            
-                /* Display child panel */
-                DisplayPanel (childPanel);
-                g_numChildPanels++;
-            
-                /* Add an item for this window to the WINDOW MRU list */
-                status = AddFileNameToWindowMenuList (g_winMenuListHandle,
-                                                      fileName, childPanel);
-                DimMenuItems ();
-                }
-            else
-                {
-                sprintf (g_msgBuffer, "Failure in LoadPanel.");
-                MessagePopup ("MenuDemo", g_msgBuffer);
-                }
-            }
-        else
-            MessagePopup("File Open", "File is already open.  Use Window menu to see list of open files.");
-        }   
+    if (event != EVENT_DISCARD && fileName) 
+        OpenDocument (fileName);
     return;         
 }
 
 /*---------------------------------------------------------------------------*/
 /* This menu callback function is called when a filename is chosen in the    */
-/* WINDOW menu's MRU list.  callbackData will point to a structure we use    */
-/* to keep track of the item data.                                           */
+/* WINDOW menu's MRU list.  callbackData holds the document's registry       */
+/* handle, so there is nothing to free when the item is discarded.           */
 /*---------------------------------------------------------------------------*/
 static void CVICALLBACK WINDOWMenuListCallbackFunc (menuList list,
                                                     int menuIndex, int event,
                                                     void *callbackData)
 {
-    WindowMenuCallbackData *data = callbackData;
-   
-    if (event == EVENT_DISCARD)
-        {
-        if (data)
-            free(data);
-        }
-    else
+    if (event != EVENT_DISCARD)
         {
         
         /* Restore the window and bring to focus */
-        if (data) 
-            DisplayPanel (data->panel);
+        DCT_ShowDocument (g_docctl, (DocHandle)(size_t)callbackData);
         }   
     return;         
 }
 
+/*---------------------------------------------------------------------------*/
+/* Document panel callback, installed by the CVI backend.  Keeps the         */
+/* document z-order in step with the panel the user brings to the front.     */
+/*---------------------------------------------------------------------------*/
+static int CVICALLBACK DocumentPanelCallback (int panel, int event,
+                                              void *callbackData,
+                                              int eventData1, int eventData2)
+{
+    if (event == EVENT_GOT_FOCUS)
+        DCT_Activate (g_docctl, panel);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* View callback, called by the CVI backend when the user clicks a tab or    */
+/* scrolls a panel's tab strip or step list.                                 */
+/*---------------------------------------------------------------------------*/
+static void CVICALLBACK DocumentViewCallback (int panel, int event,
+                                              int index)
+{
+    switch (event)
+        {
+        case UI_CVI_SHOW_TAB:
+            DCT_ShowTab (g_docctl, index);
+            break;
+        case UI_CVI_SCROLL_TABS:
+            DCT_ScrollTabs (g_docctl, index);
+            break;
+        case UI_CVI_SCROLL_STEPS:
+            DCT_ScrollSteps (g_docctl, panel, index);
+            break;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to View->Tab by switching between a panel per document and one    */
+/* panel showing whichever document is on top, with a tab for each.          */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK ViewTab (int menuBar, int menuItem, void *callbackData,
+                          int panel)
+{
+    int checked = 0;
+    
+    GetMenuBarAttribute (g_menubarHandle, MAINMENU_VIEW_TAB, ATTR_CHECKED,
+                         &checked);
+    if (DCT_SetTabbed (g_docctl, !checked) == TMS_OK)
+        SetMenuBarAttribute (g_menubarHandle, MAINMENU_VIEW_TAB, ATTR_CHECKED,
+                             !checked);
+}
+
 /*---------------------------------------------------------------------------*/
 /* MainPanelCallback                                                         */
 /*---------------------------------------------------------------------------*/
@@ -451,7 +584,6 @@ void CVICALLBACK FileOpen (int menuBar, int menuItem, void *callbackData,
                           int panel)
 {
     int  stat;
-    int  childPanel;
     char fileName[MAX_PATHNAME_LEN];
     
     /* Get fileName from user */    
@@ -460,44 +592,14 @@ void CVICALLBACK FileOpen (int menuBar, int menuItem, void *callbackData,
     if ((stat == VAL_EXISTING_FILE_SELECTED)
         || (stat == VAL_NEW_FILE_SELECTED))
         {
-        if (!CheckForFileNameInMenuList(g_winMenuListHandle, fileName))
+        /* Create a child panel to represent the newly opened file */
+        if (OpenDocument (fileName) >= 0)
             {
-            /* Create a child panel to represent the newly opened file */
-            if ((childPanel = LoadPanel (panel, "menudemo.uir", FILEPANEL))
-                >= 0)
-                {
-            
-                /* Set top and left for child panel */
-                SetPanelAttribute (childPanel, ATTR_TOP,
-                                   g_topLeftValue * 25 + 50);
-                SetPanelAttribute (childPanel, ATTR_LEFT,
-                                   g_topLeftValue * 25 + 25);
-                g_topLeftValue = (g_topLeftValue + 1) % 5;
-            
-                /* Set Title of child panel */
-                SetPanelAttribute (childPanel, ATTR_TITLE,
-                                   MU_MakeShortFileName(NULL, fileName, 32));
-                SetCtrlVal (childPanel, FILEPANEL_FILENAME, fileName);
-            
-                /* Display the child panel */
-                DisplayPanel (childPanel);
-                g_numChildPanels++;
-            
-                /* Add a menu item to the WINDOW list for this opened window */
-                AddFileNameToWindowMenuList (g_winMenuListHandle, fileName,
-                                             childPanel);
-    
-                DimMenuItems ();
-                sprintf (g_msgBuffer, "You selected to 'open' the following file:"
-                                      "\n  %s\n\nNow save or close the file to add"
-                                      " it to the 'File' menu.", fileName);
-                }
-            else
-                sprintf (g_msgBuffer, "Failure to LoadPanel.");
+            sprintf (g_msgBuffer, "You selected to 'open' the following file:"
+                                  "\n  %s\n\nNow save or close the file to add"
+                                  " it to the 'File' menu.", fileName);
             MessagePopup("Menu Utility Demo",g_msgBuffer);
             }
-        else
-            MessagePopup("File Open", "File is already open.  Use Window menu to see list of open files.");
         }
 }
 
@@ -509,13 +611,9 @@ void CVICALLBACK FileSaveAs (int menuBar, int menuItem, void *callbackData,
                              int panel)
 {
     int  stat;
-    int  childPanel;
     char fileName[MAX_PATHNAME_LEN];
-    char oldFileName[MAX_PATHNAME_LEN];
         
-    childPanel = GetTopChildWindow (panel);    
-    if ((childPanel != 0)
-        && (GetCtrlVal (childPanel, FILEPANEL_FILENAME, oldFileName) == 0))
+    if (DCT_GetTopPanel (g_docctl) >= 0)
         {
         stat = FileSelectPopupEx ("", "*.*", "", "Choose a filename to save as:",
 								  VAL_SAVE_BUTTON, 0, 0, fileName);
@@ -524,23 +622,25 @@ void CVICALLBACK FileSaveAs (int menuBar, int menuItem, void *callbackData,
             || (stat == VAL_NEW_FILE_SELECTED))
             {
             
-            /* Add menu item to FILE list */
-            AddFileNameToFileMenuList (g_fileMenuListHandle, oldFileName);
-            
-            /* Remove old menu item from WINDOW list */
-            RemoveFileNameFromMenuList (g_winMenuListHandle, oldFileName);
-            
-            /* Add menu item to WINDOW list */
-            SetPanelAttribute (childPanel, ATTR_TITLE,
-                               MU_MakeShortFileName(NULL, fileName, 32));
-            SetCtrlVal (childPanel, FILEPANEL_FILENAME, fileName);
-            AddFileNameToWindowMenuList (g_winMenuListHandle, fileName,
-                                         childPanel);
-            DimMenuItems ();
-            sprintf (g_msgBuffer, "The following file will be saved:"
+            /* Write the sequence, add old name to FILE list, replace the */
+            /* WINDOW list item */
+            stat = DCT_SaveAs (g_docctl, fileName);
+            if (stat == TMS_ERR_EXISTS)
+                {
+                MessagePopup ("File Save As", "That file is open in another "
+                                              "window.");
+                return;
+                }
+            if (stat < 0)
+                {
+                sprintf (g_msgBuffer, "The sequence could not be saved to:"
+                                      "\n  %s", fileName);
+                MessagePopup ("File Save As", g_msgBuffer);
+                return;
+                }
+            sprintf (g_msgBuffer, "The following file was saved:"
                                   "\n  %s\n\nThe old filename will be added "
-                                  "to the 'File' menu's MRU list\n\n"
-                                  "NOTE:  The actual file will not be modified.", fileName);
+                                  "to the 'File' menu's MRU list", fileName);
             MessagePopup ("MenuDemo", g_msgBuffer);
             }    
         }    
@@ -553,62 +653,25 @@ void CVICALLBACK FileSaveAs (int menuBar, int menuItem, void *callbackData,
 void CVICALLBACK FileSave (int menuBar, int menuItem, void *callbackData,
                            int panel)
 {
-    int  childPanel;
-    char fileName[MAX_PATHNAME_LEN];
-        
-    childPanel = GetTopChildWindow (panel);    
-    if ((childPanel != 0)
-        && (GetCtrlVal (childPanel, FILEPANEL_FILENAME, fileName) == 0))
-        {
-        /* Add menu item to FILE list */
-        AddFileNameToFileMenuList (g_fileMenuListHandle, fileName);
-        sprintf (g_msgBuffer, "The following file was selected to be saved:\n"
-                              " %s\n\nNOTE: Actual file will not be modified.",
-                              fileName);
-        MessagePopup ("MenuDemo",g_msgBuffer);
-        }							 
-}
-
-/*----------------------------------------------------------------------------*/
-/* Get the topmost child panel for a given parent.                            */
-/*----------------------------------------------------------------------------*/
-static int GetTopChildWindow (int panelHandle)
-{
-    int i;
-    int panel = 0;
-    int childPanels = 0;
-    int lowZPlane = 0, lowPanel = 0, zPlane;
+    int stat;
     
-    GetPanelAttribute (panelHandle, ATTR_NUM_CHILDREN, &childPanels);
-
-    /* Find lowest ZPLANE child window */
-    for (i=0;i<childPanels;i++)
+    /* Write the sequence and add menu item to FILE list */
+    stat = DCT_Save (g_docctl);
+    if (stat >= 0)
         {
-        if (i == 0)
-            {
-            GetPanelAttribute (panelHandle, ATTR_FIRST_CHILD, &panel);
-            GetPanelAttribute (panel, ATTR_ZPLANE_POSITION, &zPlane);
-            lowZPlane = zPlane;
-            lowPanel = panel;
-            }    
-        else 
-            {
-            GetPanelAttribute (panel, ATTR_NEXT_PANEL, &panel);
-            if (panel) 
-                {
-                GetPanelAttribute (panel, ATTR_ZPLANE_POSITION, &zPlane);
-                if (zPlane<lowZPlane) 
-                    {
-                    lowZPlane = zPlane;
-                    lowPanel = panel;
-                    }    
-                }    
-            }    
-        }  
-    if (childPanels)
-        return lowPanel;
-    else
-        return -1;
+        sprintf (g_msgBuffer, "The following file was saved:\n %s",
+                              DCT_GetTopPath (g_docctl));
+        MessagePopup ("MenuDemo",g_msgBuffer);
+        }
+    else if (stat == TMS_ERR_EXISTS)
+        MessagePopup ("File Save", "That file is not a sequence file.  "
+                                   "Use Save As to save to another file.");
+    else if (stat != TMS_ERR_NOT_FOUND)
+        {
+        sprintf (g_msgBuffer, "The sequence could not be saved to:\n %s",
+                              DCT_GetTopPath (g_docctl));
+        MessagePopup ("File Save", g_msgBuffer);
+        }							 
 }
 
 /*----------------------------------------------------------------------------*/
@@ -617,43 +680,24 @@ static int GetTopChildWindow (int panelHandle)
 void CVICALLBACK FileClose (int menuBar, int menuItem, void *callbackData,
                             int panel)
 {
-    char fileName[MAX_PATHNAME_LEN];
-    
-    if ((panel = GetTopChildWindow(panel)) >= 0)
-        {    
-        GetCtrlVal (panel, FILEPANEL_FILENAME, fileName);
-        DiscardPanel (panel);
-        AddFileNameToFileMenuList (g_fileMenuListHandle, fileName);
-        RemoveFileNameFromMenuList (g_winMenuListHandle, fileName);
-        g_numChildPanels--;
-        DimMenuItems ();
-        }    
+    DCT_Close (g_docctl);
 }
 
 /*---------------------------------------------------------------------------*/
 /* Respond to File->Exit menu item to close the app.  We must add currently  */
 /* open files to the File menu's MRU list, and remove items from the Window  */
-/* menu's MRU list.                                                          */
+/* menu's MRU list.  Every open document is saved, including those too old   */
+/* to still appear on the Window menu, and its panel is discarded.           */
 /*---------------------------------------------------------------------------*/
 void CVICALLBACK FileQuit (int menuBar, int menuItem, void *callbackData,
                            int panel)
 {
-    char *fileName;
-    
-    if (g_numChildPanels)
+    if (DCT_NumDocuments (g_docctl) > 0)
         {
-        while ((MU_GetMenuListAttribute (g_winMenuListHandle, 1,
-                                         ATTR_MENULIST_ITEM_CALLBACK_DATA,
-                                         &fileName) == 0))
-            {
-            AddFileNameToFileMenuList (g_fileMenuListHandle, fileName);
-            RemoveFileNameFromMenuList (g_winMenuListHandle, fileName);
-            }
+        DCT_CloseAll (g_docctl);
         sprintf (g_msgBuffer, "You are now exiting, any open files will be "
                               "saved in the File list");
         MessagePopup("MenuDemo", g_msgBuffer);
-        g_numChildPanels = 0;
-        DimMenuItems ();
     }    
     QuitUserInterface (0);
 }
@@ -686,22 +730,656 @@ void CVICALLBACK HideAllWindows (int menuBar, int menuItem,
 void CVICALLBACK CloseAllWindows (int menuBar, int menuItem,
                                   void *callbackData, int panel)
 {
-    int  childPanels = 0;
-    int  i;
-    int  childPanel;
-    char fileName[MAX_PATHNAME_LEN];
+    DCT_CloseAll (g_docctl);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Make the topmost document's sequence the one the Run menu executes.       */
+/*---------------------------------------------------------------------------*/
+static int LoadTopSequence (void)
+{
+    int status = DCT_LoadTopSequence (g_docctl);
     
-    GetPanelAttribute (panel, ATTR_NUM_CHILDREN, &childPanels);
-    for (i = 0; i < childPanels; i++) 
-        {
-        childPanel = GetTopChildWindow (panel);    
-        GetCtrlVal (childPanel, FILEPANEL_FILENAME, fileName);
-        AddFileNameToFileMenuList (g_fileMenuListHandle, fileName);
-        RemoveFileNameFromMenuList (g_winMenuListHandle, fileName);
-        DiscardPanel (childPanel);
-        g_numChildPanels--;
-        }    
-    DimMenuItems ();
+    if (status == TMS_ERR_NOT_FOUND)
+        MessagePopup ("Run", "Open a file and use Sequence->Add to give it "
+                             "some steps first.");
+    return status;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Edit->Undo and Edit->Redo by stepping the topmost document's   */
+/* history back or forward one Sequence menu edit.  The commands are dimmed  */
+/* when there is nothing to undo or redo.                                    */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK EditUndo (int menuBar, int menuItem, void *callbackData,
+                           int panel)
+{
+    if (DCT_Undo (g_docctl) == TMS_ERR_BUSY)
+        MessagePopup ("Undo", "Wait for the sequence to finish running.");
+}
+
+void CVICALLBACK EditRedo (int menuBar, int menuItem, void *callbackData,
+                           int panel)
+{
+    if (DCT_Redo (g_docctl) == TMS_ERR_BUSY)
+        MessagePopup ("Redo", "Wait for the sequence to finish running.");
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Edit->Find by searching the step names, modules, symbols and   */
+/* parameters of every open document.  The first few matches are listed and  */
+/* the document with the first one is brought to the front.                  */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK EditFind (int menuBar, int menuItem, void *callbackData,
+                           int panel)
+{
+    char     text[64] = "";
+    DctMatch matches[DEMO_FIND_LINES];
+    int      numMatches;
+    int      i;
+    char    *line;
+    
+    if (PromptPopup ("Find", "Find in all open sequences:", text,
+                     sizeof(text) - 1) < 0 || !text[0])
+        return;
+    if ((numMatches = DCT_Find (g_docctl, text, FND_FIELD_ALL, matches,
+                                DEMO_FIND_LINES)) < 0)
+        {
+        sprintf (g_msgBuffer, "Unable to search (error %d).", numMatches);
+        MessagePopup ("Find", g_msgBuffer);
+        return;
+        }
+    if (numMatches == 0)
+        {
+        sprintf (g_msgBuffer, "\"%s\" was not found.", text);
+        MessagePopup ("Find", g_msgBuffer);
+        return;
+        }
+    line = g_msgBuffer + sprintf (g_msgBuffer, "%d steps match \"%s\":\n",
+                                  numMatches, text);
+    for (i = 0; i < numMatches && i < DEMO_FIND_LINES; i++)
+        line += sprintf (line, "\n%.40s, step %d: %.40s",
+                         DOC_GetPath (DCT_GetRegistry (g_docctl),
+                                      matches[i].doc),
+                         matches[i].step + 1,
+                         SEQ_GetStepName (DCT_GetSequence (g_docctl,
+                                                           matches[i].doc),
+                                          matches[i].step));
+    if (numMatches > DEMO_FIND_LINES)
+        sprintf (line, "\n...");
+    DCT_ShowDocument (g_docctl, matches[0].doc);
+    MessagePopup ("Find", g_msgBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Edit->Replace by replacing text in the step names, modules and */
+/* symbols of every open document -- retargeting every add() step at another */
+/* DLL, say.  Each document's replacements are one Undo in that document.    */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK EditReplace (int menuBar, int menuItem, void *callbackData,
+                              int panel)
+{
+    char text[64] = "";
+    char replacement[64] = "";
+    int  numChanged;
+    
+    if (PromptPopup ("Replace", "Replace in all open sequences:", text,
+                     sizeof(text) - 1) < 0 || !text[0])
+        return;
+    if (PromptPopup ("Replace", "Replace with:", replacement,
+                     sizeof(replacement) - 1) < 0)
+        return;
+    numChanged = DCT_Replace (g_docctl, text, FND_FIELD_NAME
+                              | FND_FIELD_MODULE | FND_FIELD_SYMBOL,
+                              replacement);
+    if (numChanged == TMS_ERR_BUSY)
+        sprintf (g_msgBuffer, "Wait for the sequence to finish running.");
+    else if (numChanged < 0)
+        sprintf (g_msgBuffer, "Unable to replace (error %d).", numChanged);
+    else
+        sprintf (g_msgBuffer, "Replaced \"%s\" in %d steps.", text,
+                 numChanged);
+    MessagePopup ("Replace", g_msgBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Sequence->Add by appending add() steps from add.dll to the     */
+/* topmost document.  Each step is a numeric limit test expecting its input  */
+/* plus one; they are all independent, so Run->All runs them in parallel.    */
+/* add.dll is loaded at run time and add() is resolved once for all steps.   */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK SequenceAdd (int menuBar, int menuItem, void *callbackData,
+                              int panel)
+{
+    char countText[32] = DEMO_ADD_STEPS;
+    int  count;
+    int  status;
+    
+    if (!DCT_GetTopSequence (g_docctl))
+        {
+        MessagePopup ("Sequence Add", "Open a file first.");
+        return;
+        }
+    if (PromptPopup ("Sequence Add", "Number of add() steps to append:",
+                     countText, sizeof(countText) - 1) < 0)
+        return;
+    if ((count = atoi (countText)) <= 0)
+        return;
+    
+    status = DCT_AddSteps (g_docctl, count, DEMO_STEP_MODULE, "add");
+    if (status > 0)
+        sprintf (g_msgBuffer, "%d steps could not be resolved:\n%s", status,
+                 PLG_GetErrorString (DCT_GetPlugins (g_docctl)));
+    else if (status < 0)
+        sprintf (g_msgBuffer, "Unable to add steps (error %d).", status);
+    else
+        sprintf (g_msgBuffer, "Added %d steps.  The sequence now has %d "
+                              "steps.", count,
+                              SEQ_NumSteps (DCT_GetTopSequence (g_docctl)));
+    MessagePopup ("Sequence Add", g_msgBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Sequence->Combinate by merging the sequence of the most        */
+/* recently opened other document into the topmost one.  The other           */
+/* document's steps run after the existing ones.                             */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK SequenceCombinate (int menuBar, int menuItem,
+                                    void *callbackData, int panel)
+{
+    Sequence combined;
+    int      status;
+    
+    if (!DCT_GetTopSequence (g_docctl))
+        {
+        MessagePopup ("Sequence Combinate", "Open two files first.");
+        return;
+        }
+    if ((status = DCT_Combinate (g_docctl)) == TMS_ERR_NOT_FOUND)
+        {
+        MessagePopup ("Sequence Combinate", "Open a second file to combine "
+                                            "with this one.");
+        return;
+        }
+    if (status == TMS_OK)
+        {
+        combined = DCT_GetTopSequence (g_docctl);
+        sprintf (g_msgBuffer, "The combined sequence has %d steps in %d "
+                              "groups.", SEQ_NumSteps (combined),
+                              SEQ_NumGroups (combined));
+        }
+    else
+        sprintf (g_msgBuffer, "Unable to combine the sequences.");
+    MessagePopup ("Sequence Combinate", g_msgBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Sequence->Sweep by running the first steps of the topmost      */
+/* document over ranges of their parameter, one range per step: every        */
+/* combination of values, or just enough points to cover every pair of       */
+/* values.  The points are generated a chunk at a time as the pool runs      */
+/* them, so even 10^8 of them take next to no memory.  SweepFinished         */
+/* reports when it is done.                                                  */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK SequenceSweep (int menuBar, int menuItem, void *callbackData,
+                                int panel)
+{
+    Execution   exec = DCT_GetExecution (g_docctl);
+    char        rangeText[256] = DEMO_SWEEP_RANGES;
+    const char *next = rangeText;
+    long        first;
+    long        last;
+    long        increment;
+    int         length;
+    int         mode;
+    int         status = TMS_OK;
+    
+    if (EXE_IsRunning (exec) > 0)
+        {
+        MessagePopup ("Sequence Sweep", "Wait for the sequence to finish "
+                                        "running.");
+        return;
+        }
+    if (LoadTopSequence () < 0)
+        return;
+    if (PromptPopup ("Sequence Sweep", "Parameter ranges of steps 1, 2, ... "
+                     "(first:last:increment):", rangeText,
+                     sizeof(rangeText) - 1) < 0)
+        return;
+    mode = ConfirmPopup ("Sequence Sweep", "Cover every pair of values "
+                         "instead of every combination?")
+           ? SWP_MODE_PAIRWISE : SWP_MODE_CARTESIAN;
+    
+    SWP_Dispose (g_sweep);
+    if (!(g_sweep = SWP_New (mode)))
+        return;
+    while (status >= 0 && sscanf (next, " %ld:%ld:%ld%n", &first, &last,
+                                  &increment, &length) == 3)
+        {
+        status = SWP_AddParam (g_sweep, SWP_NumParams (g_sweep),
+                               (int32_t)first, (int32_t)last,
+                               (int32_t)increment);
+        next += length;
+        }
+    if (status >= 0)
+        status = EXE_RunSweep (exec, g_sweep, SweepDoneCallback, 0);
+    if (status == TMS_OK)
+        {
+        SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_STEP, ATTR_DIMMED,
+                             1);
+        SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_ALL, ATTR_DIMMED,
+                             1);
+        SetMenuBarAttribute (g_menubarHandle, g_sweepItem, ATTR_DIMMED, 1);
+        return;
+        }
+    if (status == TMS_ERR_NO_MEMORY)
+        sprintf (g_msgBuffer, "The sweep has too many points.");
+    else
+        sprintf (g_msgBuffer, "Enter a first:last:increment range for each "
+                              "of the first steps to sweep, at most %d.",
+                 SWP_MAX_PARAMS);
+    MessagePopup ("Sequence Sweep", g_msgBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Called on a worker thread when Sequence->Sweep finishes.  Hand over to    */
+/* the main thread, like Run->All.                                           */
+/*---------------------------------------------------------------------------*/
+static void CVICALLBACK SweepDoneCallback (Execution exec, void *callbackData)
+{
+    PostDeferredCall (SweepFinished, exec);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Report the outcome of Sequence->Sweep on the UI thread, with the values   */
+/* of the first point that failed.                                           */
+/*---------------------------------------------------------------------------*/
+static void CVICALLBACK SweepFinished (void *callbackData)
+{
+    Execution      exec = (Execution)callbackData;
+    ExeSweepResult result;
+    int32_t        values[SWP_MAX_PARAMS];
+    int            length;
+    int            i;
+    
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_STEP, ATTR_DIMMED, 0);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_ALL, ATTR_DIMMED, 0);
+    SetMenuBarAttribute (g_menubarHandle, g_sweepItem, ATTR_DIMMED, 0);
+    EXE_GetSweepResult (exec, &result);
+    length = sprintf (g_msgBuffer, "Swept %.0f points:  %s  (%.0f failed)",
+                      (double)result.numPoints,
+                      result.numFailed ? "FAILED" : "PASSED",
+                      (double)result.numFailed);
+    if (result.firstFailed >= 0
+        && SWP_GetPoints (g_sweep, result.firstFailed, 1, values) == 1)
+        {
+        length += sprintf (g_msgBuffer + length, "\n\nThe first point to "
+                           "fail, %.0f, has the values",
+                           (double)result.firstFailed);
+        for (i = 0; i < SWP_NumParams (g_sweep); i++)
+            length += sprintf (g_msgBuffer + length, " %d", (int)values[i]);
+        }
+    MessagePopup ("Sequence Sweep", g_msgBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Run->Step by executing the next step of the sequence.          */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK RunStep (int menuBar, int menuItem, void *callbackData,
+                          int panel)
+{
+    Execution exec = DCT_GetExecution (g_docctl);
+    ExeResult result;
+    int       step;
+    
+    if (LoadTopSequence () < 0)
+        return;
+    step = EXE_RunStep (exec, &result);
+    if (step >= 0)
+        sprintf (g_msgBuffer, "Step %d of %d returned %d:  %s", step + 1,
+                 EXE_NumSteps (exec), result.value,
+                 result.status == EXE_STATUS_PASSED ? "PASSED" : "FAILED");
+    else if (step == TMS_ERR_NOT_FOUND)
+        {
+        EXE_Reset (exec);
+        sprintf (g_msgBuffer, "End of sequence.  The next Step starts again "
+                              "from the first step.");
+        }
+    else
+        sprintf (g_msgBuffer, "Unable to run step (error %d).", step);
+    MessagePopup ("Run Step", g_msgBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Run->All by starting the whole sequence on every test socket   */
+/* at once.  The UI stays responsive; RunAllFinished reports when it is      */
+/* done.                                                                     */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK RunAll (int menuBar, int menuItem, void *callbackData,
+                         int panel)
+{
+    if (LoadTopSequence () < 0)
+        return;
+    if (SKT_RunAll (DCT_GetSockets (g_docctl), RunAllDoneCallback, 0)
+        == TMS_OK)
+        {
+        SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_STEP, ATTR_DIMMED,
+                             1);
+        SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_ALL, ATTR_DIMMED,
+                             1);
+        }
+    else
+        MessagePopup ("Run All", "Unable to start the sequence.");
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to Run->Isolate Steps by switching between calling steps in this  */
+/* process and in step hosts (tmshost), one per socket.  In a host a step    */
+/* that crashes fails on its own instead of taking the application with it.  */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK RunIsolateSteps (int menuBar, int menuItem,
+                                  void *callbackData, int panel)
+{
+    int checked = 0;
+    int status;
+    
+    GetMenuBarAttribute (g_menubarHandle, g_isolateItem, ATTR_CHECKED,
+                         &checked);
+    status = DCT_SetStepHost (g_docctl, checked ? 0 : DEMO_STEP_HOST);
+    if (status == TMS_OK)
+        SetMenuBarAttribute (g_menubarHandle, g_isolateItem, ATTR_CHECKED,
+                             !checked);
+    else if (status == TMS_ERR_BUSY)
+        MessagePopup ("Isolate Steps", "Wait for the sequence to finish "
+                                       "running.");
+    else
+        {
+        SetMenuBarAttribute (g_menubarHandle, g_isolateItem, ATTR_CHECKED, 0);
+        MessagePopup ("Isolate Steps", "Unable to start the step host "
+                                       DEMO_STEP_HOST ".");
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Called on a worker thread when the last socket finishes Run->All.  UI     */
+/* calls are not safe here, so hand over to the main thread.                 */
+/*---------------------------------------------------------------------------*/
+static void CVICALLBACK RunAllDoneCallback (SocketSet sockets,
+                                            void *callbackData)
+{
+    PostDeferredCall (RunAllFinished, sockets);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Report the outcome of Run->All for each socket on the UI thread.          */
+/*---------------------------------------------------------------------------*/
+static void CVICALLBACK RunAllFinished (void *callbackData)
+{
+    SocketSet sockets = (SocketSet)callbackData;
+    int       numSockets = SKT_NumSockets (sockets);
+    int       numPassed;
+    int       numFailed;
+    int       length;
+    int       i;
+    
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_STEP, ATTR_DIMMED, 0);
+    SetMenuBarAttribute (g_menubarHandle, MAINMENU_RUN_ALL, ATTR_DIMMED, 0);
+    length = sprintf (g_msgBuffer, "Sequence finished on %d socket(s) and "
+                                   "%d thread(s).\n", numSockets,
+                                   EXE_NumThreads ());
+    for (i = 0; i < numSockets; i++)
+        {
+        numPassed = numFailed = 0;
+        EXE_GetCounts (SKT_GetExecution (sockets, i), &numPassed,
+                       &numFailed);
+        length += sprintf (g_msgBuffer + length, "\n  Socket %d:  %s  "
+                           "(%d passed, %d failed)", i + 1,
+                           numFailed ? "FAILED" : "PASSED", numPassed,
+                           numFailed);
+        }
+    UpdateTimingPanel ();
+    MessagePopup ("Run All", g_msgBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to View->Step Timing by showing how long the steps took in each   */
+/* socket on the last Run->All, and in Step mode.  The panel is refreshed    */
+/* after every Run->All until it is closed.                                  */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK ViewTiming (int menuBar, int menuItem, void *callbackData,
+                             int panel)
+{
+    if (g_timingPanel <= 0)
+        {
+        g_timingPanel = NewPanel (0, "Step Timing", VAL_AUTO_CENTER,
+                                  VAL_AUTO_CENTER, 260, 640);
+        if (g_timingPanel < 0)
+            return;
+        g_timingText = NewCtrl (g_timingPanel, CTRL_TEXT_BOX, "", 0, 0);
+        SetCtrlAttribute (g_timingPanel, g_timingText, ATTR_WIDTH, 640);
+        SetCtrlAttribute (g_timingPanel, g_timingText, ATTR_HEIGHT, 260);
+        SetCtrlAttribute (g_timingPanel, g_timingText, ATTR_TEXT_FONT,
+                          VAL_EDITOR_FONT);
+        SetCtrlAttribute (g_timingPanel, g_timingText, ATTR_NO_EDIT_TEXT, 1);
+        InstallPanelCallback (g_timingPanel, TimingPanelCallback, 0);
+        }
+    UpdateTimingPanel ();
+    DisplayPanel (g_timingPanel);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Discard the timing panel when it is closed.                               */
+/*---------------------------------------------------------------------------*/
+static int CVICALLBACK TimingPanelCallback (int panel, int event,
+                                            void *callbackData,
+                                            int eventData1, int eventData2)
+{
+    if (event == EVENT_CLOSE)
+        {
+        DiscardPanel (panel);
+        g_timingPanel = 0;
+        }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Fill the timing panel, if it is open: one row of step latencies (in       */
+/* microseconds) per socket, then Step mode.                                 */
+/*---------------------------------------------------------------------------*/
+static void UpdateTimingPanel (void)
+{
+    SocketSet sockets = DCT_GetSockets (g_docctl);
+    int       numSockets = SKT_NumSockets (sockets);
+    char      text[2048];
+    char      name[32];
+    ExeTiming timing;
+    Execution exec;
+    int       length;
+    int       i;
+    
+    if (g_timingPanel <= 0)
+        return;
+    length = sprintf (text, "%-10s %7s %9s %9s %9s %9s %9s %9s %5s\n",
+                      "", "Steps", "Mean", "p50", "p90", "p99", "p99.9",
+                      "Max", "CPU");
+    for (i = 0; i <= numSockets; i++)
+        {
+        if (i < numSockets)
+            {
+            exec = SKT_GetExecution (sockets, i);
+            sprintf (name, "Socket %d", i + 1);
+            }
+        else
+            {
+            exec = DCT_GetExecution (g_docctl);
+            strcpy (name, "Step");
+            }
+        if (EXE_GetTiming (exec, &timing) < 0)
+            length += sprintf (text + length, "%-10s (running)\n", name);
+        else
+            length += sprintf (text + length, "%-10s %7d %9.2f %9.2f %9.2f "
+                               "%9.2f %9.2f %9.2f %4.0f%%\n", name,
+                               timing.numSteps, timing.meanMicros,
+                               timing.p50Micros, timing.p90Micros,
+                               timing.p99Micros, timing.p999Micros,
+                               timing.maxMicros, timing.wallSeconds > 0.0
+                               ? 100.0 * timing.cpuSeconds
+                                 / timing.wallSeconds : 0.0);
+        }
+    ResetTextBox (g_timingPanel, g_timingText, text);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to View->Live Monitor by showing each socket's progress while     */
+/* Run->All is in progress, and Step mode's or a sweep's.  A timer samples   */
+/* the progress the executions publish DEMO_MONITOR_RATE times a second on   */
+/* the UI thread; the executions publish it whether or not anyone looks, so  */
+/* the monitor does not change how fast they run.                            */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK ViewMonitor (int menuBar, int menuItem, void *callbackData,
+                              int panel)
+{
+    int timer;
+    
+    if (g_monitorPanel <= 0)
+        {
+        g_monitorPanel = NewPanel (0, "Live Monitor", VAL_AUTO_CENTER,
+                                   VAL_AUTO_CENTER, 200, 600);
+        if (g_monitorPanel < 0)
+            return;
+        g_monitorText = NewCtrl (g_monitorPanel, CTRL_TEXT_BOX, "", 0, 0);
+        SetCtrlAttribute (g_monitorPanel, g_monitorText, ATTR_WIDTH, 600);
+        SetCtrlAttribute (g_monitorPanel, g_monitorText, ATTR_HEIGHT, 200);
+        SetCtrlAttribute (g_monitorPanel, g_monitorText, ATTR_TEXT_FONT,
+                          VAL_EDITOR_FONT);
+        SetCtrlAttribute (g_monitorPanel, g_monitorText, ATTR_NO_EDIT_TEXT,
+                          1);
+        timer = NewCtrl (g_monitorPanel, CTRL_TIMER, "", 0, 0);
+        SetCtrlAttribute (g_monitorPanel, timer, ATTR_INTERVAL,
+                          1.0 / DEMO_MONITOR_RATE);
+        InstallCtrlCallback (g_monitorPanel, timer, MonitorTick, 0);
+        InstallPanelCallback (g_monitorPanel, MonitorPanelCallback, 0);
+        }
+    UpdateMonitorPanel ();
+    DisplayPanel (g_monitorPanel);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Discard the monitor panel, and its timer with it, when it is closed.      */
+/*---------------------------------------------------------------------------*/
+static int CVICALLBACK MonitorPanelCallback (int panel, int event,
+                                             void *callbackData,
+                                             int eventData1, int eventData2)
+{
+    if (event == EVENT_CLOSE)
+        {
+        DiscardPanel (panel);
+        g_monitorPanel = 0;
+        }
+    return 0;
+}
+
+static int CVICALLBACK MonitorTick (int panel, int control, int event,
+                                    void *callbackData, int eventData1,
+                                    int eventData2)
+{
+    if (event == EVENT_TIMER_TICK)
+        UpdateMonitorPanel ();
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Fill the monitor panel, if it is open: one row per socket, then Step      */
+/* mode, which also runs sweeps.                                             */
+/*---------------------------------------------------------------------------*/
+static void UpdateMonitorPanel (void)
+{
+    SocketSet   sockets = DCT_GetSockets (g_docctl);
+    int         numSockets = SKT_NumSockets (sockets);
+    char        text[2048];
+    char        name[32];
+    char        done[48];
+    ExeProgress progress;
+    Execution   exec;
+    int         length;
+    int         i;
+    
+    if (g_monitorPanel <= 0)
+        return;
+    length = sprintf (text, "%-10s %-8s %5s %23s %9s %9s %8s\n", "",
+                      "State", "Group", "Done", "Passed", "Failed", "Seconds");
+    for (i = 0; i <= numSockets; i++)
+        {
+        if (i < numSockets)
+            {
+            exec = SKT_GetExecution (sockets, i);
+            sprintf (name, "Socket %d", i + 1);
+            }
+        else
+            {
+            exec = DCT_GetExecution (g_docctl);
+            strcpy (name, "Step");
+            }
+        if (EXE_GetProgress (exec, &progress) < 0)
+            continue;
+        if (progress.totalPoints)
+            {
+            sprintf (done, "%.0f/%.0f pts", (double)progress.numPoints,
+                     (double)progress.totalPoints);
+            progress.numPassed = (int)(progress.numPoints
+                                       - progress.numFailedPoints);
+            progress.numFailed = (int)progress.numFailedPoints;
+            }
+        else
+            sprintf (done, "%d/%d", progress.numDone, progress.numSteps);
+        length += sprintf (text + length, "%-10s %-8s ", name,
+                           progress.running ? "running" : "idle");
+        if (progress.group >= 0)
+            length += sprintf (text + length, "%5d ", progress.group);
+        else
+            length += sprintf (text + length, "%5s ", "");
+        length += sprintf (text + length, "%23s %9d %9d %8.1f\n", done,
+                           progress.numPassed, progress.numFailed,
+                           progress.elapsedSeconds);
+        }
+    ResetTextBox (g_monitorPanel, g_monitorText, text);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Respond to View->Export Timing Trace by writing the step timings of every */
+/* socket and of Step mode as a Chrome trace, for chrome://tracing or        */
+/* Perfetto.                                                                 */
+/*---------------------------------------------------------------------------*/
+void CVICALLBACK ViewExportTrace (int menuBar, int menuItem,
+                                  void *callbackData, int panel)
+{
+    SocketSet sockets = DCT_GetSockets (g_docctl);
+    Execution execs[DEMO_NUM_SOCKETS + 1];
+    char      fileName[MAX_PATHNAME_LEN];
+    int       numExecs = 0;
+    int       stat;
+    int       i;
+    
+    stat = FileSelectPopupEx ("", DEMO_TRACE_FILE, "*.json",
+                              "Export step timings as:", VAL_SAVE_BUTTON, 0,
+                              1, fileName);
+    if ((stat != VAL_EXISTING_FILE_SELECTED)
+        && (stat != VAL_NEW_FILE_SELECTED))
+        return;
+    for (i = 0; i < SKT_NumSockets (sockets) && i < DEMO_NUM_SOCKETS; i++)
+        execs[numExecs++] = SKT_GetExecution (sockets, i);
+    execs[numExecs++] = DCT_GetExecution (g_docctl);
+    stat = EXE_ExportTrace (execs, numExecs, fileName);
+    if (stat == TMS_ERR_BUSY)
+        sprintf (g_msgBuffer, "Wait for Run->All to finish first.");
+    else if (stat < 0)
+        sprintf (g_msgBuffer, "The trace could not be written to:\n  %s",
+                 fileName);
+    else
+        sprintf (g_msgBuffer, "Step timings were written to:\n  %s\n\n"
+                              "Open it in chrome://tracing or Perfetto.",
+                 fileName);
+    MessagePopup ("Export Timing Trace", g_msgBuffer);
 }
 
 /*----------------------------------------------------------------------------*/
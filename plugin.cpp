@@ -0,0 +1,401 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    plugin.cpp                                                       */
+/*                                                                           */
+/* PURPOSE: Run-time loader for test step modules.  See plugin.h.            */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <dlfcn.h>
+#endif
+
+#include "plugin.h"
+#include "builtin.h"
+#include "seqtable.h"
+#include "tmsstep.h"
+
+using tms::StringPool;
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct PluginLoaderRec_Tag
+{
+    StringPool          modules;      /* module name -> module id */
+    std::vector<void *> handles;      /* module id -> OS handle, 0 if it failed */
+    StringPool          symbols;      /* "module\nsymbol" -> symbol id */
+    std::vector<void *> addresses;    /* symbol id -> address, 0 if missing */
+    std::mutex          lock;
+    std::string         error;
+    bool                builtins;     /* bind built-in steps (builtin.h) */
+
+    PluginLoaderRec_Tag () : builtins (true) {}
+};
+
+#if defined(_WIN32)
+  #define MODULE_SUFFIX ".dll"
+#else
+  #define MODULE_SUFFIX ".so"
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Thin OS layer.                                                            */
+/*---------------------------------------------------------------------------*/
+static void *OpenModule (const std::string &path)
+{
+#if defined(_WIN32)
+    return (void *)LoadLibraryA (path.c_str ());
+#else
+    return dlopen (path.c_str (), RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+static void CloseModule (void *handle)
+{
+#if defined(_WIN32)
+    FreeLibrary ((HMODULE)handle);
+#else
+    dlclose (handle);
+#endif
+}
+
+static void *FindSymbol (void *handle, const char *symbol)
+{
+#if defined(_WIN32)
+    void *address = (void *)GetProcAddress ((HMODULE)handle, symbol);
+  #if defined(_M_IX86) || defined(__i386__)
+    /* Without a .def file 32-bit __stdcall exports are decorated as */
+    /* _name@bytes; step functions take at most a few arguments      */
+    int  bytes;
+    char decorated[256];
+
+    for (bytes = 0; !address && bytes <= 32; bytes += 4)
+        {
+        _snprintf (decorated, sizeof(decorated), "_%s@%d", symbol, bytes);
+        decorated[sizeof(decorated) - 1] = '\0';
+        address = (void *)GetProcAddress ((HMODULE)handle, decorated);
+        }
+  #endif
+    return address;
+#else
+    return dlsym (handle, symbol);
+#endif
+}
+
+static std::string LastOsError ()
+{
+#if defined(_WIN32)
+    char buffer[32];
+
+    _snprintf (buffer, sizeof(buffer), "error %lu", GetLastError ());
+    buffer[sizeof(buffer) - 1] = '\0';
+    return buffer;
+#else
+    const char *text = dlerror ();
+    return text ? text : "unknown error";
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open a module by name.  "add" is tried as add.dll / add.so (and libadd.so */
+/* and ./add.so on Linux); names with an extension or a path are used as-is. */
+/*---------------------------------------------------------------------------*/
+static void *OpenModuleByName (PluginLoader loader, const std::string &name)
+{
+    std::vector<std::string> candidates;
+    std::string              base = name;
+    size_t                   slash = name.find_last_of ("/\\");
+    size_t                   i;
+    void                    *handle;
+
+    if (name.find ('.', slash == std::string::npos ? 0 : slash) == std::string::npos)
+        base += MODULE_SUFFIX;
+    candidates.push_back (base);
+#if !defined(_WIN32)
+    if (slash == std::string::npos)
+        {
+        candidates.push_back ("./" + base);
+        candidates.push_back ("lib" + base);
+        candidates.push_back ("./lib" + base);
+        }
+#endif
+    for (i = 0; i < candidates.size (); i++)
+        if ((handle = OpenModule (candidates[i])) != 0)
+            return handle;
+    loader->error = "Unable to load " + base + ": " + LastOsError ();
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Module handle for name, opening the module the first time it is seen.     */
+/* The vector slot is reserved before the name is interned, and a name that  */
+/* was interned without its slot (an allocation failed in between) is only   */
+/* indexed once the vector has caught up.  Caller holds the lock.            */
+/*---------------------------------------------------------------------------*/
+static void *GetModule (PluginLoader loader, const char *module)
+{
+    uint32_t id = loader->modules.Find (module);
+    void    *handle;
+
+    if (id != StringPool::NotFound && id < loader->handles.size ())
+        return loader->handles[id];
+    handle = OpenModuleByName (loader, module);
+    try
+        {
+        loader->handles.reserve (loader->handles.size () + 1);
+        id = loader->modules.Intern (module);
+        if (id >= loader->handles.size ())
+            loader->handles.resize (id + 1, 0);
+        }
+    catch (const std::bad_alloc &)
+        {
+        if (handle)
+            CloseModule (handle);
+        throw;
+        }
+    loader->handles[id] = handle;
+    return handle;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Cached symbol lookup.  Missing symbols are cached too, so a step that     */
+/* names an absent export costs one failed lookup, not one per run.  Keys    */
+/* are interned the same way as module names in GetModule.                   */
+/* Caller holds the lock.                                                    */
+/*---------------------------------------------------------------------------*/
+static void *ResolveLocked (PluginLoader loader, const char *module,
+                            const char *symbol, bool required)
+{
+    std::string key = std::string (module) + '\n' + symbol;
+    uint32_t    id = loader->symbols.Find (key.c_str ());
+    void       *address;
+    void       *handle;
+
+    if (id != StringPool::NotFound && id < loader->addresses.size ())
+        address = loader->addresses[id];
+    else
+        {
+        handle = GetModule (loader, module);
+        address = handle ? FindSymbol (handle, symbol) : 0;
+        loader->addresses.reserve (loader->addresses.size () + 1);
+        id = loader->symbols.Intern (key.c_str (), key.size ());
+        if (id >= loader->addresses.size ())
+            loader->addresses.resize (id + 1, 0);
+        loader->addresses[id] = address;
+        }
+    if (!address && required && loader->error.empty ())
+        loader->error = std::string ("Symbol ") + symbol + " not found in "
+                        + module;
+    return address;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Create a loader.                                                          */
+/*---------------------------------------------------------------------------*/
+PluginLoader PLG_New (void)
+{
+    return new (std::nothrow) PluginLoaderRec_Tag;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Unload every module.  Sequences bound to this loader must be rebound      */
+/* (or discarded) before they run again.                                     */
+/*---------------------------------------------------------------------------*/
+void PLG_Dispose (PluginLoader loader)
+{
+    size_t i;
+
+    if (!loader)
+        return;
+    for (i = 0; i < loader->handles.size (); i++)
+        if (loader->handles[i])
+            CloseModule (loader->handles[i]);
+    delete loader;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open a module ahead of time so load errors surface early.                 */
+/*---------------------------------------------------------------------------*/
+int PLG_LoadModule (PluginLoader loader, const char *module)
+{
+    if (!loader || !module)
+        return TMS_ERR_INVALID_ARG;
+    try
+        {
+        std::lock_guard<std::mutex> guard (loader->lock);
+
+        loader->error.clear ();
+        return GetModule (loader, module) ? TMS_OK : TMS_ERR_NOT_FOUND;
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Address of symbol in module, or 0.  Hits after the first are a single     */
+/* hash probe.                                                               */
+/*---------------------------------------------------------------------------*/
+void *PLG_Resolve (PluginLoader loader, const char *module, const char *symbol)
+{
+    if (!loader || !module || !symbol)
+        return 0;
+    try
+        {
+        std::lock_guard<std::mutex> guard (loader->lock);
+
+        loader->error.clear ();
+        return ResolveLocked (loader, module, symbol, true);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return 0;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Resolve the function (and, if the module has them, the symbol_batch and   */
+/* symbol_socket entry points) of every step that names a module export,     */
+/* and store them in the step table.  Each distinct (module, symbol) pair    */
+/* is looked up once.  A built-in step (builtin.h) is bound in place of the  */
+/* module's, which is then not opened.  Returns the number of steps left     */
+/* unresolved.                                                               */
+/*---------------------------------------------------------------------------*/
+int PLG_BindSequence (PluginLoader loader, Sequence seq)
+{
+    struct EntryPoints
+    {
+        void         *func;
+        void         *batch;
+        void         *socket;
+        SeqAsyncFunc  async;
+    };
+    typedef std::unordered_map<uint64_t, EntryPoints> BindMap;
+
+    size_t numSteps;
+    size_t i;
+    int    numUnresolved = 0;
+
+    if (!loader || !seq)
+        return TMS_ERR_INVALID_ARG;
+    if (seq->busy.load ())
+        return TMS_ERR_BUSY;
+    try
+        {
+        std::lock_guard<std::mutex> guard (loader->lock);
+        BindMap                     bound;
+
+        loader->error.clear ();
+        numSteps = seq->Size ();
+        for (i = 0; i < numSteps; i++)
+            {
+            uint32_t module = seq->module[i];
+            uint64_t key;
+
+            if (module == StringPool::NotFound)
+                continue;
+            key = ((uint64_t)module << 32) | seq->symbol[i];
+            BindMap::iterator it = bound.find (key);
+            if (it == bound.end ())
+                {
+                const char *moduleName = seq->names.Get (module);
+                const char *symbolName = seq->names.Get (seq->symbol[i]);
+                std::string batchName = std::string (symbolName)
+                                        + TMS_STEP_BATCH_SUFFIX;
+                std::string socketName = std::string (symbolName)
+                                         + TMS_STEP_SOCKET_SUFFIX;
+                EntryPoints entry = { 0, 0, 0, 0 };
+                const tms::BuiltinStepEntry *builtin
+                    = loader->builtins ? tms::FindBuiltinStep (moduleName,
+                                                               symbolName)
+                                       : 0;
+
+                if (builtin)
+                    {
+                    entry.func = (void *)builtin->func;
+                    entry.batch = (void *)builtin->batch;
+                    entry.socket = (void *)builtin->socketFunc;
+                    entry.async = builtin->asyncFunc;
+                    }
+                else
+                    entry.func = ResolveLocked (loader, moduleName,
+                                                symbolName, true);
+                if (entry.func && !builtin)
+                    {
+                    entry.batch = ResolveLocked (loader, moduleName,
+                                                 batchName.c_str (), false);
+                    entry.socket = ResolveLocked (loader, moduleName,
+                                                  socketName.c_str (), false);
+                    }
+                it = bound.insert (BindMap::value_type (key, entry)).first;
+                }
+            seq->func[i] = (SeqStepFunc)it->second.func;
+            seq->batch[i] = (SeqBatchFunc)it->second.batch;
+            seq->socketFunc[i] = (SeqSocketFunc)it->second.socket;
+            seq->asyncFunc[i] = it->second.async;
+            if (!seq->func[i])
+                numUnresolved++;
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return numUnresolved;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Bind built-in steps in place of the modules they stand in for (the        */
+/* default), or always load the modules -- to try a rebuilt add.dll, say.    */
+/* Takes effect from the next PLG_BindSequence.                              */
+/*---------------------------------------------------------------------------*/
+int PLG_SetBuiltins (PluginLoader loader, int enabled)
+{
+    if (!loader)
+        return TMS_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard (loader->lock);
+    loader->builtins = enabled != 0;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of modules the loader has tried to open.                           */
+/*---------------------------------------------------------------------------*/
+int PLG_NumModules (PluginLoader loader)
+{
+    if (!loader)
+        return TMS_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard (loader->lock);
+    return (int)loader->handles.size ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of entries in the symbol cache.                                    */
+/*---------------------------------------------------------------------------*/
+int PLG_NumSymbols (PluginLoader loader)
+{
+    if (!loader)
+        return TMS_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard (loader->lock);
+    return (int)loader->addresses.size ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Description of the last load or lookup failure, "" if there was none.     */
+/*---------------------------------------------------------------------------*/
+const char *PLG_GetErrorString (PluginLoader loader)
+{
+    if (!loader)
+        return "";
+    return loader->error.c_str ();
+}
@@ -0,0 +1,51 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    plugin.h                                                         */
+/*                                                                           */
+/* PURPOSE: Run-time loader for test step modules (add.dll / add.so).        */
+/*          Modules are opened with LoadLibrary on Windows and dlopen        */
+/*          elsewhere.  Every (module, symbol) pair is resolved once into a  */
+/*          hashed symbol cache, and binding a sequence writes the resolved  */
+/*          pointers into its step table so running a step is a direct call.*/
+/*          Adding a step module needs no relink of the application.        */
+/*          Steps of the in-tree modules are built in (builtin.h) and bound  */
+/*          without loading the module at all.                               */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __PLUGIN_H__
+#define __PLUGIN_H__
+
+#include "tmsapi.h"
+#include "sequence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct PluginLoaderRec_Tag *PluginLoader;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API PluginLoader PLG_New             (void);
+TMS_API void         PLG_Dispose         (PluginLoader loader);
+TMS_API int          PLG_LoadModule      (PluginLoader loader,
+                                          const char *module);
+TMS_API void        *PLG_Resolve         (PluginLoader loader,
+                                          const char *module,
+                                          const char *symbol);
+TMS_API int          PLG_BindSequence    (PluginLoader loader, Sequence seq);
+TMS_API int          PLG_SetBuiltins     (PluginLoader loader, int enabled);
+TMS_API int          PLG_NumModules      (PluginLoader loader);
+TMS_API int          PLG_NumSymbols      (PluginLoader loader);
+TMS_API const char  *PLG_GetErrorString  (PluginLoader loader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PLUGIN_H__ */
@@ -0,0 +1,209 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    pvector.h                                                        */
+/*                                                                           */
+/* PURPOSE: Persistent vector: a 32-way trie whose copies share every node   */
+/*          they have in common.  Copying one is O(1); changing an element   */
+/*          of a copy duplicates only the nodes on the path to it (one leaf  */
+/*          of 32 elements and a branch per level), so many versions of a    */
+/*          large table cost little more than one.  Nodes are shared with    */
+/*          reference counts, and an edit writes in place when the node is   */
+/*          not shared, so building a vector element by element is cheap.    */
+/*          Not thread-safe for concurrent edits.  C++ only.                 */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __PVECTOR_H__
+#define __PVECTOR_H__
+
+#include <stddef.h>
+#include <memory>
+
+namespace tms {
+
+template <typename T>
+class PersistentVector
+{
+public:
+    enum { kBits = 5, kWidth = 1 << kBits, kMask = kWidth - 1 };
+
+    PersistentVector () : m_size (0), m_shift (0), m_allocated (0) {}
+
+    /* A copy shares the nodes; only the allocation count is not copied */
+    PersistentVector (const PersistentVector &other)
+        : m_root (other.m_root), m_size (other.m_size),
+          m_shift (other.m_shift), m_allocated (0) {}
+
+    PersistentVector &operator= (const PersistentVector &other)
+        {
+        m_root = other.m_root;
+        m_size = other.m_size;
+        m_shift = other.m_shift;
+        return *this;
+        }
+
+    size_t size () const { return m_size; }
+
+    const T &operator[] (size_t index) const
+        {
+        const void *node = m_root.get ();
+        int         shift;
+
+        for (shift = m_shift; shift > 0; shift -= kBits)
+            node = static_cast<const Branch *> (node)
+                   ->children[(index >> shift) & kMask].get ();
+        return static_cast<const Leaf *> (node)->items[index & kMask];
+        }
+
+    void Set (size_t index, const T &value)
+        {
+        *MutableItem (index) = value;
+        }
+
+    void PushBack (const T &value)
+        {
+        if (m_root && m_size == Capacity ())
+            {
+            std::shared_ptr<Branch> root = NewNode<Branch> ();
+
+            root->children[0] = m_root;
+            m_root = root;
+            m_shift += kBits;
+            }
+        m_size++;
+        *MutableItem (m_size - 1) = value;
+        }
+
+    /* Forget the elements from size on.  Their nodes are reused, or */
+    /* copied if shared, when the vector grows again.                 */
+    void Truncate (size_t size)
+        {
+        if (size < m_size)
+            m_size = size;
+        }
+
+    /* Bytes of nodes this vector has allocated since the last call */
+    size_t TakeAllocated ()
+        {
+        size_t bytes = m_allocated;
+
+        m_allocated = 0;
+        return bytes;
+        }
+
+    /* Approximate bytes held by all of the nodes */
+    size_t Bytes () const
+        {
+        size_t numLeaves = (m_size + kMask) / kWidth;
+
+        return numLeaves * sizeof (Leaf)
+               + (numLeaves + kWidth - 2) / (kWidth - 1) * sizeof (Branch);
+        }
+
+    /* Call func (index) for each index below both sizes whose element may */
+    /* differ between a and b.  Subtrees the two share are skipped without */
+    /* being visited, so comparing two versions that differ in a few       */
+    /* elements costs a few paths, not a walk of the whole vector.         */
+    template <typename Func>
+    static void ForEachDifference (const PersistentVector &a,
+                                   const PersistentVector &b, Func func)
+        {
+        const void *nodeA = a.m_root.get ();
+        const void *nodeB = b.m_root.get ();
+        size_t      limit = a.m_size < b.m_size ? a.m_size : b.m_size;
+        int         shift = a.m_shift;
+        int         shiftB = b.m_shift;
+
+        if (!limit)
+            return;
+
+        /* A deeper trie holds the shallower one's elements in its first */
+        /* child at each extra level                                     */
+        for (; shift > shiftB; shift -= kBits)
+            nodeA = static_cast<const Branch *> (nodeA)->children[0].get ();
+        for (; shiftB > shift; shiftB -= kBits)
+            nodeB = static_cast<const Branch *> (nodeB)->children[0].get ();
+        Diff (nodeA, nodeB, shift, 0, limit, func);
+        }
+
+private:
+    struct Leaf
+    {
+        T items[kWidth];
+    };
+
+    struct Branch
+    {
+        std::shared_ptr<void> children[kWidth];
+    };
+
+    size_t Capacity () const
+        {
+        return m_root ? (size_t)kWidth << m_shift : 0;
+        }
+
+    template <typename Node>
+    std::shared_ptr<Node> NewNode (const Node *copyOf = 0)
+        {
+        std::shared_ptr<Node> node = copyOf ? std::make_shared<Node> (*copyOf)
+                                            : std::make_shared<Node> ();
+
+        m_allocated += sizeof (Node);
+        return node;
+        }
+
+    /* Make node one this vector alone refers to, creating it if missing */
+    template <typename Node>
+    Node *Unshare (std::shared_ptr<void> &node)
+        {
+        if (!node)
+            node = NewNode<Node> ();
+        else if (node.use_count () > 1)
+            node = NewNode<Node> (static_cast<const Node *> (node.get ()));
+        return static_cast<Node *> (node.get ());
+        }
+
+    T *MutableItem (size_t index)
+        {
+        std::shared_ptr<void> *node = &m_root;
+        int                    shift;
+
+        for (shift = m_shift; shift > 0; shift -= kBits)
+            node = &Unshare<Branch> (*node)
+                    ->children[(index >> shift) & kMask];
+        return &Unshare<Leaf> (*node)->items[index & kMask];
+        }
+
+    template <typename Func>
+    static void Diff (const void *a, const void *b, int shift, size_t base,
+                      size_t limit, Func &func)
+        {
+        size_t span = (size_t)1 << shift;     /* elements per child */
+        size_t i;
+
+        if (a == b || base >= limit)
+            return;
+        if (shift == 0)
+            {
+            for (i = 0; i < kWidth && base + i < limit; i++)
+                if (!a || !b
+                    || !(static_cast<const Leaf *> (a)->items[i]
+                         == static_cast<const Leaf *> (b)->items[i]))
+                    func (base + i);
+            return;
+            }
+        for (i = 0; i < kWidth && base + i * span < limit; i++)
+            Diff (a ? static_cast<const Branch *> (a)->children[i].get () : 0,
+                  b ? static_cast<const Branch *> (b)->children[i].get () : 0,
+                  shift - kBits, base + i * span, limit, func);
+        }
+
+    std::shared_ptr<void> m_root;
+    size_t                m_size;
+    int                   m_shift;      /* kBits per level above the leaves */
+    size_t                m_allocated;
+};
+
+} /* namespace tms */
+
+#endif /* __PVECTOR_H__ */
@@ -0,0 +1,841 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    reslog.cpp                                                       */
+/*                                                                           */
+/* PURPOSE: Result log.  See reslog.h.                                       */
+/*                                                                           */
+/*          The file is a 16-byte header followed by blocks, each            */
+/*              uint32 magic, uint32 payload size, uint32 FNV-1a of the      */
+/*              payload, uint32 record or entry count, payload               */
+/*          in host byte order.  A chunk block holds up to 64K results       */
+/*          column by column (time, run, step, value, status), each column   */
+/*          as zigzag varints of the difference from the previous row, so    */
+/*          a run of similar results takes a byte or two per field.  An      */
+/*          index block lists the chunks written since the previous index,   */
+/*          with their time spans, and ends with its own offset and a        */
+/*          marker: the file's last 16 bytes lead to the newest index, and   */
+/*          each index to the one before.  Blocks are only ever appended;    */
+/*          chunks cut off by a crash are indexed the next time the log is   */
+/*          opened.                                                          */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileio.h"
+#include "reslog.h"
+#include "ring.h"
+#include "strpool.h"
+#include "workpool.h"
+
+using tms::MappedFile;
+using tms::SpscRing;
+using tms::StringPool;
+using tms::SyncFile;
+using tms::TruncateFile;
+using tms::WorkPool;
+
+/*---------------------------------------------------------------------------*/
+/* Defines                                                                   */
+/*---------------------------------------------------------------------------*/
+#define RLG_FILE_VERSION     1
+#define RLG_BYTE_ORDER       0x01020304u
+#define RLG_CHUNK_MAGIC      0x4B4E4843u     /* "CHNK" */
+#define RLG_INDEX_MAGIC      0x58444E49u     /* "INDX" */
+#define RLG_TRAILER_MAGIC    0x444E4552u     /* "REND" */
+#define RLG_CHUNK_RECORDS    65536
+#define RLG_NUM_COLUMNS      5
+#define RLG_RING_SIZE        16384          /* results per thread */
+#define RLG_POLL_MS          2              /* writer's drain interval */
+#define RLG_INDEX_MS         1000           /* longest time left unindexed */
+
+static const char kMagic[8] = { 'T', 'M', 'S', 'R', 'E', 'S', '\x1A', '\0' };
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct FileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+};
+
+struct BlockHeader
+{
+    uint32_t magic;
+    uint32_t size;
+    uint32_t checksum;
+    uint32_t count;
+};
+
+/* Start of a chunk's payload; the columns follow */
+struct ChunkHeader
+{
+    uint64_t minTime;
+    uint64_t maxTime;
+    uint32_t columnBytes[RLG_NUM_COLUMNS];
+    uint32_t reserved;
+};
+
+/* An index payload is prevIndex, count entries, then the trailer */
+struct IndexEntry
+{
+    uint64_t offset;
+    uint64_t minTime;
+    uint64_t maxTime;
+    uint32_t numRecords;
+    uint32_t reserved;
+};
+
+struct Trailer
+{
+    uint64_t indexOffset;
+    uint32_t magic;
+    uint32_t reserved;
+};
+
+typedef SpscRing<ResLogRecord> ResultRing;
+
+struct ResultLogRec_Tag
+{
+    /* One ring per worker of the owning pool, plus a last one shared by */
+    /* every other thread, which take sharedLock to push                 */
+    std::vector<std::unique_ptr<ResultRing> > rings;
+    std::atomic<const void *> owner;
+    std::mutex              sharedLock;
+    std::atomic<uint64_t>   numStalled;
+    std::atomic<uint64_t>   numWritten;
+    std::atomic<bool>       drainAsked;    /* a ring is half full */
+
+    std::mutex              lock;
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    uint64_t                flushAsked;
+    uint64_t                flushDone;
+    bool                    stop;
+    std::atomic<bool>       failed;
+    std::thread             writer;
+
+    /* Writer thread only */
+    FILE                     *file;
+    uint64_t                  fileEnd;
+    uint64_t                  lastIndex;     /* offset, 0 if none */
+    std::vector<ResLogRecord> chunk;         /* RLG_CHUNK_RECORDS long */
+    size_t                    chunkUsed;
+    std::vector<IndexEntry>   unindexed;
+    std::string               buffer;
+
+    ResultLogRec_Tag ()
+        : owner (0), numStalled (0), numWritten (0), drainAsked (false),
+          flushAsked (0),
+          flushDone (0), stop (false), failed (false), file (0), fileEnd (0),
+          lastIndex (0), chunkUsed (0) {}
+};
+
+/*---------------------------------------------------------------------------*/
+/* Column encoding.                                                          */
+/*---------------------------------------------------------------------------*/
+static void PutVarint (std::string &out, uint64_t value)
+{
+    while (value >= 0x80)
+        {
+        out += (char)(value | 0x80);
+        value >>= 7;
+        }
+    out += (char)value;
+}
+
+static bool GetVarint (const unsigned char *&p, const unsigned char *end,
+                       uint64_t &value)
+{
+    int shift;
+
+    value = 0;
+    for (shift = 0; shift < 64 && p < end; shift += 7)
+        {
+        unsigned char byte = *p++;
+
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+        }
+    return false;
+}
+
+static uint64_t ZigZag (int64_t n)
+{
+    return ((uint64_t)n << 1) ^ (uint64_t)(n >> 63);
+}
+
+static int64_t UnZigZag (uint64_t n)
+{
+    return (int64_t)(n >> 1) ^ -(int64_t)(n & 1);
+}
+
+/* Field c of a record, widened so that differences cannot overflow */
+static int64_t Field (const ResLogRecord &rec, int c)
+{
+    switch (c)
+        {
+        case 0:  return (int64_t)rec.time;
+        case 1:  return (int64_t)rec.run;
+        case 2:  return rec.step;
+        case 3:  return rec.value;
+        default: return rec.status;
+        }
+}
+
+static void SetField (ResLogRecord &rec, int c, int64_t value)
+{
+    switch (c)
+        {
+        case 0:  rec.time = (uint64_t)value; break;
+        case 1:  rec.run = (uint32_t)value; break;
+        case 2:  rec.step = (int32_t)value; break;
+        case 3:  rec.value = (int32_t)value; break;
+        default: rec.status = (int32_t)value; break;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Read and check the block at offset.  False if it runs past the end of     */
+/* the data or its checksum is wrong.                                        */
+/*---------------------------------------------------------------------------*/
+static bool ReadBlock (const char *data, size_t size, uint64_t offset,
+                       BlockHeader &block)
+{
+    if (offset > size || size - offset < sizeof (block))
+        return false;
+    memcpy (&block, data + offset, sizeof (block));
+    if ((block.magic != RLG_CHUNK_MAGIC && block.magic != RLG_INDEX_MAGIC)
+        || block.size > size - offset - sizeof (block))
+        return false;
+    return StringPool::Hash (data + offset + sizeof (block), block.size)
+           == block.checksum;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The time span of a checked chunk block.                                   */
+/*---------------------------------------------------------------------------*/
+static bool ChunkEntry (const char *data, uint64_t offset,
+                        const BlockHeader &block, IndexEntry &entry)
+{
+    ChunkHeader header;
+
+    if (block.size < sizeof (header))
+        return false;
+    memcpy (&header, data + offset + sizeof (block), sizeof (header));
+    entry.offset = offset;
+    entry.minTime = header.minTime;
+    entry.maxTime = header.maxTime;
+    entry.numRecords = block.count;
+    entry.reserved = 0;
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Walk the blocks of a file from the start.  Collects the chunks after the  */
+/* last index in unindexed (or every chunk, if all is set) and returns where */
+/* the last good block ends.                                                 */
+/*---------------------------------------------------------------------------*/
+static uint64_t ScanBlocks (const char *data, size_t size, bool all,
+                            std::vector<IndexEntry> &chunks,
+                            uint64_t &lastIndex)
+{
+    uint64_t    offset = sizeof (FileHeader);
+    BlockHeader block;
+    IndexEntry  entry;
+
+    lastIndex = 0;
+    while (ReadBlock (data, size, offset, block))
+        {
+        if (block.magic == RLG_INDEX_MAGIC)
+            {
+            lastIndex = offset;
+            if (!all)
+                chunks.clear ();
+            }
+        else if (ChunkEntry (data, offset, block, entry))
+            chunks.push_back (entry);
+        else
+            break;
+        offset += sizeof (block) + block.size;
+        }
+    return offset;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Follow the trailer back through every index.  False if the file does not  */
+/* end in an intact index (it was cut off by a crash).                       */
+/*---------------------------------------------------------------------------*/
+static bool ReadIndexes (const char *data, size_t size,
+                         std::vector<IndexEntry> &chunks, uint64_t &lastIndex)
+{
+    Trailer     trailer;
+    BlockHeader block;
+    uint64_t    offset;
+    uint64_t    prev;
+
+    if (size < sizeof (FileHeader) + sizeof (trailer))
+        return false;
+    memcpy (&trailer, data + size - sizeof (trailer), sizeof (trailer));
+    if (trailer.magic != RLG_TRAILER_MAGIC)
+        return false;
+    lastIndex = trailer.indexOffset;
+    for (offset = lastIndex; offset; offset = prev)
+        {
+        size_t first = chunks.size ();
+
+        if (!ReadBlock (data, size, offset, block)
+            || block.magic != RLG_INDEX_MAGIC
+            || block.size != sizeof (prev) + block.count * sizeof (IndexEntry)
+                             + sizeof (trailer))
+            return false;
+        memcpy (&prev, data + offset + sizeof (block), sizeof (prev));
+        if (prev >= offset)
+            return false;
+        chunks.resize (first + block.count);
+        memcpy (chunks.data () + first,
+                data + offset + sizeof (block) + sizeof (prev),
+                block.count * sizeof (IndexEntry));
+        }
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Append a block to the file.                                               */
+/*---------------------------------------------------------------------------*/
+static void WriteBlock (ResultLog log, uint32_t magic, uint32_t count,
+                        const std::string &payload)
+{
+    BlockHeader block;
+
+    block.magic = magic;
+    block.size = (uint32_t)payload.size ();
+    block.checksum = StringPool::Hash (payload.data (), payload.size ());
+    block.count = count;
+    if (fwrite (&block, sizeof (block), 1, log->file) != 1
+        || fwrite (payload.data (), 1, payload.size (), log->file)
+           != payload.size ())
+        log->failed = true;
+    log->fileEnd += sizeof (block) + payload.size ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Encode the pending results as one chunk and append it.                    */
+/*---------------------------------------------------------------------------*/
+static void WriteChunk (ResultLog log)
+{
+    const ResLogRecord *chunk = log->chunk.data ();
+    size_t              numRecords = log->chunkUsed;
+    std::string        &out = log->buffer;
+    ChunkHeader         header;
+    IndexEntry          entry;
+    size_t              i;
+    size_t              start;
+    int                 c;
+
+    if (!numRecords)
+        return;
+    memset (&header, 0, sizeof (header));
+    header.minTime = header.maxTime = chunk[0].time;
+    for (i = 1; i < numRecords; i++)
+        {
+        header.minTime = std::min (header.minTime, chunk[i].time);
+        header.maxTime = std::max (header.maxTime, chunk[i].time);
+        }
+    out.assign (sizeof (header), '\0');
+    for (c = 0; c < RLG_NUM_COLUMNS; c++)
+        {
+        int64_t prev = 0;
+
+        start = out.size ();
+        for (i = 0; i < numRecords; i++)
+            {
+            int64_t value = Field (chunk[i], c);
+
+            PutVarint (out, ZigZag (value - prev));
+            prev = value;
+            }
+        header.columnBytes[c] = (uint32_t)(out.size () - start);
+        }
+    memcpy (&out[0], &header, sizeof (header));
+
+    entry.offset = log->fileEnd;
+    entry.minTime = header.minTime;
+    entry.maxTime = header.maxTime;
+    entry.numRecords = (uint32_t)numRecords;
+    entry.reserved = 0;
+    WriteBlock (log, RLG_CHUNK_MAGIC, entry.numRecords, out);
+    log->unindexed.push_back (entry);
+    log->numWritten.fetch_add (numRecords, std::memory_order_relaxed);
+    log->chunkUsed = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Append an index of the chunks written since the last one and sync.        */
+/*---------------------------------------------------------------------------*/
+static void WriteIndex (ResultLog log)
+{
+    std::string &out = log->buffer;
+    Trailer      trailer;
+    uint64_t     offset;
+
+    WriteChunk (log);
+    if (log->unindexed.empty ())
+        return;
+    out.assign ((const char *)&log->lastIndex, sizeof (log->lastIndex));
+    out.append ((const char *)log->unindexed.data (),
+                log->unindexed.size () * sizeof (IndexEntry));
+    offset = log->fileEnd;
+    trailer.indexOffset = offset;
+    trailer.magic = RLG_TRAILER_MAGIC;
+    trailer.reserved = 0;
+    out.append ((const char *)&trailer, sizeof (trailer));
+    WriteBlock (log, RLG_INDEX_MAGIC, (uint32_t)log->unindexed.size (), out);
+    if (!SyncFile (log->file))
+        log->failed = true;
+    log->lastIndex = offset;
+    log->unindexed.clear ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Move everything in the rings into chunks, writing each one that fills.    */
+/*---------------------------------------------------------------------------*/
+static void Drain (ResultLog log)
+{
+    size_t i;
+
+    for (i = 0; i < log->rings.size (); i++)
+        for (;;)
+            {
+            size_t used = log->chunkUsed;
+            size_t count;
+
+            count = log->rings[i]->PopMany (log->chunk.data () + used,
+                                            RLG_CHUNK_RECORDS - used);
+            log->chunkUsed = used + count;
+            if (log->chunkUsed == RLG_CHUNK_RECORDS)
+                WriteChunk (log);
+            else if (!count)
+                break;
+            }
+}
+
+/*---------------------------------------------------------------------------*/
+/* True when the writer should not wait for the next poll.  Call with lock.  */
+/*---------------------------------------------------------------------------*/
+static bool WriterWanted (ResultLog log)
+{
+    return log->stop || log->flushAsked > log->flushDone
+           || log->drainAsked.load (std::memory_order_relaxed);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Writer thread: drain the rings every few milliseconds, and index and sync */
+/* when asked to flush, at least once a second, and when stopping.           */
+/*---------------------------------------------------------------------------*/
+static void WriterMain (ResultLog log)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point lastSync = Clock::now ();
+
+    for (;;)
+        {
+        uint64_t asked;
+        bool     stopping;
+
+            {
+            std::unique_lock<std::mutex> guard (log->lock);
+
+            log->wake.wait_for (guard,
+                                std::chrono::milliseconds (RLG_POLL_MS),
+                                [log] { return WriterWanted (log); });
+            asked = log->flushAsked;
+            stopping = log->stop;
+            }
+        log->drainAsked.store (false, std::memory_order_relaxed);
+        Drain (log);
+        if (stopping || asked > log->flushDone
+            || Clock::now () - lastSync
+               >= std::chrono::milliseconds (RLG_INDEX_MS))
+            {
+            WriteIndex (log);
+            lastSync = Clock::now ();
+            }
+            {
+            std::lock_guard<std::mutex> guard (log->lock);
+
+            log->flushDone = asked;
+            }
+        log->flushed.notify_all ();
+        if (stopping)
+            return;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open the file for appending, creating it if need be.  A tail cut off by a */
+/* crash is trimmed to its last whole block and its chunks are queued for    */
+/* the next index.  A file that is not a result log is left alone.           */
+/*---------------------------------------------------------------------------*/
+static bool OpenFile (ResultLog log, const char *path)
+{
+    MappedFile map;
+    FileHeader header;
+    uint64_t   size;
+    uint64_t   end;
+
+    if (!map.Open (path) || map.Size () == 0)
+        {
+        map.Close ();
+        if (!(log->file = fopen (path, "wb")))
+            return false;
+        memcpy (header.magic, kMagic, sizeof (kMagic));
+        header.version = RLG_FILE_VERSION;
+        header.byteOrder = RLG_BYTE_ORDER;
+        log->fileEnd = sizeof (header);
+        return fwrite (&header, sizeof (header), 1, log->file) == 1
+               && SyncFile (log->file);
+        }
+    if (map.Size () < sizeof (header))
+        return false;
+    memcpy (&header, map.Data (), sizeof (header));
+    if (memcmp (header.magic, kMagic, sizeof (kMagic)) != 0
+        || header.version != RLG_FILE_VERSION
+        || header.byteOrder != RLG_BYTE_ORDER)
+        return false;
+
+    std::vector<IndexEntry> indexed;
+
+    size = map.Size ();
+    if (ReadIndexes (map.Data (), map.Size (), indexed, log->lastIndex))
+        end = size;
+    else
+        end = ScanBlocks (map.Data (), map.Size (), false, log->unindexed,
+                          log->lastIndex);
+    map.Close ();
+    if (!(log->file = fopen (path, "r+b")))
+        return false;
+    if (end < size && !TruncateFile (log->file, end))
+        return false;
+    log->fileEnd = end;
+    return fseek (log->file, 0, SEEK_END) == 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open a result log and start its writer.                                   */
+/*---------------------------------------------------------------------------*/
+ResultLog RLG_New (const char *path)
+{
+    ResultLog log = 0;
+    int       numRings;
+    int       i;
+
+    if (!path || !path[0])
+        return 0;
+    try
+        {
+        log = new ResultLogRec_Tag;
+        if (!OpenFile (log, path))
+            {
+            RLG_Dispose (log);
+            return 0;
+            }
+        numRings = WorkPool::Instance ().NumThreads () + 1;
+        for (i = 0; i < numRings; i++)
+            log->rings.push_back (std::unique_ptr<ResultRing> (
+                new ResultRing (RLG_RING_SIZE)));
+        log->chunk.resize (RLG_CHUNK_RECORDS);
+        log->writer = std::thread (WriterMain, log);
+        }
+    catch (...)
+        {
+        RLG_Dispose (log);
+        return 0;
+        }
+    return log;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write out and index every queued result, then close the log.  No thread   */
+/* may still be adding results.                                              */
+/*---------------------------------------------------------------------------*/
+void RLG_Dispose (ResultLog log)
+{
+    if (!log)
+        return;
+    if (log->writer.joinable ())
+        {
+            {
+            std::lock_guard<std::mutex> guard (log->lock);
+            log->stop = true;
+            }
+        log->wake.notify_one ();
+        log->writer.join ();
+        }
+    if (log->file)
+        fclose (log->file);
+    delete log;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Wall-clock time in microseconds since 1970.                               */
+/*---------------------------------------------------------------------------*/
+static uint64_t NowMicros (void)
+{
+    using namespace std::chrono;
+
+    return (uint64_t)duration_cast<microseconds> (
+        system_clock::now ().time_since_epoch ()).count ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Wake the writer before its next poll.  Without the lock the wakeup can    */
+/* come just before the writer waits, which then costs one poll interval.    */
+/*---------------------------------------------------------------------------*/
+static void AskDrain (ResultLog log)
+{
+    if (!log->drainAsked.exchange (true, std::memory_order_relaxed))
+        log->wake.notify_one ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Push onto a ring, waking the writer early once the ring is half full.     */
+/* When it is full the thread waits for the writer to make room: it gives    */
+/* up its time slice a few times, which is enough when the two share a core, */
+/* then sleeps a poll interval at a time.                                    */
+/*---------------------------------------------------------------------------*/
+static void Push (ResultLog log, ResultRing &ring, const ResLogRecord &rec)
+{
+    int tries;
+
+    if (ring.TryPush (rec))
+        {
+        if (ring.SizeGuess () == ring.Capacity () / 2)
+            AskDrain (log);
+        return;
+        }
+    log->numStalled.fetch_add (1, std::memory_order_relaxed);
+    for (tries = 0; !ring.TryPush (rec); tries++)
+        {
+        AskDrain (log);
+        if (tries < 16)
+            std::this_thread::yield ();
+        else
+            std::this_thread::sleep_for (
+                std::chrono::milliseconds (RLG_POLL_MS));
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Queue one result on the calling thread's ring.                            */
+/*---------------------------------------------------------------------------*/
+int RLG_Add (ResultLog log, uint32_t run, int step, int value, int status)
+{
+    WorkPool &pool = WorkPool::Instance ();
+
+    return RLG_AddFrom (log, &pool, pool.CurrentWorker (), run, step, value,
+                        status);
+}
+
+/*---------------------------------------------------------------------------*/
+/* True if the per-worker rings belong to pool, claiming them if they are    */
+/* still free.  A pool freed and another made at its address is fine: the    */
+/* old workers were joined before the new ones started.                      */
+/*---------------------------------------------------------------------------*/
+static bool OwnsRings (ResultLog log, const void *pool)
+{
+    const void *owner = log->owner.load (std::memory_order_relaxed);
+
+    if (!owner)
+        log->owner.compare_exchange_strong (owner, pool,
+                                            std::memory_order_relaxed);
+    return !owner || owner == pool;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Queue one result on worker's ring.  The rings are sized to the shared     */
+/* pool, so the workers of a bigger pool past that share the locked ring     */
+/* with every thread that is not a worker, and so do the workers of any      */
+/* pool but the one that owns the rings.                                     */
+/*---------------------------------------------------------------------------*/
+int RLG_AddFrom (ResultLog log, const void *pool, int worker, uint32_t run,
+                 int step, int value, int status)
+{
+    ResLogRecord rec;
+
+    if (!log)
+        return TMS_ERR_INVALID_ARG;
+    rec.time = NowMicros ();
+    rec.run = run;
+    rec.step = step;
+    rec.value = value;
+    rec.status = status;
+    if (worker >= 0 && worker + 1 < (int)log->rings.size ()
+        && OwnsRings (log, pool))
+        Push (log, *log->rings[worker], rec);
+    else
+        {
+        std::lock_guard<std::mutex> guard (log->sharedLock);
+        Push (log, *log->rings.back (), rec);
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Wait for the writer to pass a flush request made now.                     */
+/*---------------------------------------------------------------------------*/
+int RLG_Flush (ResultLog log)
+{
+    if (!log)
+        return TMS_ERR_INVALID_ARG;
+
+    std::unique_lock<std::mutex> guard (log->lock);
+    uint64_t                     ticket = ++log->flushAsked;
+
+    log->wake.notify_one ();
+    log->flushed.wait (guard,
+                       [log, ticket] { return log->flushDone >= ticket; });
+    return log->failed ? TMS_ERR_IO : TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Results written so far, and results that waited because a ring was full.  */
+/*---------------------------------------------------------------------------*/
+int RLG_GetCounts (ResultLog log, uint64_t *numWritten, uint64_t *numStalled)
+{
+    if (!log)
+        return TMS_ERR_INVALID_ARG;
+    if (numWritten)
+        *numWritten = log->numWritten.load ();
+    if (numStalled)
+        *numStalled = log->numStalled.load ();
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Decode one chunk block.                                                   */
+/*---------------------------------------------------------------------------*/
+static bool DecodeChunk (const char *data, size_t size, uint64_t offset,
+                         std::vector<ResLogRecord> &records)
+{
+    BlockHeader          block;
+    ChunkHeader          header;
+    const unsigned char *p;
+    const unsigned char *end;
+    uint32_t             i;
+    int                  c;
+
+    if (!ReadBlock (data, size, offset, block)
+        || block.magic != RLG_CHUNK_MAGIC || block.size < sizeof (header))
+        return false;
+    memcpy (&header, data + offset + sizeof (block), sizeof (header));
+    p = (const unsigned char *)data + offset + sizeof (block)
+        + sizeof (header);
+    end = (const unsigned char *)data + offset + sizeof (block) + block.size;
+    records.resize (block.count);
+    for (c = 0; c < RLG_NUM_COLUMNS; c++)
+        {
+        const unsigned char *columnEnd = p + header.columnBytes[c];
+        int64_t              value = 0;
+
+        if (header.columnBytes[c] > (size_t)(end - p))
+            return false;
+        for (i = 0; i < block.count; i++)
+            {
+            uint64_t delta;
+
+            if (!GetVarint (p, columnEnd, delta))
+                return false;
+            value += UnZigZag (delta);
+            SetField (records[i], c, value);
+            }
+        p = columnEnd;
+        }
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Read a log, visiting only the chunks whose time span meets the range.     */
+/* The index is used when the file ends in one; otherwise (a crash cut the   */
+/* file short) the blocks are walked from the start.                         */
+/*---------------------------------------------------------------------------*/
+int RLG_Scan (const char *path, uint64_t fromTime, uint64_t toTime,
+              ResLogScanCallbackPtr callback, void *callbackData)
+{
+    MappedFile map;
+    FileHeader header;
+    uint64_t   lastIndex;
+    size_t     i;
+
+    if (!path || !callback)
+        return TMS_ERR_INVALID_ARG;
+    if (!map.Open (path))
+        return TMS_ERR_NOT_FOUND;
+    if (map.Size () < sizeof (header))
+        return TMS_ERR_IO;
+    memcpy (&header, map.Data (), sizeof (header));
+    if (memcmp (header.magic, kMagic, sizeof (kMagic)) != 0
+        || header.version != RLG_FILE_VERSION
+        || header.byteOrder != RLG_BYTE_ORDER)
+        return TMS_ERR_IO;
+    try
+        {
+        std::vector<IndexEntry>   chunks;
+        std::vector<ResLogRecord> records;
+        std::vector<ResLogRecord> selected;
+
+        if (!ReadIndexes (map.Data (), map.Size (), chunks, lastIndex))
+            {
+            chunks.clear ();
+            ScanBlocks (map.Data (), map.Size (), true, chunks, lastIndex);
+            }
+        std::sort (chunks.begin (), chunks.end (),
+                   [] (const IndexEntry &a, const IndexEntry &b)
+                   { return a.offset < b.offset; });
+        for (i = 0; i < chunks.size (); i++)
+            {
+            const ResLogRecord *deliver;
+            size_t              count;
+            size_t              j;
+
+            if (chunks[i].maxTime < fromTime || chunks[i].minTime > toTime)
+                continue;
+            if (!DecodeChunk (map.Data (), map.Size (), chunks[i].offset,
+                              records))
+                return TMS_ERR_IO;
+            deliver = records.data ();
+            count = records.size ();
+            if (chunks[i].minTime < fromTime || chunks[i].maxTime > toTime)
+                {
+                selected.clear ();
+                for (j = 0; j < records.size (); j++)
+                    if (records[j].time >= fromTime
+                        && records[j].time <= toTime)
+                        selected.push_back (records[j]);
+                deliver = selected.data ();
+                count = selected.size ();
+                }
+            if (count && callback (deliver, (int)count, callbackData))
+                break;
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
@@ -0,0 +1,83 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    reslog.h                                                         */
+/*                                                                           */
+/* PURPOSE: Append-only log of step results for Run > Step and Run > All.    */
+/*          Adding a result never waits for the disk: each pool worker has   */
+/*          its own lock-free ring, and a background thread drains the       */
+/*          rings into compressed column chunks at the end of the file.      */
+/*          Every flush adds an index of the new chunks, so a reader can     */
+/*          skip straight to the chunks for a span of time.                  */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __RESLOG_H__
+#define __RESLOG_H__
+
+#include <stdint.h>
+
+#include "tmsapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct ResultLogRec_Tag *ResultLog;
+
+/* One step result.  time is in microseconds since 1970 (UTC); status is an */
+/* EXE_STATUS_* value.                                                      */
+typedef struct ResLogRecordRec_Tag
+{
+    uint64_t time;
+    uint32_t run;
+    int32_t  step;
+    int32_t  value;
+    int32_t  status;
+} ResLogRecord;
+
+/* Called with the records of one chunk at a time.  Return non-zero to stop */
+typedef int (CVICALLBACK *ResLogScanCallbackPtr) (const ResLogRecord *records,
+                                                  int numRecords,
+                                                  void *callbackData);
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API ResultLog RLG_New       (const char *path);
+TMS_API void      RLG_Dispose   (ResultLog log);
+
+/* Queue one result.  Safe from any thread; lock-free on the pool workers. */
+/* A result is never dropped: if the writer has fallen so far behind that  */
+/* the thread's ring is full, the thread waits for the writer to drain it  */
+/* (not for the disk) and the wait is counted as a stall.                  */
+TMS_API int       RLG_Add       (ResultLog log, uint32_t run, int step,
+                                 int value, int status);
+
+/* RLG_Add for a caller that is not on the shared pool: worker is its index */
+/* in pool (an execution's own pool), or -1.  The lock-free rings go to the */
+/* first pool to add a result; the workers of any other pool take the lock. */
+TMS_API int       RLG_AddFrom   (ResultLog log, const void *pool, int worker,
+                                 uint32_t run, int step, int value,
+                                 int status);
+
+/* Wait until every result queued so far is on disk and indexed */
+TMS_API int       RLG_Flush     (ResultLog log);
+
+/* Results written so far, and results that had to wait for a full ring */
+TMS_API int       RLG_GetCounts (ResultLog log, uint64_t *numWritten,
+                                 uint64_t *numStalled);
+
+/* Read the results logged between fromTime and toTime (inclusive) */
+TMS_API int       RLG_Scan      (const char *path, uint64_t fromTime,
+                                 uint64_t toTime,
+                                 ResLogScanCallbackPtr callback,
+                                 void *callbackData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RESLOG_H__ */
@@ -0,0 +1,98 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    ring.h                                                           */
+/*                                                                           */
+/* PURPOSE: Bounded single-producer, single-consumer ring buffer.  One       */
+/*          thread pushes and one thread pops, with no locks: each side      */
+/*          owns one index and only reads the other's, and keeps a cached    */
+/*          copy of it so the shared cache line is touched only when the     */
+/*          ring looks full or empty.  C++ only.                             */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __RING_H__
+#define __RING_H__
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+namespace tms {
+
+template <typename T>
+class SpscRing
+{
+public:
+    /* capacity is rounded up to a power of two */
+    explicit SpscRing (size_t capacity)
+        : m_head (0), m_cachedTail (0), m_tail (0), m_cachedHead (0)
+        {
+        size_t size = 2;
+
+        while (size < capacity)
+            size *= 2;
+        m_items.resize (size);
+        m_mask = size - 1;
+        }
+
+    size_t Capacity () const { return m_items.size (); }
+
+    /* Producer side.  Items in the ring, or more if the consumer has */
+    /* popped some since the producer last looked.                    */
+    size_t SizeGuess () const
+        {
+        return m_head.load (std::memory_order_relaxed) - m_cachedTail;
+        }
+
+    /* Producer side.  False if the ring is full. */
+    bool TryPush (const T &item)
+        {
+        size_t head = m_head.load (std::memory_order_relaxed);
+
+        if (head - m_cachedTail == m_items.size ())
+            {
+            m_cachedTail = m_tail.load (std::memory_order_acquire);
+            if (head - m_cachedTail == m_items.size ())
+                return false;
+            }
+        m_items[head & m_mask] = item;
+        m_head.store (head + 1, std::memory_order_release);
+        return true;
+        }
+
+    /* Consumer side.  Moves up to maxItems items to out and returns how */
+    /* many there were.                                                  */
+    size_t PopMany (T *out, size_t maxItems)
+        {
+        size_t tail = m_tail.load (std::memory_order_relaxed);
+        size_t count;
+        size_t i;
+
+        if (m_cachedHead == tail)
+            m_cachedHead = m_head.load (std::memory_order_acquire);
+        count = m_cachedHead - tail;
+        if (count > maxItems)
+            count = maxItems;
+        for (i = 0; i < count; i++)
+            out[i] = m_items[(tail + i) & m_mask];
+        m_tail.store (tail + count, std::memory_order_release);
+        return count;
+        }
+
+private:
+    SpscRing (const SpscRing &);
+    SpscRing &operator= (const SpscRing &);
+
+    std::vector<T> m_items;
+    size_t         m_mask;
+
+    /* Producer's line, then consumer's, so neither writes the other's */
+    alignas (64) std::atomic<size_t> m_head;
+    size_t                           m_cachedTail;
+    alignas (64) std::atomic<size_t> m_tail;
+    size_t                           m_cachedHead;
+};
+
+} /* namespace tms */
+
+#endif /* __RING_H__ */
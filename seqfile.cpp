@@ -0,0 +1,694 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    seqfile.cpp                                                      */
+/*                                                                           */
+/* PURPOSE: Sequence files.  See sequence.h.                                 */
+/*                                                                           */
+/*          A binary file is a header followed by one section per column,    */
+/*          each the column's elements in host byte order, starting on an    */
+/*          8-byte boundary:                                                 */
+/*              kind, param, lowLimit, highLimit, group, name, module,       */
+/*              symbol, argOffset, argCount   (numSteps elements each)       */
+/*              args                          (numArgs)                      */
+/*              string offsets, string bytes  (the step table's names)       */
+/*          The sections are the in-memory columns byte for byte, so Load    */
+/*          only maps the file, checks it and points the columns at it.      */
+/*                                                                           */
+/*          A text file starts with the line "TMSSEQ TEXT 1" and has one     */
+/*          line per step, its fields separated by tabs:                     */
+/*              kind name param low high group module symbol inputs          */
+/*          kind is action, limit or sweep; module and symbol are "-" if     */
+/*          the step has none; inputs are comma separated, or "-".  Lines    */
+/*          starting with '#' are comments.                                  */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "fileio.h"
+#include "seqtable.h"
+
+using tms::MappedFile;
+using tms::RenameOver;
+using tms::StringPool;
+using tms::SyncFile;
+
+/*---------------------------------------------------------------------------*/
+/* Defines                                                                   */
+/*---------------------------------------------------------------------------*/
+#define SEQ_FILE_VERSION     1
+#define SEQ_FILE_BYTE_ORDER  0x01020304u
+#define SEQ_FILE_ALIGN       8
+#define SEQ_TEXT_HEADER      "TMSSEQ TEXT 1"
+#define SEQ_HASH_SEED        0xCBF29CE484222325ull
+
+static const char kMagic[8] = { 'T', 'M', 'S', 'S', 'E', 'Q', '\x1A', '\0' };
+
+/* Sections, in file order */
+enum
+    {
+    SECTION_KIND,
+    SECTION_PARAM,
+    SECTION_LOW_LIMIT,
+    SECTION_HIGH_LIMIT,
+    SECTION_GROUP,
+    SECTION_NAME,
+    SECTION_MODULE,
+    SECTION_SYMBOL,
+    SECTION_ARG_OFFSET,
+    SECTION_ARG_COUNT,
+    SECTION_ARGS,
+    SECTION_STR_OFFSETS,
+    SECTION_STR_CHARS,
+    SECTION_COUNT
+    };
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct SeqFileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrder;             /* SEQ_FILE_BYTE_ORDER as written */
+    uint32_t numSteps;
+    uint32_t numArgs;
+    uint32_t numStrings;
+    int32_t  maxGroup;
+    uint64_t numStrBytes;
+    uint64_t fileSize;
+    uint64_t checksum;              /* of every byte after the header */
+    uint64_t section[SECTION_COUNT];   /* file offsets */
+};
+
+static_assert (sizeof (SeqFileHeader) % SEQ_FILE_ALIGN == 0,
+               "sections must start aligned");
+
+/*---------------------------------------------------------------------------*/
+/* Size in bytes of every section, from the counts in a header.              */
+/*---------------------------------------------------------------------------*/
+static void SectionSizes (const SeqFileHeader &header,
+                          uint64_t sizes[SECTION_COUNT])
+{
+    uint64_t steps = header.numSteps;
+    int      i;
+
+    sizes[SECTION_KIND] = steps * sizeof (uint8_t);
+    for (i = SECTION_PARAM; i <= SECTION_ARG_COUNT; i++)
+        sizes[i] = steps * 4;
+    sizes[SECTION_ARGS] = (uint64_t)header.numArgs * sizeof (int32_t);
+    sizes[SECTION_STR_OFFSETS] = (uint64_t)header.numStrings
+                                 * sizeof (uint32_t);
+    sizes[SECTION_STR_CHARS] = header.numStrBytes;
+}
+
+static uint64_t AlignUp (uint64_t n)
+{
+    return (n + SEQ_FILE_ALIGN - 1) & ~(uint64_t)(SEQ_FILE_ALIGN - 1);
+}
+
+/*---------------------------------------------------------------------------*/
+/* 64-bit FNV-1a taken a word at a time, so checking a large file costs      */
+/* little more than reading it.  A partial last word is padded with zeros,   */
+/* as it is in the file.                                                     */
+/*---------------------------------------------------------------------------*/
+static uint64_t HashWords (uint64_t hash, const char *data, size_t size)
+{
+    uint64_t word;
+    size_t   i;
+
+    for (i = 0; i + 8 <= size; i += 8)
+        {
+        memcpy (&word, data + i, 8);
+        hash = (hash ^ word) * 0x100000001B3ull;
+        }
+    if (i < size)
+        {
+        word = 0;
+        memcpy (&word, data + i, size - i);
+        hash = (hash ^ word) * 0x100000001B3ull;
+        }
+    return hash;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Tell a binary sequence file, a text one and anything else apart by their  */
+/* first bytes.                                                              */
+/*---------------------------------------------------------------------------*/
+int SEQ_FileFormat (const char *path)
+{
+    char   head[sizeof (kMagic) + sizeof (SEQ_TEXT_HEADER)];
+    size_t numRead;
+    FILE  *file;
+
+    if (!path)
+        return TMS_ERR_INVALID_ARG;
+    if (!(file = fopen (path, "rb")))
+        return errno == ENOENT ? TMS_ERR_NOT_FOUND : TMS_ERR_IO;
+    numRead = fread (head, 1, sizeof (head), file);
+    fclose (file);
+    if (numRead >= sizeof (kMagic)
+        && memcmp (head, kMagic, sizeof (kMagic)) == 0)
+        return SEQ_FORMAT_BINARY;
+    if (numRead >= sizeof (SEQ_TEXT_HEADER) - 1
+        && memcmp (head, SEQ_TEXT_HEADER, sizeof (SEQ_TEXT_HEADER) - 1) == 0)
+        return SEQ_FORMAT_TEXT;
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Check every id, index and count in a mapped file, so that nothing the     */
+/* engine does with the borrowed columns can read outside them.              */
+/*---------------------------------------------------------------------------*/
+static bool CheckSteps (const SeqFileHeader &header, const char *base)
+{
+    const uint8_t  *kind = (const uint8_t *)(base
+                                             + header.section[SECTION_KIND]);
+    const int32_t  *group = (const int32_t *)(base
+                                              + header.section[SECTION_GROUP]);
+    const uint32_t *name = (const uint32_t *)(base
+                                              + header.section[SECTION_NAME]);
+    const uint32_t *module = (const uint32_t *)(base
+                                 + header.section[SECTION_MODULE]);
+    const uint32_t *symbol = (const uint32_t *)(base
+                                 + header.section[SECTION_SYMBOL]);
+    const uint32_t *argOffset = (const uint32_t *)(base
+                                    + header.section[SECTION_ARG_OFFSET]);
+    const int32_t  *argCount = (const int32_t *)(base
+                                   + header.section[SECTION_ARG_COUNT]);
+    const uint32_t *strOffsets = (const uint32_t *)(base
+                                     + header.section[SECTION_STR_OFFSETS]);
+    const char     *strChars = base + header.section[SECTION_STR_CHARS];
+    uint32_t        numStrings = header.numStrings;
+    int32_t         maxGroup = -1;
+    uint32_t        i;
+
+    if (numStrings && (!header.numStrBytes
+                       || strChars[header.numStrBytes - 1] != '\0'))
+        return false;
+    for (i = 0; i < numStrings; i++)
+        if (strOffsets[i] >= header.numStrBytes)
+            return false;
+    for (i = 0; i < header.numSteps; i++)
+        {
+        if (kind[i] > SEQ_KIND_SWEEP || group[i] < 0 || name[i] >= numStrings
+            || argCount[i] < 0
+            || (uint64_t)argOffset[i] + (uint32_t)argCount[i] > header.numArgs)
+            return false;
+        if ((module[i] == StringPool::NotFound)
+            != (symbol[i] == StringPool::NotFound))
+            return false;
+        if (module[i] != StringPool::NotFound
+            && (module[i] >= numStrings || symbol[i] >= numStrings))
+            return false;
+        if (group[i] > maxGroup)
+            maxGroup = group[i];
+        }
+    return maxGroup == header.maxGroup;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Map a binary sequence file and use its columns in place.  Only the        */
+/* function pointer columns are allocated; they start out empty.             */
+/*---------------------------------------------------------------------------*/
+Sequence SEQ_Load (const char *path)
+{
+    SeqFileHeader header;
+    uint64_t      sizes[SECTION_COUNT];
+    const char   *base;
+    Sequence      seq = 0;
+    int           i;
+
+    if (!path)
+        return 0;
+    try
+        {
+        std::unique_ptr<MappedFile> map (new MappedFile);
+
+        if (!map->Open (path) || map->Size () < sizeof (header))
+            return 0;
+        base = map->Data ();
+        memcpy (&header, base, sizeof (header));
+        if (memcmp (header.magic, kMagic, sizeof (kMagic)) != 0
+            || header.version != SEQ_FILE_VERSION
+            || header.byteOrder != SEQ_FILE_BYTE_ORDER
+            || header.fileSize != map->Size ()
+            || header.numSteps > INT_MAX || header.numArgs > INT_MAX
+            || header.numStrBytes > header.fileSize)
+            return 0;
+        SectionSizes (header, sizes);
+        for (i = 0; i < SECTION_COUNT; i++)
+            if (header.section[i] < sizeof (header)
+                || header.section[i] % SEQ_FILE_ALIGN
+                || header.section[i] > header.fileSize
+                || sizes[i] > header.fileSize - header.section[i])
+                return 0;
+        if (HashWords (SEQ_HASH_SEED, base + sizeof (header),
+                       map->Size () - sizeof (header)) != header.checksum
+            || !CheckSteps (header, base))
+            return 0;
+
+        if (!(seq = SEQ_New ()))
+            return 0;
+        seq->kind.Borrow ((const uint8_t *)(base
+                                            + header.section[SECTION_KIND]),
+                          header.numSteps);
+        seq->param.Borrow ((const int32_t *)(base
+                               + header.section[SECTION_PARAM]),
+                           header.numSteps);
+        seq->lowLimit.Borrow ((const int32_t *)(base
+                                  + header.section[SECTION_LOW_LIMIT]),
+                              header.numSteps);
+        seq->highLimit.Borrow ((const int32_t *)(base
+                                   + header.section[SECTION_HIGH_LIMIT]),
+                               header.numSteps);
+        seq->group.Borrow ((const int32_t *)(base
+                               + header.section[SECTION_GROUP]),
+                           header.numSteps);
+        seq->name.Borrow ((const uint32_t *)(base
+                              + header.section[SECTION_NAME]),
+                          header.numSteps);
+        seq->module.Borrow ((const uint32_t *)(base
+                                + header.section[SECTION_MODULE]),
+                            header.numSteps);
+        seq->symbol.Borrow ((const uint32_t *)(base
+                                + header.section[SECTION_SYMBOL]),
+                            header.numSteps);
+        seq->argOffset.Borrow ((const uint32_t *)(base
+                                   + header.section[SECTION_ARG_OFFSET]),
+                               header.numSteps);
+        seq->argCount.Borrow ((const int32_t *)(base
+                                  + header.section[SECTION_ARG_COUNT]),
+                              header.numSteps);
+        seq->args.Borrow ((const int32_t *)(base
+                              + header.section[SECTION_ARGS]),
+                          header.numArgs);
+        seq->names.Borrow (base + header.section[SECTION_STR_CHARS],
+                           (size_t)header.numStrBytes,
+                           (const uint32_t *)(base
+                               + header.section[SECTION_STR_OFFSETS]),
+                           header.numStrings);
+        seq->func.resize (header.numSteps);
+        seq->batch.resize (header.numSteps);
+        seq->socketFunc.resize (header.numSteps);
+        seq->asyncFunc.resize (header.numSteps);
+        seq->maxGroup = header.maxGroup;
+        seq->file = std::move (map);
+        }
+    catch (const std::bad_alloc &)
+        {
+        SEQ_Dispose (seq);
+        return 0;
+        }
+    return seq;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write one section at the current position, zero-padded to the alignment,  */
+/* and fold it into the checksum.                                            */
+/*---------------------------------------------------------------------------*/
+static void WriteSection (FILE *file, const void *data, uint64_t size,
+                          uint64_t &hash)
+{
+    static const char zeros[SEQ_FILE_ALIGN] = { 0 };
+    size_t            padding = (size_t)(AlignUp (size) - size);
+
+    if (size)
+        fwrite (data, 1, (size_t)size, file);
+    fwrite (zeros, 1, padding, file);
+    hash = HashWords (hash, (const char *)data, (size_t)size);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Give a sequence its own copy of everything it borrows from its file, and  */
+/* unmap the file.  Windows cannot replace a file that is mapped.            */
+/*---------------------------------------------------------------------------*/
+static void Detach (Sequence seq)
+{
+    seq->kind.MutableData ();
+    seq->param.MutableData ();
+    seq->lowLimit.MutableData ();
+    seq->highLimit.MutableData ();
+    seq->group.MutableData ();
+    seq->name.MutableData ();
+    seq->module.MutableData ();
+    seq->symbol.MutableData ();
+    seq->argOffset.MutableData ();
+    seq->argCount.MutableData ();
+    seq->args.MutableData ();
+    seq->names.Reserve (seq->names.Count (), seq->names.Bytes ());
+    seq->file.reset ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write a binary sequence file.  The sections are streamed to a temporary   */
+/* file, the header goes in last, and the result replaces path.              */
+/*---------------------------------------------------------------------------*/
+int SEQ_Save (Sequence seq, const char *path)
+{
+    SeqFileHeader header;
+    uint64_t      sizes[SECTION_COUNT];
+    uint64_t      offset = sizeof (header);
+    uint64_t      hash = SEQ_HASH_SEED;
+    const void   *data[SECTION_COUNT];
+    FILE         *file;
+    bool          ok;
+    int           i;
+
+    if (!seq || !path || !path[0])
+        return TMS_ERR_INVALID_ARG;
+    try
+        {
+        std::string temp = std::string (path) + ".tmp";
+
+        if (seq->file)
+            {
+            if (seq->busy.load ())
+                return TMS_ERR_BUSY;
+            Detach (seq);
+            }
+
+        memset (&header, 0, sizeof (header));
+        memcpy (header.magic, kMagic, sizeof (kMagic));
+        header.version = SEQ_FILE_VERSION;
+        header.byteOrder = SEQ_FILE_BYTE_ORDER;
+        header.numSteps = (uint32_t)seq->Size ();
+        header.numArgs = (uint32_t)seq->args.size ();
+        header.numStrings = seq->names.Count ();
+        header.maxGroup = seq->maxGroup;
+        header.numStrBytes = seq->names.Bytes ();
+        SectionSizes (header, sizes);
+        for (i = 0; i < SECTION_COUNT; i++)
+            {
+            header.section[i] = offset;
+            offset += AlignUp (sizes[i]);
+            }
+        header.fileSize = offset;
+
+        data[SECTION_KIND] = seq->kind.data ();
+        data[SECTION_PARAM] = seq->param.data ();
+        data[SECTION_LOW_LIMIT] = seq->lowLimit.data ();
+        data[SECTION_HIGH_LIMIT] = seq->highLimit.data ();
+        data[SECTION_GROUP] = seq->group.data ();
+        data[SECTION_NAME] = seq->name.data ();
+        data[SECTION_MODULE] = seq->module.data ();
+        data[SECTION_SYMBOL] = seq->symbol.data ();
+        data[SECTION_ARG_OFFSET] = seq->argOffset.data ();
+        data[SECTION_ARG_COUNT] = seq->argCount.data ();
+        data[SECTION_ARGS] = seq->args.data ();
+        data[SECTION_STR_OFFSETS] = seq->names.OffsetData ();
+        data[SECTION_STR_CHARS] = seq->names.CharData ();
+
+        if (!(file = fopen (temp.c_str (), "wb")))
+            return TMS_ERR_IO;
+        fwrite (&header, 1, sizeof (header), file);
+        for (i = 0; i < SECTION_COUNT; i++)
+            WriteSection (file, data[i], sizes[i], hash);
+        header.checksum = hash;
+        ok = !ferror (file) && fseek (file, 0, SEEK_SET) == 0
+             && fwrite (&header, 1, sizeof (header), file) == sizeof (header)
+             && SyncFile (file);
+        ok = fclose (file) == 0 && ok;
+        if (!ok || !RenameOver (temp, path))
+            {
+            remove (temp.c_str ());
+            return TMS_ERR_IO;
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+static const char *const kKindNames[] = { "action", "limit", "sweep" };
+
+/*---------------------------------------------------------------------------*/
+/* Read one line of text without its end-of-line characters.  False at the   */
+/* end of the file.                                                          */
+/*---------------------------------------------------------------------------*/
+static bool ReadLine (FILE *file, std::string &line)
+{
+    char chunk[256];
+
+    line.clear ();
+    while (fgets (chunk, sizeof (chunk), file))
+        {
+        line += chunk;
+        if (!line.empty () && line[line.size () - 1] == '\n')
+            break;
+        }
+    if (line.empty ())
+        return false;
+    while (!line.empty () && (line[line.size () - 1] == '\n'
+                              || line[line.size () - 1] == '\r'))
+        line.erase (line.size () - 1);
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Names are written with tabs, line breaks and backslashes escaped, and a   */
+/* name of just "-" as "\-" so it is not read back as an empty field.        */
+/*---------------------------------------------------------------------------*/
+static void WriteEscaped (FILE *file, const char *str)
+{
+    if (strcmp (str, "-") == 0)
+        fputc ('\\', file);
+    for (; *str; str++)
+        switch (*str)
+            {
+            case '\t': fputs ("\\t", file); break;
+            case '\n': fputs ("\\n", file); break;
+            case '\r': fputs ("\\r", file); break;
+            case '\\': fputs ("\\\\", file); break;
+            default:   fputc (*str, file); break;
+            }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Undo WriteEscaped.                                                        */
+/*---------------------------------------------------------------------------*/
+static std::string Unescape (const std::string &field)
+{
+    std::string out;
+    size_t      i;
+
+    for (i = 0; i < field.size (); i++)
+        {
+        if (field[i] != '\\' || i + 1 == field.size ())
+            {
+            out += field[i];
+            continue;
+            }
+        switch (field[++i])
+            {
+            case 't': out += '\t'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            default:  out += field[i]; break;
+            }
+        }
+    return out;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Parse a whole field as an int.                                            */
+/*---------------------------------------------------------------------------*/
+static bool ParseInt (const std::string &field, int &value)
+{
+    const char *start = field.c_str ();
+    char       *end;
+    long        n;
+
+    errno = 0;
+    n = strtol (start, &end, 10);
+    if (end == start || *end || errno || n < INT_MIN || n > INT_MAX)
+        return false;
+    value = (int)n;
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Add the step described by one line of a text file.                        */
+/*---------------------------------------------------------------------------*/
+static int ImportStep (Sequence seq, const std::string &line,
+                       std::vector<std::string> &fields,
+                       std::vector<int32_t> &inputs)
+{
+    int    param, lowLimit, highLimit, group;
+    int    kind;
+    int    step;
+    size_t start = 0;
+    size_t end;
+
+    fields.clear ();
+    do
+        {
+        end = line.find ('\t', start);
+        fields.push_back (line.substr (start, end == std::string::npos
+                                              ? std::string::npos
+                                              : end - start));
+        start = end + 1;
+        }
+    while (end != std::string::npos);
+    if (fields.size () != 9)
+        return TMS_ERR_INVALID_ARG;
+    for (kind = 0; kind <= SEQ_KIND_SWEEP; kind++)
+        if (fields[0] == kKindNames[kind])
+            break;
+    if (kind > SEQ_KIND_SWEEP || !ParseInt (fields[2], param)
+        || !ParseInt (fields[3], lowLimit) || !ParseInt (fields[4], highLimit)
+        || !ParseInt (fields[5], group))
+        return TMS_ERR_INVALID_ARG;
+
+    inputs.clear ();
+    if (fields[8] != "-")
+        {
+        const char *p = fields[8].c_str ();
+
+        for (;;)
+            {
+            char *end;
+            long  n;
+
+            errno = 0;
+            n = strtol (p, &end, 10);
+            if (end == p || errno || n < INT_MIN || n > INT_MAX
+                || (*end && *end != ','))
+                return TMS_ERR_INVALID_ARG;
+            inputs.push_back ((int32_t)n);
+            if (!*end)
+                break;
+            p = end + 1;
+            }
+        }
+    if (kind != SEQ_KIND_SWEEP && !inputs.empty ())
+        return TMS_ERR_INVALID_ARG;
+
+    if (kind == SEQ_KIND_SWEEP)
+        step = SEQ_AddSweepStep (seq, Unescape (fields[1]).c_str (), 0, 0,
+                                 inputs.data (), (int)inputs.size (),
+                                 lowLimit, highLimit, group);
+    else
+        step = SEQ_AddStep (seq, Unescape (fields[1]).c_str (), kind, 0,
+                            param, lowLimit, highLimit, group);
+    if (step < 0)
+        return step;
+    if ((fields[6] == "-") != (fields[7] == "-"))
+        return TMS_ERR_INVALID_ARG;
+    if (fields[6] != "-")
+        return SEQ_SetStepSymbol (seq, step, Unescape (fields[6]).c_str (),
+                                  Unescape (fields[7]).c_str ());
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Build a sequence from a text file.  Returns 0 if the file cannot be read  */
+/* or any line is malformed.                                                 */
+/*---------------------------------------------------------------------------*/
+Sequence SEQ_ImportText (const char *path)
+{
+    Sequence seq = 0;
+    FILE    *file;
+    int      status = TMS_ERR_INVALID_ARG;
+
+    if (!path || !(file = fopen (path, "r")))
+        return 0;
+    try
+        {
+        std::vector<std::string> fields;
+        std::vector<int32_t>     inputs;
+        std::string              line;
+
+        if (ReadLine (file, line) && line == SEQ_TEXT_HEADER
+            && (seq = SEQ_New ()) != 0)
+            {
+            status = TMS_OK;
+            while (status == TMS_OK && ReadLine (file, line))
+                if (!line.empty () && line[0] != '#')
+                    status = ImportStep (seq, line, fields, inputs);
+            if (ferror (file))
+                status = TMS_ERR_IO;
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        status = TMS_ERR_NO_MEMORY;
+        }
+    fclose (file);
+    if (status < 0)
+        {
+        SEQ_Dispose (seq);
+        return 0;
+        }
+    return seq;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write a sequence as text.  Like Save, the file is replaced atomically.    */
+/*---------------------------------------------------------------------------*/
+int SEQ_ExportText (Sequence seq, const char *path)
+{
+    FILE  *file;
+    size_t numSteps;
+    size_t i;
+    bool   ok;
+
+    if (!seq || !path || !path[0])
+        return TMS_ERR_INVALID_ARG;
+    try
+        {
+        std::string temp = std::string (path) + ".tmp";
+
+        if (!(file = fopen (temp.c_str (), "w")))
+            return TMS_ERR_IO;
+        fprintf (file, "%s\n", SEQ_TEXT_HEADER);
+        numSteps = seq->Size ();
+        for (i = 0; i < numSteps; i++)
+            {
+            int32_t j;
+
+            fprintf (file, "%s\t", kKindNames[seq->kind[i]]);
+            WriteEscaped (file, seq->names.Get (seq->name[i]));
+            fprintf (file, "\t%d\t%d\t%d\t%d\t", (int)seq->param[i],
+                     (int)seq->lowLimit[i], (int)seq->highLimit[i],
+                     (int)seq->group[i]);
+            if (seq->module[i] == StringPool::NotFound)
+                fputs ("-\t-", file);
+            else
+                {
+                WriteEscaped (file, seq->names.Get (seq->module[i]));
+                fputc ('\t', file);
+                WriteEscaped (file, seq->names.Get (seq->symbol[i]));
+                }
+            fputc ('\t', file);
+            if (!seq->argCount[i])
+                fputc ('-', file);
+            for (j = 0; j < seq->argCount[i]; j++)
+                fprintf (file, j ? ",%d" : "%d",
+                         (int)seq->args[seq->argOffset[i] + j]);
+            fputc ('\n', file);
+            }
+        ok = !ferror (file) && SyncFile (file);
+        ok = fclose (file) == 0 && ok;
+        if (!ok || !RenameOver (temp, path))
+            {
+            remove (temp.c_str ());
+            return TMS_ERR_IO;
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
@@ -0,0 +1,96 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    seqlock.h                                                        */
+/*                                                                           */
+/* PURPOSE: Sequence lock: a small value written now and then by the         */
+/*          threads doing the work and read, whole, by any number of         */
+/*          others.  A reader never writes to the lock, so it cannot hold up */
+/*          a writer; it copies the value and tries again if a write was in  */
+/*          progress meanwhile.  Writers take turns, so they should meet     */
+/*          seldom.  The value is kept in atomic words, so a torn copy is    */
+/*          never used and is not a data race.  C++ only.                    */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __SEQLOCK_H__
+#define __SEQLOCK_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+namespace tms {
+
+template <typename T>
+class SeqLock
+{
+    static_assert (std::is_trivially_copyable<T>::value,
+                   "a SeqLock holds a plain struct");
+
+public:
+    SeqLock () : m_sequence (0)
+        {
+        T blank = T ();
+
+        Store (blank);
+        }
+
+    /* Writer side.  Waits for a write in progress on another thread. */
+    void Store (const T &value)
+        {
+        uint64_t words[kNumWords] = {0};
+        uint32_t sequence = m_sequence.load (std::memory_order_relaxed);
+        int      i;
+
+        memcpy (words, &value, sizeof(T));
+        while ((sequence & 1)
+               || !m_sequence.compare_exchange_weak (
+                      sequence, sequence + 1, std::memory_order_relaxed))
+            sequence = m_sequence.load (std::memory_order_relaxed);
+
+        /* The odd count is seen before any of the new words */
+        std::atomic_thread_fence (std::memory_order_release);
+        for (i = 0; i < kNumWords; i++)
+            m_words[i].store (words[i], std::memory_order_relaxed);
+        m_sequence.store (sequence + 2, std::memory_order_release);
+        }
+
+    /* Reader side.  The value as of the last Store to finish. */
+    T Load () const
+        {
+        uint64_t words[kNumWords];
+        uint32_t before;
+        uint32_t after;
+        T        value;
+        int      i;
+
+        do
+            {
+            before = m_sequence.load (std::memory_order_acquire);
+            for (i = 0; i < kNumWords; i++)
+                words[i] = m_words[i].load (std::memory_order_relaxed);
+
+            /* The words are read before the count is read again */
+            std::atomic_thread_fence (std::memory_order_acquire);
+            after = m_sequence.load (std::memory_order_relaxed);
+            }
+        while ((before & 1) || before != after);
+        memcpy (&value, words, sizeof(T));
+        return value;
+        }
+
+private:
+    enum { kNumWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t) };
+
+    SeqLock (const SeqLock &);
+    SeqLock &operator= (const SeqLock &);
+
+    /* Its own line, away from the fields the writers update */
+    alignas (64) std::atomic<uint32_t> m_sequence;
+    std::atomic<uint64_t>              m_words[kNumWords];
+};
+
+} /* namespace tms */
+
+#endif /* __SEQLOCK_H__ */
@@ -0,0 +1,70 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    seqtable.h                                                       */
+/*                                                                           */
+/* PURPOSE: In-memory layout of a Sequence, shared by the engine modules     */
+/*          that walk step tables directly (executor).  One vector per       */
+/*          column; index i in every column describes step i.  A sequence    */
+/*          loaded from a file borrows its columns from the mapped file      */
+/*          (see column.h), except the function pointers, which are always   */
+/*          resolved at run time.  C++ only.                                 */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __SEQTABLE_H__
+#define __SEQTABLE_H__
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#include "asyncstep.h"
+#include "column.h"
+#include "fileio.h"
+#include "sequence.h"
+#include "strpool.h"
+
+struct SequenceRec_Tag
+{
+    tms::Column<uint8_t>      kind;
+    std::vector<SeqStepFunc>  func;
+    std::vector<SeqBatchFunc> batch;     /* 0 if there is no batch form */
+    std::vector<SeqSocketFunc> socketFunc;   /* 0 if no per-socket form */
+    std::vector<SeqAsyncFunc> asyncFunc; /* 0 unless an async built-in */
+    tms::Column<int32_t>      param;
+    tms::Column<int32_t>      lowLimit;
+    tms::Column<int32_t>      highLimit;
+    tms::Column<int32_t>      group;
+
+    /* Ids in names.  module/symbol are NotFound for steps that were given */
+    /* a function pointer directly.                                        */
+    tms::Column<uint32_t>     name;
+    tms::Column<uint32_t>     module;
+    tms::Column<uint32_t>     symbol;
+
+    /* Sweep inputs of step i are args[argOffset[i], +argCount[i]) */
+    tms::Column<uint32_t>     argOffset;
+    tms::Column<int32_t>      argCount;
+    tms::Column<int32_t>      args;
+
+    tms::StringPool           names;
+    int32_t                   maxGroup;
+
+    /* The mapped file borrowed columns point into, if any */
+    std::unique_ptr<tms::MappedFile> file;
+
+    /* Number of executions currently running this table; it must not be */
+    /* edited while non-zero                                              */
+    std::atomic<int>          busy;
+
+    SequenceRec_Tag () : maxGroup (-1), busy (0) {}
+
+    size_t Size () const { return kind.size (); }
+
+    /* Grow or shrink every column to numSteps steps and args to numArgs; */
+    /* new rows are zero                                                   */
+    void   Resize (size_t numSteps, size_t numArgs);
+};
+
+#endif /* __SEQTABLE_H__ */
@@ -0,0 +1,371 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    sequence.cpp                                                     */
+/*                                                                           */
+/* PURPOSE: Compiled test sequence.  See sequence.h.                         */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <new>
+
+#include "seqtable.h"
+
+/*---------------------------------------------------------------------------*/
+/* Append the first count elements of src to dest.  dest and src may be the  */
+/* same column (Combinate of a sequence with itself).                        */
+/*---------------------------------------------------------------------------*/
+template <typename T>
+static void AppendColumn (std::vector<T> &dest, const std::vector<T> &src,
+                          size_t count)
+{
+    size_t oldSize = dest.size ();
+
+    dest.resize (oldSize + count);
+    std::copy (src.data (), src.data () + count, dest.data () + oldSize);
+}
+
+template <typename T>
+static void AppendColumn (tms::Column<T> &dest, const tms::Column<T> &src,
+                          size_t count)
+{
+    size_t oldSize = dest.size ();
+
+    dest.resize (oldSize + count);
+    std::copy (src.data (), src.data () + count,
+               dest.MutableData () + oldSize);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Create an empty sequence.                                                 */
+/*---------------------------------------------------------------------------*/
+Sequence SEQ_New (void)
+{
+    return new (std::nothrow) SequenceRec_Tag;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Discard a sequence.                                                       */
+/*---------------------------------------------------------------------------*/
+void SEQ_Dispose (Sequence seq)
+{
+    delete seq;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Pre-size every column for numSteps steps.                                 */
+/*---------------------------------------------------------------------------*/
+int SEQ_Reserve (Sequence seq, int numSteps)
+{
+    if (!seq || numSteps < 0)
+        return TMS_ERR_INVALID_ARG;
+    if (seq->busy.load ())
+        return TMS_ERR_BUSY;
+    try
+        {
+        seq->kind.reserve (numSteps);
+        seq->func.reserve (numSteps);
+        seq->batch.reserve (numSteps);
+        seq->socketFunc.reserve (numSteps);
+        seq->asyncFunc.reserve (numSteps);
+        seq->param.reserve (numSteps);
+        seq->lowLimit.reserve (numSteps);
+        seq->highLimit.reserve (numSteps);
+        seq->group.reserve (numSteps);
+        seq->name.reserve (numSteps);
+        seq->module.reserve (numSteps);
+        seq->symbol.reserve (numSteps);
+        seq->argOffset.reserve (numSteps);
+        seq->argCount.reserve (numSteps);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Size every column for numSteps steps -- shrinking them back after a       */
+/* failed append, or either way when Undo restores an earlier version.       */
+/*---------------------------------------------------------------------------*/
+void SequenceRec_Tag::Resize (size_t numSteps, size_t numArgs)
+{
+    kind.resize (numSteps);
+    func.resize (numSteps);
+    batch.resize (numSteps);
+    socketFunc.resize (numSteps);
+    asyncFunc.resize (numSteps);
+    param.resize (numSteps);
+    lowLimit.resize (numSteps);
+    highLimit.resize (numSteps);
+    group.resize (numSteps);
+    name.resize (numSteps);
+    module.resize (numSteps);
+    symbol.resize (numSteps);
+    argOffset.resize (numSteps);
+    argCount.resize (numSteps);
+    args.resize (numArgs);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Append one row to every column.                                           */
+/*---------------------------------------------------------------------------*/
+static int PushStep (Sequence seq, const char *name, int kind,
+                     SeqStepFunc func, SeqBatchFunc batchFunc, int param,
+                     const int32_t *inputs, int numInputs, int lowLimit,
+                     int highLimit, int group)
+{
+    size_t oldSize = seq->Size ();
+    size_t oldArgs = seq->args.size ();
+
+    try
+        {
+        seq->name.push_back (seq->names.Intern (name));
+        seq->module.push_back (tms::StringPool::NotFound);
+        seq->symbol.push_back (tms::StringPool::NotFound);
+        seq->kind.push_back ((uint8_t)kind);
+        seq->func.push_back (func);
+        seq->batch.push_back (batchFunc);
+        seq->socketFunc.push_back (0);
+        seq->asyncFunc.push_back (0);
+        seq->param.push_back (param);
+        seq->lowLimit.push_back (lowLimit);
+        seq->highLimit.push_back (highLimit);
+        seq->group.push_back (group);
+        seq->argOffset.push_back ((uint32_t)oldArgs);
+        seq->argCount.push_back (numInputs);
+        if (numInputs)
+            seq->args.append (inputs, inputs + numInputs);
+        }
+    catch (const std::bad_alloc &)
+        {
+        seq->Resize (oldSize, oldArgs);
+        return TMS_ERR_NO_MEMORY;
+        }
+    if (group > seq->maxGroup)
+        seq->maxGroup = group;
+    return (int)oldSize;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Append one step.  Steps with the same group (>= 0) that are adjacent in   */
+/* the table may run concurrently.  Returns the new step's index.            */
+/*---------------------------------------------------------------------------*/
+int SEQ_AddStep (Sequence seq, const char *name, int kind, SeqStepFunc func,
+                 int param, int lowLimit, int highLimit, int group)
+{
+    if (!seq || group < 0
+        || (kind != SEQ_KIND_ACTION && kind != SEQ_KIND_NUMERIC_LIMIT))
+        return TMS_ERR_INVALID_ARG;
+    if (seq->busy.load ())
+        return TMS_ERR_BUSY;
+    return PushStep (seq, name, kind, func, 0, param, 0, 0, lowLimit,
+                     highLimit, group);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Append a sweep step that calls func once per input.  When batchFunc is    */
+/* given the engine makes one batch call for the whole array instead.        */
+/*---------------------------------------------------------------------------*/
+int SEQ_AddSweepStep (Sequence seq, const char *name, SeqStepFunc func,
+                      SeqBatchFunc batchFunc, const int32_t *inputs,
+                      int numInputs, int lowLimit, int highLimit, int group)
+{
+    if (!seq || group < 0 || numInputs < 0 || (numInputs && !inputs))
+        return TMS_ERR_INVALID_ARG;
+    if (seq->busy.load ())
+        return TMS_ERR_BUSY;
+    return PushStep (seq, name, SEQ_KIND_SWEEP, func, batchFunc, 0, inputs,
+                     numInputs, lowLimit, highLimit, group);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of steps.                                                          */
+/*---------------------------------------------------------------------------*/
+int SEQ_NumSteps (Sequence seq)
+{
+    if (!seq)
+        return TMS_ERR_INVALID_ARG;
+    return (int)seq->Size ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of distinct group numbers in use (highest group + 1).              */
+/*---------------------------------------------------------------------------*/
+int SEQ_NumGroups (Sequence seq)
+{
+    if (!seq)
+        return TMS_ERR_INVALID_ARG;
+    return seq->maxGroup + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Name of a step.  The pointer stays valid until the sequence is changed.   */
+/*---------------------------------------------------------------------------*/
+const char *SEQ_GetStepName (Sequence seq, int step)
+{
+    if (!seq || step < 0 || step >= (int)seq->Size ())
+        return 0;
+    return seq->names.Get (seq->name[step]);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Parameter of a step.                                                      */
+/*---------------------------------------------------------------------------*/
+int SEQ_GetStepParam (Sequence seq, int step)
+{
+    if (!seq || step < 0 || step >= (int)seq->Size ())
+        return 0;
+    return seq->param[step];
+}
+
+/*---------------------------------------------------------------------------*/
+/* Inputs of a sweep step.  Returns their number (0 for other kinds).        */
+/*---------------------------------------------------------------------------*/
+int SEQ_GetStepInputs (Sequence seq, int step, const int32_t **inputs)
+{
+    if (!seq || !inputs || step < 0 || step >= (int)seq->Size ())
+        return TMS_ERR_INVALID_ARG;
+    *inputs = seq->args.data () + seq->argOffset[step];
+    return seq->argCount[step];
+}
+
+/*---------------------------------------------------------------------------*/
+/* Name the module export a step calls, e.g. ("add", "add").  The step's     */
+/* function pointers are cleared until the sequence is bound to a plugin     */
+/* loader (PLG_BindSequence), which resolves each distinct symbol once.      */
+/*---------------------------------------------------------------------------*/
+int SEQ_SetStepSymbol (Sequence seq, int step, const char *module,
+                       const char *symbol)
+{
+    if (!seq || !module || !symbol || step < 0 || step >= (int)seq->Size ())
+        return TMS_ERR_INVALID_ARG;
+    if (seq->busy.load ())
+        return TMS_ERR_BUSY;
+    try
+        {
+        seq->module.At (step) = seq->names.Intern (module);
+        seq->symbol.At (step) = seq->names.Intern (symbol);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    seq->func[step] = 0;
+    seq->batch[step] = 0;
+    seq->socketFunc[step] = 0;
+    seq->asyncFunc[step] = 0;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Module and symbol of a step, or TMS_ERR_NOT_FOUND if it has none.         */
+/*---------------------------------------------------------------------------*/
+int SEQ_GetStepSymbol (Sequence seq, int step, const char **module,
+                       const char **symbol)
+{
+    if (!seq || step < 0 || step >= (int)seq->Size ())
+        return TMS_ERR_INVALID_ARG;
+    if (seq->module[step] == tms::StringPool::NotFound)
+        return TMS_ERR_NOT_FOUND;
+    if (module)
+        *module = seq->names.Get (seq->module[step]);
+    if (symbol)
+        *symbol = seq->names.Get (seq->symbol[step]);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Append every step of src to dest.  src's groups are renumbered to follow  */
+/* dest's, so src still runs after dest.  Columns are grown once and copied  */
+/* in bulk; names are re-interned once per distinct name, not per step.      */
+/*---------------------------------------------------------------------------*/
+int SEQ_Append (Sequence dest, Sequence src)
+{
+    size_t   count;
+    size_t   oldSize;
+    size_t   oldArgs;
+    size_t   i;
+    int32_t  groupShift;
+    uint32_t id;
+
+    if (!dest || !src)
+        return TMS_ERR_INVALID_ARG;
+    if (dest->busy.load ())
+        return TMS_ERR_BUSY;
+    count = src->Size ();
+    oldSize = dest->Size ();
+    oldArgs = dest->args.size ();
+    groupShift = dest->maxGroup + 1;
+    try
+        {
+        std::vector<uint32_t> remap (src->names.Count ());
+
+        for (id = 0; id < remap.size (); id++)
+            remap[id] = (dest == src) ? id
+                                      : dest->names.Intern (src->names.Get (id));
+
+        AppendColumn (dest->kind, src->kind, count);
+        AppendColumn (dest->func, src->func, count);
+        AppendColumn (dest->batch, src->batch, count);
+        AppendColumn (dest->socketFunc, src->socketFunc, count);
+        AppendColumn (dest->asyncFunc, src->asyncFunc, count);
+        AppendColumn (dest->param, src->param, count);
+        AppendColumn (dest->lowLimit, src->lowLimit, count);
+        AppendColumn (dest->highLimit, src->highLimit, count);
+        AppendColumn (dest->group, src->group, count);
+        AppendColumn (dest->name, src->name, count);
+        AppendColumn (dest->module, src->module, count);
+        AppendColumn (dest->symbol, src->symbol, count);
+        AppendColumn (dest->argOffset, src->argOffset, count);
+        AppendColumn (dest->argCount, src->argCount, count);
+        AppendColumn (dest->args, src->args, src->args.size ());
+
+        int32_t  *group = dest->group.MutableData ();
+        uint32_t *name = dest->name.MutableData ();
+        uint32_t *module = dest->module.MutableData ();
+        uint32_t *symbol = dest->symbol.MutableData ();
+        uint32_t *argOffset = dest->argOffset.MutableData ();
+
+        for (i = oldSize; i < oldSize + count; i++)
+            {
+            group[i] += groupShift;
+            name[i] = remap[name[i]];
+            if (module[i] != tms::StringPool::NotFound)
+                {
+                module[i] = remap[module[i]];
+                symbol[i] = remap[symbol[i]];
+                }
+            argOffset[i] += (uint32_t)oldArgs;
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        dest->Resize (oldSize, oldArgs);
+        return TMS_ERR_NO_MEMORY;
+        }
+    if (count)
+        dest->maxGroup = groupShift + src->maxGroup;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Merge two sequences into a new one: first's steps, then second's.         */
+/*---------------------------------------------------------------------------*/
+Sequence SEQ_Combinate (Sequence first, Sequence second)
+{
+    Sequence seq;
+
+    if (!first || !second)
+        return 0;
+    if (!(seq = SEQ_New ()))
+        return 0;
+    if (SEQ_Reserve (seq, (int)(first->Size () + second->Size ())) < 0
+        || SEQ_Append (seq, first) < 0 || SEQ_Append (seq, second) < 0)
+        {
+        SEQ_Dispose (seq);
+        return 0;
+        }
+    return seq;
+}
@@ -0,0 +1,90 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    sequence.h                                                       */
+/*                                                                           */
+/* PURPOSE: Compiled test sequence behind Sequence > Add / Combinate.  A     */
+/*          sequence is a flat step table stored column by column (kind,     */
+/*          function, parameter, limits, group, name), with step names       */
+/*          interned in a string pool, so Run > All streams through          */
+/*          contiguous arrays no matter how many steps there are.            */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __SEQUENCE_H__
+#define __SEQUENCE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tmsapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef int  (TMS_STDCALL *SeqStepFunc)  (int x);
+
+/* Batch entry point of a step function: out[i] = func (in[i]), i < n */
+typedef void (TMS_STDCALL *SeqBatchFunc) (const int32_t *in, int32_t *out,
+                                          size_t n);
+
+/* Per-socket entry point: the step run against the unit in socket */
+typedef int  (TMS_STDCALL *SeqSocketFunc) (int socket, int x);
+
+typedef struct SequenceRec_Tag *Sequence;
+
+/* Step kinds.  ACTION passes if it could be called; NUMERIC_LIMIT if    */
+/* lowLimit <= value <= highLimit; SWEEP calls the step once per input   */
+/* and passes if every value is within the limits.                       */
+#define SEQ_KIND_ACTION          0
+#define SEQ_KIND_NUMERIC_LIMIT   1
+#define SEQ_KIND_SWEEP           2
+
+/* SEQ_FileFormat results; 0 means the file is not a sequence */
+#define SEQ_FORMAT_BINARY        1
+#define SEQ_FORMAT_TEXT          2
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API Sequence    SEQ_New          (void);
+TMS_API void        SEQ_Dispose      (Sequence seq);
+TMS_API int         SEQ_Reserve      (Sequence seq, int numSteps);
+TMS_API int         SEQ_AddStep      (Sequence seq, const char *name, int kind,
+                                      SeqStepFunc func, int param,
+                                      int lowLimit, int highLimit, int group);
+TMS_API int         SEQ_AddSweepStep (Sequence seq, const char *name,
+                                      SeqStepFunc func, SeqBatchFunc batchFunc,
+                                      const int32_t *inputs, int numInputs,
+                                      int lowLimit, int highLimit, int group);
+TMS_API int         SEQ_NumSteps     (Sequence seq);
+TMS_API int         SEQ_NumGroups    (Sequence seq);
+TMS_API const char *SEQ_GetStepName  (Sequence seq, int step);
+TMS_API int         SEQ_GetStepParam (Sequence seq, int step);
+TMS_API int         SEQ_GetStepInputs(Sequence seq, int step,
+                                      const int32_t **inputs);
+TMS_API int         SEQ_SetStepSymbol(Sequence seq, int step,
+                                      const char *module, const char *symbol);
+TMS_API int         SEQ_GetStepSymbol(Sequence seq, int step,
+                                      const char **module, const char **symbol);
+TMS_API int         SEQ_Append       (Sequence dest, Sequence src);
+TMS_API Sequence    SEQ_Combinate    (Sequence first, Sequence second);
+
+/* Sequence files (seqfile.cpp).  Load maps a binary file and uses it in */
+/* place; Save writes one, replacing path atomically.  Text files are    */
+/* for reading and editing by hand.  Loaded steps have no function       */
+/* pointers until the sequence is bound to a plugin loader.              */
+TMS_API int         SEQ_FileFormat   (const char *path);
+TMS_API Sequence    SEQ_Load         (const char *path);
+TMS_API int         SEQ_Save         (Sequence seq, const char *path);
+TMS_API Sequence    SEQ_ImportText   (const char *path);
+TMS_API int         SEQ_ExportText   (Sequence seq, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SEQUENCE_H__ */
@@ -0,0 +1,842 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    session.cpp                                                      */
+/*                                                                           */
+/* PURPOSE: Crash-safe MRU and session store.  See session.h.                */
+/*                                                                           */
+/*          The log is a run of records, each                                */
+/*              uint32 payload size, uint32 FNV-1a of the payload,           */
+/*              payload: uint64 sequence number, uint8 op, path bytes        */
+/*          in host byte order.  Replay stops at the first short or          */
+/*          corrupt record, which is where a crash cut the last write.  The  */
+/*          snapshot records the sequence number it covers, so records left  */
+/*          in the log by a crash during compaction are skipped.             */
+/*                                                                           */
+/*          The image (snapshot path + ".bin") is                            */
+/*              char[8] magic, uint64 sequence number, uint32 recent count,  */
+/*              uint32 open count, uint32 size of the paths,                 */
+/*              paths: uint32 length, path bytes, recent ones first          */
+/*          also in host byte order.  It is written whole and renamed into   */
+/*          place, so it is checked for size rather than summed; it has to   */
+/*          load faster than the snapshot parses.  Compaction writes it      */
+/*          snapshot; it is used when it is intact and no older than the     */
+/*          snapshot, which a build without images may have written since.   */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fileio.h"
+#include "session.h"
+#include "strpool.h"
+
+using tms::MappedFile;
+using tms::RenameOver;
+using tms::SyncFile;
+using tms::StringPool;
+
+/*---------------------------------------------------------------------------*/
+/* Defines                                                                   */
+/*---------------------------------------------------------------------------*/
+#define SES_OP_OPENED        1
+#define SES_OP_CLOSED        2
+#define SES_OP_RECENT        3
+
+#define SES_RECORD_HEADER    8          /* size + checksum */
+#define SES_PAYLOAD_HEADER   9          /* sequence number + op */
+#define SES_IMAGE_MAGIC      "TMSSES1\n"
+#define SES_IMAGE_HEADER     28         /* magic + seq + counts + size */
+#define SES_MAX_PATH         4096
+
+/* The writer waits this long after the first queued record for more, so */
+/* a burst of changes (Close All) costs one write and one fsync */
+#define SES_BATCH_DELAY_MS   20
+
+/* Compact once the log grows past this many bytes */
+#define SES_COMPACT_BYTES    (64 * 1024)
+
+#define SES_SECTION_SESSION  "Session"
+#define SES_SECTION_RECENT   "FILE MenuList"
+#define SES_SECTION_OPEN     "Open Documents"
+#define SES_KEY_SEQUENCE     "Sequence"
+#define SES_KEY_FILENAME     "Filename"
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct SessionState
+{
+    std::vector<std::string> recent;      /* newest first */
+    std::vector<std::string> open;        /* in the order opened */
+};
+
+struct SessionLogRec_Tag
+{
+    std::string             snapshotPath;
+    std::string             imagePath;
+    std::string             logPath;
+    size_t                  maxRecent;
+    SesLoadedCallbackPtr    loadedFunc;
+    void                   *loadedData;
+
+    /* Written by the writer thread before loaded is set */
+    SessionState            state;
+    bool                    hadSavedState;
+
+    /* Shared with the writer thread, under lock */
+    std::mutex              lock;
+    bool                    loaded;      /* the saved state is restored */
+    bool                    failed;      /* ... or could not be */
+    std::condition_variable wake;        /* work for the writer */
+    std::condition_variable done;        /* the writer finished a batch */
+    std::string             pending;     /* records not yet written */
+    uint64_t                nextSeq;     /* number of the next record */
+    uint64_t                durableSeq;  /* last record known on disk */
+    uint64_t                attemptedSeq;/* last record the writer tried */
+    uint64_t                numCompactions;
+    bool                    flushWanted;
+    bool                    compactWanted;
+    bool                    stop;
+    int                     error;       /* result of the last write */
+
+    /* Writer thread only */
+    FILE                   *log;
+    size_t                  logBytes;
+    bool                    dirty;       /* a write failed; compact next */
+    std::thread             writer;
+};
+
+/*---------------------------------------------------------------------------*/
+/* Apply one change to the state.  Used both for live changes and replay.    */
+/*---------------------------------------------------------------------------*/
+static void Apply (SessionState &state, size_t maxRecent, int op,
+                   const std::string &path)
+{
+    std::vector<std::string>::iterator it;
+
+    switch (op)
+        {
+        case SES_OP_OPENED:
+        case SES_OP_CLOSED:
+            it = std::find (state.open.begin (), state.open.end (), path);
+            if (it != state.open.end ())
+                state.open.erase (it);
+            if (op == SES_OP_OPENED)
+                state.open.push_back (path);
+            break;
+        case SES_OP_RECENT:
+            it = std::find (state.recent.begin (), state.recent.end (), path);
+            if (it != state.recent.end ())
+                state.recent.erase (it);
+            state.recent.insert (state.recent.begin (), path);
+            if (state.recent.size () > maxRecent)
+                state.recent.resize (maxRecent);
+            break;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Parse an INI snapshot held in memory.  Returns the sequence number of the */
+/* last record it covers.  With headerOnly it stops there, which is at the   */
+/* top of the file, and leaves state alone.                                  */
+/*---------------------------------------------------------------------------*/
+static uint64_t ParseSnapshot (const char *data, size_t size,
+                               SessionState &state, size_t maxRecent,
+                               bool headerOnly)
+{
+    const char *end = data + size;
+    const char *line;
+    const char *next;
+    std::string section;
+    uint64_t    seq = 0;
+
+    for (line = data; line < end; line = next)
+        {
+        const char *lineEnd = (const char *)memchr (line, '\n', end - line);
+        const char *equals;
+        std::string key;
+        std::string value;
+
+        if (!lineEnd)
+            lineEnd = end;
+        next = lineEnd + 1;
+        while (lineEnd > line && (lineEnd[-1] == '\r' || lineEnd[-1] == ' '))
+            lineEnd--;
+        while (line < lineEnd && *line == ' ')
+            line++;
+        if (line == lineEnd)
+            continue;
+        if (*line == '[' && lineEnd[-1] == ']')
+            {
+            if (headerOnly && section == SES_SECTION_SESSION)
+                break;
+            section.assign (line + 1, lineEnd - line - 2);
+            continue;
+            }
+        if (!(equals = (const char *)memchr (line, '=', lineEnd - line)))
+            continue;
+        key.assign (line, equals - line);
+        key.erase (key.find_last_not_of (' ') + 1);
+        for (equals++; equals < lineEnd && *equals == ' '; equals++)
+            ;
+        value.assign (equals, lineEnd - equals);
+
+        if (section == SES_SECTION_SESSION && key == SES_KEY_SEQUENCE)
+            seq = strtoull (value.c_str (), 0, 10);
+        else if (headerOnly || value.empty ()
+                 || key.compare (0, strlen (SES_KEY_FILENAME),
+                                 SES_KEY_FILENAME) != 0)
+            continue;
+        else if (section == SES_SECTION_RECENT
+                 && state.recent.size () < maxRecent)
+            state.recent.push_back (value);
+        else if (section == SES_SECTION_OPEN)
+            state.open.push_back (value);
+        }
+    return seq;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write the state to a temporary file and move it over the snapshot.        */
+/*---------------------------------------------------------------------------*/
+static bool WriteSnapshot (const std::string &path, const SessionState &state,
+                           uint64_t seq)
+{
+    std::string temp = path + ".tmp";
+    FILE       *file;
+    size_t      i;
+    bool        ok;
+
+    if (!(file = fopen (temp.c_str (), "wb")))
+        return false;
+    fprintf (file, "[%s]\n%s = %llu\n\n[%s]\n", SES_SECTION_SESSION,
+             SES_KEY_SEQUENCE, (unsigned long long)seq, SES_SECTION_RECENT);
+    for (i = 0; i < state.recent.size (); i++)
+        fprintf (file, "%s%u = %s\n", SES_KEY_FILENAME, (unsigned)i + 1,
+                 state.recent[i].c_str ());
+    fprintf (file, "\n[%s]\n", SES_SECTION_OPEN);
+    for (i = 0; i < state.open.size (); i++)
+        fprintf (file, "%s%u = %s\n", SES_KEY_FILENAME, (unsigned)i + 1,
+                 state.open[i].c_str ());
+    ok = !ferror (file) && SyncFile (file);
+    ok = fclose (file) == 0 && ok;
+    if (!ok || !RenameOver (temp, path))
+        {
+        remove (temp.c_str ());
+        return false;
+        }
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Encode the state as an image and move it over the old one.                */
+/*---------------------------------------------------------------------------*/
+static void AppendPaths (std::string &out,
+                         const std::vector<std::string> &paths)
+{
+    size_t   i;
+    uint32_t len;
+
+    for (i = 0; i < paths.size (); i++)
+        {
+        len = (uint32_t)paths[i].size ();
+        out.append ((const char *)&len, sizeof(len));
+        out.append (paths[i]);
+        }
+}
+
+static bool WriteImage (const std::string &path, const SessionState &state,
+                        uint64_t seq)
+{
+    std::string temp = path + ".tmp";
+    std::string image;
+    uint32_t    numRecent = (uint32_t)state.recent.size ();
+    uint32_t    numOpen = (uint32_t)state.open.size ();
+    uint32_t    pathBytes;
+    FILE       *file;
+    bool        ok;
+
+    try
+        {
+        image.append (SES_IMAGE_MAGIC, 8);
+        image.append ((const char *)&seq, sizeof(seq));
+        image.append ((const char *)&numRecent, sizeof(numRecent));
+        image.append ((const char *)&numOpen, sizeof(numOpen));
+        image.append (sizeof(pathBytes), '\0');
+        AppendPaths (image, state.recent);
+        AppendPaths (image, state.open);
+        }
+    catch (const std::bad_alloc &)
+        {
+        return false;
+        }
+    pathBytes = (uint32_t)(image.size () - SES_IMAGE_HEADER);
+    memcpy (&image[SES_IMAGE_HEADER - sizeof(pathBytes)], &pathBytes,
+            sizeof(pathBytes));
+    if (!(file = fopen (temp.c_str (), "wb")))
+        return false;
+    ok = fwrite (image.data (), 1, image.size (), file) == image.size ()
+         && SyncFile (file);
+    ok = fclose (file) == 0 && ok;
+    if (!ok || !RenameOver (temp, path))
+        {
+        remove (temp.c_str ());
+        return false;
+        }
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Load an image held in memory.  False, with state untouched, if it is      */
+/* short, from another format or does not add up.                            */
+/*---------------------------------------------------------------------------*/
+static bool ReadImage (const char *data, size_t size, SessionState &state,
+                       size_t maxRecent, uint64_t &seq)
+{
+    SessionState loaded;
+    uint32_t     numRecent;
+    uint32_t     numOpen;
+    uint32_t     pathBytes;
+    uint32_t     len;
+    size_t       offset = SES_IMAGE_HEADER;
+    size_t       i;
+
+    if (size < SES_IMAGE_HEADER || memcmp (data, SES_IMAGE_MAGIC, 8) != 0)
+        return false;
+    memcpy (&seq, data + 8, sizeof(seq));
+    memcpy (&numRecent, data + 16, sizeof(numRecent));
+    memcpy (&numOpen, data + 20, sizeof(numOpen));
+    memcpy (&pathBytes, data + 24, sizeof(pathBytes));
+    if (pathBytes != size - SES_IMAGE_HEADER
+        || pathBytes / sizeof(len) < (size_t)numRecent + numOpen)
+        return false;
+    loaded.recent.reserve (std::min ((size_t)numRecent, maxRecent));
+    loaded.open.reserve (numOpen);
+    for (i = 0; i < (size_t)numRecent + numOpen; i++)
+        {
+        if (size - offset < sizeof(len))
+            return false;
+        memcpy (&len, data + offset, sizeof(len));
+        offset += sizeof(len);
+        if (len > SES_MAX_PATH || size - offset < len)
+            return false;
+        if (i >= numRecent)
+            loaded.open.push_back (std::string (data + offset, len));
+        else if (loaded.recent.size () < maxRecent)
+            loaded.recent.push_back (std::string (data + offset, len));
+        offset += len;
+        }
+    if (offset != size)
+        return false;
+    state.recent.swap (loaded.recent);
+    state.open.swap (loaded.open);
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Encode one record and append it to out.                                   */
+/*---------------------------------------------------------------------------*/
+static void EncodeRecord (std::string &out, uint64_t seq, int op,
+                          const char *path, size_t pathLen)
+{
+    uint32_t size = (uint32_t)(SES_PAYLOAD_HEADER + pathLen);
+    uint32_t checksum;
+    size_t   start = out.size ();
+    char     opByte = (char)op;
+
+    out.append ((const char *)&size, sizeof(size));
+    out.append (sizeof(checksum), '\0');
+    out.append ((const char *)&seq, sizeof(seq));
+    out.append (&opByte, 1);
+    out.append (path, pathLen);
+    checksum = StringPool::Hash (&out[start + SES_RECORD_HEADER], size);
+    memcpy (&out[start + sizeof(size)], &checksum, sizeof(checksum));
+}
+
+/*---------------------------------------------------------------------------*/
+/* Replay log records newer than snapshotSeq.  Returns the number of bytes   */
+/* of valid records; anything after that is a torn write.                    */
+/*---------------------------------------------------------------------------*/
+static size_t ReplayLog (const char *data, size_t size, uint64_t snapshotSeq,
+                         SessionState &state, size_t maxRecent,
+                         uint64_t &lastSeq)
+{
+    size_t offset = 0;
+
+    while (size - offset >= SES_RECORD_HEADER + SES_PAYLOAD_HEADER)
+        {
+        const char *record = data + offset;
+        uint32_t    recordSize;
+        uint32_t    checksum;
+        uint64_t    seq;
+
+        memcpy (&recordSize, record, sizeof(recordSize));
+        memcpy (&checksum, record + sizeof(recordSize), sizeof(checksum));
+        if (recordSize < SES_PAYLOAD_HEADER
+            || recordSize > SES_PAYLOAD_HEADER + SES_MAX_PATH
+            || recordSize > size - offset - SES_RECORD_HEADER
+            || StringPool::Hash (record + SES_RECORD_HEADER, recordSize)
+               != checksum)
+            break;
+        memcpy (&seq, record + SES_RECORD_HEADER, sizeof(seq));
+        if (seq > snapshotSeq)
+            {
+            Apply (state, maxRecent,
+                   (unsigned char)record[SES_RECORD_HEADER + sizeof(seq)],
+                   std::string (record + SES_RECORD_HEADER
+                                + SES_PAYLOAD_HEADER,
+                                recordSize - SES_PAYLOAD_HEADER));
+            lastSeq = std::max (lastSeq, seq);
+            }
+        offset += SES_RECORD_HEADER + recordSize;
+        }
+    return offset;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Restore the saved state: the image if it is good and no older than the    */
+/* snapshot, else the snapshot, then the log records after it.  Opens the    */
+/* log for appending.  Called on the writer thread before anything else.     */
+/*---------------------------------------------------------------------------*/
+static void Restore (SessionLog session)
+{
+    MappedFile map;
+    uint64_t   imageSeq = 0;
+    uint64_t   snapshotSeq = 0;
+    uint64_t   lastSeq;
+    size_t     validBytes = 0;
+    bool       haveImage = false;
+    bool       tornLog = false;
+
+    if (map.Open (session->imagePath.c_str ()))
+        haveImage = ReadImage (map.Data (), map.Size (), session->state,
+                               session->maxRecent, imageSeq);
+    if (map.Open (session->snapshotPath.c_str ()))
+        {
+        snapshotSeq = ParseSnapshot (map.Data (), map.Size (),
+                                     session->state, session->maxRecent,
+                                     true);
+        if (haveImage && imageSeq < snapshotSeq)
+            {
+            session->state = SessionState ();
+            haveImage = false;
+            }
+        if (!haveImage)
+            ParseSnapshot (map.Data (), map.Size (), session->state,
+                           session->maxRecent, false);
+        session->hadSavedState = true;
+        }
+    if (haveImage)
+        {
+        snapshotSeq = imageSeq;
+        session->hadSavedState = true;
+        }
+    lastSeq = snapshotSeq;
+    if (map.Open (session->logPath.c_str ()))
+        {
+        validBytes = ReplayLog (map.Data (), map.Size (), snapshotSeq,
+                                session->state, session->maxRecent, lastSeq);
+        session->hadSavedState = session->hadSavedState || validBytes > 0;
+        tornLog = validBytes != map.Size ();
+        }
+    map.Close ();
+    session->logBytes = validBytes;
+
+    /* A torn tail is rewritten away by compacting before anything is */
+    /* appended after it                                              */
+    session->log = tornLog ? 0 : fopen (session->logPath.c_str (), "ab");
+
+    std::lock_guard<std::mutex> guard (session->lock);
+
+    session->nextSeq = lastSeq + 1;
+    session->durableSeq = lastSeq;
+    session->attemptedSeq = lastSeq;
+    session->compactWanted = tornLog;
+    session->dirty = !session->log;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Writer thread.  Restores the saved state, then takes everything queued as */
+/* one batch; appends it to the log with a single write and fsync, or, when  */
+/* the log has grown or a compaction was asked for, writes a fresh image and */
+/* snapshot and empties the log.  If the state cannot be restored it stops   */
+/* at once rather than compact an empty one over it.                         */
+/*---------------------------------------------------------------------------*/
+static void WriterMain (SessionLog session)
+{
+    bool failed = false;
+
+    try
+        {
+        Restore (session);
+        }
+    catch (const std::bad_alloc &)
+        {
+        failed = true;
+        }
+
+        {
+        std::lock_guard<std::mutex> guard (session->lock);
+
+        session->loaded = true;
+        session->failed = failed;
+        if (failed)
+            session->error = TMS_ERR_NO_MEMORY;
+        session->done.notify_all ();
+        }
+    if (session->loadedFunc)
+        session->loadedFunc (session, session->loadedData);
+    if (failed)
+        return;
+
+    std::unique_lock<std::mutex> guard (session->lock);
+
+    for (;;)
+        {
+        std::string  batch;
+        SessionState snapshot;
+        uint64_t     seq;
+        bool         compactAsked;
+        bool         compact;
+        bool         ok = true;
+
+        session->wake.wait (guard, [session] {
+            return session->stop || session->compactWanted
+                   || !session->pending.empty (); });
+        if (!session->stop && !session->compactWanted && !session->flushWanted)
+            session->wake.wait_for (guard, std::chrono::milliseconds (
+                                               SES_BATCH_DELAY_MS),
+                                    [session] {
+                                        return session->stop
+                                               || session->flushWanted
+                                               || session->compactWanted; });
+        batch.swap (session->pending);
+        seq = session->nextSeq - 1;
+        compactAsked = session->compactWanted;
+        compact = session->compactWanted || session->stop || session->dirty
+                  || session->logBytes + batch.size () > SES_COMPACT_BYTES;
+        if (compact)
+            {
+            try
+                {
+                snapshot = session->state;
+                }
+            catch (const std::bad_alloc &)
+                {
+                compact = false;
+                }
+            }
+        session->compactWanted = false;
+        session->flushWanted = false;
+        guard.unlock ();
+
+        if (compact)
+            {
+            /* The snapshot covers the batch, so it need not be logged */
+            ok = WriteImage (session->imagePath, snapshot, seq)
+                 && WriteSnapshot (session->snapshotPath, snapshot, seq);
+            if (ok)
+                {
+                if (session->log)
+                    fclose (session->log);
+                session->log = fopen (session->logPath.c_str (), "wb");
+                session->logBytes = 0;
+                ok = session->log != 0;
+                }
+            }
+        else if (!batch.empty ())
+            {
+            ok = session->log
+                 && fwrite (batch.data (), 1, batch.size (), session->log)
+                    == batch.size ()
+                 && SyncFile (session->log);
+            session->logBytes += batch.size ();
+            }
+        session->dirty = !ok;
+
+        guard.lock ();
+        session->error = ok ? TMS_OK : TMS_ERR_IO;
+        session->attemptedSeq = seq;
+        if (ok)
+            session->durableSeq = seq;
+        if (compactAsked)
+            session->numCompactions++;
+        session->done.notify_all ();
+        if (session->stop && session->pending.empty ())
+            break;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Block, holding guard, until the writer has restored the saved state.      */
+/*---------------------------------------------------------------------------*/
+static void WaitLoaded (SessionLog session,
+                        std::unique_lock<std::mutex> &guard)
+{
+    session->done.wait (guard, [session] { return session->loaded; });
+}
+
+/*---------------------------------------------------------------------------*/
+/* Queue a change: apply it to the state and hand its record to the writer.  */
+/*---------------------------------------------------------------------------*/
+static int Record (SessionLog session, int op, const char *path)
+{
+    size_t pathLen;
+
+    if (!session || !path || !path[0])
+        return TMS_ERR_INVALID_ARG;
+    if ((pathLen = strlen (path)) > SES_MAX_PATH)
+        return TMS_ERR_INVALID_ARG;
+    try
+        {
+        std::unique_lock<std::mutex> guard (session->lock);
+        bool                         wasIdle;
+
+        WaitLoaded (session, guard);
+        if (session->failed)
+            return session->error;
+        wasIdle = session->pending.empty ();
+        EncodeRecord (session->pending, session->nextSeq, op, path, pathLen);
+        Apply (session->state, session->maxRecent, op, path);
+        session->nextSeq++;
+        if (wasIdle)
+            session->wake.notify_one ();
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open the store whose snapshot is snapshotPath; the image and the log are  */
+/* the same path with ".bin" and ".log" appended.  Returns at once: the      */
+/* writer thread restores the saved state and then calls loaded.             */
+/*---------------------------------------------------------------------------*/
+SessionLog SES_Open (const char *snapshotPath, int maxRecent,
+                     SesLoadedCallbackPtr loaded, void *callbackData)
+{
+    SessionLog session;
+
+    if (!snapshotPath || !snapshotPath[0] || maxRecent <= 0)
+        return 0;
+    if (!(session = new (std::nothrow) SessionLogRec_Tag))
+        return 0;
+    try
+        {
+        session->snapshotPath = snapshotPath;
+        session->imagePath = session->snapshotPath + ".bin";
+        session->logPath = session->snapshotPath + ".log";
+        session->maxRecent = (size_t)maxRecent;
+        session->loadedFunc = loaded;
+        session->loadedData = callbackData;
+        session->hadSavedState = false;
+        session->loaded = false;
+        session->failed = false;
+        session->nextSeq = 1;
+        session->durableSeq = 0;
+        session->attemptedSeq = 0;
+        session->numCompactions = 0;
+        session->flushWanted = false;
+        session->compactWanted = false;
+        session->stop = false;
+        session->error = TMS_OK;
+        session->log = 0;
+        session->logBytes = 0;
+        session->dirty = false;
+        session->writer = std::thread (WriterMain, session);
+        }
+    catch (...)
+        {
+        delete session;
+        return 0;
+        }
+    return session;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open the store and wait for its saved state.                              */
+/*---------------------------------------------------------------------------*/
+static bool Restored (SessionLog session)
+{
+    std::unique_lock<std::mutex> guard (session->lock);
+
+    WaitLoaded (session, guard);
+    return !session->failed;
+}
+
+SessionLog SES_New (const char *snapshotPath, int maxRecent)
+{
+    SessionLog session = SES_Open (snapshotPath, maxRecent, 0, 0);
+
+    if (session && !Restored (session))
+        {
+        SES_Dispose (session);
+        return 0;
+        }
+    return session;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Write a final snapshot, stop the writer and free the store.               */
+/*---------------------------------------------------------------------------*/
+void SES_Dispose (SessionLog session)
+{
+    if (!session)
+        return;
+    {
+    std::lock_guard<std::mutex> guard (session->lock);
+
+    session->stop = true;
+    session->wake.notify_one ();
+    }
+    if (session->writer.joinable ())
+        session->writer.join ();
+    if (session->log)
+        fclose (session->log);
+    delete session;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Non-zero if a snapshot or log from an earlier run was found.              */
+/*---------------------------------------------------------------------------*/
+int SES_HasSavedState (SessionLog session)
+{
+    if (!session)
+        return TMS_ERR_INVALID_ARG;
+    std::unique_lock<std::mutex> guard (session->lock);
+    WaitLoaded (session, guard);
+    return session->hadSavedState;
+}
+
+/*---------------------------------------------------------------------------*/
+/* A document was opened.                                                    */
+/*---------------------------------------------------------------------------*/
+int SES_Opened (SessionLog session, const char *path)
+{
+    return Record (session, SES_OP_OPENED, path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* A document was closed.                                                    */
+/*---------------------------------------------------------------------------*/
+int SES_Closed (SessionLog session, const char *path)
+{
+    return Record (session, SES_OP_CLOSED, path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* A path moved to the front of the File menu's MRU list.                    */
+/*---------------------------------------------------------------------------*/
+int SES_AddRecent (SessionLog session, const char *path)
+{
+    return Record (session, SES_OP_RECENT, path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Block until every change queued so far is on disk.                        */
+/*---------------------------------------------------------------------------*/
+int SES_Flush (SessionLog session)
+{
+    if (!session)
+        return TMS_ERR_INVALID_ARG;
+    std::unique_lock<std::mutex> guard (session->lock);
+    uint64_t                     target;
+
+    WaitLoaded (session, guard);
+    if (session->failed)
+        return session->error;
+    target = session->nextSeq - 1;
+    if (session->durableSeq >= target && session->pending.empty ())
+        return session->error;
+    session->flushWanted = true;
+    session->wake.notify_one ();
+    session->done.wait (guard, [session, target] {
+        return session->durableSeq >= target
+               || session->attemptedSeq >= target; });
+    return session->error;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Block until the snapshot holds every change queued so far and the log is  */
+/* empty.                                                                    */
+/*---------------------------------------------------------------------------*/
+int SES_Compact (SessionLog session)
+{
+    if (!session)
+        return TMS_ERR_INVALID_ARG;
+    std::unique_lock<std::mutex> guard (session->lock);
+    uint64_t                     target = session->numCompactions + 1;
+
+    WaitLoaded (session, guard);
+    if (session->failed)
+        return session->error;
+    session->compactWanted = true;
+    session->wake.notify_one ();
+    session->done.wait (guard, [session, target] {
+        return session->numCompactions >= target; });
+    return session->error;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of paths on the File menu's MRU list.                              */
+/*---------------------------------------------------------------------------*/
+int SES_NumRecent (SessionLog session)
+{
+    if (!session)
+        return TMS_ERR_INVALID_ARG;
+    std::unique_lock<std::mutex> guard (session->lock);
+    WaitLoaded (session, guard);
+    return (int)session->state.recent.size ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Recent path at index (0 is the newest), or 0.  Valid until the next       */
+/* change.                                                                   */
+/*---------------------------------------------------------------------------*/
+const char *SES_GetRecent (SessionLog session, int index)
+{
+    if (!session)
+        return 0;
+    std::unique_lock<std::mutex> guard (session->lock);
+    WaitLoaded (session, guard);
+    if (index < 0 || index >= (int)session->state.recent.size ())
+        return 0;
+    return session->state.recent[index].c_str ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of documents open (after a crash: left open by the last run).      */
+/*---------------------------------------------------------------------------*/
+int SES_NumOpen (SessionLog session)
+{
+    if (!session)
+        return TMS_ERR_INVALID_ARG;
+    std::unique_lock<std::mutex> guard (session->lock);
+    WaitLoaded (session, guard);
+    return (int)session->state.open.size ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Open document at index, or 0.  Valid until the next change.               */
+/*---------------------------------------------------------------------------*/
+const char *SES_GetOpen (SessionLog session, int index)
+{
+    if (!session)
+        return 0;
+    std::unique_lock<std::mutex> guard (session->lock);
+    WaitLoaded (session, guard);
+    if (index < 0 || index >= (int)session->state.open.size ())
+        return 0;
+    return session->state.open[index].c_str ();
+}
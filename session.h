@@ -0,0 +1,71 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    session.h                                                        */
+/*                                                                           */
+/* PURPOSE: Crash-safe store for the File menu's MRU list and the set of     */
+/*          open documents.  Each change is appended to a small write-ahead  */
+/*          log by a background thread, which batches records into one       */
+/*          write and one fsync, and now and then compacts the log into an   */
+/*          INI-format snapshot, plus a binary image of the same state that  */
+/*          loads without parsing.  Opening the store maps the image (or the */
+/*          snapshot) and replays the log tail, so nothing is lost if the    */
+/*          program dies.  SES_Open does that on the writer thread, so the   */
+/*          caller can show its window at once; the store's functions wait   */
+/*          for the state if they are called before it is restored.          */
+/*          Changes must all come from one thread (the UI thread).           */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+#include "tmsapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct SessionLogRec_Tag *SessionLog;
+
+/* Called on the writer thread once SES_Open has restored the saved state */
+/* (or failed to: then the store is empty and changes fail)               */
+typedef void (CVICALLBACK *SesLoadedCallbackPtr) (SessionLog session,
+                                                  void *callbackData);
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API SessionLog  SES_New           (const char *snapshotPath,
+                                       int maxRecent);
+TMS_API SessionLog  SES_Open          (const char *snapshotPath,
+                                       int maxRecent,
+                                       SesLoadedCallbackPtr loaded,
+                                       void *callbackData);
+TMS_API void        SES_Dispose       (SessionLog session);
+TMS_API int         SES_HasSavedState (SessionLog session);
+
+/* Changes.  They return once the record is queued, not once it is on disk */
+TMS_API int         SES_Opened        (SessionLog session, const char *path);
+TMS_API int         SES_Closed        (SessionLog session, const char *path);
+TMS_API int         SES_AddRecent     (SessionLog session, const char *path);
+
+/* Wait until every queued change is on disk; Compact also rewrites the */
+/* snapshot and empties the log */
+TMS_API int         SES_Flush         (SessionLog session);
+TMS_API int         SES_Compact       (SessionLog session);
+
+/* Restored and current state.  Recent files are newest first; open */
+/* documents are in the order they were opened */
+TMS_API int         SES_NumRecent     (SessionLog session);
+TMS_API const char *SES_GetRecent     (SessionLog session, int index);
+TMS_API int         SES_NumOpen       (SessionLog session);
+TMS_API const char *SES_GetOpen       (SessionLog session, int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SESSION_H__ */
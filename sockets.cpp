@@ -0,0 +1,344 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    sockets.cpp                                                      */
+/*                                                                           */
+/* PURPOSE: Parallel test sockets.  See sockets.h.                           */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include "sockets.h"
+#include "workpool.h"
+
+using tms::TaskGroup;
+using tms::WorkPool;
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct SocketSetRec_Tag
+{
+    std::vector<Execution> sockets;
+    std::vector<ResultLog> logs;        /* empty until OpenResultLogs */
+    std::vector<StepHost>  hosts;       /* empty until OpenStepHosts */
+    Sequence               seq;
+    std::atomic<int>       running;
+    std::atomic<int>       remaining;   /* sockets still running */
+    WorkPool              *pool;
+    TaskGroup              runGroup;    /* held once per running socket */
+    SktDoneCallbackPtr     doneCallback;
+    void                  *doneCallbackData;
+
+    SocketSetRec_Tag ()
+        : seq (0), running (0), remaining (0), pool (&WorkPool::Instance ()),
+          doneCallback (0), doneCallbackData (0) {}
+};
+
+/*---------------------------------------------------------------------------*/
+/* Close the result logs, detaching them from the sockets first.             */
+/*---------------------------------------------------------------------------*/
+static void CloseResultLogs (SocketSet set)
+{
+    size_t i;
+
+    for (i = 0; i < set->logs.size (); i++)
+        {
+        EXE_SetResultLog (set->sockets[i], 0);
+        RLG_Dispose (set->logs[i]);
+        }
+    set->logs.clear ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Stop the step hosts, going back to calling steps in process.              */
+/*---------------------------------------------------------------------------*/
+static void CloseStepHosts (SocketSet set)
+{
+    size_t i;
+
+    for (i = 0; i < set->hosts.size (); i++)
+        {
+        EXE_SetStepHost (set->sockets[i], 0);
+        HST_Dispose (set->hosts[i]);
+        }
+    set->hosts.clear ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Create numSockets sockets, each with an execution of its own.             */
+/*---------------------------------------------------------------------------*/
+SocketSet SKT_New (int numSockets)
+{
+    SocketSet set;
+    int       i;
+
+    if (numSockets <= 0)
+        return 0;
+    if (!(set = new (std::nothrow) SocketSetRec_Tag))
+        return 0;
+    try
+        {
+        set->sockets.reserve (numSockets);
+        for (i = 0; i < numSockets; i++)
+            {
+            Execution exec = EXE_New ();
+
+            if (!exec)
+                throw std::bad_alloc ();
+            set->sockets.push_back (exec);
+            EXE_SetSocket (exec, i);
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        SKT_Dispose (set);
+        return 0;
+        }
+    return set;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Wait for any run in progress, then free the sockets and close their logs. */
+/*---------------------------------------------------------------------------*/
+void SKT_Dispose (SocketSet set)
+{
+    size_t i;
+
+    if (!set)
+        return;
+    SKT_Wait (set);
+    CloseResultLogs (set);
+    CloseStepHosts (set);
+    for (i = 0; i < set->sockets.size (); i++)
+        EXE_Dispose (set->sockets[i]);
+    delete set;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Number of sockets.                                                        */
+/*---------------------------------------------------------------------------*/
+int SKT_NumSockets (SocketSet set)
+{
+    if (!set)
+        return TMS_ERR_INVALID_ARG;
+    return (int)set->sockets.size ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Give every socket a result log of its own, replacing any open ones.       */
+/*---------------------------------------------------------------------------*/
+int SKT_OpenResultLogs (SocketSet set, const char *pathFormat)
+{
+    const char *conversion;
+    size_t      i;
+
+    if (!set || !pathFormat || !(conversion = strstr (pathFormat, "%d"))
+        || strchr (pathFormat, '%') != conversion
+        || strchr (conversion + 1, '%'))
+        return TMS_ERR_INVALID_ARG;
+    if (set->running.load ())
+        return TMS_ERR_BUSY;
+    CloseResultLogs (set);
+    try
+        {
+        std::vector<char> path (strlen (pathFormat) + 16);
+
+        for (i = 0; i < set->sockets.size (); i++)
+            {
+            ResultLog log;
+
+            snprintf (path.data (), path.size (), pathFormat, (int)i);
+            if (!(log = RLG_New (path.data ())))
+                {
+                CloseResultLogs (set);
+                return TMS_ERR_IO;
+                }
+            set->logs.push_back (log);
+            EXE_SetResultLog (set->sockets[i], log);
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        CloseResultLogs (set);
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Give every socket a step host of its own, replacing any running ones, so  */
+/* a step that crashes on one unit leaves the other sockets running.         */
+/*---------------------------------------------------------------------------*/
+int SKT_OpenStepHosts (SocketSet set, const char *hostPath)
+{
+    size_t i;
+    int    status;
+
+    if (!set)
+        return TMS_ERR_INVALID_ARG;
+    if (set->running.load ())
+        return TMS_ERR_BUSY;
+    CloseStepHosts (set);
+    if (!hostPath)
+        return TMS_OK;
+    try
+        {
+        set->hosts.reserve (set->sockets.size ());
+        for (i = 0; i < set->sockets.size (); i++)
+            {
+            StepHost host;
+
+            if (!(host = HST_New (hostPath)))
+                {
+                CloseStepHosts (set);
+                return TMS_ERR_IO;
+                }
+            set->hosts.push_back (host);
+            if ((status = EXE_SetStepHost (set->sockets[i], host)) < 0)
+                {
+                CloseStepHosts (set);
+                return status;
+                }
+            }
+        }
+    catch (const std::bad_alloc &)
+        {
+        CloseStepHosts (set);
+        return TMS_ERR_NO_MEMORY;
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Load a sequence into every socket and rewind them.                        */
+/*---------------------------------------------------------------------------*/
+int SKT_Load (SocketSet set, Sequence seq)
+{
+    size_t i;
+    int    status;
+
+    if (!set)
+        return TMS_ERR_INVALID_ARG;
+    if (set->running.load ())
+        return TMS_ERR_BUSY;
+    for (i = 0; i < set->sockets.size (); i++)
+        if ((status = EXE_Load (set->sockets[i], seq)) < 0)
+            {
+            while (i-- > 0)
+                EXE_Load (set->sockets[i], 0);
+            set->seq = 0;
+            return status;
+            }
+    set->seq = seq;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The loaded sequence, or 0.                                                */
+/*---------------------------------------------------------------------------*/
+Sequence SKT_GetSequence (SocketSet set)
+{
+    return set ? set->seq : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Execution callback: the last socket to finish ends the set's run.  Each   */
+/* socket lets go of the set's group last, since SKT_Wait may then free it.  */
+/*---------------------------------------------------------------------------*/
+static void CVICALLBACK SocketDone (Execution exec, void *callbackData)
+{
+    SocketSet set = (SocketSet)callbackData;
+
+    (void)exec;
+    if (set->remaining.fetch_sub (1, std::memory_order_acq_rel) == 1)
+        {
+        set->running.store (0, std::memory_order_release);
+        if (set->doneCallback)
+            set->doneCallback (set, set->doneCallbackData);
+        }
+    set->pool->Release (set->runGroup);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Start Run > All on every socket.  The sockets' steps share the worker     */
+/* pool, so eight boards take about as long as one whenever the pool has     */
+/* the cores (or the steps spend their time waiting on instruments).         */
+/*---------------------------------------------------------------------------*/
+int SKT_RunAll (SocketSet set, SktDoneCallbackPtr doneCallback,
+                void *callbackData)
+{
+    int numSockets;
+    int idle = 0;
+    int status;
+    int i;
+
+    if (!set || !set->seq)
+        return TMS_ERR_INVALID_ARG;
+    if (!set->running.compare_exchange_strong (idle, 1))
+        return TMS_ERR_BUSY;
+    numSockets = (int)set->sockets.size ();
+    set->doneCallback = doneCallback;
+    set->doneCallbackData = callbackData;
+    set->remaining.store (numSockets);
+    for (i = 0; i < numSockets; i++)
+        {
+        set->pool->Hold (set->runGroup);
+        if ((status = EXE_RunAll (set->sockets[i], SocketDone, set)) < 0)
+            {
+            /* Let the started sockets finish; none of them can be the */
+            /* last, so the set's callback is not made                 */
+            set->pool->Release (set->runGroup);
+            set->pool->Wait (set->runGroup);
+            while (i-- > 0)
+                EXE_Wait (set->sockets[i]);
+            set->remaining.store (0);
+            set->running.store (0);
+            return status;
+            }
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Non-zero while any socket is running.                                     */
+/*---------------------------------------------------------------------------*/
+int SKT_IsRunning (SocketSet set)
+{
+    if (!set)
+        return TMS_ERR_INVALID_ARG;
+    return set->running.load (std::memory_order_acquire);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Block until every socket has finished.  The set's group never has queued  */
+/* tasks, so the waiting thread only sleeps: it cannot end up running a step */
+/* of some other execution while the UI (or a caller's barrier) waits.       */
+/* Once it is done each socket is past its callback and EXE_Wait only waits  */
+/* for the socket's driver to return.                                        */
+/*---------------------------------------------------------------------------*/
+int SKT_Wait (SocketSet set)
+{
+    size_t i;
+
+    if (!set)
+        return TMS_ERR_INVALID_ARG;
+    set->pool->Wait (set->runGroup);
+    for (i = 0; i < set->sockets.size (); i++)
+        EXE_Wait (set->sockets[i]);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Execution of one socket.                                                  */
+/*---------------------------------------------------------------------------*/
+Execution SKT_GetExecution (SocketSet set, int socket)
+{
+    if (!set || socket < 0 || socket >= (int)set->sockets.size ())
+        return 0;
+    return set->sockets[socket];
+}
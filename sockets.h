@@ -0,0 +1,69 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    sockets.h                                                        */
+/*                                                                           */
+/* PURPOSE: Parallel test sockets.  A socket set runs one sequence against   */
+/*          several units under test at once -- one per fixture socket.      */
+/*          Each socket has its own execution (results, counters, Step       */
+/*          mode cursor) and its own result log; the sequence is the only    */
+/*          thing they share, and it is read-only while they run.  Steps     */
+/*          that export a per-socket entry point (TMS_STEP_SOCKET_SUFFIX)    */
+/*          are told which socket they are testing.                          */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __SOCKETS_H__
+#define __SOCKETS_H__
+
+#include "tmsapi.h"
+#include "sequence.h"
+#include "executor.h"
+#include "reslog.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct SocketSetRec_Tag *SocketSet;
+
+/* Called on a pool thread once every socket has finished Run > All */
+typedef void (CVICALLBACK *SktDoneCallbackPtr) (SocketSet set,
+                                                void *callbackData);
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API SocketSet SKT_New          (int numSockets);
+TMS_API void      SKT_Dispose      (SocketSet set);
+TMS_API int       SKT_NumSockets   (SocketSet set);
+
+/* Open one result log per socket.  pathFormat holds a %d, replaced by */
+/* the socket number (0 up).  The set closes the logs.                 */
+TMS_API int       SKT_OpenResultLogs (SocketSet set, const char *pathFormat);
+
+/* Call each socket's steps in a step host of its own running hostPath */
+/* (see stephost.h), or in process again with 0                        */
+TMS_API int       SKT_OpenStepHosts (SocketSet set, const char *hostPath);
+
+/* Load the same sequence (0 to unload) into every socket */
+TMS_API int       SKT_Load         (SocketSet set, Sequence seq);
+TMS_API Sequence  SKT_GetSequence  (SocketSet set);
+
+/* Run every socket concurrently and return immediately */
+TMS_API int       SKT_RunAll       (SocketSet set,
+                                    SktDoneCallbackPtr doneCallback,
+                                    void *callbackData);
+TMS_API int       SKT_IsRunning    (SocketSet set);
+TMS_API int       SKT_Wait         (SocketSet set);
+
+/* A socket's own execution, for its results and counts */
+TMS_API Execution SKT_GetExecution (SocketSet set, int socket);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOCKETS_H__ */
@@ -0,0 +1,663 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    stephost.cpp                                                     */
+/*                                                                           */
+/* PURPOSE: Out-of-process step host.  See stephost.h.  Both sides of the    */
+/*          channel live here; tmshost.cpp only calls HST_Serve.             */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+  #include <limits.h>
+  #include <sched.h>
+  #include <signal.h>
+  #include <spawn.h>
+  #include <time.h>
+  #include <unistd.h>
+  #include <linux/futex.h>
+  #include <sys/mman.h>
+  #include <sys/prctl.h>
+  #include <sys/syscall.h>
+  #include <sys/wait.h>
+#endif
+
+#include "plugin.h"
+#include "sequence.h"
+#include "stephost.h"
+#include "tmsstep.h"
+
+#if defined(__linux__)
+
+extern char **environ;
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+enum { kMaxCalls = 1024, kMaxName = 256 };
+enum { kOpBind = 1, kOpCall, kOpBatch };
+
+/* Not an enumerator: it is compared with sizes */
+static const int kMaxValues = 16384;
+
+/* Rounds of checking and yielding before a side goes to sleep, and how  */
+/* often a sleeping side checks that the other one is still there        */
+enum { kSpins = 200, kPollMillis = 20 };
+
+/* How long a call may go unanswered before the host is taken to have */
+/* hung, unless HST_SetTimeout says otherwise                         */
+enum { kDefaultTimeoutMillis = 10000 };
+
+/* The shared memory.  The application writes a request and bumps        */
+/* request; the host serves it and sets reply to match.  A side sets its */
+/* asleep flag before it waits on the futex, so the other side only      */
+/* makes the wake-up system call when someone is actually asleep.        */
+struct HostChannel
+{
+    std::atomic<uint32_t> request;
+    std::atomic<uint32_t> reply;
+    std::atomic<uint32_t> hostAsleep;
+    std::atomic<uint32_t> appAsleep;
+    std::atomic<int32_t>  numDone;      /* calls (or batch values without */
+                                        /* a batch form) finished         */
+    int32_t               op;
+    int32_t               slot;
+    int32_t               socket;
+    int32_t               count;
+    int32_t               result;
+    char                  module[kMaxName];
+    char                  symbol[kMaxName];
+    HstCall               calls[kMaxCalls];
+    int32_t               in[kMaxValues];
+    int32_t               out[kMaxValues];
+};
+
+struct StepHostRec_Tag
+{
+    std::string  path;
+    int          fd;                    /* the channel's memory */
+    HostChannel *channel;
+    pid_t        pid;                   /* -1 while the host is down */
+    int          numRestarts;
+    int          timeoutMillis;         /* 0 to wait as long as it lives */
+    std::mutex   lock;                  /* one request at a time */
+
+    /* Every Bind the host has been asked for, in slot order, so a new  */
+    /* host can be given the same slots; and the slots that resolved    */
+    std::vector<std::pair<std::string, std::string> > bound;
+    std::unordered_map<std::string, int>               slots;
+
+    StepHostRec_Tag ()
+        : fd (-1), channel (0), pid (-1), numRestarts (0),
+          timeoutMillis (kDefaultTimeoutMillis) {}
+};
+
+/*---------------------------------------------------------------------------*/
+/* Futexes on the shared words.  Not the private kind: the two processes     */
+/* map the memory at different addresses.                                    */
+/*---------------------------------------------------------------------------*/
+static void FutexWait (std::atomic<uint32_t> &word, uint32_t value)
+{
+    struct timespec timeout = { 0, kPollMillis * 1000000L };
+
+    syscall (SYS_futex, (uint32_t *)&word, FUTEX_WAIT, value, &timeout, 0, 0);
+}
+
+static void FutexWake (std::atomic<uint32_t> &word)
+{
+    syscall (SYS_futex, (uint32_t *)&word, FUTEX_WAKE, INT_MAX, 0, 0, 0);
+}
+
+static uint64_t NowMillis ()
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void Post (std::atomic<uint32_t> &word, uint32_t value,
+                  std::atomic<uint32_t> &asleep)
+{
+    word.store (value);
+    if (asleep.load ())
+        FutexWake (word);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Wait until word moves on from value: spin (yielding, so that on a single  */
+/* core the other side gets to run), then sleep on the futex, checking the   */
+/* other side with alive (context) now and then.  false if it has gone, or   */
+/* is still there but timeoutMillis (if not 0) have passed since progress    */
+/* (if given) last moved.                                                    */
+/*---------------------------------------------------------------------------*/
+static bool WaitFor (std::atomic<uint32_t> &word, uint32_t value,
+                     std::atomic<uint32_t> &asleep,
+                     bool (*alive) (void *context), void *context,
+                     int timeoutMillis, const std::atomic<int32_t> *progress)
+{
+    uint64_t deadline = timeoutMillis ? NowMillis () + timeoutMillis : 0;
+    int32_t  seen = progress ? progress->load () : 0;
+    int      i;
+
+    for (i = 0; i < kSpins; i++)
+        {
+        if (word.load (std::memory_order_acquire) != value)
+            return true;
+        sched_yield ();
+        }
+    for (;;)
+        {
+        asleep.store (1);
+        if (word.load () == value)
+            FutexWait (word, value);
+        asleep.store (0);
+        if (word.load (std::memory_order_acquire) != value)
+            return true;
+        if (!alive (context))
+            return false;
+        if (!deadline)
+            continue;
+        if (progress && progress->load () != seen)
+            {
+            seen = progress->load ();
+            deadline = NowMillis () + timeoutMillis;
+            }
+        else if (NowMillis () >= deadline)
+            return false;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Application side.                                                         */
+/*---------------------------------------------------------------------------*/
+static bool HostAlive (void *context)
+{
+    StepHost host = (StepHost)context;
+    int      status;
+
+    if (host->pid >= 0 && waitpid (host->pid, &status, WNOHANG) == 0)
+        return true;
+    host->pid = -1;
+    return false;
+}
+
+/* Send the request in the channel and wait for the reply, allowing the */
+/* timeout for each call in it.  false if the host died, or hung: then  */
+/* pid is still set, and it must be stopped before the channel is read  */
+static bool Request (StepHost host)
+{
+    HostChannel *channel = host->channel;
+    uint32_t     current = channel->reply.load ();
+
+    channel->numDone.store (0);
+    Post (channel->request, current + 1, channel->hostAsleep);
+    return WaitFor (channel->reply, current, channel->appAsleep, HostAlive,
+                    host, host->timeoutMillis, &channel->numDone);
+}
+
+static bool SendBind (StepHost host, const std::string &module,
+                      const std::string &symbol)
+{
+    HostChannel *channel = host->channel;
+
+    channel->op = kOpBind;
+    memcpy (channel->module, module.c_str (), module.size () + 1);
+    memcpy (channel->symbol, symbol.c_str (), symbol.size () + 1);
+    return Request (host);
+}
+
+static void Stop (StepHost host)
+{
+    int status;
+
+    if (host->pid < 0)
+        return;
+    kill (host->pid, SIGKILL);
+    waitpid (host->pid, &status, 0);
+    host->pid = -1;
+}
+
+/* Start the host program on a fresh channel and bind its slots again */
+static bool Start (StepHost host)
+{
+    HostChannel *channel = host->channel;
+    char         fdText[16];
+    char        *argv[3];
+    size_t       i;
+
+    channel->request.store (0);
+    channel->reply.store (0);
+    channel->hostAsleep.store (0);
+    channel->appAsleep.store (0);
+    snprintf (fdText, sizeof(fdText), "%d", host->fd);
+    argv[0] = (char *)host->path.c_str ();
+    argv[1] = fdText;
+    argv[2] = 0;
+    if (posix_spawn (&host->pid, argv[0], 0, 0, argv, environ) != 0)
+        {
+        host->pid = -1;
+        return false;
+        }
+    for (i = 0; i < host->bound.size (); i++)
+        if (!SendBind (host, host->bound[i].first, host->bound[i].second))
+            return false;
+    return true;
+}
+
+/* On failure the host is left down (pid -1), even if it hung binding */
+static bool Restart (StepHost host)
+{
+    host->numRestarts++;
+    Stop (host);
+    if (Start (host))
+        return true;
+    Stop (host);
+    return false;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Create a host.  The channel is a memory file the host inherits; it        */
+/* outlives crashes, and each new host maps the same one.                    */
+/*---------------------------------------------------------------------------*/
+StepHost HST_New (const char *hostPath)
+{
+    StepHost host;
+    void    *memory;
+
+    if (!hostPath)
+        return 0;
+    if (!(host = new (std::nothrow) StepHostRec_Tag))
+        return 0;
+    try
+        {
+        host->path = hostPath;
+        }
+    catch (const std::bad_alloc &)
+        {
+        delete host;
+        return 0;
+        }
+    if ((host->fd = memfd_create ("tmshost", 0)) < 0
+        || ftruncate (host->fd, sizeof(HostChannel)) < 0
+        || (memory = mmap (0, sizeof(HostChannel), PROT_READ | PROT_WRITE,
+                           MAP_SHARED, host->fd, 0)) == MAP_FAILED)
+        {
+        HST_Dispose (host);
+        return 0;
+        }
+    host->channel = (HostChannel *)memory;
+    if (!Start (host))
+        {
+        HST_Dispose (host);
+        return 0;
+        }
+    return host;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Stop the host and discard it.                                             */
+/*---------------------------------------------------------------------------*/
+void HST_Dispose (StepHost host)
+{
+    if (!host)
+        return;
+    Stop (host);
+    if (host->channel)
+        munmap (host->channel, sizeof(HostChannel));
+    if (host->fd >= 0)
+        close (host->fd);
+    delete host;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Resolve a step function in the host.                                      */
+/*---------------------------------------------------------------------------*/
+int HST_Bind (StepHost host, const char *module, const char *symbol)
+{
+    if (!host || !module || !symbol || strlen (module) >= kMaxName
+        || strlen (symbol) >= kMaxName)
+        return TMS_ERR_INVALID_ARG;
+    try
+        {
+        std::lock_guard<std::mutex> guard (host->lock);
+        std::string key = std::string (module) + '\n' + symbol;
+        std::unordered_map<std::string, int>::iterator it;
+        int         slot;
+
+        if ((it = host->slots.find (key)) != host->slots.end ())
+            return it->second;
+        if (host->pid < 0 && !Restart (host))
+            return TMS_ERR_IO;
+        host->bound.push_back (std::make_pair (std::string (module),
+                                               std::string (symbol)));
+        if (!SendBind (host, module, symbol))
+            {
+            /* Loading the module crashed (or hung) the host; leave it out */
+            host->bound.pop_back ();
+            Restart (host);
+            return TMS_ERR_IO;
+            }
+        if ((slot = host->channel->result) >= 0)
+            host->slots[key] = slot;
+        return slot;
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Make a list of calls, as many per round trip as the channel holds.        */
+/*---------------------------------------------------------------------------*/
+int HST_Call (StepHost host, HstCall *calls, int numCalls)
+{
+    HostChannel *channel;
+    bool         hung;
+    int          done = 0;
+    int          count;
+    int          i;
+
+    if (!host || numCalls < 0 || (numCalls && !calls))
+        return TMS_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard (host->lock);
+
+    channel = host->channel;
+    while (done < numCalls)
+        {
+        if (host->pid < 0 && !Restart (host))
+            {
+            for (i = done; i < numCalls; i++)
+                {
+                calls[i].value = 0;
+                calls[i].status = HST_CALL_CRASHED;
+                }
+            return TMS_ERR_IO;
+            }
+        count = numCalls - done < kMaxCalls ? numCalls - done : kMaxCalls;
+        memcpy (channel->calls, calls + done, count * sizeof(HstCall));
+        channel->op = kOpCall;
+        channel->count = count;
+        if (Request (host))
+            {
+            memcpy (calls + done, channel->calls, count * sizeof(HstCall));
+            done += count;
+            continue;
+            }
+
+        /* The calls before the one that crashed or hung are good.  If */
+        /* the host went down after the last one, they all are.  A hung */
+        /* host is killed first so it cannot write them as they are     */
+        /* copied.                                                      */
+        hung = host->pid >= 0;
+        Stop (host);
+        i = channel->numDone.load (std::memory_order_acquire);
+        memcpy (calls + done, channel->calls, i * sizeof(HstCall));
+        if (i < count)
+            {
+            calls[done + i].value = 0;
+            calls[done + i].status = hung ? HST_CALL_HUNG : HST_CALL_CRASHED;
+            i++;
+            }
+        done += i;
+        if (!Restart (host))
+            {
+            for (i = done; i < numCalls; i++)
+                {
+                calls[i].value = 0;
+                calls[i].status = HST_CALL_CRASHED;
+                }
+            return TMS_ERR_IO;
+            }
+        }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Run a sweep through the host, a channel's worth of inputs at a time.      */
+/*---------------------------------------------------------------------------*/
+int HST_CallBatch (StepHost host, int slot, int socket, const int32_t *in,
+                   int32_t *out, size_t n)
+{
+    HostChannel *channel;
+    size_t       done;
+    size_t       count;
+
+    if (!host || slot < 0 || (n && (!in || !out)))
+        return TMS_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard (host->lock);
+
+    channel = host->channel;
+    for (done = 0; done < n; done += count)
+        {
+        if (host->pid < 0 && !Restart (host))
+            return TMS_ERR_IO;
+        count = n - done < (size_t)kMaxValues ? n - done
+                                              : (size_t)kMaxValues;
+        memcpy (channel->in, in + done, count * sizeof(int32_t));
+        channel->op = kOpBatch;
+        channel->slot = slot;
+        channel->socket = socket;
+        channel->count = (int32_t)count;
+        /* The rest of the sweep is given up either way; a host that */
+        /* does not come back is left down for the next call to retry */
+        if (!Request (host))
+            {
+            Restart (host);
+            return TMS_ERR_IO;
+            }
+        if (channel->result < 0)
+            return channel->result;
+        memcpy (out + done, channel->out, count * sizeof(int32_t));
+        }
+    return TMS_OK;
+}
+
+int HST_NumRestarts (StepHost host)
+{
+    if (!host)
+        return TMS_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard (host->lock);
+
+    return host->numRestarts;
+}
+
+/*---------------------------------------------------------------------------*/
+/* How long a request may take before the host is killed and restarted.      */
+/*---------------------------------------------------------------------------*/
+int HST_SetTimeout (StepHost host, int millis)
+{
+    if (!host || millis < 0)
+        return TMS_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard (host->lock);
+
+    host->timeoutMillis = millis;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Host side.                                                                */
+/*---------------------------------------------------------------------------*/
+struct HostSlot
+{
+    SeqStepFunc   func;
+    SeqBatchFunc  batch;
+    SeqSocketFunc socket;
+};
+
+static bool ParentAlive (void *context)
+{
+    return getppid () == *(pid_t *)context;
+}
+
+static void ServeCalls (HostChannel *channel,
+                        const std::vector<HostSlot> &slots)
+{
+    int i;
+
+    for (i = 0; i < channel->count; i++)
+        {
+        HstCall &call = channel->calls[i];
+        size_t   slot = (size_t)call.slot;
+
+        call.value = 0;
+        call.status = HST_CALL_OK;
+        if (slot >= slots.size () || !slots[slot].func)
+            call.status = HST_CALL_MISSING;
+        else if (call.socket >= 0 && slots[slot].socket)
+            call.value = slots[slot].socket (call.socket, call.x);
+        else
+            call.value = slots[slot].func (call.x);
+        channel->numDone.store (i + 1, std::memory_order_release);
+        }
+}
+
+static int ServeBatch (HostChannel *channel,
+                       const std::vector<HostSlot> &slots)
+{
+    size_t   slot = (size_t)channel->slot;
+    size_t   count = (size_t)channel->count;
+    int32_t *in = channel->in;
+    int32_t *out = channel->out;
+    size_t   i;
+
+    if (slot >= slots.size () || !slots[slot].func)
+        return TMS_ERR_NOT_FOUND;
+    /* A value at a time counts as a call each for the hang timeout */
+    if (channel->socket >= 0 && slots[slot].socket)
+        for (i = 0; i < count; i++)
+            {
+            out[i] = slots[slot].socket (channel->socket, in[i]);
+            channel->numDone.store ((int32_t)i + 1, std::memory_order_release);
+            }
+    else if (slots[slot].batch)
+        slots[slot].batch (in, out, count);
+    else
+        for (i = 0; i < count; i++)
+            {
+            out[i] = slots[slot].func (in[i]);
+            channel->numDone.store ((int32_t)i + 1, std::memory_order_release);
+            }
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* tmshost's main loop.  The host dies with the application.                 */
+/*---------------------------------------------------------------------------*/
+int HST_Serve (int channelFd)
+{
+    HostChannel          *channel;
+    PluginLoader          loader;
+    std::vector<HostSlot> slots;
+    pid_t                 parent = getppid ();
+    void                 *memory;
+
+    prctl (PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid () != parent)
+        return TMS_ERR_IO;
+    memory = mmap (0, sizeof(HostChannel), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, channelFd, 0);
+    if (memory == MAP_FAILED)
+        return TMS_ERR_IO;
+    channel = (HostChannel *)memory;
+    if (!(loader = PLG_New ()))
+        return TMS_ERR_NO_MEMORY;
+    for (;;)
+        {
+        uint32_t seen = channel->reply.load ();
+
+        if (!WaitFor (channel->request, seen, channel->hostAsleep,
+                      ParentAlive, &parent, 0, 0))
+            break;
+        switch (channel->op)
+            {
+            case kOpBind:
+                {
+                std::string batchName = std::string (channel->symbol)
+                                        + TMS_STEP_BATCH_SUFFIX;
+                std::string socketName = std::string (channel->symbol)
+                                         + TMS_STEP_SOCKET_SUFFIX;
+                HostSlot    slot = { 0, 0, 0 };
+
+                /* A slot even if it does not resolve, to keep the numbers */
+                /* the application has                                     */
+                slot.func = (SeqStepFunc)PLG_Resolve (loader, channel->module,
+                                                      channel->symbol);
+                if (slot.func)
+                    {
+                    slot.batch = (SeqBatchFunc)PLG_Resolve (
+                        loader, channel->module, batchName.c_str ());
+                    slot.socket = (SeqSocketFunc)PLG_Resolve (
+                        loader, channel->module, socketName.c_str ());
+                    }
+                slots.push_back (slot);
+                channel->result = slot.func ? (int32_t)slots.size () - 1
+                                            : TMS_ERR_NOT_FOUND;
+                break;
+                }
+            case kOpCall:
+                ServeCalls (channel, slots);
+                break;
+            case kOpBatch:
+                channel->result = ServeBatch (channel, slots);
+                break;
+            }
+        Post (channel->reply, channel->request.load (), channel->appAsleep);
+        }
+    PLG_Dispose (loader);
+    munmap (memory, sizeof(HostChannel));
+    return TMS_OK;
+}
+
+#else /* not Linux */
+
+StepHost HST_New (const char *)
+{
+    return 0;
+}
+
+void HST_Dispose (StepHost)
+{
+}
+
+int HST_Bind (StepHost, const char *, const char *)
+{
+    return TMS_ERR_INVALID_ARG;
+}
+
+int HST_Call (StepHost, HstCall *, int)
+{
+    return TMS_ERR_INVALID_ARG;
+}
+
+int HST_CallBatch (StepHost, int, int, const int32_t *, int32_t *, size_t)
+{
+    return TMS_ERR_INVALID_ARG;
+}
+
+int HST_NumRestarts (StepHost)
+{
+    return TMS_ERR_INVALID_ARG;
+}
+
+int HST_SetTimeout (StepHost, int)
+{
+    return TMS_ERR_INVALID_ARG;
+}
+
+int HST_Serve (int)
+{
+    return TMS_ERR_IO;
+}
+
+#endif
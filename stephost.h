@@ -0,0 +1,97 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    stephost.h                                                       */
+/*                                                                           */
+/* PURPOSE: Out-of-process step host.  Step modules are loaded by a child    */
+/*          process (tmshost) instead of the application, so a step that     */
+/*          crashes takes down only the host: the call that crashed fails,   */
+/*          the host is started again and the run carries on.  Calls and     */
+/*          their results pass through memory the two processes share, and   */
+/*          each side wakes the other with a futex after spinning briefly,   */
+/*          so a call costs a few microseconds rather than the milliseconds  */
+/*          of a pipe.  Many calls go over in one round trip, and a sweep    */
+/*          step's inputs in as few as fit.  Linux only; elsewhere HST_New   */
+/*          returns 0.                                                       */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __STEPHOST_H__
+#define __STEPHOST_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tmsapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Call status                                                               */
+/*---------------------------------------------------------------------------*/
+#define HST_CALL_OK         0
+#define HST_CALL_MISSING    1           /* the step has no function */
+#define HST_CALL_CRASHED    2           /* the host died in the call */
+#define HST_CALL_HUNG       3           /* no reply within the timeout */
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct StepHostRec_Tag *StepHost;
+
+/* One step call: value = symbol (x), or symbol_socket (socket, x) when */
+/* socket >= 0 and the module exports it                                */
+typedef struct
+{
+    int32_t slot;                       /* from HST_Bind */
+    int32_t socket;
+    int32_t x;
+    int32_t value;
+    int32_t status;                     /* HST_CALL_* */
+} HstCall;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+
+/* Start a host running the program at hostPath (tmshost) */
+TMS_API StepHost HST_New         (const char *hostPath);
+TMS_API void     HST_Dispose     (StepHost host);
+
+/* Have the host load module and resolve symbol, with its batch and     */
+/* socket forms.  Returns the slot calls name it by, the same for the   */
+/* same module and symbol; TMS_ERR_NOT_FOUND if it cannot be resolved.  */
+TMS_API int      HST_Bind        (StepHost host, const char *module,
+                                  const char *symbol);
+
+/* Make numCalls calls in order, filling in their value and status.  If */
+/* one crashes or hangs the host, it is started again for the rest.     */
+/* TMS_ERR_IO if it cannot be; the calls not made are marked crashed.   */
+TMS_API int      HST_Call        (StepHost host, HstCall *calls,
+                                  int numCalls);
+
+/* out[i] = slot's function of in[i], i < n, through its batch form if  */
+/* it has one (or its socket form for socket >= 0).  TMS_ERR_NOT_FOUND  */
+/* if the slot has no function, TMS_ERR_IO if the host crashed or hung. */
+TMS_API int      HST_CallBatch   (StepHost host, int slot, int socket,
+                                  const int32_t *in, int32_t *out, size_t n);
+
+/* Times the host has been started again after a crash or a hang */
+TMS_API int      HST_NumRestarts (StepHost host);
+
+/* A call the host has not finished in millis (10 s to begin with) is    */
+/* taken as a hang: the host is killed and started again, and the call   */
+/* is marked hung.  Each call of a round trip, and each value of a batch */
+/* without a batch form, gets the full time.  0 waits as long as the     */
+/* host is alive.                                                        */
+TMS_API int      HST_SetTimeout  (StepHost host, int millis);
+
+/* The host side: serve calls over the channel passed to tmshost.  Runs */
+/* until the application goes away.                                     */
+TMS_API int      HST_Serve       (int channelFd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STEPHOST_H__ */
@@ -0,0 +1,130 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    steptime.cpp                                                     */
+/*                                                                           */
+/* PURPOSE: Step timing probes.  See steptime.h.                             */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#if defined(_WIN32)
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+#include <chrono>
+#include <thread>
+
+#include "steptime.h"
+
+namespace tms {
+
+/*---------------------------------------------------------------------------*/
+/* Both clocks read together at start-up.                                    */
+/*---------------------------------------------------------------------------*/
+struct ClockEpoch
+{
+    uint64_t                              ticks;
+    std::chrono::steady_clock::time_point time;
+
+    ClockEpoch () : ticks (ReadTicks ()),
+                    time (std::chrono::steady_clock::now ()) {}
+};
+
+static const ClockEpoch s_epoch;
+
+uint64_t TickEpoch ()
+{
+    return s_epoch.ticks;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Compare the ticks elapsed since start-up with the steady clock.  The      */
+/* longer the baseline the better the estimate, so a call in the first few   */
+/* milliseconds after start-up waits until there is enough of one.           */
+/*---------------------------------------------------------------------------*/
+double NanosPerTick ()
+{
+#if defined(TMS_HAVE_TSC)
+    using namespace std::chrono;
+
+    const nanoseconds minBaseline = milliseconds (10);
+    nanoseconds       elapsed = steady_clock::now () - s_epoch.time;
+    uint64_t          ticks;
+
+    if (elapsed < minBaseline)
+        std::this_thread::sleep_for (minBaseline - elapsed);
+    ticks = ReadTicks ();
+    elapsed = steady_clock::now () - s_epoch.time;
+    if (ticks <= s_epoch.ticks)
+        return 1.0;
+    return (double)elapsed.count () / (double)(ticks - s_epoch.ticks);
+#else
+    return 1.0;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/* CPU time of the calling thread, user and kernel.                          */
+/*---------------------------------------------------------------------------*/
+uint64_t ThreadCpuNanos ()
+{
+#if defined(_WIN32)
+    FILETIME created, exited, kernel, user;
+
+    if (!GetThreadTimes (GetCurrentThread (), &created, &exited, &kernel,
+                         &user))
+        return 0;
+    return ((((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime)
+            + (((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime))
+           * 100;
+#else
+    struct timespec now;
+
+    if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &now) != 0)
+        return 0;
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/* Walk the buckets to the one holding the requested rank and report its     */
+/* midpoint, kept within the exact minimum and maximum.                      */
+/*---------------------------------------------------------------------------*/
+uint64_t Histogram::Quantile (double fraction) const
+{
+    uint64_t rank;
+    uint64_t seen = 0;
+    uint64_t low;
+    uint64_t value;
+    int      magnitude;
+    int      i;
+
+    if (!m_count)
+        return 0;
+    if (fraction <= 0.0)
+        return Min ();
+    rank = fraction >= 1.0 ? m_count : (uint64_t)(fraction * m_count + 0.5);
+    if (rank == 0)
+        rank = 1;
+    for (i = 0; i < kNumBuckets; i++)
+        if ((seen += m_counts[i]) >= rank)
+            break;
+    if (i < kSubCount)
+        value = (uint64_t)i;
+    else
+        {
+        magnitude = (i >> kSubBits) + kSubBits - 1;
+        low = (uint64_t)(kSubCount + (i & (kSubCount - 1)))
+              << (magnitude - kSubBits);
+        value = low + ((uint64_t)1 << (magnitude - kSubBits)) / 2;
+        }
+    if (value < Min ())
+        value = Min ();
+    if (value > m_max)
+        value = m_max;
+    return value;
+}
+
+} /* namespace tms */
@@ -0,0 +1,209 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    steptime.h                                                       */
+/*                                                                           */
+/* PURPOSE: Step timing probes for the execution engine.  A probe is two     */
+/*          reads of the CPU's time-stamp counter, so it can stay on in      */
+/*          production; ticks are converted to time only when someone asks.  */
+/*          Each worker records into a slot of its own (a latency            */
+/*          histogram plus a bounded list of trace events), so probes never  */
+/*          share a cache line.  C++ only -- not part of the exported C API. */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __STEPTIME_H__
+#define __STEPTIME_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+  #define TMS_HAVE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  #define TMS_HAVE_TSC 1
+#else
+  #include <chrono>
+#endif
+
+namespace tms {
+
+/*---------------------------------------------------------------------------*/
+/* Clock                                                                     */
+/*---------------------------------------------------------------------------*/
+
+/* Free-running tick counter: the TSC on x86, nanoseconds elsewhere */
+inline uint64_t ReadTicks ()
+{
+#if defined(TMS_HAVE_TSC)
+    return __rdtsc ();
+#else
+    return (uint64_t)std::chrono::steady_clock::now ().time_since_epoch ()
+           .count ();
+#endif
+}
+
+/* Length of a tick, measured against the steady clock since start-up */
+double   NanosPerTick ();
+
+/* Tick count at start-up; trace timestamps are relative to it */
+uint64_t TickEpoch ();
+
+/* CPU time used by the calling thread */
+uint64_t ThreadCpuNanos ();
+
+/*---------------------------------------------------------------------------*/
+/* Log-linear histogram in the style of HdrHistogram: exact below 32, then   */
+/* 32 buckets per power of two, so any value is recorded to within 3% in a   */
+/* fixed 15 KB with no allocation on the recording path.                     */
+/*---------------------------------------------------------------------------*/
+class Histogram
+{
+public:
+    enum { kSubBits = 5, kSubCount = 1 << kSubBits,
+           kNumBuckets = (64 - kSubBits + 1) * kSubCount };
+
+    Histogram () { Clear (); }
+
+    void Clear ()
+        {
+        for (int i = 0; i < kNumBuckets; i++)
+            m_counts[i] = 0;
+        m_count = 0;
+        m_min = ~(uint64_t)0;
+        m_max = 0;
+        }
+
+    void Record (uint64_t value)
+        {
+        m_counts[BucketOf (value)]++;
+        m_count++;
+        if (value < m_min)
+            m_min = value;
+        if (value > m_max)
+            m_max = value;
+        }
+
+    void Add (const Histogram &other)
+        {
+        for (int i = 0; i < kNumBuckets; i++)
+            m_counts[i] += other.m_counts[i];
+        m_count += other.m_count;
+        if (other.m_min < m_min)
+            m_min = other.m_min;
+        if (other.m_max > m_max)
+            m_max = other.m_max;
+        }
+
+    uint64_t Count () const { return m_count; }
+    uint64_t Min () const { return m_count ? m_min : 0; }
+    uint64_t Max () const { return m_max; }
+
+    /* Value below which the given fraction (0 to 1) of the values lie */
+    uint64_t Quantile (double fraction) const;
+
+    static int BucketOf (uint64_t value)
+        {
+        int magnitude;
+
+        if (value < kSubCount)
+            return (int)value;
+        magnitude = HighBit (value);
+        return ((magnitude - kSubBits + 1) << kSubBits)
+               + (int)((value >> (magnitude - kSubBits)) & (kSubCount - 1));
+        }
+
+private:
+    static int HighBit (uint64_t value)
+        {
+#if defined(_MSC_VER)
+        unsigned long bit;
+
+        _BitScanReverse64 (&bit, value);
+        return (int)bit;
+#else
+        return 63 - __builtin_clzll (value);
+#endif
+        }
+
+    uint64_t m_counts[kNumBuckets];
+    uint64_t m_count;
+    uint64_t m_min;
+    uint64_t m_max;
+};
+
+/*---------------------------------------------------------------------------*/
+/* Trace events, in ticks.  A range is one chunk of a group run by a worker; */
+/* thread CPU time is read per range, since reading it costs a system call.  */
+/*---------------------------------------------------------------------------*/
+struct StepEvent
+{
+    uint64_t start;
+    uint32_t ticks;
+    int32_t  step;
+};
+
+struct RangeEvent
+{
+    uint64_t start;
+    uint64_t ticks;
+    uint64_t cpuNanos;
+    int32_t  begin;
+    int32_t  end;
+};
+
+/*---------------------------------------------------------------------------*/
+/* What one thread recorded for one execution.                               */
+/*---------------------------------------------------------------------------*/
+struct alignas (64) TimingSlot
+{
+    enum { kMaxEvents = 1 << 16 };
+
+    Histogram               steps;
+    uint64_t                totalTicks;
+    uint64_t                cpuNanos;
+    uint64_t                numDropped;   /* events past kMaxEvents */
+    std::vector<StepEvent>  stepEvents;
+    std::vector<RangeEvent> rangeEvents;
+
+    TimingSlot () : totalTicks (0), cpuNanos (0), numDropped (0) {}
+
+    void Clear ()
+        {
+        steps.Clear ();
+        totalTicks = cpuNanos = numDropped = 0;
+        stepEvents.clear ();
+        rangeEvents.clear ();
+        }
+
+    void RecordStep (int step, uint64_t start, uint64_t ticks)
+        {
+        StepEvent event = {start, ticks > UINT32_MAX ? UINT32_MAX
+                                                     : (uint32_t)ticks, step};
+
+        steps.Record (ticks);
+        totalTicks += ticks;
+        if (stepEvents.size () < kMaxEvents)
+            stepEvents.push_back (event);
+        else
+            numDropped++;
+        }
+
+    void RecordRange (int begin, int end, uint64_t start, uint64_t ticks,
+                      uint64_t cpu)
+        {
+        RangeEvent event = {start, ticks, cpu, begin, end};
+
+        cpuNanos += cpu;
+        if (rangeEvents.size () < kMaxEvents)
+            rangeEvents.push_back (event);
+        else
+            numDropped++;
+        }
+};
+
+} /* namespace tms */
+
+#endif /* __STEPTIME_H__ */
@@ -0,0 +1,202 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    strpool.cpp                                                      */
+/*                                                                           */
+/* PURPOSE: Interned string pool implementation.                             */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "strpool.h"
+
+namespace tms {
+
+const uint32_t StringPool::NotFound;
+
+/*---------------------------------------------------------------------------*/
+/* Create an empty pool.                                                     */
+/*---------------------------------------------------------------------------*/
+StringPool::StringPool ()
+{
+    m_slots.assign (16, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+/* FNV-1a.  Short names dominate, so a simple byte-wise hash is plenty.      */
+/*---------------------------------------------------------------------------*/
+uint32_t StringPool::Hash (const char *str, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    size_t   i;
+
+    for (i = 0; i < len; i++)
+        {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+        }
+    return hash;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Probe for str.  Returns its id, or NotFound with slot set to the empty    */
+/* slot where it would be inserted.                                          */
+/*---------------------------------------------------------------------------*/
+uint32_t StringPool::Lookup (const char *str, size_t len, uint32_t hash,
+                             size_t &slot) const
+{
+    size_t mask;
+
+    if (m_hashes.size () != m_offsets.size ())
+        Index ();
+    mask = m_slots.size () - 1;
+
+    for (slot = hash & mask; m_slots[slot]; slot = (slot + 1) & mask)
+        {
+        uint32_t id = m_slots[slot] - 1;
+        const char *candidate;
+
+        if (m_hashes[id] != hash)
+            continue;
+        candidate = &m_chars[m_offsets[id]];
+        if (memcmp (candidate, str, len) == 0 && candidate[len] == '\0')
+            return id;
+        }
+    return NotFound;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Grow the slot table and re-insert every id.                               */
+/*---------------------------------------------------------------------------*/
+void StringPool::Rehash (size_t numSlots) const
+{
+    size_t   mask = numSlots - 1;
+    uint32_t id;
+
+    m_slots.assign (numSlots, 0);
+    for (id = 0; id < m_offsets.size (); id++)
+        {
+        size_t slot = m_hashes[id] & mask;
+
+        while (m_slots[slot])
+            slot = (slot + 1) & mask;
+        m_slots[slot] = id + 1;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Hash borrowed strings and build the slot table for them.                  */
+/*---------------------------------------------------------------------------*/
+void StringPool::Index () const
+{
+    size_t   numSlots = 16;
+    uint32_t id;
+
+    m_hashes.resize (m_offsets.size ());
+    for (id = 0; id < m_offsets.size (); id++)
+        {
+        const char *str = Get (id);
+
+        m_hashes[id] = Hash (str, strlen (str));
+        }
+    while (numSlots < m_offsets.size () * 2)
+        numSlots *= 2;
+    Rehash (numSlots);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Use strings stored elsewhere in place.  The caller checks that every      */
+/* offset is inside chars and every string is terminated.                    */
+/*---------------------------------------------------------------------------*/
+void StringPool::Borrow (const char *chars, size_t numBytes,
+                         const uint32_t *offsets, uint32_t count)
+{
+    m_chars.Borrow (chars, numBytes);
+    m_offsets.Borrow (offsets, count);
+    std::vector<uint32_t> ().swap (m_hashes);
+    m_slots.clear ();
+
+    /* A mismatch in size marks the index as not built */
+    if (!count)
+        m_slots.assign (16, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Intern a NUL-terminated string.                                           */
+/*---------------------------------------------------------------------------*/
+uint32_t StringPool::Intern (const char *str)
+{
+    return Intern (str ? str : "", str ? strlen (str) : 0);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Intern len bytes of str (which need not be NUL-terminated).               */
+/*---------------------------------------------------------------------------*/
+uint32_t StringPool::Intern (const char *str, size_t len)
+{
+    uint32_t hash = Hash (str, len);
+    uint32_t id;
+    size_t   slot;
+
+    if (m_hashes.size () != m_offsets.size ())
+        Index ();
+    if ((id = Lookup (str, len, hash, slot)) != NotFound)
+        return id;
+
+    /* Keep the load factor under 1/2 */
+    if ((m_offsets.size () + 1) * 2 > m_slots.size ())
+        {
+        Rehash (m_slots.size () * 2);
+        Lookup (str, len, hash, slot);
+        }
+    id = (uint32_t)m_offsets.size ();
+    m_offsets.push_back ((uint32_t)m_chars.size ());
+    m_hashes.push_back (hash);
+    m_chars.append (str, str + len);
+    m_chars.push_back ('\0');
+    m_slots[slot] = id + 1;
+    return id;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Look up without inserting.                                                */
+/*---------------------------------------------------------------------------*/
+uint32_t StringPool::Find (const char *str) const
+{
+    size_t len = str ? strlen (str) : 0;
+    size_t slot;
+
+    return Lookup (str ? str : "", len, Hash (str ? str : "", len), slot);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Drop every string.  Capacity is kept.                                     */
+/*---------------------------------------------------------------------------*/
+void StringPool::Clear ()
+{
+    m_chars.clear ();
+    m_offsets.clear ();
+    m_hashes.clear ();
+    m_slots.assign (m_slots.size () < 16 ? 16 : m_slots.size (), 0);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Pre-size for a known number of strings and bytes.                         */
+/*---------------------------------------------------------------------------*/
+void StringPool::Reserve (size_t numStrings, size_t numBytes)
+{
+    size_t numSlots;
+
+    if (m_hashes.size () != m_offsets.size ())
+        Index ();
+    numSlots = m_slots.size ();
+    m_offsets.reserve (numStrings);
+    m_hashes.reserve (numStrings);
+    m_chars.reserve (numBytes);
+    while (numSlots < numStrings * 2)
+        numSlots *= 2;
+    if (numSlots != m_slots.size ())
+        Rehash (numSlots);
+}
+
+} /* namespace tms */
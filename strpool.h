@@ -0,0 +1,70 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    strpool.h                                                        */
+/*                                                                           */
+/* PURPOSE: Interned string pool.  Every distinct string is stored once in   */
+/*          a single contiguous buffer and identified by a small integer id, */
+/*          so tables can hold 4-byte ids instead of pointers or copies.     */
+/*          C++ only -- not part of the exported C API.                      */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __STRPOOL_H__
+#define __STRPOOL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "column.h"
+
+namespace tms {
+
+class StringPool
+{
+public:
+    StringPool ();
+
+    /* Return the id of str, adding it if it is not in the pool yet. */
+    uint32_t    Intern (const char *str);
+    uint32_t    Intern (const char *str, size_t len);
+
+    /* Return the id of str, or NotFound. */
+    uint32_t    Find   (const char *str) const;
+
+    const char *Get    (uint32_t id) const { return &m_chars[m_offsets[id]]; }
+    uint32_t    Count  () const { return (uint32_t)m_offsets.size (); }
+    size_t      Bytes  () const { return m_chars.size (); }
+    void        Clear  ();
+    void        Reserve (size_t numStrings, size_t numBytes);
+
+    /* Use count strings stored elsewhere (a mapped sequence file) in      */
+    /* place: chars holds them NUL-terminated, offsets[id] is where id     */
+    /* starts.  The hash index is only built when a lookup needs it.       */
+    void        Borrow (const char *chars, size_t numBytes,
+                        const uint32_t *offsets, uint32_t count);
+
+    const char     *CharData ()   const { return m_chars.data (); }
+    const uint32_t *OffsetData () const { return m_offsets.data (); }
+
+    static const uint32_t NotFound = 0xFFFFFFFFu;
+
+    static uint32_t Hash (const char *str, size_t len);
+
+private:
+    uint32_t Lookup (const char *str, size_t len, uint32_t hash,
+                     size_t &slot) const;
+    void     Rehash (size_t numSlots) const;
+    void     Index  () const;
+
+    Column<char>     m_chars;     /* NUL-terminated strings, back to back */
+    Column<uint32_t> m_offsets;   /* id -> offset into m_chars */
+
+    /* Built on demand for borrowed strings, hence mutable */
+    mutable std::vector<uint32_t> m_hashes;   /* id -> hash */
+    mutable std::vector<uint32_t> m_slots;    /* open addressed, id + 1 */
+};
+
+} /* namespace tms */
+
+#endif /* __STRPOOL_H__ */
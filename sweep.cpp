@@ -0,0 +1,241 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    sweep.cpp                                                        */
+/*                                                                           */
+/* PURPOSE: Parameter sweeps.  See sweep.h.                                  */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <new>
+
+#include "sweep.h"
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct SweepParam
+{
+    int     step;
+    int32_t first;
+    int32_t increment;
+    int64_t numLevels;                  /* values in the range */
+};
+
+struct ParamSweepRec_Tag
+{
+    int        mode;
+    int        numParams;
+    SweepParam params[SWP_MAX_PARAMS];
+
+    /* Worked out again whenever a parameter is added.  A pairwise sweep */
+    /* uses the rows of an orthogonal array over the integers modulo     */
+    /* prime; prime is 0 when the sweep is a cartesian product, which    */
+    /* is the case for fewer than three parameters, or when the product  */
+    /* is the smaller of the two.                                        */
+    int64_t    numPoints;               /* < 0 if too many */
+    int64_t    prime;
+};
+
+static const int64_t kMaxPoints = INT64_MAX;
+
+/*---------------------------------------------------------------------------*/
+/* Smallest prime at least n.                                                */
+/*---------------------------------------------------------------------------*/
+static int64_t NextPrime (int64_t n)
+{
+    int64_t d;
+
+    if (n <= 2)
+        return 2;
+    for (;; n++)
+        {
+        for (d = 2; d * d <= n; d++)
+            if (n % d == 0)
+                break;
+        if (d * d > n)
+            return n;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Count the points of the sweep and pick the pairwise array, if any.        */
+/*                                                                           */
+/* For a prime p the p^2 rows (a, b) with columns (a + j*b) mod p, j < p,    */
+/* and b form an orthogonal array of strength 2: any two columns hold every  */
+/* pair of residues exactly once.  With p at least the number of values of   */
+/* every parameter and at least one less than the number of parameters,      */
+/* parameter i takes column i and uses level (column mod its number of       */
+/* values), which still covers each of its pairs.                            */
+/*---------------------------------------------------------------------------*/
+static void CountPoints (ParamSweep sweep)
+{
+    int64_t product = sweep->numParams ? 1 : 0;
+    int64_t maxLevels = 0;
+    int64_t prime;
+    int     i;
+
+    for (i = 0; i < sweep->numParams; i++)
+        {
+        int64_t levels = sweep->params[i].numLevels;
+
+        if (product > 0 && product > kMaxPoints / levels)
+            product = -1;
+        else if (product > 0)
+            product *= levels;
+        if (levels > maxLevels)
+            maxLevels = levels;
+        }
+    sweep->numPoints = product;
+    sweep->prime = 0;
+    if (sweep->mode != SWP_MODE_PAIRWISE || sweep->numParams < 3)
+        return;
+    if (maxLevels < sweep->numParams - 1)
+        maxLevels = sweep->numParams - 1;
+    if (maxLevels > 3037000000LL)           /* the square would overflow */
+        return;
+    prime = NextPrime (maxLevels);
+    if (product < 0 || prime * prime < product)
+        {
+        sweep->numPoints = prime * prime;
+        sweep->prime = prime;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Create an empty sweep.                                                    */
+/*---------------------------------------------------------------------------*/
+ParamSweep SWP_New (int mode)
+{
+    ParamSweep sweep;
+
+    if (mode != SWP_MODE_CARTESIAN && mode != SWP_MODE_PAIRWISE)
+        return 0;
+    if (!(sweep = new (std::nothrow) ParamSweepRec_Tag))
+        return 0;
+    sweep->mode = mode;
+    sweep->numParams = 0;
+    sweep->numPoints = 0;
+    sweep->prime = 0;
+    return sweep;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Discard a sweep.                                                          */
+/*---------------------------------------------------------------------------*/
+void SWP_Dispose (ParamSweep sweep)
+{
+    delete sweep;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Add a parameter range.                                                    */
+/*---------------------------------------------------------------------------*/
+int SWP_AddParam (ParamSweep sweep, int step, int32_t first, int32_t last,
+                  int32_t increment)
+{
+    SweepParam *param;
+    int64_t     span = (int64_t)last - first;
+    int         i;
+
+    if (!sweep || step < 0 || sweep->numParams >= SWP_MAX_PARAMS)
+        return TMS_ERR_INVALID_ARG;
+    if (increment == 0 ? span != 0 : span / increment < 0)
+        return TMS_ERR_INVALID_ARG;
+    for (i = 0; i < sweep->numParams; i++)
+        if (sweep->params[i].step == step)
+            return TMS_ERR_EXISTS;
+    param = &sweep->params[sweep->numParams];
+    param->step = step;
+    param->first = first;
+    param->increment = increment ? increment : 1;
+    param->numLevels = span / param->increment + 1;
+    sweep->numParams++;
+    CountPoints (sweep);
+    return sweep->numParams - 1;
+}
+
+int SWP_NumParams (ParamSweep sweep)
+{
+    return sweep ? sweep->numParams : TMS_ERR_INVALID_ARG;
+}
+
+int SWP_GetParamStep (ParamSweep sweep, int param)
+{
+    if (!sweep || param < 0 || param >= sweep->numParams)
+        return TMS_ERR_INVALID_ARG;
+    return sweep->params[param].step;
+}
+
+int64_t SWP_NumPoints (ParamSweep sweep)
+{
+    if (!sweep)
+        return TMS_ERR_INVALID_ARG;
+    return sweep->numPoints < 0 ? TMS_ERR_NO_MEMORY : sweep->numPoints;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Generate a run of points.  A cartesian sweep counts in mixed radix, the   */
+/* last parameter fastest: the first point's levels are decoded from its     */
+/* index and the rest follow by carrying, so a point costs about one         */
+/* addition.  A pairwise sweep works each point out from its row.            */
+/*---------------------------------------------------------------------------*/
+int SWP_GetPoints (ParamSweep sweep, int64_t firstPoint, int numPoints,
+                   int32_t *values)
+{
+    const SweepParam *params;
+    int64_t           levels[SWP_MAX_PARAMS];
+    int64_t           rest;
+    int               numParams;
+    int               point;
+    int               i;
+
+    if (!sweep || firstPoint < 0 || numPoints < 0 || (numPoints && !values))
+        return TMS_ERR_INVALID_ARG;
+    if (sweep->numPoints < 0)
+        return TMS_ERR_NO_MEMORY;
+    if (firstPoint >= sweep->numPoints)
+        return 0;
+    if (numPoints > sweep->numPoints - firstPoint)
+        numPoints = (int)(sweep->numPoints - firstPoint);
+    params = sweep->params;
+    numParams = sweep->numParams;
+    if (sweep->prime)
+        {
+        int64_t p = sweep->prime;
+
+        for (point = 0; point < numPoints; point++)
+            {
+            int64_t a = (firstPoint + point) / p;
+            int64_t b = (firstPoint + point) % p;
+
+            for (i = 0; i < numParams; i++)
+                {
+                int64_t column = i < p ? (a + i * b) % p : b;
+
+                *values++ = (int32_t)(params[i].first + column
+                                      % params[i].numLevels
+                                      * params[i].increment);
+                }
+            }
+        return numPoints;
+        }
+    for (rest = firstPoint, i = numParams - 1; i >= 0; i--)
+        {
+        levels[i] = rest % params[i].numLevels;
+        rest /= params[i].numLevels;
+        }
+    for (point = 0; point < numPoints; point++)
+        {
+        for (i = 0; i < numParams; i++)
+            *values++ = (int32_t)(params[i].first
+                                  + levels[i] * params[i].increment);
+        for (i = numParams - 1; i >= 0; i--)
+            {
+            if (++levels[i] < params[i].numLevels)
+                break;
+            levels[i] = 0;
+            }
+        }
+    return numPoints;
+}
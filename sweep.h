@@ -0,0 +1,67 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    sweep.h                                                          */
+/*                                                                           */
+/* PURPOSE: Parameter sweeps behind Sequence > Sweep.  A sweep gives a       */
+/*          range of values to the parameter x of some steps and combines    */
+/*          them: every combination (cartesian product), or a pairwise       */
+/*          covering array in which every pair of values of any two          */
+/*          parameters occurs at least once.  Points are never stored; each  */
+/*          one is worked out from its index, so a sweep of 10^8 points      */
+/*          takes no more memory than one of ten, and any range of indices   */
+/*          can be generated on its own, on any thread.                      */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include <stdint.h>
+#include "tmsapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Ways of combining the parameters                                          */
+/*---------------------------------------------------------------------------*/
+#define SWP_MODE_CARTESIAN  0
+#define SWP_MODE_PAIRWISE   1
+
+#define SWP_MAX_PARAMS      16
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct ParamSweepRec_Tag *ParamSweep;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API ParamSweep SWP_New          (int mode);
+TMS_API void       SWP_Dispose      (ParamSweep sweep);
+
+/* Sweep the parameter of step from first to last (included) in steps   */
+/* of increment, which is negative if last < first.  Returns the index  */
+/* of the new parameter; TMS_ERR_EXISTS if the step already has one.    */
+TMS_API int        SWP_AddParam     (ParamSweep sweep, int step,
+                                     int32_t first, int32_t last,
+                                     int32_t increment);
+TMS_API int        SWP_NumParams    (ParamSweep sweep);
+TMS_API int        SWP_GetParamStep (ParamSweep sweep, int param);
+
+/* Number of points, or TMS_ERR_NO_MEMORY if it does not fit in 63 bits */
+TMS_API int64_t    SWP_NumPoints    (ParamSweep sweep);
+
+/* Values of points [firstPoint, firstPoint + numPoints), one row of    */
+/* SWP_NumParams values per point.  Returns the number of points        */
+/* filled, fewer than numPoints at the end of the sweep.                */
+TMS_API int        SWP_GetPoints    (ParamSweep sweep, int64_t firstPoint,
+                                     int numPoints, int32_t *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SWEEP_H__ */
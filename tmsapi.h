@@ -0,0 +1,58 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    tmsapi.h                                                         */
+/*                                                                           */
+/* PURPOSE: Common export, calling-convention and status definitions shared  */
+/*          by the C++ test-engine modules and the CVI application that      */
+/*          imports them.                                                    */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __TMSAPI_H__
+#define __TMSAPI_H__
+
+/*---------------------------------------------------------------------------*/
+/* Export macros.  Define TMS_BUILD_DLL when building the engine library;    */
+/* clients (menudemo.c) leave it undefined and get the import declaration.   */
+/* TMS_STATIC builds and links the engine as a static library (CMake).       */
+/*---------------------------------------------------------------------------*/
+#if defined(TMS_STATIC)
+  #define TMS_API
+  #if defined(_WIN32)
+    #define TMS_STDCALL __stdcall
+  #else
+    #define TMS_STDCALL
+  #endif
+#elif defined(_WIN32)
+  #ifdef TMS_BUILD_DLL
+    #define TMS_API __declspec(dllexport)
+  #else
+    #define TMS_API __declspec(dllimport)
+  #endif
+  #define TMS_STDCALL __stdcall
+#else
+  #define TMS_API __attribute__((visibility("default")))
+  #define TMS_STDCALL
+#endif
+
+#ifndef CVICALLBACK
+  #if defined(_WIN32)
+    #define CVICALLBACK __cdecl
+  #else
+    #define CVICALLBACK
+  #endif
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Status codes.  Like the CVI libraries, functions return a negative value  */
+/* on failure and zero (or a non-negative count/index) on success.           */
+/*---------------------------------------------------------------------------*/
+#define TMS_OK                   0
+#define TMS_ERR_INVALID_ARG     -1
+#define TMS_ERR_NO_MEMORY       -2
+#define TMS_ERR_BUSY            -3
+#define TMS_ERR_NOT_FOUND       -4
+#define TMS_ERR_IO              -5
+#define TMS_ERR_EXISTS          -6
+
+#endif /* __TMSAPI_H__ */
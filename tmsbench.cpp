@@ -0,0 +1,712 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    tmsbench.cpp                                                     */
+/*                                                                           */
+/* PURPOSE: Benchmarks for the hot paths: calling a step (scalar and batch,  */
+/*          linked in, loaded at run time and built in), the File and Window */
+/*          menu lists, loading a sequence, opening the session store,       */
+/*          Edit > Find, Run > All and a parameter sweep on 1 to 8 threads,  */
+/*          async steps waiting together, and calls through the step host.   */
+/*          Built on Google Benchmark; write the results as JSON to track    */
+/*          regressions:                                                     */
+/*                                                                           */
+/*            tmsbench --benchmark_out=bench.json                            */
+/*                     --benchmark_out_format=json                           */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "add.h"
+#include "builtin.h"
+#include "docctl.h"
+#include "docreg.h"
+#include "executor.h"
+#include "findidx.h"
+#include "plugin.h"
+#include "sequence.h"
+#include "session.h"
+#include "stephost.h"
+#include "sweep.h"
+#include "uimem.h"
+
+#ifndef TMSBENCH_ADD_MODULE
+  #define TMSBENCH_ADD_MODULE "add"
+#endif
+
+typedef void (TMS_STDCALL *AddBatchFunc) (const int32_t *in, int32_t *out,
+                                          size_t n);
+
+/*---------------------------------------------------------------------------*/
+/* The add module, loaded once for the whole run.                            */
+/*---------------------------------------------------------------------------*/
+static PluginLoader LoadedAdd (SeqStepFunc *func, AddBatchFunc *batch)
+{
+    static PluginLoader loader = PLG_New ();
+    static SeqStepFunc  s_func = (SeqStepFunc)PLG_Resolve (
+        loader, TMSBENCH_ADD_MODULE, "add");
+    static AddBatchFunc s_batch = (AddBatchFunc)PLG_Resolve (
+        loader, TMSBENCH_ADD_MODULE, "add" TMS_STEP_BATCH_SUFFIX);
+
+    *func = s_func;
+    *batch = s_batch;
+    return loader;
+}
+
+static std::vector<int32_t> Inputs (size_t count)
+{
+    std::vector<int32_t> inputs (count);
+    size_t               i;
+
+    for (i = 0; i < count; i++)
+        inputs[i] = (int32_t)i;
+    return inputs;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Step calls: one add per input through the loaded module, the same through */
+/* the linked-in add, and one add_batch call for all of them.                */
+/*---------------------------------------------------------------------------*/
+static void BM_AddScalarLoaded (benchmark::State &state)
+{
+    std::vector<int32_t> in = Inputs ((size_t)state.range (0));
+    std::vector<int32_t> out (in.size ());
+    SeqStepFunc          func;
+    AddBatchFunc         batch;
+    size_t               i;
+
+    LoadedAdd (&func, &batch);
+    if (!func)
+        {
+        state.SkipWithError ("add module not found");
+        return;
+        }
+    for (auto _ : state)
+        {
+        for (i = 0; i < in.size (); i++)
+            out[i] = func (in[i]);
+        benchmark::DoNotOptimize (out.data ());
+        }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_AddScalarLoaded)->Arg (1 << 10)->Arg (1 << 16);
+
+static void BM_AddScalarLinked (benchmark::State &state)
+{
+    std::vector<int32_t> in = Inputs ((size_t)state.range (0));
+    std::vector<int32_t> out (in.size ());
+    size_t               i;
+
+    for (auto _ : state)
+        {
+        for (i = 0; i < in.size (); i++)
+            out[i] = add (in[i]);
+        benchmark::DoNotOptimize (out.data ());
+        }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_AddScalarLinked)->Arg (1 << 10)->Arg (1 << 16);
+
+static void BM_AddBatchLoaded (benchmark::State &state)
+{
+    std::vector<int32_t> in = Inputs ((size_t)state.range (0));
+    std::vector<int32_t> out (in.size ());
+    SeqStepFunc          func;
+    AddBatchFunc         batch;
+
+    LoadedAdd (&func, &batch);
+    if (!batch)
+        {
+        state.SkipWithError ("add module not found");
+        return;
+        }
+    for (auto _ : state)
+        {
+        batch (in.data (), out.data (), in.size ());
+        benchmark::DoNotOptimize (out.data ());
+        }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_AddBatchLoaded)->Arg (1 << 10)->Arg (1 << 16);
+
+static void BM_AddBatchLinked (benchmark::State &state)
+{
+    std::vector<int32_t> in = Inputs ((size_t)state.range (0));
+    std::vector<int32_t> out (in.size ());
+
+    for (auto _ : state)
+        {
+        add_batch (in.data (), out.data (), in.size ());
+        benchmark::DoNotOptimize (out.data ());
+        }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_AddBatchLinked)->Arg (1 << 10)->Arg (1 << 16);
+
+/*---------------------------------------------------------------------------*/
+/* The built-in add (builtin.h) through the entry points a bound step table  */
+/* holds.                                                                    */
+/*---------------------------------------------------------------------------*/
+static void BM_AddScalarBuiltin (benchmark::State &state)
+{
+    std::vector<int32_t>         in = Inputs ((size_t)state.range (0));
+    std::vector<int32_t>         out (in.size ());
+    const tms::BuiltinStepEntry *step = tms::FindBuiltinStep ("add", "add");
+    size_t                       i;
+
+    for (auto _ : state)
+        {
+        for (i = 0; i < in.size (); i++)
+            out[i] = step->func (in[i]);
+        benchmark::DoNotOptimize (out.data ());
+        }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_AddScalarBuiltin)->Arg (1 << 10)->Arg (1 << 16);
+
+static void BM_AddBatchBuiltin (benchmark::State &state)
+{
+    std::vector<int32_t>         in = Inputs ((size_t)state.range (0));
+    std::vector<int32_t>         out (in.size ());
+    const tms::BuiltinStepEntry *step = tms::FindBuiltinStep ("add", "add");
+
+    for (auto _ : state)
+        {
+        step->batch (in.data (), out.data (), in.size ());
+        benchmark::DoNotOptimize (out.data ());
+        }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_AddBatchBuiltin)->Arg (1 << 10)->Arg (1 << 16);
+
+/*---------------------------------------------------------------------------*/
+/* Window menu list: the registry behind it holds one entry per open file.   */
+/* Insert opens range(0) files, Lookup finds and raises one (what choosing   */
+/* a Window menu item does), Delete closes them all again.                   */
+/*---------------------------------------------------------------------------*/
+static std::vector<std::string> Paths (int count)
+{
+    std::vector<std::string> paths;
+    char                     path[64];
+    int                      i;
+
+    for (i = 0; i < count; i++)
+        {
+        sprintf (path, "C:\\Tests\\Station %d\\sequence%05d.seq", i % 7, i);
+        paths.push_back (path);
+        }
+    return paths;
+}
+
+static DocRegistry OpenAll (const std::vector<std::string> &paths)
+{
+    DocRegistry reg = DOC_New (5);
+    size_t      i;
+
+    for (i = 0; i < paths.size (); i++)
+        DOC_Open (reg, paths[i].c_str (), 0);
+    return reg;
+}
+
+static void BM_WindowListInsert (benchmark::State &state)
+{
+    std::vector<std::string> paths = Paths ((int)state.range (0));
+    DocRegistry              reg;
+    size_t                   i;
+
+    for (auto _ : state)
+        {
+        state.PauseTiming ();
+        reg = DOC_New (5);
+        state.ResumeTiming ();
+        for (i = 0; i < paths.size (); i++)
+            DOC_Open (reg, paths[i].c_str (), 0);
+        state.PauseTiming ();
+        DOC_Dispose (reg);
+        state.ResumeTiming ();
+        }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_WindowListInsert)->RangeMultiplier (10)->Range (10, 10000);
+
+static void BM_WindowListLookup (benchmark::State &state)
+{
+    std::vector<std::string> paths = Paths ((int)state.range (0));
+    DocRegistry              reg = OpenAll (paths);
+    size_t                   next = 0;
+
+    for (auto _ : state)
+        {
+        DOC_Activate (reg, DOC_FindPath (reg, paths[next].c_str ()));
+        next = (next + 7919) % paths.size ();
+        }
+    DOC_Dispose (reg);
+    state.SetItemsProcessed (state.iterations ());
+}
+BENCHMARK (BM_WindowListLookup)->RangeMultiplier (10)->Range (10, 10000);
+
+static void BM_WindowListDelete (benchmark::State &state)
+{
+    std::vector<std::string> paths = Paths ((int)state.range (0));
+    DocRegistry              reg;
+    size_t                   i;
+
+    for (auto _ : state)
+        {
+        state.PauseTiming ();
+        reg = OpenAll (paths);
+        state.ResumeTiming ();
+        for (i = 0; i < paths.size (); i++)
+            DOC_Close (reg, DOC_FindPath (reg, paths[i].c_str ()));
+        state.PauseTiming ();
+        DOC_Dispose (reg);
+        state.ResumeTiming ();
+        }
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_WindowListDelete)->RangeMultiplier (10)->Range (10, 10000);
+
+/*---------------------------------------------------------------------------*/
+/* File menu MRU list of range(0) entries, on the in-memory backend: adding  */
+/* a file moves it to the top, dropping the oldest once the list is full.    */
+/*---------------------------------------------------------------------------*/
+static void BM_RecentFileAdd (benchmark::State &state)
+{
+    std::vector<std::string> paths = Paths ((int)state.range (0) * 2);
+    const UiBackend         *ui = UI_MemBackend ();
+    size_t                   next = 0;
+
+    UI_MemReset (5, (int)state.range (0));
+    UI_MemSetRecording (0);
+    for (auto _ : state)
+        {
+        ui->addRecentFile (paths[next].c_str ());
+        next = (next + 7919) % paths.size ();
+        }
+    state.SetItemsProcessed (state.iterations ());
+}
+BENCHMARK (BM_RecentFileAdd)->RangeMultiplier (10)->Range (10, 10000);
+
+/*---------------------------------------------------------------------------*/
+/* Close All with range(0) documents open, on the in-memory backend with     */
+/* five Window and File menu items; "calls" is the backend calls it makes.   */
+/*---------------------------------------------------------------------------*/
+static void BM_CloseAll (benchmark::State &state)
+{
+    std::vector<std::string> paths = Paths ((int)state.range (0));
+    DocController            ctl;
+
+    UI_MemReset (5, 5);
+    UI_MemSetRecording (0);
+    ctl = DCT_New (UI_MemBackend (), 1, 5);
+    DCT_SetMaxRecentFiles (ctl, 5);
+    for (auto _ : state)
+        {
+        state.PauseTiming ();
+        DCT_BeginUpdate (ctl);
+        for (const std::string &path : paths)
+            DCT_OpenInBackground (ctl, path.c_str ());
+        DCT_EndUpdate (ctl);
+        UI_MemSetRecording (1);
+        state.ResumeTiming ();
+        DCT_CloseAll (ctl);
+        UI_MemSetRecording (0);
+        }
+    state.counters["calls"] = benchmark::Counter (
+        UI_MemNumCalls (), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+    DCT_Dispose (ctl);
+    UI_MemReset (5, 5);
+}
+BENCHMARK (BM_CloseAll)->RangeMultiplier (10)->Range (10, 1000);
+
+/*---------------------------------------------------------------------------*/
+/* Open and show range(0) documents, each with a panel of its own or, for    */
+/* range(1) 1, as tabs of one panel; "panels" is how many that leaves.       */
+/*---------------------------------------------------------------------------*/
+static void BM_OpenShown (benchmark::State &state)
+{
+    std::vector<std::string> paths = Paths ((int)state.range (0));
+    DocController            ctl;
+    int                      numPanels = 0;
+
+    UI_MemReset (5, 5);
+    UI_MemSetRecording (0);
+    ctl = DCT_New (UI_MemBackend (), 1, 5);
+    DCT_SetMaxRecentFiles (ctl, 5);
+    DCT_SetTabbed (ctl, (int)state.range (1));
+    for (auto _ : state)
+        {
+        UI_MemSetRecording (1);
+        for (const std::string &path : paths)
+            DCT_Open (ctl, path.c_str ());
+        UI_MemSetRecording (0);
+        state.PauseTiming ();
+        numPanels = UI_MemNumPanels ();
+        DCT_CloseAll (ctl);
+        state.ResumeTiming ();
+        }
+    state.counters["calls"] = benchmark::Counter (
+        UI_MemNumCalls (), benchmark::Counter::kAvgIterations);
+    state.counters["panels"] = numPanels;
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+    DCT_Dispose (ctl);
+    UI_MemReset (5, 5);
+}
+BENCHMARK (BM_OpenShown)->ArgsProduct ({{10, 100, 1000}, {0, 1}});
+
+/*---------------------------------------------------------------------------*/
+/* Scroll the step list of a document of range(0) steps; "calls" per scroll  */
+/* stays at one screenful however long the sequence.                         */
+/*---------------------------------------------------------------------------*/
+static void BM_ScrollSteps (benchmark::State &state)
+{
+    int           numSteps = (int)state.range (0);
+    DocController ctl;
+    int           panel;
+    int           i = 0;
+
+    UI_MemReset (5, 5);
+    UI_MemSetRecording (0);
+    ctl = DCT_New (UI_MemBackend (), 1, 5);
+    panel = DCT_Open (ctl, "C:\\Tests\\scroll.seq");
+    if (panel <= 0 || DCT_AddSteps (ctl, numSteps, TMSBENCH_ADD_MODULE,
+                                    "add") < 0)
+        state.SkipWithError ("DCT_AddSteps failed");
+    UI_MemSetRecording (1);
+    for (auto _ : state)
+        DCT_ScrollSteps (ctl, panel, (int)(i++ * 7919LL % numSteps));
+    UI_MemSetRecording (0);
+    state.counters["calls"] = benchmark::Counter (
+        UI_MemNumCalls (), benchmark::Counter::kAvgIterations);
+    DCT_Dispose (ctl);
+    UI_MemReset (5, 5);
+}
+BENCHMARK (BM_ScrollSteps)->RangeMultiplier (100)->Range (100, 1000000);
+
+/*---------------------------------------------------------------------------*/
+/* Sequences of range(0) numeric limit steps on add, saved once per size.    */
+/*---------------------------------------------------------------------------*/
+static Sequence AddSteps (int numSteps, int numGroups,
+                          const char *module = TMSBENCH_ADD_MODULE)
+{
+    Sequence seq = SEQ_New ();
+    char     name[32];
+    int      i;
+    int      step;
+
+    SEQ_Reserve (seq, numSteps);
+    for (i = 0; i < numSteps; i++)
+        {
+        sprintf (name, "add %d", i);
+        step = SEQ_AddStep (seq, name, SEQ_KIND_NUMERIC_LIMIT, 0, i, i + 1,
+                            i + 1, (int)((long long)i * numGroups / numSteps));
+        SEQ_SetStepSymbol (seq, step, module, "add");
+        }
+    return seq;
+}
+
+static std::string SavedSequence (int numSteps, bool text)
+{
+    std::string path = "tmsbench." + std::to_string (numSteps)
+                       + (text ? ".txt" : ".seq");
+    Sequence    seq = AddSteps (numSteps, 1);
+
+    if (text)
+        SEQ_ExportText (seq, path.c_str ());
+    else
+        SEQ_Save (seq, path.c_str ());
+    SEQ_Dispose (seq);
+    return path;
+}
+
+static void BM_SequenceLoad (benchmark::State &state)
+{
+    std::string path = SavedSequence ((int)state.range (0), false);
+    Sequence    seq;
+
+    for (auto _ : state)
+        {
+        if (!(seq = SEQ_Load (path.c_str ())))
+            {
+            state.SkipWithError ("SEQ_Load failed");
+            break;
+            }
+        SEQ_Dispose (seq);
+        }
+    remove (path.c_str ());
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_SequenceLoad)->RangeMultiplier (10)->Range (100, 100000)
+    ->Unit (benchmark::kMicrosecond);
+
+static void BM_SequenceImportText (benchmark::State &state)
+{
+    std::string path = SavedSequence ((int)state.range (0), true);
+    Sequence    seq;
+
+    for (auto _ : state)
+        {
+        if (!(seq = SEQ_ImportText (path.c_str ())))
+            {
+            state.SkipWithError ("SEQ_ImportText failed");
+            break;
+            }
+        SEQ_Dispose (seq);
+        }
+    remove (path.c_str ());
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_SequenceImportText)->RangeMultiplier (10)->Range (100, 100000)
+    ->Unit (benchmark::kMicrosecond);
+
+/*---------------------------------------------------------------------------*/
+/* Opening a session store left with range(0) documents open: range(1) 0     */
+/* waits for the state (SES_New), 1 only until SES_Open returns, which is    */
+/* how long startup waits for it.                                            */
+/*---------------------------------------------------------------------------*/
+static void BM_SessionOpen (benchmark::State &state)
+{
+    std::vector<std::string> paths = Paths ((int)state.range (0));
+    const char              *path = "tmsbench.session";
+    SessionLog               session = SES_New (path, 5);
+    size_t                   i;
+
+    for (i = 0; i < paths.size (); i++)
+        SES_Opened (session, paths[i].c_str ());
+    SES_Dispose (session);
+    for (auto _ : state)
+        {
+        session = state.range (1) ? SES_Open (path, 5, 0, 0)
+                                  : SES_New (path, 5);
+        state.PauseTiming ();
+        if (!session || SES_NumOpen (session) != (int)paths.size ())
+            state.SkipWithError ("cannot restore the session");
+        SES_Dispose (session);
+        state.ResumeTiming ();
+        }
+    remove (path);
+    remove ((std::string (path) + ".bin").c_str ());
+    remove ((std::string (path) + ".log").c_str ());
+}
+BENCHMARK (BM_SessionOpen)->ArgsProduct ({{10, 1000, 100000}, {0, 1}})
+    ->Unit (benchmark::kMicrosecond)->UseRealTime ();
+
+/*---------------------------------------------------------------------------*/
+/* Edit > Find over 100k steps named "add <n>": a query matching one step    */
+/* name, one matching the name of every step, and one matching nothing.      */
+/*---------------------------------------------------------------------------*/
+static void BM_Find (benchmark::State &state)
+{
+    static const char *const queries[] = { "add 12345", "ADD", "sub" };
+    Sequence                 seq = AddSteps (100000, 1);
+    FindIndex                index = FND_New (seq);
+    FndMatch                 matches[16];
+    int                      numMatches = 0;
+
+    for (auto _ : state)
+        {
+        numMatches = FND_Find (index, queries[state.range (0)],
+                               FND_FIELD_ALL, matches, 16);
+        benchmark::DoNotOptimize (numMatches);
+        }
+    state.counters["matches"] = numMatches;
+    FND_Dispose (index);
+    SEQ_Dispose (seq);
+}
+BENCHMARK (BM_Find)->DenseRange (0, 2)->Unit (benchmark::kMicrosecond);
+
+/*---------------------------------------------------------------------------*/
+/* Run > All over range(1) steps in 4 groups on a pool of range(0) threads.  */
+/*---------------------------------------------------------------------------*/
+static void BM_RunAll (benchmark::State &state)
+{
+    PluginLoader loader;
+    SeqStepFunc  func;
+    AddBatchFunc batch;
+    Sequence     seq = AddSteps ((int)state.range (1), 4);
+    Execution    exec = EXE_New ();
+
+    loader = LoadedAdd (&func, &batch);
+    if (PLG_BindSequence (loader, seq) != 0
+        || EXE_SetNumThreads (exec, (int)state.range (0)) < 0
+        || EXE_Load (exec, seq) < 0)
+        state.SkipWithError ("cannot set up the sequence");
+    else
+        for (auto _ : state)
+            {
+            EXE_RunAll (exec, 0, 0);
+            EXE_Wait (exec);
+            }
+    EXE_Dispose (exec);
+    SEQ_Dispose (seq);
+    state.SetItemsProcessed (state.iterations () * state.range (1));
+}
+BENCHMARK (BM_RunAll)->ArgsProduct ({{1, 2, 4, 8}, {10000, 1000000}})
+    ->Unit (benchmark::kMillisecond)->UseRealTime ();
+
+/*---------------------------------------------------------------------------*/
+/* Run > All over 1000000 steps in 4 groups on 4 threads, with no monitor    */
+/* (range(0) 0), one sampling the progress 60 times a second (1), or a       */
+/* thread reading it as fast as it can (2); "samples" is how many it read.   */
+/*---------------------------------------------------------------------------*/
+static void BM_RunAllMonitored (benchmark::State &state)
+{
+    PluginLoader      loader;
+    SeqStepFunc       func;
+    AddBatchFunc      batch;
+    Sequence          seq = AddSteps (1000000, 4);
+    Execution         exec = EXE_New ();
+    std::atomic<bool> stop (false);
+    std::atomic<long> numSamples (0);
+    std::thread       monitor;
+
+    loader = LoadedAdd (&func, &batch);
+    if (PLG_BindSequence (loader, seq) != 0
+        || EXE_SetNumThreads (exec, 4) < 0 || EXE_Load (exec, seq) < 0)
+        state.SkipWithError ("cannot set up the sequence");
+    else
+        {
+        if (state.range (0))
+            monitor = std::thread ([&] ()
+                {
+                ExeProgress progress;
+
+                while (!stop.load (std::memory_order_relaxed))
+                    {
+                    EXE_GetProgress (exec, &progress);
+                    benchmark::DoNotOptimize (progress);
+                    numSamples.fetch_add (1, std::memory_order_relaxed);
+                    if (state.range (0) == 1)
+                        std::this_thread::sleep_for (
+                            std::chrono::microseconds (16667));
+                    }
+                });
+        for (auto _ : state)
+            {
+            EXE_RunAll (exec, 0, 0);
+            EXE_Wait (exec);
+            }
+        stop.store (true);
+        if (monitor.joinable ())
+            monitor.join ();
+        }
+    state.counters["samples"] = benchmark::Counter (
+        (double)numSamples.load (), benchmark::Counter::kAvgIterations);
+    EXE_Dispose (exec);
+    SEQ_Dispose (seq);
+    state.SetItemsProcessed (state.iterations () * 1000000);
+}
+BENCHMARK (BM_RunAllMonitored)->DenseRange (0, 2)
+    ->Unit (benchmark::kMillisecond)->UseRealTime ();
+
+/*---------------------------------------------------------------------------*/
+/* Sequence > Sweep of 6 add steps over 10 values each (10^6 points) on a    */
+/* pool of range(0) threads, calling the loaded module's add (range(1) 0)    */
+/* or the built-in one (1).                                                  */
+/*---------------------------------------------------------------------------*/
+static void BM_Sweep (benchmark::State &state)
+{
+    PluginLoader loader;
+    SeqStepFunc  func;
+    AddBatchFunc batch;
+    Sequence     seq = AddSteps (6, 1, state.range (1) ? "add"
+                                                       : TMSBENCH_ADD_MODULE);
+    Execution    exec = EXE_New ();
+    ParamSweep   sweep = SWP_New (SWP_MODE_CARTESIAN);
+    int          i;
+
+    for (i = 0; i < 6; i++)
+        SWP_AddParam (sweep, i, 0, 9, 1);
+    loader = LoadedAdd (&func, &batch);
+    if (PLG_BindSequence (loader, seq) != 0
+        || EXE_SetNumThreads (exec, (int)state.range (0)) < 0
+        || EXE_Load (exec, seq) < 0)
+        state.SkipWithError ("cannot set up the sequence");
+    else
+        for (auto _ : state)
+            {
+            EXE_RunSweep (exec, sweep, 0, 0);
+            EXE_Wait (exec);
+            }
+    EXE_Dispose (exec);
+    SWP_Dispose (sweep);
+    SEQ_Dispose (seq);
+    state.SetItemsProcessed (state.iterations () * 1000000);
+}
+BENCHMARK (BM_Sweep)->ArgsProduct ({{1, 2, 4, 8}, {0, 1}})
+    ->Unit (benchmark::kMillisecond)->UseRealTime ();
+
+/*---------------------------------------------------------------------------*/
+/* Run > All over range(0) async tms.wait steps of 10 ms each on one thread: */
+/* the waits overlap, so the run takes about 10 ms however many there are.   */
+/*---------------------------------------------------------------------------*/
+static void BM_AsyncWait (benchmark::State &state)
+{
+    PluginLoader loader = PLG_New ();
+    Sequence     seq = SEQ_New ();
+    Execution    exec = EXE_New ();
+    int          i;
+
+    for (i = 0; i < state.range (0); i++)
+        SEQ_SetStepSymbol (seq, SEQ_AddStep (seq, "wait", SEQ_KIND_ACTION,
+                                             0, 10, 0, 0, 0),
+                           "tms", "wait");
+    if (PLG_BindSequence (loader, seq) != 0
+        || EXE_SetNumThreads (exec, 1) < 0 || EXE_Load (exec, seq) < 0)
+        state.SkipWithError ("cannot set up the sequence");
+    else
+        for (auto _ : state)
+            {
+            EXE_RunAll (exec, 0, 0);
+            EXE_Wait (exec);
+            }
+    EXE_Dispose (exec);
+    SEQ_Dispose (seq);
+    PLG_Dispose (loader);
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_AsyncWait)->Arg (1)->Arg (100)->Arg (10000)
+    ->Unit (benchmark::kMillisecond)->UseRealTime ();
+
+#ifdef TMSBENCH_HOST
+
+/*---------------------------------------------------------------------------*/
+/* Calls to add through the step host, range(0) per round trip.              */
+/*---------------------------------------------------------------------------*/
+static void BM_HostCall (benchmark::State &state)
+{
+    StepHost             host = HST_New (TMSBENCH_HOST);
+    std::vector<HstCall> calls ((size_t)state.range (0));
+    int                  slot;
+    size_t               i;
+
+    if (!host
+        || (slot = HST_Bind (host, TMSBENCH_ADD_MODULE, "add")) < 0)
+        state.SkipWithError ("cannot start the step host");
+    else
+        {
+        for (i = 0; i < calls.size (); i++)
+            {
+            calls[i].slot = slot;
+            calls[i].socket = -1;
+            calls[i].x = (int32_t)i;
+            }
+        for (auto _ : state)
+            HST_Call (host, calls.data (), (int)calls.size ());
+        }
+    HST_Dispose (host);
+    state.SetItemsProcessed (state.iterations () * state.range (0));
+}
+BENCHMARK (BM_HostCall)->Arg (1)->Arg (16)->Arg (256);
+
+#endif
+
+BENCHMARK_MAIN ();
@@ -0,0 +1,24 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    tmshost.cpp                                                      */
+/*                                                                           */
+/* PURPOSE: Out-of-process step host (see stephost.h).  Started by the       */
+/*          application, which passes the descriptor of the channel it       */
+/*          shares with the host; not meant to be run by hand.               */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stephost.h"
+
+int main (int argc, char *argv[])
+{
+    if (argc != 2)
+        {
+        fprintf (stderr, "usage: tmshost <channel descriptor>\n");
+        return 2;
+        }
+    return HST_Serve (atoi (argv[1])) < 0 ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    tmsstep.h                                                        */
+/*                                                                           */
+/* PURPOSE: Portable export macros for test step modules such as add.dll.    */
+/*          The same module source builds as a Windows DLL or a Linux .so    */
+/*          and can be linked at build time or loaded at run time by the     */
+/*          plugin loader (plugin.h).                                        */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __TMSSTEP_H__
+#define __TMSSTEP_H__
+
+#include "tmsapi.h"
+
+#if defined(_WIN32)
+  #define TMS_STEP_EXPORT __declspec(dllexport)
+  #define TMS_STEP_IMPORT __declspec(dllimport)
+#else
+  #define TMS_STEP_EXPORT __attribute__((visibility("default")))
+  #define TMS_STEP_IMPORT
+#endif
+
+/* Suffix the plugin loader appends to a step's symbol to find its batch */
+/* entry point, e.g. add -> add_batch.                                   */
+#define TMS_STEP_BATCH_SUFFIX "_batch"
+
+/* Suffix of a step's per-socket entry point, int f (int socket, int x),   */
+/* which a test socket calls instead so the step can address its own unit */
+/* under test, e.g. add -> add_socket.                                     */
+#define TMS_STEP_SOCKET_SUFFIX "_socket"
+
+#endif /* __TMSSTEP_H__ */
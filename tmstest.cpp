@@ -0,0 +1,1207 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    tmstest.cpp                                                      */
+/*                                                                           */
+/* PURPOSE: Unit tests for the document logic, run headless against the      */
+/*          in-memory UI backend (uimem.h), for sequence files, for          */
+/*          recovering the session store after a crash, and for the undo     */
+/*          history, Find and Replace, and parameter sweeps.  With a test    */
+/*          name, runs that test alone; with none, runs them all.  Exits     */
+/*          non-zero if any check fails.  ctest runs each test by name:      */
+/*                                                                           */
+/*            tmstest zorder                                                 */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "docctl.h"
+#include "docreg.h"
+#include "findidx.h"
+#include "seqtable.h"
+#include "sequence.h"
+#include "session.h"
+#include "sweep.h"
+#include "undo.h"
+#include "uimem.h"
+
+static int g_numFailed;
+
+#define CHECK(cond) Check ((cond) != 0, #cond, __FILE__, __LINE__)
+
+static void Check (bool passed, const char *text, const char *file, int line)
+{
+    if (passed)
+        return;
+    fprintf (stderr, "%s:%d: CHECK (%s) failed\n", file, line, text);
+    g_numFailed++;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The z-order, top first, as a string of the documents' first letters.      */
+/*---------------------------------------------------------------------------*/
+static const char *ZOrder (DocRegistry reg)
+{
+    static char order[64];
+    DocHandle   doc;
+    int         n = 0;
+
+    for (doc = DOC_GetTop (reg); doc && n < 63; doc = DOC_GetBelow (reg, doc))
+        order[n++] = DOC_GetPath (reg, doc)[0];
+    order[n] = '\0';
+    return order;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Opening puts a document on top, activating raises it, and closing one     */
+/* (the top one or any other) leaves the rest in order.                      */
+/*---------------------------------------------------------------------------*/
+static void TestZOrder (void)
+{
+    DocRegistry reg = DOC_New (3);
+    DocHandle   a = DOC_Open (reg, "a.seq", 11);
+    DocHandle   b = DOC_Open (reg, "b.seq", 12);
+    DocHandle   c = DOC_Open (reg, "c.seq", 13);
+    DocHandle   d;
+
+    CHECK (a > 0 && b > 0 && c > 0);
+    CHECK (DOC_GetTop (reg) == c);
+    CHECK (strcmp (ZOrder (reg), "cba") == 0);
+
+    CHECK (DOC_Activate (reg, a) == TMS_OK);
+    CHECK (DOC_GetTop (reg) == a);
+    CHECK (strcmp (ZOrder (reg), "acb") == 0);
+    CHECK (DOC_Activate (reg, a) == TMS_OK);
+    CHECK (strcmp (ZOrder (reg), "acb") == 0);
+    CHECK (DOC_Activate (reg, b) == TMS_OK);
+    CHECK (strcmp (ZOrder (reg), "bac") == 0);
+    CHECK (DOC_FindPanel (reg, 12) == DOC_GetTop (reg));
+
+    /* Closing the top document brings the one below it up */
+    CHECK (DOC_Close (reg, b) == TMS_OK);
+    CHECK (DOC_GetTop (reg) == a);
+    CHECK (strcmp (ZOrder (reg), "ac") == 0);
+
+    /* A closed document's handle is dead, even once its slot is reused */
+    d = DOC_Open (reg, "d.seq", 14);
+    CHECK (d > 0 && d != b);
+    CHECK (DOC_Activate (reg, b) == TMS_ERR_NOT_FOUND);
+    CHECK (DOC_GetBelow (reg, b) == 0);
+    CHECK (strcmp (ZOrder (reg), "dac") == 0);
+
+    /* Closing one in the middle or at the bottom */
+    CHECK (DOC_Close (reg, a) == TMS_OK);
+    CHECK (strcmp (ZOrder (reg), "dc") == 0);
+    CHECK (DOC_Close (reg, c) == TMS_OK);
+    CHECK (strcmp (ZOrder (reg), "d") == 0);
+    CHECK (DOC_Close (reg, d) == TMS_OK);
+    CHECK (DOC_GetTop (reg) == 0);
+    CHECK (DOC_Activate (reg, 0) == TMS_ERR_NOT_FOUND);
+    DOC_Dispose (reg);
+}
+
+/*---------------------------------------------------------------------------*/
+/* The Window menu mirror holds the newest documents, newest first.          */
+/* Raising a document does not reorder it; closing or renaming one does.     */
+/*---------------------------------------------------------------------------*/
+static void TestWindowMirror (void)
+{
+    DocRegistry reg = DOC_New (3);
+    DocHandle   a = DOC_Open (reg, "a.seq", 0);
+    DocHandle   b = DOC_Open (reg, "b.seq", 0);
+    DocHandle   c = DOC_Open (reg, "c.seq", 0);
+    DocHandle   d = DOC_Open (reg, "d.seq", 0);
+
+    CHECK (DOC_GetMirrorItem (reg, 1) == d);
+    CHECK (DOC_GetMirrorItem (reg, 2) == c);
+    CHECK (DOC_GetMirrorItem (reg, 3) == b);
+    CHECK (DOC_GetMirrorItem (reg, 4) == 0);
+    CHECK (DOC_GetMirrorIndex (reg, a) == 0);
+
+    DOC_Activate (reg, b);
+    CHECK (DOC_GetMirrorIndex (reg, b) == 3);
+    CHECK (DOC_GetMirrorIndex (reg, d) == 1);
+
+    CHECK (DOC_Close (reg, c) == TMS_OK);
+    CHECK (DOC_GetMirrorItem (reg, 1) == d);
+    CHECK (DOC_GetMirrorItem (reg, 2) == b);
+    CHECK (DOC_GetMirrorItem (reg, 3) == 0);
+
+    CHECK (DOC_Rename (reg, b, "e.seq") == TMS_OK);
+    CHECK (DOC_GetMirrorItem (reg, 1) == b);
+    CHECK (DOC_GetMirrorItem (reg, 2) == d);
+    DOC_Dispose (reg);
+}
+
+/*---------------------------------------------------------------------------*/
+/* The controller finds the top document through the registry: File >        */
+/* Close closes it, the one below comes up, and the Window menu follows.     */
+/*---------------------------------------------------------------------------*/
+static void TestCloseTop (void)
+{
+    DocController ctl;
+    DocRegistry   reg;
+    int           a;
+    int           b;
+    int           c;
+
+    UI_MemReset (3, 5);
+    ctl = DCT_New (UI_MemBackend (), 1, 3);
+    reg = DCT_GetRegistry (ctl);
+    a = DCT_Open (ctl, "a.seq");
+    b = DCT_Open (ctl, "b.seq");
+    c = DCT_Open (ctl, "c.seq");
+    CHECK (a > 0 && b > 0 && c > 0);
+    CHECK (DCT_GetTopPanel (ctl) == c);
+
+    CHECK (DCT_Activate (ctl, a) == TMS_OK);
+    CHECK (DCT_GetTopPanel (ctl) == a);
+    CHECK (strcmp (DCT_GetTopPath (ctl), "a.seq") == 0);
+
+    CHECK (DCT_Close (ctl) == TMS_OK);
+    CHECK (DCT_NumDocuments (ctl) == 2);
+    CHECK (DCT_GetTopPanel (ctl) == c);
+    CHECK (DOC_FindPanel (reg, a) == 0);
+    CHECK (UI_MemNumWindowItems () == 2);
+    CHECK (UI_MemGetWindowItem (1) == (void *)(size_t)DOC_FindPanel (reg, c));
+    CHECK (UI_MemGetWindowItem (2) == (void *)(size_t)DOC_FindPanel (reg, b));
+
+    CHECK (DCT_Close (ctl) == TMS_OK);
+    CHECK (DCT_GetTopPanel (ctl) == b);
+    CHECK (DCT_Close (ctl) == TMS_OK);
+    CHECK (DCT_GetTopPanel (ctl) <= 0);
+    CHECK (DCT_Close (ctl) == TMS_ERR_NOT_FOUND);
+    CHECK (UI_MemNumWindowItems () == 0);
+    CHECK (UI_MemIsCommandDimmed (UI_CMD_CLOSE));
+    DCT_Dispose (ctl);
+    UI_MemReset (3, 5);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Window menu item i (1-based) of the in-memory backend, as a path.         */
+/*---------------------------------------------------------------------------*/
+static const char *WindowItem (DocController ctl, int item)
+{
+    DocHandle doc = (DocHandle)(size_t)UI_MemGetWindowItem (item);
+
+    return doc ? DOC_GetPath (DCT_GetRegistry (ctl), doc) : "";
+}
+
+/*---------------------------------------------------------------------------*/
+/* File > Open: a shown panel with the path in its title, a Window menu      */
+/* item, and the File and Window commands no longer dimmed.                  */
+/*---------------------------------------------------------------------------*/
+static void TestOpen (void)
+{
+    DocController ctl;
+    int           a;
+    int           b;
+
+    UI_MemReset (3, 4);
+    ctl = DCT_New (UI_MemBackend (), 1, 3);
+    CHECK (UI_MemIsCommandDimmed (UI_CMD_SAVE));
+    CHECK (UI_MemIsCommandDimmed (UI_CMD_CLOSEALL));
+
+    a = DCT_Open (ctl, "a.seq");
+    CHECK (a > 0);
+    CHECK (UI_MemNumPanels () == 1);
+    CHECK (UI_MemIsPanelVisible (a) == 1);
+    CHECK (strcmp (UI_MemGetPanelPath (a), "a.seq") == 0);
+    CHECK (UI_MemNumWindowItems () == 1);
+    CHECK (strcmp (WindowItem (ctl, 1), "a.seq") == 0);
+    CHECK (!UI_MemIsCommandDimmed (UI_CMD_SAVE));
+    CHECK (!UI_MemIsCommandDimmed (UI_CMD_CLOSE));
+    CHECK (!UI_MemIsCommandDimmed (UI_CMD_CLOSEALL));
+    CHECK (UI_MemIsCommandDimmed (UI_CMD_UNDO));
+
+    /* Opening it again is refused, and changes nothing */
+    CHECK (DCT_Open (ctl, "a.seq") == TMS_ERR_EXISTS);
+    CHECK (DCT_NumDocuments (ctl) == 1);
+    CHECK (UI_MemNumPanels () == 1);
+
+    b = DCT_Open (ctl, "b.seq");
+    CHECK (b > 0 && b != a);
+    CHECK (DCT_GetTopPanel (ctl) == b);
+    CHECK (strcmp (DCT_GetTopPath (ctl), "b.seq") == 0);
+    CHECK (UI_MemNumRecentFiles () == 0);
+    DCT_Dispose (ctl);
+    UI_MemReset (3, 4);
+}
+
+/*---------------------------------------------------------------------------*/
+/* File > Close: the top document's panel is discarded, its path goes to the */
+/* top of the recent files, and its Window menu item is deleted.  The last   */
+/* close dims the commands again.                                            */
+/*---------------------------------------------------------------------------*/
+static void TestClose (void)
+{
+    DocController ctl;
+    int           a;
+    int           b;
+
+    UI_MemReset (3, 4);
+    ctl = DCT_New (UI_MemBackend (), 1, 3);
+    DCT_SetMaxRecentFiles (ctl, 4);
+    a = DCT_Open (ctl, "a.seq");
+    b = DCT_Open (ctl, "b.seq");
+
+    CHECK (DCT_Close (ctl) == TMS_OK);
+    CHECK (UI_MemNumPanels () == 1);
+    CHECK (UI_MemIsPanelVisible (b) < 0);
+    CHECK (UI_MemIsPanelVisible (a) == 1);
+    CHECK (DCT_GetTopPanel (ctl) == a);
+    CHECK (UI_MemNumRecentFiles () == 1);
+    CHECK (strcmp (UI_MemGetRecentFile (1), "b.seq") == 0);
+    CHECK (UI_MemNumWindowItems () == 1);
+    CHECK (strcmp (WindowItem (ctl, 1), "a.seq") == 0);
+
+    CHECK (DCT_Close (ctl) == TMS_OK);
+    CHECK (UI_MemNumPanels () == 0);
+    CHECK (strcmp (UI_MemGetRecentFile (1), "a.seq") == 0);
+    CHECK (strcmp (UI_MemGetRecentFile (2), "b.seq") == 0);
+    CHECK (UI_MemNumWindowItems () == 0);
+    CHECK (UI_MemIsCommandDimmed (UI_CMD_SAVE));
+    CHECK (UI_MemIsCommandDimmed (UI_CMD_CLOSE));
+    CHECK (DCT_Close (ctl) == TMS_ERR_NOT_FOUND);
+
+    /* The recent files keep the newest four */
+    DCT_Open (ctl, "c.seq");
+    DCT_Open (ctl, "d.seq");
+    DCT_Open (ctl, "e.seq");
+    CHECK (DCT_CloseAll (ctl) == 3);
+    CHECK (UI_MemNumRecentFiles () == 4);
+    CHECK (strcmp (UI_MemGetRecentFile (1), "c.seq") == 0);
+    CHECK (strcmp (UI_MemGetRecentFile (4), "a.seq") == 0);
+    CHECK (DCT_NumDocuments (ctl) == 0);
+    DCT_Dispose (ctl);
+    UI_MemReset (3, 4);
+}
+
+/*---------------------------------------------------------------------------*/
+/* A panel coming to the front, or a Window menu item chosen, raises its     */
+/* document without reordering the Window menu.                              */
+/*---------------------------------------------------------------------------*/
+static void TestActivate (void)
+{
+    DocController ctl;
+    int           a;
+    int           b;
+    int           c;
+
+    UI_MemReset (3, 4);
+    ctl = DCT_New (UI_MemBackend (), 1, 3);
+    a = DCT_Open (ctl, "a.seq");
+    b = DCT_Open (ctl, "b.seq");
+    c = DCT_Open (ctl, "c.seq");
+
+    CHECK (DCT_Activate (ctl, a) == TMS_OK);
+    CHECK (DCT_GetTopPanel (ctl) == a);
+    CHECK (strcmp (WindowItem (ctl, 1), "c.seq") == 0);
+    CHECK (strcmp (WindowItem (ctl, 3), "a.seq") == 0);
+
+    /* A panel that is not a document's changes nothing */
+    CHECK (DCT_Activate (ctl, a + b + c) == TMS_ERR_NOT_FOUND);
+    CHECK (DCT_GetTopPanel (ctl) == a);
+
+    /* Window > b.seq */
+    CHECK (strcmp (WindowItem (ctl, 2), "b.seq") == 0);
+    CHECK (DCT_ShowDocument (ctl, (DocHandle)(size_t)UI_MemGetWindowItem (2))
+           >= 0);
+    CHECK (DCT_GetTopPanel (ctl) == b);
+    CHECK (UI_MemIsPanelVisible (b) == 1);
+    CHECK (strcmp (WindowItem (ctl, 2), "b.seq") == 0);
+
+    /* Closing now closes b.seq, and a.seq comes back up */
+    CHECK (DCT_Close (ctl) == TMS_OK);
+    CHECK (DCT_GetTopPanel (ctl) == a);
+    DCT_Dispose (ctl);
+    UI_MemReset (3, 4);
+}
+
+/*---------------------------------------------------------------------------*/
+/* The Window menu lists the newest documents, newest first.  A closed       */
+/* document's item goes without an older one taking its place; a document    */
+/* opened in the background is listed like any other.                        */
+/*---------------------------------------------------------------------------*/
+static void TestWindowMenu (void)
+{
+    DocController ctl;
+
+    UI_MemReset (3, 4);
+    ctl = DCT_New (UI_MemBackend (), 1, 3);
+    DCT_Open (ctl, "a.seq");
+    DCT_Open (ctl, "b.seq");
+    DCT_Open (ctl, "c.seq");
+    DCT_Open (ctl, "d.seq");
+    CHECK (UI_MemNumWindowItems () == 3);
+    CHECK (strcmp (WindowItem (ctl, 1), "d.seq") == 0);
+    CHECK (strcmp (WindowItem (ctl, 2), "c.seq") == 0);
+    CHECK (strcmp (WindowItem (ctl, 3), "b.seq") == 0);
+
+    CHECK (DCT_Activate (ctl, DOC_GetPanel (DCT_GetRegistry (ctl),
+                                            DOC_FindPath (DCT_GetRegistry (
+                                                              ctl),
+                                                          "c.seq")))
+           == TMS_OK);
+    CHECK (DCT_Close (ctl) == TMS_OK);
+    CHECK (UI_MemNumWindowItems () == 2);
+    CHECK (strcmp (WindowItem (ctl, 1), "d.seq") == 0);
+    CHECK (strcmp (WindowItem (ctl, 2), "b.seq") == 0);
+
+    CHECK (DCT_OpenInBackground (ctl, "e.seq") > 0);
+    CHECK (UI_MemNumWindowItems () == 3);
+    CHECK (strcmp (WindowItem (ctl, 1), "e.seq") == 0);
+    CHECK (strcmp (WindowItem (ctl, 2), "d.seq") == 0);
+    CHECK (strcmp (WindowItem (ctl, 3), "b.seq") == 0);
+    CHECK (strcmp (DCT_GetTopPath (ctl), "d.seq") == 0);
+
+    CHECK (DCT_CloseAll (ctl) == 4);
+    CHECK (UI_MemNumWindowItems () == 0);
+    DCT_Dispose (ctl);
+    UI_MemReset (3, 4);
+}
+
+/*---------------------------------------------------------------------------*/
+/* A sequence with one step of each kind, odd names and a bound symbol.      */
+/*---------------------------------------------------------------------------*/
+static Sequence MakeSequence (const char *oddName)
+{
+    static const int32_t inputs[] = { 4, -7, 2147483647 };
+    Sequence seq = SEQ_New ();
+
+    CHECK (SEQ_AddStep (seq, "setup", SEQ_KIND_ACTION, 0, 3, 0, 0, 0) == 0);
+    CHECK (SEQ_AddStep (seq, oddName, SEQ_KIND_NUMERIC_LIMIT, 0, -5, -10,
+                        20, 1) == 1);
+    CHECK (SEQ_AddSweepStep (seq, "sweep", 0, 0, inputs, 3, 0, 5, 1) == 2);
+    CHECK (SEQ_AddStep (seq, "", SEQ_KIND_ACTION, 0, 0, 0, 0, 4) == 3);
+    CHECK (SEQ_SetStepSymbol (seq, 0, "C:\\steps\\io.dll", "Open\tPort")
+           == TMS_OK);
+    CHECK (SEQ_SetStepSymbol (seq, 3, "io", oddName) == TMS_OK);
+    return seq;
+}
+
+/*---------------------------------------------------------------------------*/
+/* True if every column of a and b holds the same values.                    */
+/*---------------------------------------------------------------------------*/
+static bool SameSequence (Sequence a, Sequence b)
+{
+    int step;
+
+    if (SEQ_NumSteps (a) != SEQ_NumSteps (b)
+        || SEQ_NumGroups (a) != SEQ_NumGroups (b))
+        return false;
+    for (step = 0; step < SEQ_NumSteps (a); step++)
+        {
+        const int32_t *inputsA, *inputsB;
+        const char    *moduleA, *symbolA, *moduleB, *symbolB;
+        int            numInputs = SEQ_GetStepInputs (a, step, &inputsA);
+        int            bound = SEQ_GetStepSymbol (a, step, &moduleA,
+                                                  &symbolA);
+
+        if (a->kind[step] != b->kind[step]
+            || a->lowLimit[step] != b->lowLimit[step]
+            || a->highLimit[step] != b->highLimit[step]
+            || a->group[step] != b->group[step]
+            || SEQ_GetStepParam (a, step) != SEQ_GetStepParam (b, step)
+            || strcmp (SEQ_GetStepName (a, step),
+                       SEQ_GetStepName (b, step)) != 0
+            || SEQ_GetStepInputs (b, step, &inputsB) != numInputs
+            || (numInputs > 0
+                && memcmp (inputsA, inputsB,
+                           numInputs * sizeof (int32_t)) != 0)
+            || SEQ_GetStepSymbol (b, step, &moduleB, &symbolB) != bound)
+            return false;
+        if (bound == TMS_OK
+            && (strcmp (moduleA, moduleB) != 0
+                || strcmp (symbolA, symbolB) != 0))
+            return false;
+        }
+    return true;
+}
+
+static std::string ReadFile (const char *path)
+{
+    std::string data;
+    FILE       *file = fopen (path, "rb");
+    char        buffer[4096];
+    size_t      n;
+
+    if (!file)
+        return data;
+    while ((n = fread (buffer, 1, sizeof (buffer), file)) > 0)
+        data.append (buffer, n);
+    fclose (file);
+    return data;
+}
+
+static void WriteFile (const char *path, const std::string &data)
+{
+    FILE *file = fopen (path, "wb");
+
+    if (!file)
+        return;
+    fwrite (data.data (), 1, data.size (), file);
+    fclose (file);
+}
+
+/*---------------------------------------------------------------------------*/
+/* A saved sequence loads back with every column intact.                     */
+/*---------------------------------------------------------------------------*/
+static void TestSeqFile (void)
+{
+    const char *path = "tmstest_seqfile.seq";
+    Sequence    seq = MakeSequence ("volt");
+    Sequence    loaded;
+    Sequence    empty = SEQ_New ();
+
+    CHECK (SEQ_Save (seq, path) == TMS_OK);
+    CHECK (SEQ_FileFormat (path) == SEQ_FORMAT_BINARY);
+    loaded = SEQ_Load (path);
+    CHECK (loaded != 0);
+    if (loaded)
+        CHECK (SameSequence (seq, loaded));
+
+    /* Saving a loaded sequence over its own file writes the same bytes */
+    if (loaded)
+        {
+        std::string before = ReadFile (path);
+
+        CHECK (SEQ_Save (loaded, path) == TMS_OK);
+        CHECK (ReadFile (path) == before);
+        }
+    SEQ_Dispose (loaded);
+
+    CHECK (SEQ_Save (empty, path) == TMS_OK);
+    loaded = SEQ_Load (path);
+    CHECK (loaded != 0 && SEQ_NumSteps (loaded) == 0);
+    SEQ_Dispose (loaded);
+    SEQ_Dispose (empty);
+    SEQ_Dispose (seq);
+    remove (path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Load rejects a file with any one byte changed, cut short or grown.        */
+/*---------------------------------------------------------------------------*/
+static void TestSeqDamage (void)
+{
+    const char *path = "tmstest_seqdamage.seq";
+    Sequence    seq = MakeSequence ("volt");
+    std::string good;
+    size_t      i;
+    int         numLoaded = 0;
+
+    CHECK (SEQ_Save (seq, path) == TMS_OK);
+    good = ReadFile (path);
+    CHECK (good.size () > 0);
+    for (i = 0; i < good.size (); i++)
+        {
+        std::string bad = good;
+        Sequence    loaded;
+
+        bad[i] ^= 0x01;
+        WriteFile (path, bad);
+        if ((loaded = SEQ_Load (path)) != 0)
+            {
+            fprintf (stderr, "tmstest: flipped byte %zu loaded\n", i);
+            numLoaded++;
+            }
+        SEQ_Dispose (loaded);
+        }
+    CHECK (numLoaded == 0);
+
+    WriteFile (path, good.substr (0, good.size () - 1));
+    CHECK (SEQ_Load (path) == 0);
+    WriteFile (path, good.substr (0, good.size () / 2));
+    CHECK (SEQ_Load (path) == 0);
+    WriteFile (path, good.substr (0, 4));
+    CHECK (SEQ_Load (path) == 0);
+    WriteFile (path, good + '\0');
+    CHECK (SEQ_Load (path) == 0);
+    SEQ_Dispose (seq);
+    remove (path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Names with tabs, backslashes and line breaks survive a text round trip.   */
+/*---------------------------------------------------------------------------*/
+static void TestSeqText (void)
+{
+    const char *path = "tmstest_seqtext.txt";
+    const char *names[] = { "a\tb", "C:\\temp\\", "two\nlines\r", "\\t",
+                            "-" };
+    size_t      i;
+
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+        {
+        Sequence seq = MakeSequence (names[i]);
+        Sequence imported;
+
+        CHECK (SEQ_ExportText (seq, path) == TMS_OK);
+        CHECK (SEQ_FileFormat (path) == SEQ_FORMAT_TEXT);
+        imported = SEQ_ImportText (path);
+        CHECK (imported != 0);
+        if (imported)
+            CHECK (SameSequence (seq, imported));
+        SEQ_Dispose (imported);
+        SEQ_Dispose (seq);
+        }
+    remove (path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* A session store's files: the snapshot, its image and its log.  An empty   */
+/* string stands for a missing file.                                         */
+/*---------------------------------------------------------------------------*/
+struct SessionFiles
+{
+    std::string snapshot;
+    std::string image;
+    std::string log;
+};
+
+static const char *const kSessionPath = "tmstest_session.ini";
+
+static SessionFiles CopySession (void)
+{
+    SessionFiles files;
+    std::string  path = kSessionPath;
+
+    files.snapshot = ReadFile (path.c_str ());
+    files.image = ReadFile ((path + ".bin").c_str ());
+    files.log = ReadFile ((path + ".log").c_str ());
+    return files;
+}
+
+static void PutFile (const std::string &path, const std::string &data)
+{
+    if (data.empty ())
+        remove (path.c_str ());
+    else
+        WriteFile (path.c_str (), data);
+}
+
+static void PutSession (const SessionFiles &files)
+{
+    std::string path = kSessionPath;
+
+    PutFile (path, files.snapshot);
+    PutFile (path + ".bin", files.image);
+    PutFile (path + ".log", files.log);
+}
+
+/*---------------------------------------------------------------------------*/
+/* The MRU list, newest first, as a string of the paths' first letters.      */
+/*---------------------------------------------------------------------------*/
+static const char *Recent (SessionLog session)
+{
+    static char order[64];
+    int         n = 0;
+
+    for (n = 0; n < SES_NumRecent (session) && n < 63; n++)
+        order[n] = SES_GetRecent (session, n)[0];
+    order[n] = '\0';
+    return order;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Reopen the store from the given files, as if the program had died with    */
+/* them on disk, and return its MRU list.                                    */
+/*---------------------------------------------------------------------------*/
+static std::string RecentAfterCrash (const SessionFiles &files)
+{
+    SessionLog  session;
+    std::string recent;
+
+    PutSession (files);
+    session = SES_New (kSessionPath, 8);
+    CHECK (session != 0);
+    if (!session)
+        return recent;
+    recent = Recent (session);
+    SES_Dispose (session);
+    return recent;
+}
+
+/*---------------------------------------------------------------------------*/
+/* A crash in the middle of the last log write loses that change and no      */
+/* other, and the store keeps working after it.                              */
+/*---------------------------------------------------------------------------*/
+static void TestSessionTorn (void)
+{
+    SessionFiles files;
+    SessionFiles torn;
+    SessionLog   session;
+
+    PutSession (SessionFiles ());
+    session = SES_New (kSessionPath, 8);
+    CHECK (SES_HasSavedState (session) == 0);
+    CHECK (SES_AddRecent (session, "a.seq") == TMS_OK);
+    CHECK (SES_AddRecent (session, "b.seq") == TMS_OK);
+    CHECK (SES_AddRecent (session, "c.seq") == TMS_OK);
+    CHECK (SES_Flush (session) == TMS_OK);
+    files = CopySession ();
+    SES_Dispose (session);
+    CHECK (files.snapshot.empty () && !files.log.empty ());
+
+    CHECK (RecentAfterCrash (files) == "cba");
+    torn = files;
+    torn.log.resize (torn.log.size () - 3);
+    CHECK (RecentAfterCrash (torn) == "ba");
+    torn = files;
+    torn.log[torn.log.size () - 1] ^= 0x01;
+    CHECK (RecentAfterCrash (torn) == "ba");
+    torn = files;
+    torn.log += std::string (5, '\xFF');
+    CHECK (RecentAfterCrash (torn) == "cba");
+
+    /* Changes after the torn record are kept */
+    torn = files;
+    torn.log.resize (torn.log.size () - 3);
+    PutSession (torn);
+    session = SES_New (kSessionPath, 8);
+    CHECK (SES_HasSavedState (session) == 1);
+    CHECK (strcmp (Recent (session), "ba") == 0);
+    CHECK (SES_AddRecent (session, "d.seq") == TMS_OK);
+    CHECK (SES_Flush (session) == TMS_OK);
+    files = CopySession ();
+    SES_Dispose (session);
+    CHECK (RecentAfterCrash (files) == "dba");
+    PutSession (SessionFiles ());
+}
+
+/*---------------------------------------------------------------------------*/
+/* Records the snapshot already covers, left in the log by a crash during    */
+/* compaction, are not replayed again.                                       */
+/*---------------------------------------------------------------------------*/
+static void TestSessionSkip (void)
+{
+    SessionFiles oldFiles;
+    SessionFiles files;
+    SessionLog   session;
+
+    PutSession (SessionFiles ());
+    session = SES_New (kSessionPath, 8);
+    CHECK (SES_AddRecent (session, "a.seq") == TMS_OK);
+    CHECK (SES_AddRecent (session, "b.seq") == TMS_OK);
+    CHECK (SES_Flush (session) == TMS_OK);
+    oldFiles = CopySession ();
+    CHECK (SES_AddRecent (session, "a.seq") == TMS_OK);
+    CHECK (SES_Compact (session) == TMS_OK);
+    files = CopySession ();
+    CHECK (SES_AddRecent (session, "c.seq") == TMS_OK);
+    CHECK (SES_Flush (session) == TMS_OK);
+    SES_Dispose (session);
+    CHECK (!files.snapshot.empty () && !files.image.empty ());
+    CHECK (files.log.empty ());
+
+    /* Replaying a then b again would put b first */
+    files.log = oldFiles.log;
+    CHECK (RecentAfterCrash (files) == "ab");
+    files.image.clear ();
+    CHECK (RecentAfterCrash (files) == "ab");
+
+    /* A newer record after the covered ones is still replayed */
+    session = SES_New (kSessionPath, 8);
+    CHECK (SES_AddRecent (session, "c.seq") == TMS_OK);
+    CHECK (SES_Flush (session) == TMS_OK);
+    files = CopySession ();
+    SES_Dispose (session);
+    files.log = oldFiles.log + files.log;
+    CHECK (RecentAfterCrash (files) == "cab");
+    PutSession (SessionFiles ());
+}
+
+/*---------------------------------------------------------------------------*/
+/* The image is used only when it is intact and no older than the snapshot.  */
+/*---------------------------------------------------------------------------*/
+static void TestSessionImage (void)
+{
+    SessionFiles oldFiles;
+    SessionFiles newFiles;
+    SessionFiles files;
+    SessionLog   session;
+
+    PutSession (SessionFiles ());
+    session = SES_New (kSessionPath, 8);
+    CHECK (SES_AddRecent (session, "a.seq") == TMS_OK);
+    CHECK (SES_Compact (session) == TMS_OK);
+    oldFiles = CopySession ();
+    CHECK (SES_AddRecent (session, "b.seq") == TMS_OK);
+    CHECK (SES_Compact (session) == TMS_OK);
+    newFiles = CopySession ();
+    SES_Dispose (session);
+
+    CHECK (RecentAfterCrash (oldFiles) == "a");
+    CHECK (RecentAfterCrash (newFiles) == "ba");
+
+    /* Older image, newer snapshot: the snapshot wins */
+    files = newFiles;
+    files.image = oldFiles.image;
+    CHECK (RecentAfterCrash (files) == "ba");
+
+    /* Newer image, older snapshot: the image wins */
+    files = oldFiles;
+    files.image = newFiles.image;
+    CHECK (RecentAfterCrash (files) == "ba");
+
+    /* A damaged image falls back to the snapshot */
+    files = oldFiles;
+    files.image = newFiles.image.substr (0, newFiles.image.size () - 1);
+    CHECK (RecentAfterCrash (files) == "a");
+    files.image.clear ();
+    CHECK (RecentAfterCrash (files) == "a");
+    PutSession (SessionFiles ());
+}
+
+/*---------------------------------------------------------------------------*/
+/* A sequence of numSteps action steps named s0, s1, ...                     */
+/*---------------------------------------------------------------------------*/
+static Sequence MakeSteps (int numSteps)
+{
+    Sequence seq = SEQ_New ();
+    int      i;
+
+    for (i = 0; i < numSteps; i++)
+        {
+        char name[16];
+
+        snprintf (name, sizeof(name), "s%d", i);
+        SEQ_AddStep (seq, name, SEQ_KIND_ACTION, 0, i, 0, 0, 0);
+        }
+    return seq;
+}
+
+/* "<i>", a symbol unique to edit i */
+static std::string Tag (int i)
+{
+    char tag[16];
+
+    snprintf (tag, sizeof(tag), "<%d>", i);
+    return tag;
+}
+
+/* The symbol step is bound to, or "" if none */
+static std::string Symbol (Sequence seq, int step)
+{
+    const char *module, *symbol;
+
+    if (SEQ_GetStepSymbol (seq, step, &module, &symbol) != TMS_OK)
+        return "";
+    return symbol;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Undo and Redo walk the recorded edits both ways, report what they         */
+/* rewrote, and a new edit discards what could be redone.                    */
+/*---------------------------------------------------------------------------*/
+static void TestUndo (void)
+{
+    Sequence    seq = MakeSteps (200);
+    UndoHistory hist = UND_New (seq, 1 << 20);
+    int         first, count;
+
+    CHECK (hist != 0);
+    CHECK (UND_Undo (hist) == TMS_ERR_NOT_FOUND);
+    CHECK (UND_Redo (hist) == TMS_ERR_NOT_FOUND);
+    CHECK (!UND_GetUndoLabel (hist) && !UND_GetRedoLabel (hist));
+
+    CHECK (SEQ_SetStepSymbol (seq, 150, "io", "Bind") == TMS_OK);
+    CHECK (UND_Record (hist, "Bind", 150, 1) == TMS_OK);
+    CHECK (SEQ_AddStep (seq, "added", SEQ_KIND_ACTION, 0, 0, 0, 0, 2)
+           == 200);
+    CHECK (UND_Record (hist, "Add", 200, 1) == TMS_OK);
+    CHECK (SEQ_NumGroups (seq) == 3);
+
+    /* Recording an edit that changed nothing adds no version */
+    CHECK (UND_Record (hist, "Nothing", 0, -1) == TMS_OK);
+    CHECK (strcmp (UND_GetUndoLabel (hist), "Add") == 0);
+
+    CHECK (UND_Undo (hist) == TMS_OK);
+    CHECK (SEQ_NumSteps (seq) == 200 && SEQ_NumGroups (seq) == 1);
+    CHECK (strcmp (UND_GetUndoLabel (hist), "Bind") == 0);
+    CHECK (strcmp (UND_GetRedoLabel (hist), "Add") == 0);
+    CHECK (UND_Undo (hist) == TMS_OK);
+    CHECK (Symbol (seq, 150) == "");
+    CHECK (UND_GetChangedSteps (hist, &first, &count) == TMS_OK);
+    CHECK (first == 150 && count == 1);
+    CHECK (UND_Undo (hist) == TMS_ERR_NOT_FOUND);
+    CHECK (!UND_GetUndoLabel (hist));
+
+    CHECK (UND_Redo (hist) == TMS_OK);
+    CHECK (Symbol (seq, 150) == "Bind");
+    CHECK (UND_Redo (hist) == TMS_OK);
+    CHECK (SEQ_NumSteps (seq) == 201);
+    CHECK (strcmp (SEQ_GetStepName (seq, 200), "added") == 0);
+    CHECK (UND_Redo (hist) == TMS_ERR_NOT_FOUND);
+
+    /* A new edit after an Undo drops the Redo */
+    CHECK (UND_Undo (hist) == TMS_OK);
+    CHECK (SEQ_SetStepSymbol (seq, 3, "io", "Other") == TMS_OK);
+    CHECK (UND_Record (hist, "Other", 3, 1) == TMS_OK);
+    CHECK (!UND_GetRedoLabel (hist));
+    CHECK (UND_Redo (hist) == TMS_ERR_NOT_FOUND);
+    CHECK (UND_Undo (hist) == TMS_OK);
+    CHECK (Symbol (seq, 3) == "" && Symbol (seq, 150) == "Bind");
+    CHECK (SEQ_NumSteps (seq) == 200);
+
+    UND_Dispose (hist);
+    SEQ_Dispose (seq);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Past its budget the history drops its oldest edits, keeping the newest    */
+/* ones undoable.                                                            */
+/*---------------------------------------------------------------------------*/
+static void TestUndoBudget (void)
+{
+    const int   numEdits = 20;
+    Sequence    seq = MakeSteps (1000);
+    UndoHistory hist = UND_New (seq, (size_t)-1);
+    size_t      base = UND_MemoryUsed (hist);
+    size_t      perEdit;
+    size_t      budget;
+    int         numUndone = 0;
+    int         i;
+
+    /* Measure one edit, then allow the base version and about five */
+    CHECK (SEQ_SetStepSymbol (seq, 0, "io", "<0>") == TMS_OK);
+    CHECK (UND_Record (hist, "<0>", 0, 1) == TMS_OK);
+    perEdit = UND_MemoryUsed (hist) - base;
+    CHECK (perEdit > 0);
+    UND_Dispose (hist);
+    SEQ_Dispose (seq);
+
+    seq = MakeSteps (1000);
+    budget = base + perEdit * 5 + perEdit / 2;
+    hist = UND_New (seq, budget);
+    for (i = 0; i < numEdits; i++)
+        {
+        std::string symbol = Tag (i);
+
+        CHECK (SEQ_SetStepSymbol (seq, i * 37, "io", symbol.c_str ())
+               == TMS_OK);
+        CHECK (UND_Record (hist, symbol.c_str (), i * 37, 1) == TMS_OK);
+        CHECK (UND_MemoryUsed (hist) <= budget);
+        }
+    while (UND_Undo (hist) == TMS_OK)
+        numUndone++;
+    CHECK (numUndone > 0 && numUndone < numEdits);
+
+    /* The oldest edits can no longer be undone; the rest were */
+    for (i = 0; i < numEdits; i++)
+        CHECK ((Symbol (seq, i * 37) != "") == (i < numEdits - numUndone));
+    for (i = 0; i < numUndone; i++)
+        CHECK (UND_Redo (hist) == TMS_OK);
+    CHECK (UND_Redo (hist) == TMS_ERR_NOT_FOUND);
+    for (i = 0; i < numEdits; i++)
+        CHECK (Symbol (seq, i * 37) == Tag (i));
+
+    UND_Dispose (hist);
+    SEQ_Dispose (seq);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Four steps whose names spell "read" in different cases, bound to a DMM.   */
+/*---------------------------------------------------------------------------*/
+static Sequence MakeReadSteps (void)
+{
+    Sequence seq = SEQ_New ();
+
+    SEQ_AddStep (seq, "VoltRead", SEQ_KIND_ACTION, 0, 0, 0, 0, 0);
+    SEQ_AddStep (seq, "idle", SEQ_KIND_ACTION, 0, 0, 0, 0, 0);
+    SEQ_AddStep (seq, "readCurrent", SEQ_KIND_ACTION, 0, 0, 0, 0, 0);
+    SEQ_AddStep (seq, "Read READ read", SEQ_KIND_ACTION, 0, 0, 0, 0, 0);
+    SEQ_SetStepSymbol (seq, 0, "DMM", "dmm_read");
+    return seq;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Replace matches text in any case, keeps the rest of each string as it     */
+/* was, touches only the fields asked for, and leaves the index current.     */
+/*---------------------------------------------------------------------------*/
+static void TestReplace (void)
+{
+    Sequence  seq = MakeReadSteps ();
+    FindIndex index = FND_New (seq);
+    FndMatch  matches[8];
+    int       first, count;
+
+    CHECK (index != 0);
+    CHECK (FND_Replace (index, "READ", FND_FIELD_NAME, "Get", &first,
+                        &count) == 3);
+    CHECK (first == 0 && count == 4);
+    CHECK (strcmp (SEQ_GetStepName (seq, 0), "VoltGet") == 0);
+    CHECK (strcmp (SEQ_GetStepName (seq, 1), "idle") == 0);
+    CHECK (strcmp (SEQ_GetStepName (seq, 2), "GetCurrent") == 0);
+    CHECK (strcmp (SEQ_GetStepName (seq, 3), "Get Get Get") == 0);
+    CHECK (Symbol (seq, 0) == "dmm_read");
+
+    /* The index sees the new names */
+    CHECK (FND_Find (index, "read", FND_FIELD_ALL, matches, 8) == 1);
+    CHECK (matches[0].step == 0 && matches[0].fields == FND_FIELD_SYMBOL);
+    CHECK (FND_Find (index, "gEt", FND_FIELD_NAME, matches, 8) == 3);
+
+    /* Module and symbol, and a query shorter than a trigram */
+    CHECK (FND_Replace (index, "dmm", FND_FIELD_MODULE | FND_FIELD_SYMBOL,
+                        "Scope", &first, &count) == 1);
+    CHECK (first == 0 && count == 1);
+    CHECK (Symbol (seq, 0) == "Scope_read");
+    CHECK (FND_Replace (index, "i", FND_FIELD_NAME, "I", &first, &count)
+           == 1);
+    CHECK (first == 1 && count == 1);
+    CHECK (strcmp (SEQ_GetStepName (seq, 1), "Idle") == 0);
+
+    /* A replacement that contains the text is not replaced again */
+    CHECK (FND_Replace (index, "get", FND_FIELD_NAME, "forget", &first,
+                        &count) == 3);
+    CHECK (strcmp (SEQ_GetStepName (seq, 0), "Voltforget") == 0);
+
+    CHECK (FND_Replace (index, "missing", FND_FIELD_ALL, "x", &first,
+                        &count) == 0);
+    CHECK (first == 0 && count == 0);
+    FND_Dispose (index);
+    SEQ_Dispose (seq);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Edit > Replace across documents is one edit in each, so Undo in one       */
+/* document reverts all of its steps and none of the other's.                */
+/*---------------------------------------------------------------------------*/
+static void TestReplaceUndo (void)
+{
+    const char   *pathA = "tmstest_replace_a.txt";
+    const char   *pathB = "tmstest_replace_b.txt";
+    Sequence      seq = MakeReadSteps ();
+    DocController ctl;
+    Sequence      seqA, seqB;
+    int           a, b;
+
+    CHECK (SEQ_ExportText (seq, pathA) == TMS_OK);
+    CHECK (SEQ_ExportText (seq, pathB) == TMS_OK);
+    SEQ_Dispose (seq);
+    UI_MemReset (3, 4);
+    ctl = DCT_New (UI_MemBackend (), 1, 3);
+    a = DCT_Open (ctl, pathA);
+    b = DCT_Open (ctl, pathB);
+    CHECK (a > 0 && b > 0);
+    CHECK (!DCT_GetUndoLabel (ctl, 0));
+
+    CHECK (DCT_Replace (ctl, "READ", FND_FIELD_NAME, "Get") == 6);
+    CHECK (DCT_GetUndoLabel (ctl, 0)
+           && strcmp (DCT_GetUndoLabel (ctl, 0), "Replace") == 0);
+    seqB = DCT_GetTopSequence (ctl);
+    CHECK (DCT_Undo (ctl) == TMS_OK);
+    CHECK (strcmp (SEQ_GetStepName (seqB, 0), "VoltRead") == 0);
+    CHECK (strcmp (SEQ_GetStepName (seqB, 3), "Read READ read") == 0);
+    CHECK (DCT_Undo (ctl) == TMS_ERR_NOT_FOUND);
+    CHECK (DCT_GetUndoLabel (ctl, 1)
+           && strcmp (DCT_GetUndoLabel (ctl, 1), "Replace") == 0);
+
+    CHECK (DCT_Activate (ctl, a) == TMS_OK);
+    seqA = DCT_GetTopSequence (ctl);
+    CHECK (strcmp (SEQ_GetStepName (seqA, 0), "VoltGet") == 0);
+    CHECK (strcmp (SEQ_GetStepName (seqA, 2), "GetCurrent") == 0);
+    CHECK (DCT_Undo (ctl) == TMS_OK);
+    CHECK (strcmp (SEQ_GetStepName (seqA, 0), "VoltRead") == 0);
+    CHECK (strcmp (SEQ_GetStepName (seqA, 2), "readCurrent") == 0);
+    CHECK (strcmp (SEQ_GetStepName (seqA, 3), "Read READ read") == 0);
+    CHECK (DCT_Undo (ctl) == TMS_ERR_NOT_FOUND);
+
+    /* The Find index follows the Undo */
+    CHECK (DCT_Find (ctl, "get", FND_FIELD_NAME, 0, 0) == 0);
+    CHECK (DCT_Find (ctl, "read", FND_FIELD_NAME, 0, 0) == 6);
+    DCT_Dispose (ctl);
+    UI_MemReset (3, 4);
+    remove (pathA);
+    remove (pathB);
+}
+
+/*---------------------------------------------------------------------------*/
+/* A cartesian sweep lists every combination, the last parameter changing    */
+/* fastest, and any run of points decodes the same on its own.               */
+/*---------------------------------------------------------------------------*/
+static void TestSweep (void)
+{
+    ParamSweep           sweep = SWP_New (SWP_MODE_CARTESIAN);
+    std::vector<int32_t> all;
+    std::vector<int32_t> some;
+    int32_t              x, y, z;
+    int                  first;
+    int                  n;
+
+    CHECK (SWP_AddParam (sweep, 4, 1, 3, 1) == 0);
+    CHECK (SWP_AddParam (sweep, 7, 10, -10, -10) == 1);
+    CHECK (SWP_AddParam (sweep, 9, 0, 7, 3) == 2);
+    CHECK (SWP_AddParam (sweep, 7, 0, 1, 1) == TMS_ERR_EXISTS);
+    CHECK (SWP_NumParams (sweep) == 3 && SWP_GetParamStep (sweep, 1) == 7);
+    CHECK (SWP_NumPoints (sweep) == 27);
+
+    for (x = 1; x <= 3; x++)
+        for (y = 10; y >= -10; y -= 10)
+            for (z = 0; z <= 6; z += 3)
+                {
+                all.push_back (x);
+                all.push_back (y);
+                all.push_back (z);
+                }
+    some.resize (all.size ());
+    CHECK (SWP_GetPoints (sweep, 0, 27, some.data ()) == 27);
+    CHECK (some == all);
+
+    for (first = 0; first < 27; first++)
+        for (n = 1; n <= 5; n += 4)
+            {
+            int expected = n < 27 - first ? n : 27 - first;
+
+            std::fill (some.begin (), some.end (), 12345);
+            CHECK (SWP_GetPoints (sweep, first, n, some.data ()) == expected);
+            CHECK (std::equal (some.begin (), some.begin () + expected * 3,
+                               all.begin () + first * 3));
+            }
+    CHECK (SWP_GetPoints (sweep, 27, 1, some.data ()) == 0);
+    CHECK (SWP_GetPoints (sweep, -1, 1, some.data ()) == TMS_ERR_INVALID_ARG);
+    SWP_Dispose (sweep);
+}
+
+/*---------------------------------------------------------------------------*/
+/* A pairwise sweep of levels[0..numParams) values per parameter: fewer      */
+/* points than every combination, yet every pair of values of every two      */
+/* parameters occurs, and runs of points decode as the whole does.           */
+/*---------------------------------------------------------------------------*/
+static void CheckPairwise (const int *levels, int numParams)
+{
+    ParamSweep           sweep = SWP_New (SWP_MODE_PAIRWISE);
+    std::vector<int32_t> all;
+    std::vector<int32_t> some;
+    int64_t              product = 1;
+    int                  numPoints;
+    int                  point;
+    int                  i, j;
+
+    for (i = 0; i < numParams; i++)
+        {
+        /* Parameter i takes 100 * i, 100 * i + (i + 1), ... */
+        CHECK (SWP_AddParam (sweep, i, 100 * i,
+                             100 * i + (levels[i] - 1) * (i + 1), i + 1)
+               == i);
+        product *= levels[i];
+        }
+    numPoints = (int)SWP_NumPoints (sweep);
+    CHECK (numPoints > 0 && numPoints < product);
+    all.resize ((size_t)numPoints * numParams);
+    CHECK (SWP_GetPoints (sweep, 0, numPoints, all.data ()) == numPoints);
+
+    for (i = 0; i < numParams; i++)
+        for (j = i + 1; j < numParams; j++)
+            {
+            std::vector<bool> seen (levels[i] * levels[j]);
+            int               numSeen = 0;
+
+            for (point = 0; point < numPoints; point++)
+                {
+                int vi = (all[point * numParams + i] - 100 * i) / (i + 1);
+                int vj = (all[point * numParams + j] - 100 * j) / (j + 1);
+
+                CHECK (vi >= 0 && vi < levels[i] && vj >= 0
+                       && vj < levels[j]);
+                if (vi >= 0 && vi < levels[i] && vj >= 0 && vj < levels[j]
+                    && !seen[vi * levels[j] + vj])
+                    {
+                    seen[vi * levels[j] + vj] = true;
+                    numSeen++;
+                    }
+                }
+            CHECK (numSeen == levels[i] * levels[j]);
+            }
+
+    some.resize (3 * numParams);
+    for (point = 1; point < numPoints; point += 2)
+        {
+        int expected = numPoints - point < 3 ? numPoints - point : 3;
+
+        CHECK (SWP_GetPoints (sweep, point, 3, some.data ()) == expected);
+        CHECK (std::equal (some.begin (),
+                           some.begin () + expected * numParams,
+                           all.begin () + point * numParams));
+        }
+    SWP_Dispose (sweep);
+}
+
+static void TestPairwise (void)
+{
+    static const int mixed[] = { 3, 4, 2, 5 };
+    static const int two[] = { 2, 2, 2, 2, 2 };
+    static const int three[] = { 3, 3, 3, 3, 3, 3 };
+    ParamSweep       sweep;
+
+    CheckPairwise (mixed, 4);
+    CheckPairwise (two, 4);             /* p = 3: the last column is b */
+    CheckPairwise (two, 5);
+    CheckPairwise (three, 6);
+
+    /* Two parameters are swept in full */
+    sweep = SWP_New (SWP_MODE_PAIRWISE);
+    SWP_AddParam (sweep, 0, 0, 2, 1);
+    SWP_AddParam (sweep, 1, 0, 3, 1);
+    CHECK (SWP_NumPoints (sweep) == 12);
+    SWP_Dispose (sweep);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Main                                                                      */
+/*---------------------------------------------------------------------------*/
+static const struct
+{
+    const char *name;
+    void      (*func) (void);
+} kTests[] =
+{
+    { "zorder",   TestZOrder },
+    { "mirror",   TestWindowMirror },
+    { "closetop", TestCloseTop },
+    { "open",     TestOpen },
+    { "close",    TestClose },
+    { "activate", TestActivate },
+    { "window",   TestWindowMenu },
+    { "seqfile",  TestSeqFile },
+    { "seqdamage", TestSeqDamage },
+    { "seqtext",  TestSeqText },
+    { "sestorn",  TestSessionTorn },
+    { "sesskip",  TestSessionSkip },
+    { "sesimage", TestSessionImage },
+    { "undo",     TestUndo },
+    { "undobudget", TestUndoBudget },
+    { "replace",  TestReplace },
+    { "replaceundo", TestReplaceUndo },
+    { "sweep",    TestSweep },
+    { "pairwise", TestPairwise },
+};
+
+int main (int argc, char *argv[])
+{
+    size_t i;
+    int    numRun = 0;
+
+    for (i = 0; i < sizeof(kTests) / sizeof(kTests[0]); i++)
+        {
+        int numFailed = g_numFailed;
+
+        if (argc > 1 && strcmp (argv[1], kTests[i].name) != 0)
+            continue;
+        kTests[i].func ();
+        numRun++;
+        printf ("%-12s %s\n", kTests[i].name,
+                g_numFailed == numFailed ? "ok" : "FAILED");
+        }
+    if (!numRun)
+        {
+        fprintf (stderr, "tmstest: no test named %s\n", argv[1]);
+        return 2;
+        }
+    return g_numFailed ? 1 : 0;
+}
@@ -0,0 +1,345 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    uicvi.c                                                          */
+/*                                                                           */
+/* PURPOSE: CVI user-interface backend.  See uicvi.h.                        */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/* Include files                                                             */
+/*---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <userint.h>
+#include "menudemo.h"
+#include "menuutil.h"
+#include "arena.h"
+#include "uicvi.h"
+
+/*---------------------------------------------------------------------------*/
+/* Defines                                                                   */
+/*---------------------------------------------------------------------------*/
+#define NUM_TABS           8
+#define NUM_STEP_ROWS      16
+#define TAB_LABEL_MAX      24
+
+/*---------------------------------------------------------------------------*/
+/* Module-globals                                                            */
+/*---------------------------------------------------------------------------*/
+static int g_menuBar = 0;
+static menuList g_fileMenuList = 0;
+static menuList g_windowMenuList = 0;
+static PanelCallbackPtr g_documentPanelCallback = 0;
+static int g_documentTemplate = 0;
+static UiCviViewCallback g_viewCallback = 0;
+
+/* Controls added to the template, so the same in every document panel */
+static int g_tabButtons[NUM_TABS];
+static int g_tabSlide = 0;
+static int g_stepList = 0;
+static int g_stepSlide = 0;
+static char g_rowBuffer[256];
+
+/*---------------------------------------------------------------------------*/
+/* Internal function prototypes                                              */
+/*---------------------------------------------------------------------------*/
+static int AddViewControls (int panel);
+static int CVICALLBACK ViewCtrlCallback (int panel, int control, int event,
+                                         void *callbackData,
+                                         int eventData1, int eventData2);
+
+/* Menu item for each UI_CMD_* */
+static const int g_commandItems[UI_NUM_COMMANDS] =
+{
+    MAINMENU_FILE_SAVE,
+    MAINMENU_FILE_SAVEAS,
+    MAINMENU_FILE_CLOSE,
+    MAINMENU_WINDOW_CLOSEALL,
+    MAINMENU_WINDOW_HIDEALL,
+    MAINMENU_EDIT_UNDO,
+    MAINMENU_EDIT_REDO
+};
+
+/*---------------------------------------------------------------------------*/
+/* Document panels.                                                          */
+/*---------------------------------------------------------------------------*/
+static int CviLoadDocumentPanel (int parentPanel)
+{
+    int panel;
+    int status;
+
+    /* The UIR is parsed once, into a hidden template that every document */
+    /* panel is copied from                                               */
+    if (g_documentTemplate <= 0)
+        {
+        if ((g_documentTemplate = LoadPanel (parentPanel, "menudemo.uir",
+                                             FILEPANEL)) < 0)
+            return g_documentTemplate;
+        if ((status = AddViewControls (g_documentTemplate)) < 0)
+            {
+            DiscardPanel (g_documentTemplate);
+            g_documentTemplate = 0;
+            return status;
+            }
+        }
+    if ((panel = DuplicatePanel (parentPanel, g_documentTemplate, "",
+                                 VAL_KEEP_SAME_POSITION,
+                                 VAL_KEEP_SAME_POSITION)) >= 0
+        && g_documentPanelCallback)
+        SetPanelAttribute (panel, ATTR_CALLBACK_FUNCTION_POINTER,
+                           g_documentPanelCallback);
+    return panel;
+}
+
+static int CviDiscardPanel (int panel)
+{
+    return DiscardPanel (panel);
+}
+
+static int CviDisplayPanel (int panel)
+{
+    return DisplayPanel (panel);
+}
+
+static int CviSetPanelPosition (int panel, int top, int left)
+{
+    SetPanelAttribute (panel, ATTR_TOP, top);
+    return SetPanelAttribute (panel, ATTR_LEFT, left);
+}
+
+static int CviSetDocumentPath (int panel, const char *path)
+{
+    SetPanelAttribute (panel, ATTR_TITLE,
+                       MU_MakeShortFileName (NULL, (char *)path, 32));
+    return SetCtrlVal (panel, FILEPANEL_FILENAME, path);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Add the tab strip, with the slide that scrolls it, and the step list,     */
+/* with its slide, below the UIR's controls.  The list has a fixed number    */
+/* of rows however long the sequence; the tab strip is hidden until the      */
+/* panel is used for tabs.                                                   */
+/*---------------------------------------------------------------------------*/
+static int AddViewControls (int panel)
+{
+    int top;
+    int width;
+    int listHeight;
+    int i;
+
+    GetPanelAttribute (panel, ATTR_HEIGHT, &top);
+    GetPanelAttribute (panel, ATTR_WIDTH, &width);
+    for (i = 0; i < NUM_TABS; i++)
+        {
+        if ((g_tabButtons[i] = NewCtrl (panel, CTRL_SQUARE_TEXT_BUTTON, "",
+                                        top + 4, i * width / NUM_TABS)) < 0)
+            return g_tabButtons[i];
+        SetCtrlAttribute (panel, g_tabButtons[i], ATTR_WIDTH,
+                          width / NUM_TABS);
+        SetCtrlAttribute (panel, g_tabButtons[i], ATTR_VISIBLE, 0);
+        InstallCtrlCallback (panel, g_tabButtons[i], ViewCtrlCallback,
+                             (void *)(size_t)i);
+        }
+    if ((g_tabSlide = NewCtrl (panel, CTRL_NUMERIC_HSLIDE, "", top + 28,
+                               0)) < 0)
+        return g_tabSlide;
+    SetCtrlAttribute (panel, g_tabSlide, ATTR_DATA_TYPE, VAL_INTEGER);
+    SetCtrlAttribute (panel, g_tabSlide, ATTR_WIDTH, width);
+    SetCtrlAttribute (panel, g_tabSlide, ATTR_VISIBLE, 0);
+    InstallCtrlCallback (panel, g_tabSlide, ViewCtrlCallback, 0);
+
+    if ((g_stepList = NewCtrl (panel, CTRL_LIST, "", top + 52, 0)) < 0)
+        return g_stepList;
+    SetCtrlAttribute (panel, g_stepList, ATTR_WIDTH, width - 32);
+    SetCtrlAttribute (panel, g_stepList, ATTR_VISIBLE_LINES, NUM_STEP_ROWS);
+    SetCtrlAttribute (panel, g_stepList, ATTR_TEXT_FONT, VAL_EDITOR_FONT);
+    for (i = 0; i < NUM_STEP_ROWS; i++)
+        InsertListItem (panel, g_stepList, -1, "", i);
+    GetCtrlAttribute (panel, g_stepList, ATTR_HEIGHT, &listHeight);
+    if ((g_stepSlide = NewCtrl (panel, CTRL_NUMERIC_VSLIDE, "", top + 52,
+                                width - 28)) < 0)
+        return g_stepSlide;
+    SetCtrlAttribute (panel, g_stepSlide, ATTR_DATA_TYPE, VAL_INTEGER);
+    SetCtrlAttribute (panel, g_stepSlide, ATTR_HEIGHT, listHeight);
+    SetCtrlAttribute (panel, g_stepSlide, ATTR_DIMMED, 1);
+    InstallCtrlCallback (panel, g_stepSlide, ViewCtrlCallback, 0);
+    return SetPanelAttribute (panel, ATTR_HEIGHT, top + 56 + listHeight);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Pass a click on a tab or a move of a slide to the view callback, as the   */
+/* tab or the first step or tab now in view.  A tab button toggles itself    */
+/* when clicked, so it is set back: which tab is selected is up to the       */
+/* controller.  The step slide's top is step 0, so its value counts from the */
+/* bottom.                                                                   */
+/*---------------------------------------------------------------------------*/
+static int CVICALLBACK ViewCtrlCallback (int panel, int control, int event,
+                                         void *callbackData,
+                                         int eventData1, int eventData2)
+{
+    int value;
+    int maxValue;
+
+    if (event != EVENT_COMMIT || !g_viewCallback)
+        return 0;
+    GetCtrlVal (panel, control, &value);
+    if (control == g_stepSlide)
+        {
+        GetCtrlAttribute (panel, control, ATTR_MAX_VALUE, &maxValue);
+        g_viewCallback (panel, UI_CVI_SCROLL_STEPS, maxValue - value);
+        }
+    else if (control == g_tabSlide)
+        g_viewCallback (panel, UI_CVI_SCROLL_TABS, value);
+    else
+        {
+        SetCtrlVal (panel, control, !value);
+        GetCtrlVal (panel, g_tabSlide, &value);
+        g_viewCallback (panel, UI_CVI_SHOW_TAB,
+                        value + (int)(size_t)callbackData);
+        }
+    return 0;
+}
+
+static int CviSetStepView (int panel, int numSteps, int firstStep)
+{
+    int maxValue = numSteps > NUM_STEP_ROWS ? numSteps - NUM_STEP_ROWS : 0;
+
+    /* A slide needs a range, so one with nothing to scroll is dimmed */
+    SetCtrlAttribute (panel, g_stepSlide, ATTR_DIMMED, maxValue == 0);
+    SetCtrlAttribute (panel, g_stepSlide, ATTR_MAX_VALUE,
+                      maxValue ? maxValue : 1);
+    SetCtrlVal (panel, g_stepSlide, maxValue ? maxValue - firstStep : 1);
+    return NUM_STEP_ROWS;
+}
+
+static int CviSetStepRow (int panel, int row, const UiStepRow *step)
+{
+    if (row < 0 || row >= NUM_STEP_ROWS)
+        return -1;
+    if (!step)
+        g_rowBuffer[0] = 0;
+    else if (step->module)
+        sprintf (g_rowBuffer, "%6d  %-24.24s %s:%s (%d)", step->step + 1,
+                 step->name ? step->name : "", step->module,
+                 step->symbol ? step->symbol : "", step->param);
+    else
+        sprintf (g_rowBuffer, "%6d  %-24.24s (%d)", step->step + 1,
+                 step->name ? step->name : "", step->param);
+    return ReplaceListItem (panel, g_stepList, row, g_rowBuffer, row);
+}
+
+static int CviSetTabView (int panel, int numTabs, int firstTab)
+{
+    int maxValue = numTabs > NUM_TABS ? numTabs - NUM_TABS : 0;
+    int i;
+
+    /* No tabs: a document panel, so no strip */
+    for (i = 0; i < NUM_TABS && numTabs == 0; i++)
+        SetCtrlAttribute (panel, g_tabButtons[i], ATTR_VISIBLE, 0);
+    SetCtrlAttribute (panel, g_tabSlide, ATTR_VISIBLE, maxValue > 0);
+    if (maxValue > 0)
+        {
+        SetCtrlAttribute (panel, g_tabSlide, ATTR_MAX_VALUE, maxValue);
+        SetCtrlVal (panel, g_tabSlide, firstTab);
+        }
+    else
+        SetCtrlVal (panel, g_tabSlide, 0);
+    return NUM_TABS;
+}
+
+static int CviSetTab (int panel, int tab, const char *path, int selected)
+{
+    char *label;
+
+    if (tab < 0 || tab >= NUM_TABS)
+        return -1;
+    if (!path)
+        return SetCtrlAttribute (panel, g_tabButtons[tab], ATTR_VISIBLE, 0);
+    label = MU_MakeShortFileName (NULL, (char *)path, TAB_LABEL_MAX);
+    SetCtrlAttribute (panel, g_tabButtons[tab], ATTR_ON_TEXT, label);
+    SetCtrlAttribute (panel, g_tabButtons[tab], ATTR_OFF_TEXT, label);
+    SetCtrlVal (panel, g_tabButtons[tab], selected != 0);
+    return SetCtrlAttribute (panel, g_tabButtons[tab], ATTR_VISIBLE, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Menus.                                                                    */
+/*---------------------------------------------------------------------------*/
+static int CviSetCommandDimmed (int command, int dimmed)
+{
+    if (command < 0 || command >= UI_NUM_COMMANDS)
+        return -1;
+    return SetMenuBarAttribute (g_menuBar, g_commandItems[command],
+                                ATTR_DIMMED, dimmed);
+}
+
+static int CviAddRecentFile (const char *path)
+{
+    if (!g_fileMenuList || !path || !path[0])
+        return 0;
+    return MU_AddItemToMenuList (g_fileMenuList, FRONT_OF_LIST,
+                                 MU_MakeShortFileName (NULL, (char *)path, 32),
+                                 (void *)ARN_InternPath (path));
+}
+
+static int CviAddWindowItem (const char *path, void *itemData)
+{
+    if (!g_windowMenuList)
+        return 0;
+    return MU_AddItemToMenuList (g_windowMenuList, FRONT_OF_LIST,
+                                 MU_MakeShortFileName (NULL, (char *)path, 32),
+                                 itemData);
+}
+
+static int CviDeleteWindowItem (int item)
+{
+    if (!g_windowMenuList)
+        return 0;
+    return MU_DeleteMenuListItem (g_windowMenuList, item);
+}
+
+static const UiBackend g_cviBackend =
+{
+    CviLoadDocumentPanel,
+    CviDiscardPanel,
+    CviDisplayPanel,
+    CviSetPanelPosition,
+    CviSetDocumentPath,
+    CviSetStepView,
+    CviSetStepRow,
+    CviSetTabView,
+    CviSetTab,
+    CviSetCommandDimmed,
+    CviAddRecentFile,
+    CviAddWindowItem,
+    CviDeleteWindowItem
+};
+
+/*---------------------------------------------------------------------------*/
+/* Tell the backend which menu bar and menu lists to use, and which callback */
+/* to install on document panels.                                            */
+/*---------------------------------------------------------------------------*/
+void UI_CviInit (int menuBar, menuList fileMenuList, menuList windowMenuList,
+                 PanelCallbackPtr documentPanelCallback)
+{
+    g_menuBar = menuBar;
+    g_fileMenuList = fileMenuList;
+    g_windowMenuList = windowMenuList;
+    g_documentPanelCallback = documentPanelCallback;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Tell the backend what to call when the user clicks a tab or scrolls.      */
+/*---------------------------------------------------------------------------*/
+void UI_CviSetViewCallback (UiCviViewCallback viewCallback)
+{
+    g_viewCallback = viewCallback;
+}
+
+/*---------------------------------------------------------------------------*/
+/* The backend to hand to DCT_New.                                           */
+/*---------------------------------------------------------------------------*/
+const UiBackend *UI_CviBackend (void)
+{
+    return &g_cviBackend;
+}
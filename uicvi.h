@@ -0,0 +1,50 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    uicvi.h                                                          */
+/*                                                                           */
+/* PURPOSE: CVI user-interface backend for the document controller.  It      */
+/*          drives menudemo.uir panels and the Menu Utility lists that       */
+/*          menudemo.c creates.  Document panels get a tab strip and a step  */
+/*          list with scroll slides, whose use is passed to the view         */
+/*          callback.                                                        */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __UICVI_H__
+#define __UICVI_H__
+
+#include <userint.h>
+#include "menuutil.h"
+#include "uiport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Defines                                                                   */
+/*---------------------------------------------------------------------------*/
+
+/* What the user did to a document panel's tab strip or step list; index */
+/* is the tab to show or the first tab or step to scroll to              */
+#define UI_CVI_SHOW_TAB      0
+#define UI_CVI_SCROLL_TABS   1
+#define UI_CVI_SCROLL_STEPS  2
+
+typedef void (CVICALLBACK *UiCviViewCallback) (int panel, int event,
+                                               int index);
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+void             UI_CviInit     (int menuBar, menuList fileMenuList,
+                                 menuList windowMenuList,
+                                 PanelCallbackPtr documentPanelCallback);
+void             UI_CviSetViewCallback (UiCviViewCallback viewCallback);
+const UiBackend *UI_CviBackend  (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UICVI_H__ */
@@ -0,0 +1,471 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    uimem.cpp                                                        */
+/*                                                                           */
+/* PURPOSE: In-memory user-interface backend.  See uimem.h.                  */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "uimem.h"
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+struct MemPanel
+{
+    int                      parent;
+    int                      top;
+    int                      left;
+    bool                     visible;
+    std::string              path;
+    std::vector<int>         stepRows;      /* step each row shows, -1 */
+    std::vector<std::string> tabs;          /* "" for an empty tab */
+    int                      selectedTab;   /* -1 for none */
+};
+
+struct MemWindowItem
+{
+    std::string path;
+    void       *data;
+};
+
+struct MemState
+{
+    std::unordered_map<int, MemPanel> panels;
+    int                               nextPanel;
+    std::vector<MemWindowItem>        windowItems;   /* item 1 first */
+    int                               maxWindowItems;
+    std::vector<std::string>          recentFiles;   /* newest first */
+    int                               maxRecentFiles;
+    bool                              dimmed[UI_NUM_COMMANDS];
+    int                               numTabs;       /* per tab strip */
+    int                               numStepRows;   /* per step list */
+    std::vector<UiMemCall>            calls;
+    bool                              recording;
+
+    MemState () : nextPanel (1), maxWindowItems (5), maxRecentFiles (5),
+                  numTabs (8), numStepRows (20), recording (true)
+        {
+        std::fill (dimmed, dimmed + UI_NUM_COMMANDS, false);
+        }
+};
+
+static MemState g_state;
+
+/*---------------------------------------------------------------------------*/
+/* Append a call to the log and pass its result through.                     */
+/*---------------------------------------------------------------------------*/
+static int Record (int op, int panel, int result)
+{
+    if (g_state.recording)
+        {
+        try
+            {
+            UiMemCall call;
+
+            call.op = op;
+            call.panel = panel;
+            call.result = result;
+            g_state.calls.push_back (call);
+            }
+        catch (const std::bad_alloc &)
+            {
+            }
+        }
+    return result;
+}
+
+static MemPanel *FindPanel (int panel)
+{
+    std::unordered_map<int, MemPanel>::iterator it = g_state.panels.find (panel);
+
+    return it == g_state.panels.end () ? 0 : &it->second;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Backend functions.                                                        */
+/*---------------------------------------------------------------------------*/
+static int MemLoadDocumentPanel (int parentPanel)
+{
+    int panel;
+
+    try
+        {
+        MemPanel &entry = g_state.panels[g_state.nextPanel];
+
+        entry.parent = parentPanel;
+        entry.top = entry.left = 0;
+        entry.visible = false;
+        entry.selectedTab = -1;
+        panel = g_state.nextPanel++;
+        }
+    catch (const std::bad_alloc &)
+        {
+        panel = TMS_ERR_NO_MEMORY;
+        }
+    return Record (UI_MEM_LOAD_PANEL, panel, panel);
+}
+
+static int MemDiscardPanel (int panel)
+{
+    int result = g_state.panels.erase (panel) ? 0 : TMS_ERR_NOT_FOUND;
+
+    return Record (UI_MEM_DISCARD_PANEL, panel, result);
+}
+
+static int MemDisplayPanel (int panel)
+{
+    MemPanel *entry = FindPanel (panel);
+
+    if (entry)
+        entry->visible = true;
+    return Record (UI_MEM_DISPLAY_PANEL, panel, entry ? 0 : TMS_ERR_NOT_FOUND);
+}
+
+static int MemSetPanelPosition (int panel, int top, int left)
+{
+    MemPanel *entry = FindPanel (panel);
+
+    if (entry)
+        {
+        entry->top = top;
+        entry->left = left;
+        }
+    return Record (UI_MEM_SET_POSITION, panel, entry ? 0 : TMS_ERR_NOT_FOUND);
+}
+
+static int MemSetDocumentPath (int panel, const char *path)
+{
+    MemPanel *entry = FindPanel (panel);
+    int       result = entry ? 0 : TMS_ERR_NOT_FOUND;
+
+    if (entry)
+        {
+        try
+            {
+            entry->path = path ? path : "";
+            }
+        catch (const std::bad_alloc &)
+            {
+            result = TMS_ERR_NO_MEMORY;
+            }
+        }
+    return Record (UI_MEM_SET_PATH, panel, result);
+}
+
+/* Like a table with a scroll bar: a fixed number of rows, the first */
+/* entry in view being the scroll bar's value                         */
+static int MemSetStepView (int panel, int numSteps, int firstStep)
+{
+    MemPanel *entry = FindPanel (panel);
+    int       result = g_state.numStepRows;
+
+    if (!entry)
+        result = TMS_ERR_NOT_FOUND;
+    else if (numSteps < 0 || firstStep < 0)
+        result = TMS_ERR_INVALID_ARG;
+    else
+        {
+        try
+            {
+            entry->stepRows.resize (g_state.numStepRows, -1);
+            }
+        catch (const std::bad_alloc &)
+            {
+            result = TMS_ERR_NO_MEMORY;
+            }
+        }
+    return Record (UI_MEM_SET_STEP_VIEW, panel, result);
+}
+
+static int MemSetStepRow (int panel, int row, const UiStepRow *step)
+{
+    MemPanel *entry = FindPanel (panel);
+
+    if (!entry)
+        return Record (UI_MEM_SET_STEP_ROW, panel, TMS_ERR_NOT_FOUND);
+    if (row < 0 || row >= (int)entry->stepRows.size ())
+        return Record (UI_MEM_SET_STEP_ROW, panel, TMS_ERR_INVALID_ARG);
+    entry->stepRows[row] = step ? step->step : -1;
+    return Record (UI_MEM_SET_STEP_ROW, panel, 0);
+}
+
+static int MemSetTabView (int panel, int numTabs, int firstTab)
+{
+    MemPanel *entry = FindPanel (panel);
+    int       result = g_state.numTabs;
+
+    if (!entry)
+        result = TMS_ERR_NOT_FOUND;
+    else if (numTabs < 0 || firstTab < 0)
+        result = TMS_ERR_INVALID_ARG;
+    else
+        {
+        try
+            {
+            entry->tabs.resize (g_state.numTabs);
+            }
+        catch (const std::bad_alloc &)
+            {
+            result = TMS_ERR_NO_MEMORY;
+            }
+        }
+    return Record (UI_MEM_SET_TAB_VIEW, panel, result);
+}
+
+static int MemSetTab (int panel, int tab, const char *path, int selected)
+{
+    MemPanel *entry = FindPanel (panel);
+    int       result = 0;
+
+    if (!entry)
+        return Record (UI_MEM_SET_TAB, panel, TMS_ERR_NOT_FOUND);
+    if (tab < 0 || tab >= (int)entry->tabs.size ())
+        return Record (UI_MEM_SET_TAB, panel, TMS_ERR_INVALID_ARG);
+    try
+        {
+        entry->tabs[tab] = path ? path : "";
+        }
+    catch (const std::bad_alloc &)
+        {
+        result = TMS_ERR_NO_MEMORY;
+        }
+    if (selected)
+        entry->selectedTab = tab;
+    else if (entry->selectedTab == tab)
+        entry->selectedTab = -1;
+    return Record (UI_MEM_SET_TAB, panel, result);
+}
+
+static int MemSetCommandDimmed (int command, int dimmed)
+{
+    if (command < 0 || command >= UI_NUM_COMMANDS)
+        return Record (UI_MEM_SET_DIMMED, command, TMS_ERR_INVALID_ARG);
+    g_state.dimmed[command] = dimmed != 0;
+    return Record (UI_MEM_SET_DIMMED, command, 0);
+}
+
+/* Like the File menu list: no duplicates, newest first, oldest dropped */
+static int MemAddRecentFile (const char *path)
+{
+    std::vector<std::string> &files = g_state.recentFiles;
+    int                       result = 0;
+
+    if (!path || !path[0])
+        return Record (UI_MEM_ADD_RECENT, 0, TMS_ERR_INVALID_ARG);
+    try
+        {
+        std::vector<std::string>::iterator it
+            = std::find (files.begin (), files.end (), path);
+
+        if (it != files.end ())
+            files.erase (it);
+        files.insert (files.begin (), path);
+        if ((int)files.size () > g_state.maxRecentFiles)
+            files.resize (g_state.maxRecentFiles);
+        }
+    catch (const std::bad_alloc &)
+        {
+        result = TMS_ERR_NO_MEMORY;
+        }
+    return Record (UI_MEM_ADD_RECENT, 0, result);
+}
+
+/* Like the Window menu list: newest first, oldest dropped when full */
+static int MemAddWindowItem (const char *path, void *itemData)
+{
+    std::vector<MemWindowItem> &items = g_state.windowItems;
+    int                         result = 1;
+
+    if (g_state.maxWindowItems <= 0)
+        return Record (UI_MEM_ADD_WINDOW_ITEM, 0, 0);
+    try
+        {
+        MemWindowItem item;
+
+        item.path = path ? path : "";
+        item.data = itemData;
+        items.insert (items.begin (), item);
+        if ((int)items.size () > g_state.maxWindowItems)
+            items.pop_back ();
+        }
+    catch (const std::bad_alloc &)
+        {
+        result = TMS_ERR_NO_MEMORY;
+        }
+    return Record (UI_MEM_ADD_WINDOW_ITEM, 1, result);
+}
+
+static int MemDeleteWindowItem (int item)
+{
+    std::vector<MemWindowItem> &items = g_state.windowItems;
+
+    if (item < 1 || item > (int)items.size ())
+        return Record (UI_MEM_DELETE_WINDOW_ITEM, item, TMS_ERR_INVALID_ARG);
+    items.erase (items.begin () + (item - 1));
+    return Record (UI_MEM_DELETE_WINDOW_ITEM, item, 0);
+}
+
+static const UiBackend g_memBackend =
+{
+    MemLoadDocumentPanel,
+    MemDiscardPanel,
+    MemDisplayPanel,
+    MemSetPanelPosition,
+    MemSetDocumentPath,
+    MemSetStepView,
+    MemSetStepRow,
+    MemSetTabView,
+    MemSetTab,
+    MemSetCommandDimmed,
+    MemAddRecentFile,
+    MemAddWindowItem,
+    MemDeleteWindowItem
+};
+
+/*---------------------------------------------------------------------------*/
+/* The backend to hand to DCT_New.                                           */
+/*---------------------------------------------------------------------------*/
+const UiBackend *UI_MemBackend (void)
+{
+    return &g_memBackend;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Forget all panels, menu items and recorded calls, and set the capacity    */
+/* of the Window and File menu lists.  Panels get the default view size.     */
+/*---------------------------------------------------------------------------*/
+void UI_MemReset (int maxWindowItems, int maxRecentFiles)
+{
+    bool recording = g_state.recording;
+
+    g_state = MemState ();
+    g_state.recording = recording;
+    g_state.maxWindowItems = maxWindowItems;
+    g_state.maxRecentFiles = maxRecentFiles;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Turn the call log on or off.  Benchmarks turn it off so the log does not  */
+/* grow without bound.                                                       */
+/*---------------------------------------------------------------------------*/
+void UI_MemSetRecording (int record)
+{
+    g_state.recording = record != 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Recorded calls, oldest first.                                             */
+/*---------------------------------------------------------------------------*/
+int UI_MemNumCalls (void)
+{
+    return (int)g_state.calls.size ();
+}
+
+int UI_MemGetCall (int index, UiMemCall *call)
+{
+    if (!call || index < 0 || index >= (int)g_state.calls.size ())
+        return TMS_ERR_INVALID_ARG;
+    *call = g_state.calls[index];
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Panel state.                                                              */
+/*---------------------------------------------------------------------------*/
+int UI_MemNumPanels (void)
+{
+    return (int)g_state.panels.size ();
+}
+
+int UI_MemIsPanelVisible (int panel)
+{
+    MemPanel *entry = FindPanel (panel);
+
+    return entry ? entry->visible : TMS_ERR_NOT_FOUND;
+}
+
+const char *UI_MemGetPanelPath (int panel)
+{
+    MemPanel *entry = FindPanel (panel);
+
+    return entry ? entry->path.c_str () : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Menu state.  Items are numbered from 1, as in the Menu Utility.           */
+/*---------------------------------------------------------------------------*/
+int UI_MemNumWindowItems (void)
+{
+    return (int)g_state.windowItems.size ();
+}
+
+void *UI_MemGetWindowItem (int item)
+{
+    if (item < 1 || item > (int)g_state.windowItems.size ())
+        return 0;
+    return g_state.windowItems[item - 1].data;
+}
+
+int UI_MemNumRecentFiles (void)
+{
+    return (int)g_state.recentFiles.size ();
+}
+
+const char *UI_MemGetRecentFile (int item)
+{
+    if (item < 1 || item > (int)g_state.recentFiles.size ())
+        return 0;
+    return g_state.recentFiles[item - 1].c_str ();
+}
+
+int UI_MemIsCommandDimmed (int command)
+{
+    if (command < 0 || command >= UI_NUM_COMMANDS)
+        return TMS_ERR_INVALID_ARG;
+    return g_state.dimmed[command];
+}
+
+/*---------------------------------------------------------------------------*/
+/* Document view state.  Tab strips and step lists set from now on show      */
+/* numTabs tabs and numStepRows rows.                                        */
+/*---------------------------------------------------------------------------*/
+void UI_MemSetViewSize (int numTabs, int numStepRows)
+{
+    g_state.numTabs = numTabs > 0 ? numTabs : 0;
+    g_state.numStepRows = numStepRows > 0 ? numStepRows : 0;
+}
+
+int UI_MemGetStepRow (int panel, int row)
+{
+    MemPanel *entry = FindPanel (panel);
+
+    if (!entry)
+        return TMS_ERR_NOT_FOUND;
+    if (row < 0 || row >= (int)entry->stepRows.size ())
+        return -1;
+    return entry->stepRows[row];
+}
+
+const char *UI_MemGetTab (int panel, int tab)
+{
+    MemPanel *entry = FindPanel (panel);
+
+    if (!entry || tab < 0 || tab >= (int)entry->tabs.size ()
+        || entry->tabs[tab].empty ())
+        return 0;
+    return entry->tabs[tab].c_str ();
+}
+
+int UI_MemGetSelectedTab (int panel)
+{
+    MemPanel *entry = FindPanel (panel);
+
+    return entry ? entry->selectedTab : TMS_ERR_NOT_FOUND;
+}
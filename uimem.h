@@ -0,0 +1,79 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    uimem.h                                                          */
+/*                                                                           */
+/* PURPOSE: In-memory user-interface backend.  Panels with their step lists  */
+/*          and tab strips, the File and Window menu lists and the dimmed    */
+/*          state of commands are kept in plain data structures, and every   */
+/*          backend call can be recorded, so the document logic runs and can */
+/*          be checked and profiled without a display.  Like the CVI User    */
+/*          Interface Library it has a single global state and must be used  */
+/*          from one thread.                                                 */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __UIMEM_H__
+#define __UIMEM_H__
+
+#include "tmsapi.h"
+#include "uiport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+#define UI_MEM_LOAD_PANEL          0
+#define UI_MEM_DISCARD_PANEL       1
+#define UI_MEM_DISPLAY_PANEL       2
+#define UI_MEM_SET_POSITION        3
+#define UI_MEM_SET_PATH            4
+#define UI_MEM_SET_DIMMED          5
+#define UI_MEM_ADD_RECENT          6
+#define UI_MEM_ADD_WINDOW_ITEM     7
+#define UI_MEM_DELETE_WINDOW_ITEM  8
+#define UI_MEM_SET_STEP_VIEW       9
+#define UI_MEM_SET_STEP_ROW        10
+#define UI_MEM_SET_TAB_VIEW        11
+#define UI_MEM_SET_TAB             12
+
+typedef struct UiMemCallRec_Tag
+{
+    int op;        /* UI_MEM_* */
+    int panel;     /* panel, command or menu item the call acted on */
+    int result;    /* value the backend returned */
+} UiMemCall;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+TMS_API const UiBackend *UI_MemBackend           (void);
+TMS_API void             UI_MemReset             (int maxWindowItems,
+                                                  int maxRecentFiles);
+TMS_API void             UI_MemSetRecording      (int record);
+TMS_API int              UI_MemNumCalls          (void);
+TMS_API int              UI_MemGetCall           (int index, UiMemCall *call);
+TMS_API int              UI_MemNumPanels         (void);
+TMS_API int              UI_MemIsPanelVisible    (int panel);
+TMS_API const char      *UI_MemGetPanelPath      (int panel);
+TMS_API int              UI_MemNumWindowItems    (void);
+TMS_API void            *UI_MemGetWindowItem     (int item);
+TMS_API int              UI_MemNumRecentFiles    (void);
+TMS_API const char      *UI_MemGetRecentFile     (int item);
+TMS_API int              UI_MemIsCommandDimmed   (int command);
+
+/* Tabs of a panel's tab strip and rows of its step list, 8 and 20 unless */
+/* set.  GetStepRow gives the step a row shows, -1 for none               */
+TMS_API void             UI_MemSetViewSize       (int numTabs,
+                                                  int numStepRows);
+TMS_API int              UI_MemGetStepRow        (int panel, int row);
+TMS_API const char      *UI_MemGetTab            (int panel, int tab);
+TMS_API int              UI_MemGetSelectedTab    (int panel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UIMEM_H__ */
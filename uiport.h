@@ -0,0 +1,82 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    uiport.h                                                         */
+/*                                                                           */
+/* PURPOSE: The user-interface operations the document logic (docctl.c)      */
+/*          needs, as a table of function pointers.  uicvi.c implements it   */
+/*          on the CVI User Interface Library and Menu Utility; uimem.cpp    */
+/*          implements it in memory, with no display, so the document and    */
+/*          sequence logic builds and runs on any platform.                  */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __UIPORT_H__
+#define __UIPORT_H__
+
+#include "tmsapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Menu commands whose dimmed state the document logic controls.  Backends   */
+/* map them to their own menu items.                                         */
+/*---------------------------------------------------------------------------*/
+#define UI_CMD_SAVE        0
+#define UI_CMD_SAVEAS      1
+#define UI_CMD_CLOSE       2
+#define UI_CMD_CLOSEALL    3
+#define UI_CMD_HIDEALL     4
+#define UI_CMD_UNDO        5
+#define UI_CMD_REDO        6
+#define UI_NUM_COMMANDS    7
+
+/*---------------------------------------------------------------------------*/
+/* One row of a document panel's step list.                                  */
+/*---------------------------------------------------------------------------*/
+typedef struct
+{
+    int         step;                   /* 0-based index in the sequence */
+    const char *name;
+    const char *module;                 /* 0 for a step with no symbol */
+    const char *symbol;
+    int         param;
+} UiStepRow;
+
+/*---------------------------------------------------------------------------*/
+/* Backend.  Functions return a negative value on failure, like the CVI      */
+/* functions they stand for.                                                 */
+/*---------------------------------------------------------------------------*/
+typedef struct UiBackendRec_Tag
+{
+    /* Document panels */
+    int   (*loadDocumentPanel)  (int parentPanel);
+    int   (*discardPanel)       (int panel);
+    int   (*displayPanel)       (int panel);
+    int   (*setPanelPosition)   (int panel, int top, int left);
+    int   (*setDocumentPath)    (int panel, const char *path);
+
+    /* A panel's step list and, in tabbed mode, its tab strip show a      */
+    /* window onto a longer list.  set...View gives the list's length and */
+    /* its first entry in view, and returns how many rows (tabs) the      */
+    /* panel shows; only those are filled in, 0 clearing one.  A tab      */
+    /* view of no tabs hides the strip.                                   */
+    int   (*setStepView)        (int panel, int numSteps, int firstStep);
+    int   (*setStepRow)         (int panel, int row, const UiStepRow *step);
+    int   (*setTabView)         (int panel, int numTabs, int firstTab);
+    int   (*setTab)             (int panel, int tab, const char *path,
+                                 int selected);
+
+    /* Menus */
+    int   (*setCommandDimmed)   (int command, int dimmed);
+    int   (*addRecentFile)      (const char *path);
+    int   (*addWindowItem)      (const char *path, void *itemData);
+    int   (*deleteWindowItem)   (int item);
+} UiBackend;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UIPORT_H__ */
@@ -0,0 +1,377 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    undo.cpp                                                         */
+/*                                                                           */
+/* PURPOSE: Undo and Redo history.  See undo.h.                              */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include <deque>
+#include <new>
+#include <string>
+
+#include "pvector.h"
+#include "seqtable.h"
+#include "undo.h"
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+
+/* One step, every column.  The function pointers are kept as well, so a  */
+/* restored step runs without being bound to its module again.            */
+struct UndoStep
+{
+    SeqStepFunc   func;
+    SeqBatchFunc  batch;
+    SeqSocketFunc socketFunc;
+    SeqAsyncFunc  asyncFunc;
+    int32_t       param;
+    int32_t       lowLimit;
+    int32_t       highLimit;
+    int32_t       group;
+    uint32_t      name;
+    uint32_t      module;
+    uint32_t      symbol;
+    uint32_t      argOffset;
+    int32_t       argCount;
+    uint8_t       kind;
+
+    bool operator== (const UndoStep &other) const
+        {
+        return func == other.func && batch == other.batch
+               && socketFunc == other.socketFunc
+               && asyncFunc == other.asyncFunc && param == other.param
+               && lowLimit == other.lowLimit && highLimit == other.highLimit
+               && group == other.group && name == other.name
+               && module == other.module && symbol == other.symbol
+               && argOffset == other.argOffset && argCount == other.argCount
+               && kind == other.kind;
+        }
+};
+
+/* The sequence after one edit */
+struct UndoVersion
+{
+    tms::PersistentVector<UndoStep> steps;
+    tms::PersistentVector<int32_t>  args;
+    int32_t                         maxGroup;
+    size_t                          bytes;  /* nodes not shared with the */
+                                            /* version before            */
+    std::string                     label;  /* edit that made it */
+
+    UndoVersion () : maxGroup (-1), bytes (0) {}
+};
+
+struct UndoHistoryRec_Tag
+{
+    Sequence                seq;
+    size_t                  budget;
+    std::deque<UndoVersion> versions;   /* oldest first */
+    size_t                  current;    /* index of the sequence's version */
+    size_t                  newerBytes; /* bytes of all but the oldest */
+    size_t                  changedFirst;   /* rows the last Undo or */
+    size_t                  changedEnd;     /* Redo wrote            */
+
+    UndoHistoryRec_Tag () : seq (0), budget (0), current (0),
+                            newerBytes (0), changedFirst (0),
+                            changedEnd (0) {}
+};
+
+/*---------------------------------------------------------------------------*/
+/* Step i of a sequence as a row.                                            */
+/*---------------------------------------------------------------------------*/
+static UndoStep ReadStep (Sequence seq, size_t i)
+{
+    UndoStep step;
+
+    step.func = seq->func[i];
+    step.batch = seq->batch[i];
+    step.socketFunc = seq->socketFunc[i];
+    step.asyncFunc = seq->asyncFunc[i];
+    step.param = seq->param[i];
+    step.lowLimit = seq->lowLimit[i];
+    step.highLimit = seq->highLimit[i];
+    step.group = seq->group[i];
+    step.name = seq->name[i];
+    step.module = seq->module[i];
+    step.symbol = seq->symbol[i];
+    step.argOffset = seq->argOffset[i];
+    step.argCount = seq->argCount[i];
+    step.kind = seq->kind[i];
+    return step;
+}
+
+static void WriteStep (Sequence seq, size_t i, const UndoStep &step)
+{
+    seq->func[i] = step.func;
+    seq->batch[i] = step.batch;
+    seq->socketFunc[i] = step.socketFunc;
+    seq->asyncFunc[i] = step.asyncFunc;
+    seq->param.At (i) = step.param;
+    seq->lowLimit.At (i) = step.lowLimit;
+    seq->highLimit.At (i) = step.highLimit;
+    seq->group.At (i) = step.group;
+    seq->name.At (i) = step.name;
+    seq->module.At (i) = step.module;
+    seq->symbol.At (i) = step.symbol;
+    seq->argOffset.At (i) = step.argOffset;
+    seq->argCount.At (i) = step.argCount;
+    seq->kind.At (i) = step.kind;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Bring version up to date with the sequence: steps [begin, end) and the    */
+/* inputs they use are compared, anything past version's end is appended,    */
+/* and anything past the sequence's end is dropped.  Only the elements that  */
+/* differ are written, so the version keeps sharing the rest.                */
+/*---------------------------------------------------------------------------*/
+static void Capture (UndoVersion &version, Sequence seq, size_t begin,
+                     size_t end)
+{
+    size_t   size = seq->Size ();
+    size_t   oldSize = version.steps.size ();
+    size_t   oldArgs = version.args.size ();
+    size_t   i;
+    size_t   a;
+    UndoStep step;
+
+    if (end > oldSize)
+        end = oldSize;
+    if (end > size)
+        end = size;
+    for (i = begin; i < end; i++)
+        {
+        step = ReadStep (seq, i);
+        if (!(version.steps[i] == step))
+            version.steps.Set (i, step);
+        for (a = step.argOffset; a < step.argOffset + (size_t)step.argCount
+                                 && a < oldArgs && a < seq->args.size (); a++)
+            if (version.args[a] != seq->args[a])
+                version.args.Set (a, seq->args[a]);
+        }
+    version.steps.Truncate (size);
+    for (i = oldSize; i < size; i++)
+        version.steps.PushBack (ReadStep (seq, i));
+    version.args.Truncate (seq->args.size ());
+    for (a = oldArgs; a < seq->args.size (); a++)
+        version.args.PushBack (seq->args[a]);
+    version.maxGroup = seq->maxGroup;
+    version.bytes = version.steps.TakeAllocated ()
+                    + version.args.TakeAllocated ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Drop the oldest versions, never the current one, until the history fits   */
+/* its budget.                                                               */
+/*---------------------------------------------------------------------------*/
+static void Evict (UndoHistory hist)
+{
+    while (hist->current > 0 && UND_MemoryUsed (hist) > hist->budget)
+        {
+        hist->versions.pop_front ();
+        hist->current--;
+        hist->newerBytes -= hist->versions.front ().bytes;
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Rewrite the sequence, which is at the current version, as target.  Only   */
+/* the steps and inputs whose nodes the two versions do not share are        */
+/* compared, so the work follows the size of the edits being undone.         */
+/*---------------------------------------------------------------------------*/
+static int Restore (UndoHistory hist, const UndoVersion &target)
+{
+    const UndoVersion &current = hist->versions[hist->current];
+    Sequence           seq = hist->seq;
+    size_t             oldSize = seq->Size ();
+    size_t             oldArgs = seq->args.size ();
+    size_t             i;
+
+    if (seq->busy.load ())
+        return TMS_ERR_BUSY;
+    try
+        {
+        seq->Resize (target.steps.size (), target.args.size ());
+        }
+    catch (const std::bad_alloc &)
+        {
+        seq->Resize (oldSize, oldArgs);
+        return TMS_ERR_NO_MEMORY;
+        }
+    hist->changedFirst = target.steps.size ();
+    hist->changedEnd = 0;
+    tms::PersistentVector<UndoStep>::ForEachDifference (
+        current.steps, target.steps,
+        [&] (size_t step)
+            {
+            WriteStep (seq, step, target.steps[step]);
+            if (step < hist->changedFirst)
+                hist->changedFirst = step;
+            hist->changedEnd = step + 1;
+            });
+    for (i = oldSize; i < target.steps.size (); i++)
+        WriteStep (seq, i, target.steps[i]);
+    tms::PersistentVector<int32_t>::ForEachDifference (
+        current.args, target.args,
+        [&] (size_t arg) { seq->args.At (arg) = target.args[arg]; });
+    for (i = oldArgs; i < target.args.size (); i++)
+        seq->args.At (i) = target.args[i];
+    seq->maxGroup = target.maxGroup;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Create a history whose first version is the sequence as it is now.        */
+/*---------------------------------------------------------------------------*/
+UndoHistory UND_New (Sequence seq, size_t budgetBytes)
+{
+    UndoHistory hist;
+
+    if (!seq)
+        return 0;
+    if (!(hist = new (std::nothrow) UndoHistoryRec_Tag))
+        return 0;
+    hist->seq = seq;
+    hist->budget = budgetBytes;
+    try
+        {
+        hist->versions.emplace_back ();
+        Capture (hist->versions.back (), seq, 0, 0);
+        }
+    catch (const std::bad_alloc &)
+        {
+        delete hist;
+        return 0;
+        }
+    return hist;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Discard a history.  The sequence stays as it is.                          */
+/*---------------------------------------------------------------------------*/
+void UND_Dispose (UndoHistory hist)
+{
+    delete hist;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Record the sequence as a new version after the current one.  An edit      */
+/* that changed nothing is not recorded.                                     */
+/*---------------------------------------------------------------------------*/
+int UND_Record (UndoHistory hist, const char *label, int firstStep,
+                int numSteps)
+{
+    const UndoVersion *current;
+    size_t             begin;
+    size_t             end;
+
+    if (!hist || firstStep < 0)
+        return TMS_ERR_INVALID_ARG;
+    current = &hist->versions[hist->current];
+    begin = numSteps < 0 ? 0 : (size_t)firstStep;
+    end = numSteps < 0 ? hist->seq->Size () : begin + (size_t)numSteps;
+    try
+        {
+        UndoVersion next = *current;
+
+        next.label = label ? label : "";
+        Capture (next, hist->seq, begin, end);
+        if (!next.bytes && next.steps.size () == current->steps.size ()
+            && next.args.size () == current->args.size ()
+            && next.maxGroup == current->maxGroup)
+            return TMS_OK;
+        while (hist->versions.size () > hist->current + 1)
+            {
+            hist->newerBytes -= hist->versions.back ().bytes;
+            hist->versions.pop_back ();
+            }
+        hist->versions.push_back (next);
+        hist->newerBytes += next.bytes;
+        hist->current++;
+        }
+    catch (const std::bad_alloc &)
+        {
+        return TMS_ERR_NO_MEMORY;
+        }
+    Evict (hist);
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Undo the current version's edit.                                          */
+/*---------------------------------------------------------------------------*/
+int UND_Undo (UndoHistory hist)
+{
+    int status;
+
+    if (!hist)
+        return TMS_ERR_INVALID_ARG;
+    if (hist->current == 0)
+        return TMS_ERR_NOT_FOUND;
+    if ((status = Restore (hist, hist->versions[hist->current - 1])) < 0)
+        return status;
+    hist->current--;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Redo the edit after the current version.                                  */
+/*---------------------------------------------------------------------------*/
+int UND_Redo (UndoHistory hist)
+{
+    int status;
+
+    if (!hist)
+        return TMS_ERR_INVALID_ARG;
+    if (hist->current + 1 >= hist->versions.size ())
+        return TMS_ERR_NOT_FOUND;
+    if ((status = Restore (hist, hist->versions[hist->current + 1])) < 0)
+        return status;
+    hist->current++;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Range of the rows the last Undo or Redo rewrote, so that whatever keeps   */
+/* its own view of the table (the Find index) need not re-read all of it.    */
+/*---------------------------------------------------------------------------*/
+int UND_GetChangedSteps (UndoHistory hist, int *firstStep, int *numSteps)
+{
+    if (!hist || !firstStep || !numSteps)
+        return TMS_ERR_INVALID_ARG;
+    *firstStep = (int)hist->changedFirst;
+    *numSteps = hist->changedEnd > hist->changedFirst
+                ? (int)(hist->changedEnd - hist->changedFirst) : 0;
+    return TMS_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Labels for the Edit menu.                                                 */
+/*---------------------------------------------------------------------------*/
+const char *UND_GetUndoLabel (UndoHistory hist)
+{
+    if (!hist || hist->current == 0)
+        return 0;
+    return hist->versions[hist->current].label.c_str ();
+}
+
+const char *UND_GetRedoLabel (UndoHistory hist)
+{
+    if (!hist || hist->current + 1 >= hist->versions.size ())
+        return 0;
+    return hist->versions[hist->current + 1].label.c_str ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* The oldest version's nodes, plus the nodes each later one added.          */
+/*---------------------------------------------------------------------------*/
+size_t UND_MemoryUsed (UndoHistory hist)
+{
+    const UndoVersion *oldest;
+
+    if (!hist)
+        return 0;
+    oldest = &hist->versions.front ();
+    return oldest->steps.Bytes () + oldest->args.Bytes () + hist->newerBytes;
+}
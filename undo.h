@@ -0,0 +1,69 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    undo.h                                                           */
+/*                                                                           */
+/* PURPOSE: Edit > Undo and Redo for a sequence.  The history keeps a        */
+/*          version of the step table after every recorded edit, stored as   */
+/*          persistent vectors (pvector.h), so each version shares all of    */
+/*          its unchanged steps with the one before: an edit of one step in  */
+/*          a 100k-step sequence adds a few KB, not a copy of the table.     */
+/*          Undo and Redo rewrite only the steps that differ.  The oldest    */
+/*          versions are dropped once the history outgrows its budget.       */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __UNDO_H__
+#define __UNDO_H__
+
+#include <stddef.h>
+#include "tmsapi.h"
+#include "sequence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Types                                                                     */
+/*---------------------------------------------------------------------------*/
+typedef struct UndoHistoryRec_Tag *UndoHistory;
+
+/*---------------------------------------------------------------------------*/
+/* Functions                                                                 */
+/*---------------------------------------------------------------------------*/
+
+/* Start a history of seq, which must outlive it, holding at most about */
+/* budgetBytes of old versions.  The sequence as it is now is the       */
+/* version the first Undo returns to.                                   */
+TMS_API UndoHistory UND_New          (Sequence seq, size_t budgetBytes);
+TMS_API void        UND_Dispose      (UndoHistory hist);
+
+/* Record an edit just made to seq under label (the command's name).  */
+/* Only steps [firstStep, firstStep + numSteps) and any steps added   */
+/* or removed at the end are compared; numSteps < 0 compares them     */
+/* all.  Discards whatever could be redone.                           */
+TMS_API int         UND_Record       (UndoHistory hist, const char *label,
+                                      int firstStep, int numSteps);
+
+/* Step back or forward one edit.  TMS_ERR_NOT_FOUND if there is none, */
+/* TMS_ERR_BUSY while the sequence is running.                         */
+TMS_API int         UND_Undo         (UndoHistory hist);
+TMS_API int         UND_Redo         (UndoHistory hist);
+
+/* Steps the last Undo or Redo rewrote: [*firstStep, + *numSteps), plus */
+/* any added or removed at the end                                      */
+TMS_API int         UND_GetChangedSteps (UndoHistory hist, int *firstStep,
+                                         int *numSteps);
+
+/* Label of the edit Undo or Redo would reverse or repeat, or 0 */
+TMS_API const char *UND_GetUndoLabel (UndoHistory hist);
+TMS_API const char *UND_GetRedoLabel (UndoHistory hist);
+
+/* Bytes the history holds, counting nodes shared by versions once */
+TMS_API size_t      UND_MemoryUsed   (UndoHistory hist);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UNDO_H__ */
@@ -0,0 +1,366 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    workpool.cpp                                                     */
+/*                                                                           */
+/* PURPOSE: Work-stealing thread pool implementation.                        */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#include "workpool.h"
+
+namespace tms {
+
+/* Index of the pool worker running on this thread, -1 for outside threads */
+static thread_local int t_workerIndex = -1;
+static thread_local WorkPool *t_workerPool = 0;
+
+/*---------------------------------------------------------------------------*/
+/* Start one worker per core (or numThreads if given).                       */
+/*---------------------------------------------------------------------------*/
+WorkPool::WorkPool (int numThreads)
+    : m_queued (0), m_numPushed (0), m_asleep (0), m_waiting (0),
+      m_nextQueue (0), m_outside (0), m_stopping (false), m_stop (false)
+{
+    int i;
+
+    if (numThreads <= 0)
+        numThreads = (int)std::thread::hardware_concurrency ();
+    if (numThreads <= 0)
+        numThreads = 1;
+    for (i = 0; i < numThreads; i++)
+        m_workers.push_back (new Worker);
+    for (i = 0; i < numThreads; i++)
+        m_workers[i]->thread = std::thread (&WorkPool::Run, this, i);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Stop and join all workers.  Queued tasks that never ran are dropped.      */
+/* The AtStop hooks stop the threads feeding the pool first.  Once m_stop is */
+/* set ParallelFor turns away any other thread outside the pool, but one     */
+/* that got in first may still be pushing, so let it finish before the       */
+/* deques go.                                                                */
+/*---------------------------------------------------------------------------*/
+WorkPool::~WorkPool ()
+{
+    std::vector<StopHook> atStop;
+    size_t                i;
+
+    {
+    std::lock_guard<std::mutex> guard (m_sleepLock);
+    atStop.swap (m_atStop);
+    m_stopping = true;
+    }
+    for (i = 0; i < atStop.size (); i++)
+        atStop[i].func (atStop[i].context);
+    {
+    std::lock_guard<std::mutex> guard (m_sleepLock);
+    m_stop = true;
+    }
+    m_wake.notify_all ();
+    while (m_outside.load (std::memory_order_acquire) > 0)
+        std::this_thread::yield ();
+    for (i = 0; i < m_workers.size (); i++)
+        m_workers[i]->thread.join ();
+    for (i = 0; i < m_workers.size (); i++)
+        delete m_workers[i];
+}
+
+/*---------------------------------------------------------------------------*/
+/* The shared pool.  Constructed on first use.                               */
+/*---------------------------------------------------------------------------*/
+WorkPool &WorkPool::Instance ()
+{
+    static WorkPool pool;
+    return pool;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Register a hook for the destructor, or call it now if the destructor has  */
+/* already called the others.  Throws std::bad_alloc.                        */
+/*---------------------------------------------------------------------------*/
+void WorkPool::AtStop (void (*func) (void *context), void *context)
+{
+    StopHook hook = { func, context };
+
+    {
+    std::lock_guard<std::mutex> guard (m_sleepLock);
+    if (!m_stopping)
+        {
+        m_atStop.push_back (hook);
+        return;
+        }
+    }
+    func (context);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Which worker, if any, is running on this thread.                          */
+/*---------------------------------------------------------------------------*/
+int WorkPool::CurrentWorker () const
+{
+    return t_workerPool == this ? t_workerIndex : -1;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Queue a task on a worker deque and wake a sleeper, and any waiters so     */
+/* they can help.  The shared lock is only taken when someone is asleep: a   */
+/* sleeper counts itself before its last look at the counters, and the       */
+/* pusher bumps them before it looks at the sleepers (all sequentially       */
+/* consistent), so one of the two always sees the other.                     */
+/*---------------------------------------------------------------------------*/
+void WorkPool::Push (int worker, const Task &task)
+{
+    bool sleepers;
+    bool waiters;
+
+    {
+    std::lock_guard<std::mutex> guard (m_workers[worker]->lock);
+    m_workers[worker]->tasks.push_back (task);
+    }
+    m_queued.fetch_add (1);
+    m_numPushed.fetch_add (1);
+    sleepers = m_asleep.load () > 0;
+    waiters = m_waiting.load () > 0;
+    if (!sleepers && !waiters)
+        return;
+    {
+    /* Taking the lock orders this notify after a sleeper's check */
+    std::lock_guard<std::mutex> guard (m_sleepLock);
+    }
+    if (sleepers)
+        m_wake.notify_one ();
+    if (waiters)
+        m_groupDone.notify_all ();
+}
+
+/*---------------------------------------------------------------------------*/
+/* Owner pops the most recently pushed (cache-warm) task.                    */
+/*---------------------------------------------------------------------------*/
+bool WorkPool::PopOwn (int worker, Task &task)
+{
+    Worker *w = m_workers[worker];
+    std::lock_guard<std::mutex> guard (w->lock);
+
+    if (w->tasks.empty ())
+        return false;
+    task = w->tasks.back ();
+    w->tasks.pop_back ();
+    m_queued.fetch_sub (1, std::memory_order_relaxed);
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Thieves take the oldest (largest) task from the front of a victim deque.  */
+/*---------------------------------------------------------------------------*/
+bool WorkPool::Steal (int thief, Task &task)
+{
+    size_t n = m_workers.size ();
+    size_t start = (size_t)(thief < 0 ? 0 : thief + 1);
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        {
+        Worker *victim = m_workers[(start + i) % n];
+        std::unique_lock<std::mutex> guard (victim->lock, std::try_to_lock);
+
+        if (!guard.owns_lock () || victim->tasks.empty ())
+            continue;
+        task = victim->tasks.front ();
+        victim->tasks.pop_front ();
+        m_queued.fetch_sub (1, std::memory_order_relaxed);
+        return true;
+        }
+    return false;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Look for something to run: own deque first, then everyone else's.         */
+/*---------------------------------------------------------------------------*/
+bool WorkPool::FindWork (int self, Task &task)
+{
+    if (self >= 0 && PopOwn (self, task))
+        return true;
+    return Steal (self, task);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Look for a queued task of one group only: the newest on the caller's own  */
+/* deque, else the oldest on any deque.                                      */
+/*---------------------------------------------------------------------------*/
+bool WorkPool::FindGroupWork (int self, TaskGroup &group, Task &task)
+{
+    size_t n = m_workers.size ();
+    size_t start = (size_t)(self < 0 ? 0 : self);
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        {
+        Worker *w = m_workers[(start + i) % n];
+        std::lock_guard<std::mutex> guard (w->lock);
+        size_t count = w->tasks.size ();
+        size_t k;
+
+        for (k = 0; k < count; k++)
+            {
+            size_t at = (i == 0 && self >= 0) ? count - 1 - k : k;
+
+            if (w->tasks[at].group != &group)
+                continue;
+            task = w->tasks[at];
+            w->tasks.erase (w->tasks.begin () + at);
+            m_queued.fetch_sub (1, std::memory_order_relaxed);
+            return true;
+            }
+        }
+    return false;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Run a task, splitting off the upper half of oversized ranges first so     */
+/* that they are visible to thieves.                                         */
+/*---------------------------------------------------------------------------*/
+void WorkPool::Execute (int self, Task &task)
+{
+    TaskGroup *group = task.group;
+
+    while (task.end - task.begin > task.grain)
+        {
+        Task upper = task;
+        int  mid = task.begin + (task.end - task.begin) / 2;
+
+        upper.begin = mid;
+        task.end = mid;
+        group->m_pending.fetch_add (1, std::memory_order_relaxed);
+        if (self >= 0)
+            Push (self, upper);
+        else
+            Push ((int)(m_nextQueue.fetch_add (1) % m_workers.size ()), upper);
+        }
+    task.func (task.context, task.begin, task.end);
+    Release (*group);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Worker thread body.                                                       */
+/*---------------------------------------------------------------------------*/
+void WorkPool::Run (int self)
+{
+    Task task;
+
+    t_workerIndex = self;
+    t_workerPool = this;
+    for (;;)
+        {
+        if (FindWork (self, task))
+            {
+            Execute (self, task);
+            continue;
+            }
+        std::unique_lock<std::mutex> guard (m_sleepLock);
+        if (m_stop)
+            return;
+        m_asleep.fetch_add (1);
+        if (m_queued.load () == 0)
+            m_wake.wait (guard);
+        m_asleep.fetch_sub (1);
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Queue [begin, end) as a single range; workers split it as they go.        */
+/*---------------------------------------------------------------------------*/
+void WorkPool::ParallelFor (TaskGroup &group, int begin, int end, int grain,
+                            RangeFunc func, void *context)
+{
+    Task task;
+    int  target;
+
+    if (end <= begin)
+        return;
+    task.func = func;
+    task.context = context;
+    task.begin = begin;
+    task.end = end;
+    task.grain = grain > 0 ? grain : 1;
+    task.group = &group;
+    if (t_workerPool == this)
+        {
+        group.m_pending.fetch_add (1, std::memory_order_relaxed);
+        Push (t_workerIndex, task);
+        return;
+        }
+    {
+    /* A pool being destroyed takes no more work from outside */
+    std::lock_guard<std::mutex> guard (m_sleepLock);
+    if (m_stop)
+        return;
+    m_outside.fetch_add (1, std::memory_order_relaxed);
+    }
+    group.m_pending.fetch_add (1, std::memory_order_relaxed);
+    target = (int)(m_nextQueue.fetch_add (1) % m_workers.size ());
+    Push (target, task);
+    m_outside.fetch_sub (1, std::memory_order_release);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Queue a single call.                                                      */
+/*---------------------------------------------------------------------------*/
+void WorkPool::Submit (TaskGroup &group, RangeFunc func, void *context)
+{
+    ParallelFor (group, 0, 1, 1, func, context);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Wait for a group.  The waiting thread helps with the group's own queued   */
+/* tasks, so waiting from inside a task (nested parallelism) cannot starve   */
+/* the pool, but it never picks up unrelated work: the UI thread in Step     */
+/* mode, or one socket waiting on its steps, must not end up running         */
+/* another execution's whole Run > All.                                      */
+/*---------------------------------------------------------------------------*/
+void WorkPool::Wait (TaskGroup &group)
+{
+    int      self = (t_workerPool == this) ? t_workerIndex : -1;
+    unsigned pushed;
+    Task     task;
+
+    while (!group.Done ())
+        {
+        pushed = m_numPushed.load (std::memory_order_acquire);
+        if (FindGroupWork (self, group, task))
+            {
+            Execute (self, task);
+            continue;
+            }
+
+        /* Push and the last Release notify under the lock when they see */
+        /* a waiter, so neither can slip in between this check and the    */
+        /* wait                                                           */
+        std::unique_lock<std::mutex> guard (m_sleepLock);
+        m_waiting.fetch_add (1);
+        if (group.m_pending.load () != 0 && m_numPushed.load () == pushed)
+            m_groupDone.wait (guard);
+        m_waiting.fetch_sub (1);
+        }
+}
+
+/*---------------------------------------------------------------------------*/
+/* Hold a group open for work outside the queues; the last Release (or       */
+/* finished task) wakes its waiters.                                         */
+/*---------------------------------------------------------------------------*/
+void WorkPool::Hold (TaskGroup &group)
+{
+    group.m_pending.fetch_add (1, std::memory_order_relaxed);
+}
+
+void WorkPool::Release (TaskGroup &group)
+{
+    if (group.m_pending.fetch_sub (1) == 1 && m_waiting.load () > 0)
+        {
+        {
+        std::lock_guard<std::mutex> guard (m_sleepLock);
+        }
+        m_groupDone.notify_all ();
+        }
+}
+
+} /* namespace tms */
@@ -0,0 +1,131 @@
+/*---------------------------------------------------------------------------*/
+/*                                                                           */
+/* FILE:    workpool.h                                                       */
+/*                                                                           */
+/* PURPOSE: Work-stealing thread pool used by the execution engine.  Each    */
+/*          worker owns a deque of index ranges; it pops from the back of    */
+/*          its own deque and steals from the front of the others.  Large    */
+/*          ranges are split on the way so idle workers always have work     */
+/*          to take.  C++ only -- not part of the exported C API.            */
+/*                                                                           */
+/*---------------------------------------------------------------------------*/
+
+#ifndef __WORKPOOL_H__
+#define __WORKPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tms {
+
+/*---------------------------------------------------------------------------*/
+/* A set of tasks that can be waited on together.                            */
+/*---------------------------------------------------------------------------*/
+class TaskGroup
+{
+public:
+    TaskGroup () : m_pending (0) {}
+
+    bool Done () const { return m_pending.load (std::memory_order_acquire) == 0; }
+
+private:
+    friend class WorkPool;
+    std::atomic<int> m_pending;
+};
+
+/*---------------------------------------------------------------------------*/
+/* RangeFunc is called with a half-open index range [begin, end).            */
+/*---------------------------------------------------------------------------*/
+typedef void (*RangeFunc) (void *context, int begin, int end);
+
+class WorkPool
+{
+public:
+    explicit WorkPool (int numThreads = 0);
+    ~WorkPool ();
+
+    int  NumThreads () const { return (int)m_workers.size (); }
+
+    /* Index of the calling thread among the workers, or -1. */
+    int  CurrentWorker () const;
+
+    /* Run func over [begin, end) in chunks of at most grain indices. */
+    /* Ignored when called from outside while the pool is destroyed.   */
+    void ParallelFor (TaskGroup &group, int begin, int end, int grain,
+                      RangeFunc func, void *context);
+
+    /* Queue a single call func(context, 0, 1). */
+    void Submit (TaskGroup &group, RangeFunc func, void *context);
+
+    /* Block until the group is done, executing the group's own queued */
+    /* tasks meanwhile (never anyone else's).                           */
+    void Wait (TaskGroup &group);
+
+    /* Count work that is not a queued task (a step waiting on I/O) as   */
+    /* part of group until the matching Release.                         */
+    void Hold    (TaskGroup &group);
+    void Release (TaskGroup &group);
+
+    /* Have the destructor call func (context) before anything else,  */
+    /* while the pool still takes work: to stop a thread that queues    */
+    /* tasks from outside (the async steps' I/O thread).                */
+    void AtStop (void (*func) (void *context), void *context);
+
+    /* Process-wide pool sized to the number of cores. */
+    static WorkPool &Instance ();
+
+private:
+    struct Task
+    {
+        RangeFunc  func;
+        void      *context;
+        int        begin;
+        int        end;
+        int        grain;
+        TaskGroup *group;
+    };
+
+    struct Worker
+    {
+        std::mutex       lock;
+        std::deque<Task> tasks;
+        std::thread      thread;
+    };
+
+    struct StopHook
+    {
+        void (*func) (void *context);
+        void  *context;
+    };
+
+    void Push    (int worker, const Task &task);
+    bool PopOwn  (int worker, Task &task);
+    bool Steal   (int thief, Task &task);
+    bool FindWork(int self, Task &task);
+    bool FindGroupWork (int self, TaskGroup &group, Task &task);
+    void Execute (int self, Task &task);
+    void Run     (int self);
+
+    std::vector<Worker *>   m_workers;
+    std::vector<StopHook>   m_atStop;
+    std::mutex              m_sleepLock;
+    std::condition_variable m_wake;
+    std::condition_variable m_groupDone;
+    std::atomic<int>        m_queued;
+    std::atomic<unsigned>   m_numPushed;  /* wakes waiters on new tasks */
+    std::atomic<int>        m_asleep;     /* workers in m_wake */
+    std::atomic<int>        m_waiting;    /* threads in m_groupDone */
+    std::atomic<unsigned>   m_nextQueue;
+    std::atomic<int>        m_outside;    /* threads in ParallelFor that */
+                                          /* are not workers             */
+    bool                    m_stopping;   /* AtStop hooks called */
+    bool                    m_stop;
+};
+
+} /* namespace tms */
+
+#endif /* __WORKPOOL_H__ */